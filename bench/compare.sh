@@ -0,0 +1,78 @@
+#!/bin/sh
+# Brisk Language - Benchmark Comparison
+# Compares two result files written by bench_runner and flags benchmarks
+# whose median CPU time or peak RSS grew by more than THRESHOLD percent
+# (default 10). Wall time is shown but not judged, since it moves with
+# machine load. Exits 1 if anything regressed.
+#
+# Usage: bench/compare.sh BASELINE CURRENT [THRESHOLD]
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 BASELINE CURRENT [THRESHOLD]" >&2
+    exit 2
+fi
+
+awk -v threshold="${3:-10}" '
+# Number after "key": inside the object named section ("" for top level)
+function value(line, section, key,    rest, at) {
+    rest = line
+    if (section != "") {
+        at = index(rest, "\"" section "\"")
+        if (at == 0) return -1
+        rest = substr(rest, at)
+    }
+    at = index(rest, "\"" key "\": ")
+    if (at == 0) return -1
+    return substr(rest, at + length(key) + 4) + 0
+}
+
+function name(line,    rest) {
+    rest = substr(line, index(line, "\"name\": \"") + 9)
+    return substr(rest, 1, index(rest, "\"") - 1)
+}
+
+function change(old, new) {
+    return old > 0 ? (new - old) / old * 100 : 0
+}
+
+BEGIN {
+    printf "%-16s %10s %10s %10s\n", "Benchmark", "CPU", "Wall", "RSS"
+}
+
+!/"name": / { next }
+
+FNR == NR {
+    n = name($0)
+    base_cpu[n] = value($0, "cpu_ms", "median")
+    base_wall[n] = value($0, "wall_ms", "median")
+    base_rss[n] = value($0, "", "rss_kb")
+    next
+}
+
+{
+    n = name($0)
+    if (!(n in base_cpu)) {
+        printf "%-16s %s\n", n, "new, no baseline"
+        next
+    }
+    cpu = change(base_cpu[n], value($0, "cpu_ms", "median"))
+    wall = change(base_wall[n], value($0, "wall_ms", "median"))
+    rss = change(base_rss[n], value($0, "", "rss_kb"))
+
+    verdict = ""
+    if (cpu > threshold) verdict = "REGRESSION (cpu)"
+    if (rss > threshold) verdict = verdict == "" ? "REGRESSION (rss)" : "REGRESSION (cpu, rss)"
+    if (verdict != "") regressions++
+    else if (cpu < -threshold) verdict = "faster"
+
+    printf "%-16s %+9.1f%% %+9.1f%% %+9.1f%%  %s\n", n, cpu, wall, rss, verdict
+}
+
+END {
+    if (regressions > 0) {
+        printf "\n%d benchmark(s) regressed by more than %s%%\n", regressions, threshold
+        exit 1
+    }
+    printf "\nNo regressions beyond %s%%\n", threshold
+}
+' "$1" "$2"
@@ -0,0 +1,209 @@
+/*
+ * Brisk Language - Benchmark Runner
+ * Runs each benchmark script several times in a fresh interpreter process
+ * and records wall time, CPU time (user + system) and peak resident set
+ * size. Prints a summary table and writes the results as JSON, one
+ * benchmark per line, for bench/compare.sh.
+ *
+ * Usage: bench_runner [-n RUNS] [-w WARMUP] [-o FILE] BRISK SCRIPT...
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#define MAX_RUNS 1000
+
+typedef struct {
+    double wall_ms;
+    double cpu_ms;
+    long rss_kb;
+} Sample;
+
+typedef struct {
+    double min;
+    double median;
+    double mean;
+    double max;
+} Summary;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static double timeval_ms(struct timeval tv) {
+    return (double)tv.tv_sec * 1e3 + (double)tv.tv_usec / 1e3;
+}
+
+/* Run brisk on script once with its output discarded */
+static bool run_once(const char* brisk, const char* script, Sample* sample) {
+    double start = now_ms();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            close(null_fd);
+        }
+        execl(brisk, brisk, script, (char*)NULL);
+        perror(brisk);
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return false;
+    }
+    sample->wall_ms = now_ms() - start;
+    sample->cpu_ms = timeval_ms(usage.ru_utime) + timeval_ms(usage.ru_stime);
+    sample->rss_kb = usage.ru_maxrss;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Error: %s failed (status %d)\n", script,
+                WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        return false;
+    }
+    return true;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static Summary summarize(double* values, int count) {
+    qsort(values, count, sizeof(double), compare_doubles);
+    Summary summary;
+    summary.min = values[0];
+    summary.max = values[count - 1];
+    summary.median = count % 2 == 1 ? values[count / 2]
+                                    : (values[count / 2 - 1] + values[count / 2]) / 2;
+    double total = 0;
+    for (int i = 0; i < count; i++) total += values[i];
+    summary.mean = total / count;
+    return summary;
+}
+
+/* "bench/fib.brisk" is reported as "fib" */
+static void benchmark_name(const char* script, char* out, size_t size) {
+    const char* base = strrchr(script, '/');
+    base = base != NULL ? base + 1 : script;
+    size_t length = strlen(base);
+    if (length > 6 && strcmp(base + length - 6, ".brisk") == 0) length -= 6;
+    if (length >= size) length = size - 1;
+    memcpy(out, base, length);
+    out[length] = '\0';
+}
+
+static void write_summary(FILE* out, const char* key, Summary summary) {
+    fprintf(out, "\"%s\": {\"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"max\": %.3f}",
+            key, summary.min, summary.median, summary.mean, summary.max);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [-n RUNS] [-w WARMUP] [-o FILE] BRISK SCRIPT...\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    int warmup = 1;
+    const char* json_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:o:")) != -1) {
+        switch (opt) {
+            case 'n': runs = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'o': json_path = optarg; break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (runs < 1 || runs > MAX_RUNS || warmup < 0 || argc - optind < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char* brisk = argv[optind];
+
+    FILE* json = NULL;
+    if (json_path != NULL) {
+        json = fopen(json_path, "w");
+        if (json == NULL) {
+            perror(json_path);
+            return 1;
+        }
+        fprintf(json, "{\"brisk\": \"%s\", \"runs\": %d, \"benchmarks\": [\n", brisk, runs);
+    }
+
+    printf("%-16s %12s %12s %12s %10s\n", "Benchmark", "Wall (ms)", "CPU (ms)", "Spread", "RSS (KB)");
+
+    static double wall[MAX_RUNS];
+    static double cpu[MAX_RUNS];
+    int failures = 0;
+    bool first = true;
+    for (int s = optind + 1; s < argc; s++) {
+        const char* script = argv[s];
+        char name[64];
+        benchmark_name(script, name, sizeof(name));
+
+        Sample sample;
+        bool ok = true;
+        for (int i = 0; i < warmup && ok; i++) ok = run_once(brisk, script, &sample);
+
+        long rss_kb = 0;
+        for (int i = 0; i < runs && ok; i++) {
+            ok = run_once(brisk, script, &sample);
+            wall[i] = sample.wall_ms;
+            cpu[i] = sample.cpu_ms;
+            if (sample.rss_kb > rss_kb) rss_kb = sample.rss_kb;
+        }
+        if (!ok) {
+            failures++;
+            continue;
+        }
+
+        Summary wall_summary = summarize(wall, runs);
+        Summary cpu_summary = summarize(cpu, runs);
+
+        /* Spread is the range of wall times relative to the median */
+        double spread = wall_summary.median > 0
+                      ? (wall_summary.max - wall_summary.min) / wall_summary.median * 100 : 0;
+        printf("%-16s %12.1f %12.1f %11.1f%% %10ld\n", name,
+               wall_summary.median, cpu_summary.median, spread, rss_kb);
+        fflush(stdout);
+
+        if (json != NULL) {
+            fprintf(json, "%s  {\"name\": \"%s\", ", first ? "" : ",\n", name);
+            write_summary(json, "wall_ms", wall_summary);
+            fprintf(json, ", ");
+            write_summary(json, "cpu_ms", cpu_summary);
+            fprintf(json, ", \"rss_kb\": %ld}", rss_kb);
+            first = false;
+        }
+    }
+
+    if (json != NULL) {
+        fprintf(json, "\n]}\n");
+        fclose(json);
+    }
+    return failures > 0 ? 1 : 0;
+}
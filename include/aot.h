@@ -0,0 +1,210 @@
+/*
+ * Brisk Language - Compiled Program Support
+ * What the C written by --emit-c (emitc.h) calls besides the interpreter's
+ * own operations: string constants, locals kept in C variables, inline
+ * fast paths for numbers, closures over compiled bodies and for loops.
+ */
+
+#ifndef BRISK_AOT_H
+#define BRISK_AOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "interp.h"
+#include "cffi.h"
+#include "iter.h"
+#include "generator.h"
+#include "ffitrace.h"
+
+/* Why a compiled block is being left before its end */
+typedef enum {
+    AOT_NONE,
+    AOT_BREAK,
+    AOT_CONTINUE,
+    AOT_RETURN
+} AotPending;
+
+/* A name, key or string literal of the program */
+typedef struct {
+    const char* chars;
+    int length;
+} AotConstant;
+
+/* A fn declaration or lambda of the program */
+typedef struct {
+    const char* name;        /* NULL for lambdas */
+    char** params;
+    int* param_lengths;
+    int arity;
+    AstNode* body;           /* Only its line is read, for call frames */
+    bool is_generator;
+    CompiledBody compiled;
+} AotFunction;
+
+/* The C signature a direct call of a header function was compiled for */
+typedef struct {
+    CType return_type;
+    const CType* param_types;
+    int param_count;
+} AotSignature;
+
+/* A for loop over an array, an iterator or, when both are NULL, the
+   integers from position to end by step */
+typedef struct {
+    ObjArray* array;
+    ObjIterator* iterator;
+    int64_t position;
+    int64_t end;
+    int64_t step;
+    bool owned;              /* The iterator holds a reference for the loop
+                                beyond iterator_of's (see exec_for) */
+} AotLoop;
+
+/* Run a compiled program; constants are what aot_key indexes */
+int aot_main(CompiledBody program, const AotConstant* constants, int count);
+
+/* Intern constant index for interp (called by aot_key the first time) */
+ObjString* aot_intern(Interpreter* interp, int index);
+
+/* A function value for a declaration, closing over the current scope */
+Value aot_closure(Interpreter* interp, const AotFunction* function);
+
+/* Start a loop over iterable, or over start..end; false after reporting
+   a runtime error if it cannot be iterated. from_call is set when iterable
+   is the result of a call written as the loop's iterable. */
+bool aot_loop_start(Interpreter* interp, AotLoop* loop, Value iterable,
+                    bool from_call, int line);
+bool aot_loop_range(Interpreter* interp, AotLoop* loop, Value start, Value end, int line);
+
+/* Release what a loop holds */
+void aot_loop_end(AotLoop* loop);
+
+/* Constant index as an interned string, borrowed from interp */
+static inline ObjString* aot_key(Interpreter* interp, int index) {
+    if (interp->constants != NULL && interp->constants[index] != NULL) {
+        return interp->constants[index];
+    }
+    return aot_intern(interp, index);
+}
+
+/* Store into a local kept in a C variable, which holds a reference the
+   way a scope does */
+static inline void aot_store(Value* slot, Value value) {
+    if (IS_OBJ(value)) obj_incref(AS_OBJ(value));
+    Value old = *slot;
+    *slot = value;
+    if (IS_OBJ(old)) obj_decref(AS_OBJ(old));
+}
+
+/* Drop a C local as its scope ends */
+static inline void aot_release(Value* slot) {
+    Value old = *slot;
+    *slot = NIL_VAL;
+    if (IS_OBJ(old)) obj_decref(AS_OBJ(old));
+}
+
+static inline bool aot_truthy(Value value) {
+    return IS_BOOL(value) ? AS_BOOL(value) : value_is_truthy(value);
+}
+
+/* Arithmetic and comparison with both operands of one numeric type are
+   inline; everything else, errors included, goes through binary_op */
+static inline Value aot_add(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return INT_VAL(AS_INT(left) + AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return FLOAT_VAL(AS_FLOAT(left) + AS_FLOAT(right));
+    return binary_op(interp, TOKEN_PLUS, left, right, line);
+}
+
+static inline Value aot_subtract(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return INT_VAL(AS_INT(left) - AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return FLOAT_VAL(AS_FLOAT(left) - AS_FLOAT(right));
+    return binary_op(interp, TOKEN_MINUS, left, right, line);
+}
+
+static inline Value aot_multiply(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return INT_VAL(AS_INT(left) * AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return FLOAT_VAL(AS_FLOAT(left) * AS_FLOAT(right));
+    return binary_op(interp, TOKEN_STAR, left, right, line);
+}
+
+static inline Value aot_less(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return BOOL_VAL(AS_INT(left) < AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return BOOL_VAL(AS_FLOAT(left) < AS_FLOAT(right));
+    return binary_op(interp, TOKEN_LT, left, right, line);
+}
+
+static inline Value aot_greater(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return BOOL_VAL(AS_INT(left) > AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return BOOL_VAL(AS_FLOAT(left) > AS_FLOAT(right));
+    return binary_op(interp, TOKEN_GT, left, right, line);
+}
+
+static inline Value aot_less_equal(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return BOOL_VAL(AS_INT(left) <= AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return BOOL_VAL(AS_FLOAT(left) <= AS_FLOAT(right));
+    return binary_op(interp, TOKEN_LTE, left, right, line);
+}
+
+static inline Value aot_greater_equal(Interpreter* interp, Value left, Value right, int line) {
+    if (IS_INT(left) && IS_INT(right)) return BOOL_VAL(AS_INT(left) >= AS_INT(right));
+    if (IS_FLOAT(left) && IS_FLOAT(right)) return BOOL_VAL(AS_FLOAT(left) >= AS_FLOAT(right));
+    return binary_op(interp, TOKEN_GTE, left, right, line);
+}
+
+static inline Value aot_negate(Interpreter* interp, Value operand, int line) {
+    if (IS_INT(operand)) return INT_VAL(-AS_INT(operand));
+    return unary_op(interp, TOKEN_MINUS, operand, line);
+}
+
+/* object[index] with an in-bounds array index inline */
+static inline Value aot_index(Interpreter* interp, Value object, Value index, int line) {
+    if (IS_ARRAY(object) && IS_INT(index)) {
+        ObjArray* array = AS_ARRAY(object);
+        int64_t i = AS_INT(index);
+        if (i >= 0 && i < array->count) return array->elements[i];
+    }
+    return index_get(interp, object, index, line);
+}
+
+/* The next value of a for loop, or false once it is done */
+static inline bool aot_loop_next(Interpreter* interp, AotLoop* loop, Value* out) {
+    if (loop->array != NULL) {
+        /* Re-check count each step: the loop body may change the array */
+        if (loop->position >= loop->array->count) return false;
+        *out = loop->array->elements[loop->position++];
+        return true;
+    }
+    if (loop->iterator != NULL) {
+        return iterator_next(interp, loop->iterator, out);
+    }
+    if (loop->step > 0 ? loop->position >= loop->end : loop->position <= loop->end) {
+        return false;
+    }
+    *out = INT_VAL(loop->position);
+    loop->position += loop->step;
+    return true;
+}
+
+/* The descriptor of callee if it is a C function whose signature matches
+   the one a direct call was compiled for, else NULL. Calls traced with
+   BRISK_FFI_TRACE keep going through libffi so they are counted. */
+static inline CFunctionDesc* aot_direct(Value callee, const AotSignature* signature) {
+    if (!IS_CFUNCTION(callee) || ffi_tracing) return NULL;
+    CFunctionDesc* desc = AS_CFUNCTION(callee)->desc;
+    if (desc->is_variadic || desc->return_type != signature->return_type ||
+        desc->param_count != signature->param_count ||
+        memcmp(desc->param_types, signature->param_types,
+               sizeof(CType) * signature->param_count) != 0) {
+        return NULL;
+    }
+    return desc;
+}
+
+/* C code may write to stdout directly; keep it in order */
+static inline void aot_flush(Interpreter* interp) {
+    if (interp->out.length > 0) output_flush(&interp->out);
+}
+
+#endif /* BRISK_AOT_H */
@@ -33,6 +33,7 @@ typedef enum {
     NODE_LAMBDA,
     NODE_RANGE,
     NODE_ADDRESS_OF,
+    NODE_INTERP,
     
     /* Statements */
     NODE_VAR_DECL,
@@ -49,6 +50,7 @@ typedef enum {
     NODE_FN_DECL,
     NODE_MATCH,
     NODE_DEFER,
+    NODE_YIELD,
     
     /* Special */
     NODE_PROGRAM,
@@ -185,6 +187,7 @@ typedef struct {
     int* param_lengths;
     int param_count;
     AstNode* body;
+    bool is_generator;       /* Body contains yield */
 } FnDecl;
 
 /* Lambda (anonymous function) data */
@@ -193,6 +196,7 @@ typedef struct {
     int* param_lengths;
     int param_count;
     AstNode* body;
+    bool is_generator;
 } Lambda;
 
 /* Return statement data */
@@ -200,6 +204,11 @@ typedef struct {
     AstNode* value;  /* Can be NULL */
 } ReturnStmt;
 
+/* Yield statement data */
+typedef struct {
+    AstNode* value;  /* Can be NULL */
+} YieldStmt;
+
 /* Match statement data */
 typedef struct {
     AstNode* value;
@@ -236,6 +245,29 @@ typedef struct {
     AstNode* operand;
 } AddressOf;
 
+/* Format spec for an interpolated expression: [<|>][0][width][.precision][type] */
+typedef struct {
+    char align;          /* '<', '>' or 0 for the default */
+    bool zero_pad;
+    int width;           /* 0 = no minimum width */
+    int precision;       /* -1 = not given */
+    char type;           /* d, x, X, o, b, f, e, g, s or 0 */
+} FormatSpec;
+
+/* Interpolated string part: literal text or a formatted expression */
+typedef struct {
+    char* literal;       /* NULL for expression parts */
+    int literal_length;
+    AstNode* expr;
+    FormatSpec spec;
+} InterpPart;
+
+/* Interpolated string data */
+typedef struct {
+    InterpPart* parts;
+    int part_count;
+} InterpString;
+
 /* AST Node structure */
 struct AstNode {
     NodeType type;
@@ -265,12 +297,14 @@ struct AstNode {
         FnDecl fn_decl;
         Lambda lambda;
         ReturnStmt return_stmt;
+        YieldStmt yield_stmt;
         MatchStmt match_stmt;
         DeferStmt defer_stmt;
         Import import;
         CBlock c_block;
         Program program;
         AddressOf address_of;
+        InterpString interp_string;
     } as;
 };
 
@@ -308,10 +342,12 @@ AstNode* ast_break(int line, int column);
 AstNode* ast_continue(int line, int column);
 AstNode* ast_match(AstNode* value, AstNode** patterns, AstNode** bodies, int arm_count, int line, int column);
 AstNode* ast_defer(AstNode* stmt, int line, int column);
+AstNode* ast_yield(AstNode* value, int line, int column);
 AstNode* ast_import(const char* path, int length, int line, int column);
 AstNode* ast_c_block(const char* code, int length, int line, int column);
 AstNode* ast_program(AstNode** stmts, int count);
 AstNode* ast_address_of(AstNode* operand, int line, int column);
+AstNode* ast_interp(InterpPart* parts, int part_count, int line, int column);
 AstNode* ast_expr_stmt(AstNode* expr, int line, int column);
 
 /* Memory management */
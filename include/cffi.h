@@ -70,6 +70,7 @@ typedef struct {
     void* func_ptr;
     ffi_cif cif;
     bool cif_prepared;
+    struct FfiTrace* trace;  /* Call histograms under BRISK_FFI_TRACE */
 } CFunctionDesc;
 
 /* C function object (for interpreter) */
@@ -0,0 +1,42 @@
+/*
+ * Brisk Language - Channels
+ */
+
+#ifndef BRISK_CHANNEL_H
+#define BRISK_CHANNEL_H
+
+#include <stdbool.h>
+#include "value.h"
+#include "clone.h"
+
+typedef enum {
+    CHANNEL_OK,
+    CHANNEL_EMPTY,      /* Nothing to receive right now */
+    CHANNEL_CLOSED      /* Closed, and drained when receiving */
+} ChannelStatus;
+
+/* A bounded queue of messages shared by any number of isolates. It lives
+   outside all of them and is freed when its last handle is released. */
+typedef struct Channel Channel;
+
+/* Capacity is rounded up to a power of two, at least 2 */
+Channel* channel_create(int capacity);
+void channel_retain(Channel* channel);
+void channel_release(Channel* channel);
+int channel_capacity(Channel* channel);
+
+/* Handle object for the current isolate; takes over one reference */
+ObjChannel* channel_wrap(Channel* channel);
+
+/* Queue one message, parking while the channel is full. On CHANNEL_OK
+   the channel owns the message and buffer is left empty. */
+ChannelStatus channel_send(Channel* channel, CloneBuffer* message);
+
+/* Take the oldest message into message, parking while the channel is
+   empty if block is set */
+ChannelStatus channel_recv(Channel* channel, CloneBuffer* message, bool block);
+
+/* Wake everything parked; later sends fail, receives drain what is left */
+void channel_close(Channel* channel);
+
+#endif /* BRISK_CHANNEL_H */
@@ -0,0 +1,62 @@
+/*
+ * Brisk Language - Value Cloning Between Isolates
+ */
+
+#ifndef BRISK_CLONE_H
+#define BRISK_CLONE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "value.h"
+#include "env.h"
+
+/* Large strings and number-only arrays of at least this many bytes are
+   built once by the sender and adopted by the receiver as they are */
+#define CLONE_MOVE_MIN 256
+
+typedef enum {
+    ATTACH_MEMORY,      /* Moved object or element block */
+    ATTACH_CHANNEL,     /* A channel reference */
+    ATTACH_FROZEN       /* A reference to a frozen object, shared as is */
+} CloneAttachmentKind;
+
+/* Something a message owns outside its bytes */
+typedef struct {
+    void* pointer;
+    CloneAttachmentKind kind;
+} CloneAttachment;
+
+/* Serialized value graphs. The bytes are written in one isolate and read
+   in another, so the buffer uses malloc directly rather than the
+   per-isolate allocation counters. */
+typedef struct {
+    uint8_t* data;
+    size_t length;
+    size_t capacity;
+    CloneAttachment* attachments;
+    int attachment_count;
+    int attachment_capacity;
+} CloneBuffer;
+
+void clone_buffer_init(CloneBuffer* buffer);
+
+/* Release the buffer and whatever its unread messages still own */
+void clone_buffer_free(CloneBuffer* buffer);
+
+/* Append one message holding value. Shared and cyclic objects are written
+   once and referenced after that. Functions carry their captured
+   environments; global is the sender's global scope, which maps to the
+   receiver's. With module set, the contents of global are sent too and
+   values that cannot cross (files, pointers, C functions) become nil;
+   otherwise they fail with a message in error. Messages without module
+   set move large strings and number arrays and must be read only once.
+   Frozen objects are never copied: every reader gets the same object. */
+bool clone_write(CloneBuffer* buffer, Value value, Environment* global,
+                 bool module, char* error, int error_size);
+
+/* Rebuild the message at offset in the current isolate. Returns an owned
+   reference; global is the receiver's global scope. */
+Value clone_read(CloneBuffer* buffer, size_t offset, Environment* global);
+
+#endif /* BRISK_CLONE_H */
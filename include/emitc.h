@@ -0,0 +1,29 @@
+/*
+ * Brisk Language - C Code Generator
+ * Translates a program into C that runs it through the interpreter's own
+ * operations (aot.h), so it can be built into a standalone executable.
+ */
+
+#ifndef BRISK_EMITC_H
+#define BRISK_EMITC_H
+
+#include <stdbool.h>
+#include "ast.h"
+
+/* Write program as C source to path. Modules it imports are read and
+   compiled in now, relative to the current directory the way the
+   interpreter looks for them; headers are read now to compile direct
+   calls of their functions, and again when the program starts. Returns
+   false after printing an error. */
+bool emit_c(AstNode* program, const char* path);
+
+/* Parse the script at script_path and write it as C to c_path; 0 on
+   success, 1 after printing an error */
+int emit_c_file(const char* script_path, const char* c_path);
+
+/* Build c_path into an executable with $CC (default cc), linked against
+   build/libbrisk.a of the source tree in $BRISK_HOME, or of the directory
+   this brisk binary is in */
+int emit_c_build(const char* c_path, const char* binary_path);
+
+#endif /* BRISK_EMITC_H */
@@ -29,4 +29,11 @@ bool env_is_const(Environment* env, const char* name, int length);
 /* Get from specific scope (no parent lookup) */
 bool env_get_local(Environment* env, const char* name, int length, Value* value);
 
+/* The same operations on a name already interned, as compiled programs
+   keep their names (aot.h) */
+bool env_define_key(Environment* env, ObjString* key, Value value, bool is_const);
+bool env_get_key(Environment* env, ObjString* key, Value* value);
+bool env_set_key(Environment* env, ObjString* key, Value value);
+bool env_is_const_key(Environment* env, ObjString* key);
+
 #endif /* BRISK_ENV_H */
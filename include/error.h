@@ -28,9 +28,7 @@ typedef struct {
     int column;
 } BriskError;
 
-/* Global error state */
-extern BriskError last_error;
-extern bool had_error;
+/* The last error and its flag are kept per isolate (isolate.h) */
 
 /* Set error */
 void error_set(ErrorType type, const char* file, int line, int column, const char* fmt, ...);
@@ -0,0 +1,65 @@
+/*
+ * Brisk Language - Event Loop
+ */
+
+#ifndef BRISK_EVENT_H
+#define BRISK_EVENT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "interp.h"
+
+/* Default most bytes one fd_read returns */
+#define EVENT_READ_MAX 65536
+
+typedef struct EventLoop EventLoop;
+
+/* Start fn(args) as a coroutine. It runs once the current flow waits
+   (await, sleep or blocked I/O), and the loop keeps it alive until it
+   returns. */
+ObjTask* event_spawn(Interpreter* interp, ObjFunction* fn, int arg_count, Value* args);
+
+/* The operations below park the running coroutine and let others run. When
+   called outside any coroutine they run the loop until they can go on.
+   They return false if a runtime error was reported meanwhile. */
+
+/* Wait for task to return and store its return value in out */
+bool event_await(Interpreter* interp, ObjTask* task, Value* out);
+
+bool event_sleep(Interpreter* interp, int64_t ns);
+
+/* Wait until fd is readable (or writable) */
+bool event_wait_fd(Interpreter* interp, int fd, bool write);
+
+/* Non-blocking descriptors: every one made here is O_NONBLOCK and
+   close-on-exec, and reports failure as -1 (or nil) rather than an error */
+bool event_pipe(int fds[2]);
+bool event_socketpair(int fds[2]);
+int event_unix_listen(const char* path);
+int event_unix_connect(Interpreter* interp, const char* path);
+int event_accept(Interpreter* interp, int fd);
+
+/* Up to max bytes as an uninterned string, "" at end of input, nil on error */
+Value event_read(Interpreter* interp, int fd, int max);
+
+/* Write everything, waiting whenever the descriptor is full. Returns the
+   number of bytes written or -1. */
+int64_t event_write(Interpreter* interp, int fd, const char* chars, size_t length);
+
+/* Close fd, waking any coroutine waiting on it */
+void event_close(Interpreter* interp, int fd);
+
+/* Run command under /bin/sh with pipes to its stdin and from its stdout */
+int event_process(const char* command, int* input, int* output);
+
+/* Wait for a child to exit; its exit code, 128 + signal, or -1 */
+int event_wait_process(Interpreter* interp, int pid);
+
+/* Drop unfinished coroutines and the loop itself */
+void event_loop_free(EventLoop* loop);
+
+/* Release what a task holds (called when it is freed) */
+void task_free(ObjTask* task);
+
+#endif /* BRISK_EVENT_H */
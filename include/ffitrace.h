@@ -0,0 +1,32 @@
+/*
+ * Brisk Language - FFI Call Tracer
+ * Latency histograms for C function calls, split into marshalling the
+ * arguments, the call itself and converting the result back. Turned on by
+ * setting BRISK_FFI_TRACE in the environment.
+ */
+
+#ifndef BRISK_FFITRACE_H
+#define BRISK_FFITRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cffi.h"
+
+/* Set once at startup; cffi_call only reads the clock when it is true */
+extern bool ffi_tracing;
+
+/* Turn tracing on if BRISK_FFI_TRACE is set to anything but "" or "0" */
+void ffi_trace_configure(void);
+
+/* Add one call's phase times, in nanoseconds, to desc's histograms */
+void ffi_trace_record(CFunctionDesc* desc, uint64_t marshal_ns,
+                      uint64_t call_ns, uint64_t unmarshal_ns);
+
+/* Print every traced function's call count and latency percentiles to
+   stderr, the most expensive first */
+void ffi_trace_report(void);
+
+/* Print the final report and free the histograms */
+void ffi_trace_finish(void);
+
+#endif /* BRISK_FFITRACE_H */
@@ -0,0 +1,30 @@
+/*
+ * Brisk Language - File I/O
+ */
+
+#ifndef BRISK_FILEIO_H
+#define BRISK_FILEIO_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "value.h"
+
+/* Read a whole file through mmap. The result is not interned so large
+   contents can be freed. Returns NULL if the file cannot be read. */
+ObjString* file_read_all(const char* path);
+
+/* Write (or append) a buffer to a file in one call */
+bool file_write_all(const char* path, const char* chars, size_t length, bool append);
+
+/* Open a line reader, or a buffered writer when write is set.
+   Returns NULL if the file cannot be opened. */
+ObjFile* file_open(const char* path, bool write, bool append);
+
+/* Next line without its line ending, as an uninterned string.
+   Returns NULL at end of file. */
+ObjString* file_read_line(ObjFile* file);
+
+/* Flush (writers) and close; safe to call more than once */
+void file_close(ObjFile* file);
+
+#endif /* BRISK_FILEIO_H */
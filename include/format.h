@@ -0,0 +1,16 @@
+/*
+ * Brisk Language - Value Formatting
+ */
+
+#ifndef BRISK_FORMAT_H
+#define BRISK_FORMAT_H
+
+#include "value.h"
+#include "ast.h"
+
+/* Format a value according to spec into out without allocating.
+   Returns the length of the full result; if that exceeds capacity the
+   output is incomplete and the caller should retry with a larger buffer. */
+int format_value(char* out, int capacity, Value value, const FormatSpec* spec);
+
+#endif /* BRISK_FORMAT_H */
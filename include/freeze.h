@@ -0,0 +1,18 @@
+/*
+ * Brisk Language - Frozen Values
+ */
+
+#ifndef BRISK_FREEZE_H
+#define BRISK_FREEZE_H
+
+#include <stdbool.h>
+#include "value.h"
+
+/* Mark value and everything reachable from it immutable. Frozen objects
+   count references atomically, so other isolates can share them instead
+   of copying. Only strings, arrays and tables (and plain values) can be
+   frozen; on anything else nothing is changed and a message is written
+   to error. */
+bool freeze_value(Value value, char* error, int error_size);
+
+#endif /* BRISK_FREEZE_H */
@@ -0,0 +1,43 @@
+/*
+ * Brisk Language - Generators
+ */
+
+#ifndef BRISK_GENERATOR_H
+#define BRISK_GENERATOR_H
+
+#include <stdbool.h>
+#include "interp.h"
+
+/* C stack reserved for each generator body, as deep as a default main
+   thread's. Only the pages it touches are ever committed. */
+#define GENERATOR_STACK_SIZE (8 * 1024 * 1024)
+
+typedef struct Generator Generator;
+
+typedef enum {
+    GENERATOR_YIELDED,
+    GENERATOR_DONE,
+    GENERATOR_ERROR
+} GeneratorStatus;
+
+/* A call of a generator function; its body does not start until the
+   first resume */
+Generator* generator_create(ObjFunction* fn, int arg_count, Value* args);
+
+/* Run the body on its own stack until the next yield, storing the value
+   in out, or until it returns, storing its return value */
+GeneratorStatus generator_resume(Interpreter* interp, Generator* generator, Value* out);
+
+/* Pause the running generator, handing value to whoever resumed it */
+void generator_yield(Interpreter* interp, Value value);
+
+/* Switch back to whoever resumed generator, from its body or from any
+   generator nested inside it; the next resume continues from here. Lets a
+   coroutine wait while deep inside generators it is pulling. */
+void generator_suspend(Generator* generator);
+
+/* Free a generator. A body paused at a yield is dropped where it stands;
+   its pending defers do not run. */
+void generator_free(Generator* generator);
+
+#endif /* BRISK_GENERATOR_H */
@@ -0,0 +1,40 @@
+/*
+ * Brisk Language - Allocation Site Profiler
+ */
+
+#ifndef BRISK_HEAP_H
+#define BRISK_HEAP_H
+
+#include <stddef.h>
+#include "interp.h"
+
+/* Track where the next script run allocates (--heap-profile) */
+void heap_profile_configure(void);
+
+/* Report objects that outlive the next script's interpreter (--leak-check) */
+void heap_leak_configure(void);
+
+/* Start tagging interp's objects with the line running when each was
+   made, if heap_profile_configure or heap_leak_configure was called */
+void heap_profile_start(Interpreter* interp);
+
+/* Print the final report and stop tracking, unless a leak check needs
+   tracking to go on through interp_destroy */
+void heap_profile_stop(Interpreter* interp);
+
+/* After interp_destroy: print the objects still alive by type and by
+   allocation site, stop tracking and return how many there were */
+int heap_leak_check(void);
+
+/* Print the allocation sites holding the most live memory, then how much
+   is reachable from each variable, to stderr. The reachable view works
+   even when allocations are not being tracked. */
+void heap_report(Interpreter* interp);
+
+/* Allocation hooks for value.c. Only objects made while heap_isolate is
+   current are tracked, so the check costs one comparison otherwise. */
+extern Isolate* heap_isolate;
+void heap_track(Object* obj, size_t size);
+void heap_untrack(Object* obj);
+
+#endif /* BRISK_HEAP_H */
@@ -8,6 +8,8 @@
 #include "ast.h"
 #include "value.h"
 #include "env.h"
+#include "output.h"
+#include "isolate.h"
 #include <stdbool.h>
 
 /* Defer stack entry */
@@ -16,8 +18,17 @@ typedef struct DeferEntry {
     struct DeferEntry* next;
 } DeferEntry;
 
+/* One active call, linked from the innermost out through the C stack so a
+   sampling profiler can walk it from a signal handler */
+typedef struct CallFrame {
+    const char* name;       /* NULL for anonymous functions */
+    int def_line;           /* Where the function was defined; 0 for natives */
+    int line;               /* Statement running in this frame */
+    struct CallFrame* caller;
+} CallFrame;
+
 /* Interpreter structure */
-typedef struct {
+typedef struct Interpreter {
     Environment* global;
     Environment* current;
     Value return_value;
@@ -28,10 +39,23 @@ typedef struct {
     bool had_error;
     char error_message[256];
     int error_line;
+    int call_line;          /* Line of the innermost call (for native errors) */
+    CallFrame* frame;       /* Innermost call */
+    CallFrame script_frame; /* Top-level code, below every call */
     DeferEntry* defer_stack;
+    struct Generator* generator;    /* Innermost generator body running */
+    Object* fresh_generator;        /* Iterator the last call returned from a generator
+                                       function; nothing owns its creation reference */
+    struct EventLoop* loop;         /* Coroutine scheduler, made on first use */
+    Output out;             /* Buffered stdout for print/println */
+    Isolate isolate;        /* Heap, intern table and error state */
+    Isolate* previous_isolate;  /* Restored by interp_destroy */
+    ObjString** constants;  /* A compiled program's strings, interned on first use (aot.h) */
+    int constant_count;
 } Interpreter;
 
-/* Initialize interpreter */
+/* Initialize interpreter; its isolate becomes current on this thread until
+   interp_destroy, so values must not be shared with other interpreters */
 void interp_init(Interpreter* interp);
 
 /* Destroy interpreter */
@@ -52,7 +76,42 @@ int interpret(const char* source);
 /* Run from file */
 int interpret_file(const char* path);
 
+/* Run a program compiled by --emit-c; its body gets NULL arguments */
+int interpret_compiled(CompiledBody program);
+
+/* Execute @import of a Brisk module or a C header */
+void interp_import(Interpreter* interp, const char* path, int line);
+
+/* Call a function value (Brisk, native or C) from native code */
+Value brisk_call(Interpreter* interp, Value callee, int arg_count, Value* args);
+
+/* Run a Brisk function's body with arguments already checked against its
+   arity, even a generator's (its own stack calls this on the first resume) */
+Value call_function(Interpreter* interp, ObjFunction* fn, Value* args);
+
+/* Call a function value with already-evaluated arguments */
+Value call_value(Interpreter* interp, Value callee, int arg_count, Value* args, int line);
+
 /* Runtime error */
 void runtime_error(Interpreter* interp, int line, const char* format, ...);
 
+/* The operations eval performs, also called directly by compiled programs.
+   Each reports a runtime error at line and returns nil if it fails. */
+Value variable_get(Interpreter* interp, ObjString* name, int line);
+void variable_set(Interpreter* interp, ObjString* name, Value value, int line);
+void variable_define(Interpreter* interp, ObjString* name, Value value,
+                     bool is_const, int line);
+Value binary_op(Interpreter* interp, TokenType op, Value left, Value right, int line);
+Value unary_op(Interpreter* interp, TokenType op, Value operand, int line);
+Value index_get(Interpreter* interp, Value object, Value index, int line);
+void index_set(Interpreter* interp, Value object, Value index, Value value, int line);
+Value field_get(Interpreter* interp, Value object, ObjString* key, int line);
+void field_set(Interpreter* interp, Value object, ObjString* key, Value value, int line);
+Value range_array(Interpreter* interp, Value start, Value end, int line);
+Value address_of(Interpreter* interp, Value operand, int line);
+
+/* Build an interpolated string, values[i] standing in for each part that
+   is an expression */
+Value interpolate(const InterpPart* parts, int count, const Value* values);
+
 #endif /* BRISK_INTERP_H */
@@ -0,0 +1,49 @@
+/*
+ * Brisk Language - Isolates
+ */
+
+#ifndef BRISK_ISOLATE_H
+#define BRISK_ISOLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "value.h"
+#include "error.h"
+
+/* Runtime state that would otherwise be process-wide. Each interpreter
+   owns one and objects never cross between them, so several interpreters
+   can run on separate threads without locking. The allocation and intern
+   paths find it through a thread-local pointer. */
+typedef struct Isolate {
+    Object* all_objects;        /* Every tracked object allocated here */
+    ObjTable* string_table;     /* Interned strings */
+    size_t bytes_allocated;     /* Currently live */
+    size_t allocation_count;    /* Cumulative number of allocations */
+    size_t allocated_total;     /* Cumulative bytes allocated */
+    BriskError last_error;
+    bool had_error;
+    ObjFile* open_files;        /* Flushed on exit if never closed */
+} Isolate;
+
+/* Prepare an empty isolate */
+void isolate_init(Isolate* isolate);
+
+/* Close its files and release the intern table. Must be the current
+   isolate so the memory is accounted against it. */
+void isolate_free(Isolate* isolate);
+
+/* Make an isolate current on this thread (NULL goes back to the thread's
+   own default). Returns the previous one so it can be restored. */
+Isolate* isolate_enter(Isolate* isolate);
+
+/* Current isolate; code running outside any interpreter gets a default
+   one per thread */
+extern __thread Isolate* isolate_active;
+extern __thread Isolate isolate_thread;
+
+static inline Isolate* isolate_current(void) {
+    Isolate* isolate = isolate_active;
+    return isolate != NULL ? isolate : &isolate_thread;
+}
+
+#endif /* BRISK_ISOLATE_H */
@@ -0,0 +1,40 @@
+/*
+ * Brisk Language - Iterators
+ */
+
+#ifndef BRISK_ITER_H
+#define BRISK_ITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "interp.h"
+
+struct Generator;
+
+/* Integers from start up to end (exclusive) by step, or down to it when
+   step is negative */
+ObjIterator* iterator_range(int64_t start, int64_t end, int64_t step);
+
+/* The values a generator call yields; the iterator owns the generator */
+ObjIterator* iterator_generator(struct Generator* generator);
+
+/* Lazy stages over another iterator */
+ObjIterator* iterator_map(ObjIterator* source, Value fn);
+ObjIterator* iterator_filter(ObjIterator* source, Value fn);
+ObjIterator* iterator_take(ObjIterator* source, int64_t count);
+
+/* Iterator over an array, a string (one-character strings), a table
+   ([key, value] pairs, or what its next function returns until nil if it
+   has one), a file from lines(), or an iterator itself. Returns a new
+   reference, or NULL if the value cannot be iterated. */
+ObjIterator* iterator_of(Value value);
+
+/* Store the next value in out and return true, or return false once the
+   sequence is exhausted or a runtime error has been reported. The iterator
+   keeps the value alive until the following call. */
+bool iterator_next(Interpreter* interp, ObjIterator* iterator, Value* out);
+
+/* Release what an iterator holds (called when it is freed) */
+void iterator_free(ObjIterator* iterator);
+
+#endif /* BRISK_ITER_H */
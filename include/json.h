@@ -0,0 +1,24 @@
+/*
+ * Brisk Language - JSON
+ */
+
+#ifndef BRISK_JSON_H
+#define BRISK_JSON_H
+
+#include <stdbool.h>
+#include "value.h"
+
+/* Nesting limit for both directions; also stops cyclic arrays/tables */
+#define JSON_MAX_DEPTH 512
+
+/* Parse a whole JSON document: objects become tables, arrays become
+   arrays, integers without a fraction or exponent become ints. On failure
+   returns false and writes a message with the line and column to error. */
+bool json_parse(const char* text, int length, Value* out,
+                char* error, int error_size);
+
+/* Serialize a value as compact JSON. Returns NULL and writes a message to
+   error if the value holds something JSON cannot represent. */
+ObjString* json_stringify(Value value, char* error, int error_size);
+
+#endif /* BRISK_JSON_H */
@@ -7,14 +7,17 @@
 
 #include <stddef.h>
 
-/* Memory allocation tracking */
-extern size_t bytes_allocated;
+/* Allocation counters live in the current isolate (isolate.h) */
 
 /* Allocation functions */
 void* mem_alloc(size_t size);
 void* mem_realloc(void* ptr, size_t old_size, size_t new_size);
 void mem_free(void* ptr, size_t size);
 
+/* Count a block that came from plain malloc (another thread's message)
+   as allocated here, so mem_free can release it later */
+void mem_adopt(size_t size);
+
 /* Debug helpers */
 void mem_print_stats(void);
 
@@ -0,0 +1,31 @@
+/*
+ * Brisk Language - Number Conversion
+ */
+
+#ifndef BRISK_NUMCONV_H
+#define BRISK_NUMCONV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Buffer sizes that always fit a formatted number */
+#define NUM_INT_BUFFER 24
+#define NUM_DOUBLE_BUFFER 32
+
+/* Parse flags */
+#define NUM_SEPARATORS 0x1   /* Allow '_' between digits */
+#define NUM_C_PREFIXES 0x2   /* 0x hex and leading-zero octal, like C literals */
+
+/* Write n in decimal (no terminator). Returns the length. */
+int num_format_int(char* out, int64_t n);
+
+/* Write the shortest decimal form of d that reads back as the same
+   double (no terminator). Returns the length. */
+int num_format_double(char* out, double d);
+
+/* Parse a whole span as an integer / a float. Leading whitespace is
+   skipped; anything else left over makes the parse fail. */
+bool num_parse_int(const char* chars, int length, int flags, int64_t* out);
+bool num_parse_double(const char* chars, int length, int flags, double* out);
+
+#endif /* BRISK_NUMCONV_H */
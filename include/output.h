@@ -0,0 +1,50 @@
+/*
+ * Brisk Language - Buffered Output
+ */
+
+#ifndef BRISK_OUTPUT_H
+#define BRISK_OUTPUT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "value.h"
+
+/* When buffered output reaches the stream */
+typedef enum {
+    OUTPUT_LINE,    /* After each print that wrote a newline (default for a TTY) */
+    OUTPUT_BLOCK,   /* When the buffer fills (default otherwise) */
+    OUTPUT_MANUAL   /* Only on flush() or exit; the buffer grows as needed */
+} OutputMode;
+
+/* Output buffer (interpreter stdout and file writers) */
+typedef struct Output {
+    FILE* stream;
+    char* data;
+    size_t length;
+    size_t capacity;
+    OutputMode mode;
+    bool newline;           /* A newline was written since the last flush */
+} Output;
+
+/* Set up a buffer for stream; the mode depends on whether it is a TTY */
+void output_init(Output* out, FILE* stream);
+
+/* Flush and release the buffer */
+void output_free(Output* out);
+
+/* Write buffered data to the stream */
+void output_flush(Output* out);
+
+/* Append raw bytes / a formatted value (arrays are printed recursively) */
+void output_write(Output* out, const char* chars, size_t length);
+void output_value(Output* out, Value value);
+
+/* Called after a print-like operation: flushes according to the mode */
+void output_end(Output* out);
+
+/* Mode names: "line", "block", "manual" */
+bool output_mode_parse(const char* name, OutputMode* mode);
+const char* output_mode_name(OutputMode mode);
+
+#endif /* BRISK_OUTPUT_H */
@@ -0,0 +1,43 @@
+/*
+ * Brisk Language - Parallel Map
+ */
+
+#ifndef BRISK_PARALLEL_H
+#define BRISK_PARALLEL_H
+
+#include <stdbool.h>
+#include "interp.h"
+
+/* Upper bound on worker threads for one call */
+#define PARALLEL_MAX_WORKERS 256
+
+/* Call fn on every element of array using worker threads, each running
+   its own interpreter. The function (with the globals it can see) and
+   each element are deep-copied into the workers and the results copied
+   back, so nothing is shared. On success stores a new array in out; on
+   failure writes a message to error. */
+bool parallel_map(Interpreter* interp, Value fn, ObjArray* array, int workers,
+                  Value* out, char* error, int error_size);
+
+/* Number of online CPUs, at least 1 */
+int parallel_cpu_count(void);
+
+/* Run fn(args...) on a new thread with its own interpreter, copying fn
+   and its globals like parallel_map. Returns NULL and writes error if
+   the arguments cannot be sent. */
+ObjThread* thread_start(Interpreter* interp, Value fn, int arg_count, Value* args,
+                        char* error, int error_size);
+
+/* Wait for the thread and copy its result in; later joins return the
+   same value. Returns false with error set if the function failed. */
+bool thread_join(Interpreter* interp, ObjThread* thread, Value* out,
+                 char* error, int error_size);
+
+/* Free a handle; a thread never joined keeps running detached */
+void thread_free(ObjThread* thread);
+
+/* Whether any started thread is still running (it may be using the
+   program's AST) */
+bool thread_any_running(void);
+
+#endif /* BRISK_PARALLEL_H */
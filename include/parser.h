@@ -16,6 +16,8 @@ typedef struct {
     Token previous;
     bool had_error;
     bool panic_mode;
+    int function_depth;     /* Nesting of fn bodies being parsed */
+    bool saw_yield;         /* The innermost fn body contains yield */
 } Parser;
 
 /* Initialize parser */
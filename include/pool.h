@@ -0,0 +1,28 @@
+/*
+ * Brisk Language - Work-Stealing Pool
+ */
+
+#ifndef BRISK_POOL_H
+#define BRISK_POOL_H
+
+#include <stdint.h>
+
+/* Upper bound on threads in the pool, the caller included */
+#define POOL_MAX_THREADS 256
+
+/* Work on [begin, end) of a pool_for range. Runs on pool threads, which
+   have no isolate: it must not allocate objects or call mem_alloc. */
+typedef void (*PoolFn)(void* context, int64_t begin, int64_t end);
+
+/* Threads that share pool work, counting the caller: BRISK_THREADS if
+   set, otherwise the number of CPUs. 1 means everything runs serially. */
+int pool_size(void);
+
+/* Call fn over [0, count) and return once all of it is done. The range is
+   halved until pieces are at most grain long, and idle threads steal the
+   largest pieces left; the caller works too instead of just waiting. A
+   range of at most grain runs inline. Piece boundaries depend only on
+   count and grain, never on the thread count. May be nested. */
+void pool_for(int64_t count, int64_t grain, PoolFn fn, void* context);
+
+#endif /* BRISK_POOL_H */
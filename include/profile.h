@@ -0,0 +1,25 @@
+/*
+ * Brisk Language - Sampling Profiler
+ */
+
+#ifndef BRISK_PROFILE_H
+#define BRISK_PROFILE_H
+
+#include <stdbool.h>
+#include "interp.h"
+
+/* Samples per second of CPU time unless --profile-rate says otherwise */
+#define PROFILE_DEFAULT_RATE 1000
+
+/* Profile the next script run, writing collapsed stacks to path */
+void profile_configure(const char* path, int rate);
+
+/* Start sampling interp's calls on this thread if a profile was asked for;
+   false if the output file could not be opened */
+bool profile_start(Interpreter* interp);
+
+/* Stop sampling, write the collapsed stacks and print the hottest functions
+   and lines to stderr. Does nothing unless profile_start began a profile. */
+void profile_stop(Interpreter* interp);
+
+#endif /* BRISK_PROFILE_H */
@@ -0,0 +1,21 @@
+/*
+ * Brisk Language - Sorting
+ */
+
+#ifndef BRISK_SORT_H
+#define BRISK_SORT_H
+
+#include <stdbool.h>
+#include "interp.h"
+
+/* Sort values in place. With a NIL comparator the default ordering is
+   used (numbers, strings or bools); otherwise cmp(a, b) is called and
+   should return a negative number (or true) when a sorts before b.
+   Returns false if a comparison raised a runtime error. */
+bool sort_values(Interpreter* interp, Value* values, int count, Value cmp, bool stable);
+
+/* Stable sort of values in place by precomputed keys (default ordering).
+   keys[i] belongs to values[i]; keys are permuted alongside. */
+bool sort_values_by_keys(Interpreter* interp, Value* values, Value* keys, int count);
+
+#endif /* BRISK_SORT_H */
@@ -0,0 +1,53 @@
+/*
+ * Brisk Language - Execution Statistics
+ * Counters for where interpretation effort goes. They exist only in builds
+ * made with -DBRISK_STATS (make stats); elsewhere STAT_INC is empty.
+ */
+
+#ifndef BRISK_STATS_H
+#define BRISK_STATS_H
+
+#ifdef BRISK_STATS
+
+#include <stdint.h>
+#include "ast.h"
+#include "value.h"
+
+/* env_get hits by scopes walked; the last bucket holds that many or more */
+#define STATS_DEPTHS 8
+
+typedef struct {
+    uint64_t nodes[NODE_TYPE_COUNT];    /* eval and exec calls by node type */
+    uint64_t env_depth[STATS_DEPTHS];
+    uint64_t env_misses;                /* env_get found nothing */
+    uint64_t environments;              /* env_create calls */
+    uint64_t table_lookups;
+    uint64_t table_probes;              /* Slots looked at by those lookups */
+    uint64_t strings;                   /* Requests to make a string */
+    uint64_t intern_hits;               /* Requests the intern table answered */
+    uint64_t ffi_calls;
+    uint64_t objects[OBJ_TYPE_COUNT];   /* Allocations by type */
+} Stats;
+
+/* This thread's counts, folded into the totals by stats_merge */
+extern __thread Stats stats_thread;
+
+#define STAT_INC(field) (stats_thread.field++)
+
+/* Add this thread's counts to the process totals and reset them */
+void stats_merge(void);
+
+/* Report the totals at exit: text on stderr, and JSON to json_path if
+   it is not NULL */
+void stats_enable(const char* json_path);
+
+/* Print the report if stats_enable was called */
+void stats_report(void);
+
+#else
+
+#define STAT_INC(field) ((void)0)
+
+#endif /* BRISK_STATS */
+
+#endif /* BRISK_STATS_H */
@@ -0,0 +1,29 @@
+/*
+ * Brisk Language - Substring Search
+ */
+
+#ifndef BRISK_STRSEARCH_H
+#define BRISK_STRSEARCH_H
+
+/* Find the first occurrence of needle in haystack at or after start.
+   Works on length-delimited data (embedded NULs are fine).
+   Returns the byte index or -1 if not found. */
+int str_find(const char* haystack, int haystack_len,
+             const char* needle, int needle_len, int start);
+
+/* Find the last occurrence of needle in haystack. Returns -1 if not found. */
+int str_rfind(const char* haystack, int haystack_len,
+              const char* needle, int needle_len);
+
+/* Count non-overlapping occurrences of a non-empty needle */
+int str_count(const char* haystack, int haystack_len,
+              const char* needle, int needle_len);
+
+/* Positions of the non-overlapping occurrences of a non-empty needle, as
+   repeated str_find calls would report them. Stores a mem_alloc'd array
+   in out (NULL if there are none) and returns the count. Long haystacks
+   are searched in parallel. */
+int str_find_all(const char* haystack, int haystack_len,
+                 const char* needle, int needle_len, int** out);
+
+#endif /* BRISK_STRSEARCH_H */
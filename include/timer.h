@@ -0,0 +1,16 @@
+/*
+ * Brisk Language - Timers
+ */
+
+#ifndef BRISK_TIMER_H
+#define BRISK_TIMER_H
+
+#include <stdint.h>
+
+/* Monotonic wall-clock time in nanoseconds (arbitrary epoch) */
+uint64_t timer_now_ns(void);
+
+/* CPU time consumed by the process in nanoseconds */
+uint64_t timer_cpu_ns(void);
+
+#endif /* BRISK_TIMER_H */
@@ -16,6 +16,7 @@ typedef enum {
     TOKEN_INT,
     TOKEN_FLOAT,
     TOKEN_STRING,
+    TOKEN_FSTRING,
     TOKEN_TRUE,
     TOKEN_FALSE,
     TOKEN_NIL,
@@ -36,6 +37,7 @@ typedef enum {
     TOKEN_CONTINUE,
     TOKEN_MATCH,
     TOKEN_DEFER,
+    TOKEN_YIELD,
     TOKEN_AND,
     TOKEN_OR,
     TOKEN_NOT,
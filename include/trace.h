@@ -0,0 +1,35 @@
+/*
+ * Brisk Language - Trace Events
+ * Spans for startup phases, imports and slow calls, written at exit in the
+ * Chrome trace-event format that chrome://tracing and Perfetto load.
+ */
+
+#ifndef BRISK_TRACE_H
+#define BRISK_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* True once --trace asked for spans; every hook tests it first */
+extern bool trace_enabled;
+
+/* True if Brisk function calls are traced too (--trace-calls) */
+extern bool trace_calls;
+
+/* Record spans and write them to path when the process exits. Brisk calls
+   taking at least call_threshold_us microseconds are recorded as well,
+   unless it is negative. */
+void trace_configure(const char* path, double call_threshold_us);
+
+/* Start time for trace_span; 0 when tracing is off */
+uint64_t trace_clock(void);
+
+/* Record a span from started until now. category groups spans in the
+   viewer ("phase", "module", "header", ...); name is copied. */
+void trace_span(const char* category, const char* name, uint64_t started);
+
+/* Record a call of the function defined at def_line if it took at least
+   the --trace-calls threshold. name is NULL for anonymous functions. */
+void trace_call(const char* name, int def_line, uint64_t started);
+
+#endif /* BRISK_TRACE_H */
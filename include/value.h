@@ -5,6 +5,7 @@
 #ifndef BRISK_VALUE_H
 #define BRISK_VALUE_H
 
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "ast.h"
@@ -19,6 +20,11 @@ typedef struct ObjNative ObjNative;
 typedef struct ObjPointer ObjPointer;
 typedef struct ObjCStruct ObjCStruct;
 typedef struct ObjCFunction ObjCFunction;
+typedef struct ObjFile ObjFile;
+typedef struct ObjChannel ObjChannel;
+typedef struct ObjThread ObjThread;
+typedef struct ObjIterator ObjIterator;
+typedef struct ObjTask ObjTask;
 typedef struct Environment Environment;
 
 /* Value types */
@@ -39,9 +45,16 @@ typedef enum {
     OBJ_NATIVE,
     OBJ_POINTER,
     OBJ_CSTRUCT,
-    OBJ_CFUNCTION
+    OBJ_CFUNCTION,
+    OBJ_FILE,
+    OBJ_CHANNEL,
+    OBJ_THREAD,
+    OBJ_ITERATOR,
+    OBJ_TASK
 } ObjectType;
 
+#define OBJ_TYPE_COUNT (OBJ_TASK + 1)
+
 /* Value structure */
 typedef struct {
     ValueType type;
@@ -59,6 +72,8 @@ struct Object {
     int ref_count;
     Object* next;  /* For GC list */
     bool marked;   /* For cycle detection */
+    bool frozen;   /* Immutable and shareable: ref_count changes atomically */
+    uint32_t heap_slot;  /* Heap profiler's index for it plus one; 0 if untracked */
 };
 
 /* String object */
@@ -95,6 +110,16 @@ struct ObjTable {
 /* Native function type */
 typedef Value (*NativeFn)(int arg_count, Value* args);
 
+/* Interpreter-aware native function type (may call back into Brisk
+   and report errors through runtime_error) */
+struct Interpreter;
+typedef Value (*NativeInterpFn)(struct Interpreter* interp, void* user_data,
+                                int arg_count, Value* args);
+
+/* Body of a function compiled to C by --emit-c. It runs in place of the
+   tree walk and binds the arguments itself. */
+typedef void (*CompiledBody)(struct Interpreter* interp, Value* args);
+
 /* Function object */
 struct ObjFunction {
     Object obj;
@@ -104,12 +129,16 @@ struct ObjFunction {
     char** params;           /* Parameter names */
     int* param_lengths;
     Environment* closure;    /* Captured environment */
+    bool is_generator;       /* Calls return an iterator over its yields */
+    CompiledBody compiled;   /* Runs instead of body when set */
 };
 
 /* Native function object */
 struct ObjNative {
     Object obj;
     NativeFn function;
+    NativeInterpFn interp_function;  /* Used instead of function when set */
+    void* user_data;                 /* Passed to interp_function */
     int arity;  /* -1 for variadic */
     const char* name;
 };
@@ -131,6 +160,72 @@ struct ObjCStruct {
     void* data;  /* Raw C memory */
 };
 
+/* File object: a line reader from lines() or a writer from open_writer() */
+struct ObjFile {
+    Object obj;
+    FILE* file;              /* NULL once closed */
+    struct Output* out;      /* Write buffer (writers only) */
+    char* line;              /* Reusable line buffer (readers only) */
+    size_t line_capacity;
+    ObjFile* next_open;      /* Open file list (flushed at exit) */
+    ObjFile* prev_open;
+};
+
+/* Handle to a channel shared between isolates (channel.h) */
+struct ObjChannel {
+    Object obj;
+    struct Channel* channel;
+};
+
+/* Handle to a thread started with thread_start (parallel.h) */
+struct ObjThread {
+    Object obj;
+    struct ThreadState* state;
+    bool joined;
+    Value result;            /* Kept after the first join */
+};
+
+/* What an iterator walks (iter.h) */
+typedef enum {
+    ITER_RANGE,              /* Integers from position to end by step */
+    ITER_ARRAY,
+    ITER_STRING,             /* One-character strings */
+    ITER_TABLE,              /* [key, value] pairs */
+    ITER_LINES,              /* Lines of a file from lines() */
+    ITER_GENERATOR,
+    ITER_OBJECT,             /* A table's next(), until it returns nil */
+    ITER_MAP,
+    ITER_FILTER,
+    ITER_TAKE
+} IteratorKind;
+
+/* Lazy sequence consumed one value at a time by for loops and the
+   iterator builtins */
+struct ObjIterator {
+    Object obj;
+    IteratorKind kind;
+    bool done;
+    Value source;            /* What is walked, or the inner iterator */
+    Value function;          /* map / filter callback, or the object's next */
+    Value current;           /* Last value produced, kept alive until the next */
+    int64_t position;
+    int64_t end;
+    int64_t step;
+    struct Generator* generator;
+};
+
+/* Coroutine started with spawn (event.h) */
+struct ObjTask {
+    Object obj;
+    struct Generator* body;
+    bool done;
+    Value result;
+    ObjTask* next;           /* Ready queue or await list link */
+    ObjTask* waiters;        /* Tasks parked in await on this one */
+    int64_t wake_at;         /* sleep deadline, monotonic ns */
+    int slot;                /* Index among the loop's unfinished tasks */
+};
+
 /* Value creation macros */
 #define NIL_VAL           ((Value){VAL_NIL, {.integer = 0}})
 #define BOOL_VAL(b)       ((Value){VAL_BOOL, {.boolean = (b)}})
@@ -156,6 +251,12 @@ struct ObjCStruct {
 #define IS_POINTER(v)     (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_POINTER)
 #define IS_CSTRUCT(v)     (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_CSTRUCT)
 #define IS_CFUNCTION(v)   (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_CFUNCTION)
+#define IS_FILE(v)        (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_FILE)
+#define IS_CHANNEL(v)     (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_CHANNEL)
+#define IS_THREAD(v)      (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_THREAD)
+#define IS_ITERATOR(v)    (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_ITERATOR)
+#define IS_TASK(v)        (IS_OBJ(v) && OBJ_TYPE(v) == OBJ_TASK)
+#define IS_FROZEN(v)      (IS_OBJ(v) && AS_OBJ(v)->frozen)
 
 /* Value extraction macros */
 #define AS_BOOL(v)        ((v).as.boolean)
@@ -171,6 +272,11 @@ struct ObjCStruct {
 #define AS_POINTER(v)     ((ObjPointer*)AS_OBJ(v))
 #define AS_CSTRUCT(v)     ((ObjCStruct*)AS_OBJ(v))
 #define AS_CFUNCTION(v)   ((ObjCFunction*)AS_OBJ(v))
+#define AS_FILE(v)        ((ObjFile*)AS_OBJ(v))
+#define AS_CHANNEL(v)     ((ObjChannel*)AS_OBJ(v))
+#define AS_THREAD(v)      ((ObjThread*)AS_OBJ(v))
+#define AS_ITERATOR(v)    ((ObjIterator*)AS_OBJ(v))
+#define AS_TASK(v)        ((ObjTask*)AS_OBJ(v))
 
 /* Get number as double (works for int or float) */
 #define AS_NUMBER(v)      (IS_INT(v) ? (double)AS_INT(v) : AS_FLOAT(v))
@@ -182,14 +288,23 @@ void obj_decref(Object* obj);
 /* Object allocation */
 Object* allocate_object(size_t size, ObjectType type);
 
+/* Take an object built with malloc outside any isolate (a moved message
+   part) into the current one */
+void object_adopt(Object* obj, size_t size);
+
 /* String operations */
 ObjString* string_create(const char* chars, int length);
+ObjString* string_create_hashed(const char* chars, int length, uint32_t hash);
+ObjString* string_create_uninterned(const char* chars, int length);
+ObjString* string_allocate(int length);
+ObjString* string_finish(ObjString* string);
 ObjString* string_concat(ObjString* a, ObjString* b);
 uint32_t string_hash(const char* chars, int length);
 ObjString* string_intern(ObjString* string);
 
 /* Array operations */
 ObjArray* array_create(void);
+void array_reserve(ObjArray* array, int capacity);
 void array_push(ObjArray* array, Value value);
 Value array_pop(ObjArray* array);
 Value array_get(ObjArray* array, int index);
@@ -200,6 +315,7 @@ int array_length(ObjArray* array);
 ObjTable* table_create(void);
 bool table_get(ObjTable* table, ObjString* key, Value* value);
 bool table_set(ObjTable* table, ObjString* key, Value value, bool is_const);
+void table_reserve(ObjTable* table, int count);
 bool table_delete(ObjTable* table, ObjString* key);
 ObjArray* table_keys(ObjTable* table);
 ObjArray* table_values(ObjTable* table);
@@ -212,6 +328,8 @@ ObjFunction* function_create(const char* name, int name_len,
 
 /* Native function operations */
 ObjNative* native_create(NativeFn function, int arity, const char* name);
+ObjNative* native_create_interp(NativeInterpFn function, void* user_data,
+                                int arity, const char* name);
 
 /* Pointer operations */
 ObjPointer* pointer_create(void* ptr, const char* type_name);
@@ -220,13 +338,20 @@ ObjPointer* pointer_create(void* ptr, const char* type_name);
 bool value_equals(Value a, Value b);
 void value_print(Value value);
 char* value_to_string(Value value);
+
+/* Text of a value without allocating: strings point at their own chars,
+   everything else is written into buffer (VALUE_TEXT_BUFFER bytes).
+   Sets *text and returns the length. */
+#define VALUE_TEXT_BUFFER 32
+int value_text(Value value, char* buffer, const char** text);
 bool value_is_truthy(Value value);
 const char* value_type_name(Value value);
+const char* object_type_name(ObjectType type);
 
 /* Free object */
 void free_object(Object* obj);
 
-/* Global object list for GC */
-extern Object* all_objects;
+/* Bytes an object owns: its struct plus element or entry storage */
+size_t object_size(Object* obj);
 
 #endif /* BRISK_VALUE_H */
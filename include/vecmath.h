@@ -0,0 +1,43 @@
+/*
+ * Brisk Language - Numeric Array Kernels
+ */
+
+#ifndef BRISK_VECMATH_H
+#define BRISK_VECMATH_H
+
+#include "value.h"
+
+/* What an array holds, found in one pass before picking a loop */
+typedef enum {
+    VEC_INT,      /* Only ints (or empty) */
+    VEC_FLOAT,    /* Only floats */
+    VEC_MIXED,    /* Ints and floats */
+    VEC_INVALID   /* Something that is not a number */
+} VecKind;
+
+VecKind vec_kind(const Value* values, int count);
+
+/* Kind of an array operand combined with a scalar or second array */
+VecKind vec_kind_join(VecKind a, VecKind b);
+
+/* Reductions; kind must come from vec_kind and not be VEC_INVALID.
+   Int sums and products wrap on overflow. */
+Value vec_sum(const Value* values, int count, VecKind kind);
+Value vec_prod(const Value* values, int count, VecKind kind);
+
+/* Index of the first smallest / largest element (NaN never wins), or -1
+   for an empty array */
+int vec_argmin(const Value* values, int count, VecKind kind);
+int vec_argmax(const Value* values, int count, VecKind kind);
+
+/* out[i] = values[i] limited to [lo, hi]; elements keep their own type
+   unless a bound replaces them */
+void vec_clamp(Value* out, const Value* values, int count, VecKind kind,
+               Value lo, Value hi);
+
+/* out[i] = a[i] op b[i], op being '+' or '*'. b_stride 0 broadcasts a
+   single value. The result is int only when kind is VEC_INT. */
+void vec_binary(Value* out, const Value* a, const Value* b, int b_stride,
+                int count, VecKind kind, char op);
+
+#endif /* BRISK_VECMATH_H */
@@ -0,0 +1,92 @@
+/*
+ * Brisk Language - Compiled Program Support Implementation
+ */
+
+#include <string.h>
+#include "aot.h"
+#include "memory.h"
+
+/* The program's constants; every interpreter (one per thread) interns
+   them into its own isolate as they are first used */
+static const AotConstant* program_constants = NULL;
+static int program_constant_count = 0;
+
+int aot_main(CompiledBody program, const AotConstant* constants, int count) {
+    program_constants = constants;
+    program_constant_count = count;
+    ffi_trace_configure();
+    return interpret_compiled(program);
+}
+
+ObjString* aot_intern(Interpreter* interp, int index) {
+    if (interp->constants == NULL) {
+        size_t size = sizeof(ObjString*) * program_constant_count;
+        interp->constants = mem_alloc(size);
+        memset(interp->constants, 0, size);
+        interp->constant_count = program_constant_count;
+    }
+    const AotConstant* constant = &program_constants[index];
+    interp->constants[index] = string_create(constant->chars, constant->length);
+    return interp->constants[index];
+}
+
+Value aot_closure(Interpreter* interp, const AotFunction* function) {
+    ObjFunction* fn = function_create(
+        function->name,
+        function->name != NULL ? (int)strlen(function->name) : 0,
+        function->params,
+        function->param_lengths,
+        function->arity,
+        function->body,
+        interp->current
+    );
+    fn->is_generator = function->is_generator;
+    fn->compiled = function->compiled;
+    env_incref(interp->current);
+    return OBJ_VAL(fn);
+}
+
+bool aot_loop_start(Interpreter* interp, AotLoop* loop, Value iterable,
+                    bool from_call, int line) {
+    loop->array = NULL;
+    loop->iterator = NULL;
+    loop->position = 0;
+    loop->end = 0;
+    loop->step = 0;
+    loop->owned = from_call && IS_OBJ(iterable) &&
+                  AS_OBJ(iterable) == interp->fresh_generator;
+    interp->fresh_generator = NULL;
+
+    if (IS_ARRAY(iterable)) {
+        loop->array = AS_ARRAY(iterable);
+        return true;
+    }
+    loop->iterator = iterator_of(iterable);
+    if (loop->iterator == NULL) {
+        runtime_error(interp, line, "Cannot iterate over %s", value_type_name(iterable));
+        return false;
+    }
+    return true;
+}
+
+bool aot_loop_range(Interpreter* interp, AotLoop* loop, Value start, Value end, int line) {
+    loop->array = NULL;
+    loop->iterator = NULL;
+    loop->owned = false;
+    if (!IS_INT(start) || !IS_INT(end)) {
+        runtime_error(interp, line, "Range bounds must be integers");
+        return false;
+    }
+    loop->position = AS_INT(start);
+    loop->end = AS_INT(end);
+    loop->step = AS_INT(start) <= AS_INT(end) ? 1 : -1;
+    return true;
+}
+
+void aot_loop_end(AotLoop* loop) {
+    if (loop->iterator != NULL) {
+        obj_decref((Object*)loop->iterator);
+        if (loop->owned) obj_decref((Object*)loop->iterator);
+        loop->iterator = NULL;
+    }
+}
@@ -25,6 +25,7 @@ static const char* node_names[] = {
     [NODE_LAMBDA] = "LAMBDA",
     [NODE_RANGE] = "RANGE",
     [NODE_ADDRESS_OF] = "ADDRESS_OF",
+    [NODE_INTERP] = "INTERP",
     [NODE_VAR_DECL] = "VAR_DECL",
     [NODE_CONST_DECL] = "CONST_DECL",
     [NODE_ASSIGNMENT] = "ASSIGNMENT",
@@ -39,6 +40,7 @@ static const char* node_names[] = {
     [NODE_FN_DECL] = "FN_DECL",
     [NODE_MATCH] = "MATCH",
     [NODE_DEFER] = "DEFER",
+    [NODE_YIELD] = "YIELD",
     [NODE_PROGRAM] = "PROGRAM",
     [NODE_IMPORT] = "IMPORT",
     [NODE_C_BLOCK] = "C_BLOCK",
@@ -266,6 +268,7 @@ AstNode* ast_fn_decl(const char* name, int name_len, char** params, int* param_l
         node->as.fn_decl.param_lengths = param_lens;
         node->as.fn_decl.param_count = param_count;
         node->as.fn_decl.body = body;
+        node->as.fn_decl.is_generator = false;
     }
     return node;
 }
@@ -277,6 +280,7 @@ AstNode* ast_lambda(char** params, int* param_lens, int param_count, AstNode* bo
         node->as.lambda.param_lengths = param_lens;
         node->as.lambda.param_count = param_count;
         node->as.lambda.body = body;
+        node->as.lambda.is_generator = false;
     }
     return node;
 }
@@ -316,6 +320,14 @@ AstNode* ast_defer(AstNode* stmt, int line, int column) {
     return node;
 }
 
+AstNode* ast_yield(AstNode* value, int line, int column) {
+    AstNode* node = ast_create_node(NODE_YIELD, line, column);
+    if (node) {
+        node->as.yield_stmt.value = value;
+    }
+    return node;
+}
+
 AstNode* ast_import(const char* path, int length, int line, int column) {
     AstNode* node = ast_create_node(NODE_IMPORT, line, column);
     if (node) {
@@ -351,6 +363,15 @@ AstNode* ast_address_of(AstNode* operand, int line, int column) {
     return node;
 }
 
+AstNode* ast_interp(InterpPart* parts, int part_count, int line, int column) {
+    AstNode* node = ast_create_node(NODE_INTERP, line, column);
+    if (node) {
+        node->as.interp_string.parts = parts;
+        node->as.interp_string.part_count = part_count;
+    }
+    return node;
+}
+
 AstNode* ast_expr_stmt(AstNode* expr, int line, int column) {
     AstNode* node = ast_create_node(NODE_EXPR_STMT, line, column);
     if (node) {
@@ -409,6 +430,12 @@ static void free_node_data(AstNode* node) {
         case NODE_C_BLOCK:
             free(node->as.c_block.code);
             break;
+        case NODE_INTERP:
+            for (int i = 0; i < node->as.interp_string.part_count; i++) {
+                free(node->as.interp_string.parts[i].literal);
+            }
+            free(node->as.interp_string.parts);
+            break;
         default:
             break;
     }
@@ -493,6 +520,9 @@ void ast_free_tree(AstNode* node) {
         case NODE_RETURN:
             ast_free_tree(node->as.return_stmt.value);
             break;
+        case NODE_YIELD:
+            ast_free_tree(node->as.yield_stmt.value);
+            break;
         case NODE_MATCH:
             ast_free_tree(node->as.match_stmt.value);
             for (int i = 0; i < node->as.match_stmt.arm_count; i++) {
@@ -514,6 +544,11 @@ void ast_free_tree(AstNode* node) {
         case NODE_ADDRESS_OF:
             ast_free_tree(node->as.address_of.operand);
             break;
+        case NODE_INTERP:
+            for (int i = 0; i < node->as.interp_string.part_count; i++) {
+                ast_free_tree(node->as.interp_string.parts[i].expr);
+            }
+            break;
         default:
             break;
     }
@@ -648,6 +683,12 @@ void ast_print(AstNode* node, int indent) {
                 ast_print(node->as.return_stmt.value, indent + 1);
             }
             break;
+        case NODE_YIELD:
+            printf("\n");
+            if (node->as.yield_stmt.value) {
+                ast_print(node->as.yield_stmt.value, indent + 1);
+            }
+            break;
         case NODE_PROGRAM:
             printf(" (%d statements)\n", node->as.program.statement_count);
             for (int i = 0; i < node->as.program.statement_count; i++) {
@@ -658,6 +699,18 @@ void ast_print(AstNode* node, int indent) {
             printf("\n");
             ast_print(node->as.unary.operand, indent + 1);
             break;
+        case NODE_INTERP:
+            printf(" (%d parts)\n", node->as.interp_string.part_count);
+            for (int i = 0; i < node->as.interp_string.part_count; i++) {
+                InterpPart* part = &node->as.interp_string.parts[i];
+                if (part->literal) {
+                    print_indent(indent + 1);
+                    printf("\"%.*s\"\n", part->literal_length, part->literal);
+                } else {
+                    ast_print(part->expr, indent + 1);
+                }
+            }
+            break;
         default:
             printf("\n");
             break;
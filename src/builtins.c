@@ -5,11 +5,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <math.h>
 #include <time.h>
 #include "builtins.h"
 #include "value.h"
 #include "memory.h"
+#include "interp.h"
+#include "sort.h"
+#include "strsearch.h"
+#include "fileio.h"
+#include "timer.h"
+#include "numconv.h"
+#include "vecmath.h"
+#include "json.h"
+#include "parallel.h"
+#include "channel.h"
+#include "clone.h"
+#include "iter.h"
+#include "event.h"
+#include "pool.h"
+#include "freeze.h"
+#include "heap.h"
+#include "ffitrace.h"
 
 /* Helper to register a native function */
 static void register_native(Environment* env, const char* name, NativeFn fn, int arity) {
@@ -17,30 +35,75 @@ static void register_native(Environment* env, const char* name, NativeFn fn, int
     env_define(env, name, strlen(name), OBJ_VAL(native), true);
 }
 
+/* Helper to register an interpreter-aware native function */
+static void register_native_interp(Environment* env, const char* name,
+                                   NativeInterpFn fn, int arity) {
+    ObjNative* native = native_create_interp(fn, NULL, arity, name);
+    env_define(env, name, strlen(name), OBJ_VAL(native), true);
+}
+
+/* Check that a value can be called through brisk_call */
+static bool is_callable(Value value) {
+    return IS_FUNCTION(value) || IS_NATIVE(value) || IS_CFUNCTION(value);
+}
+
 /* ============ I/O Functions ============ */
 
-static Value native_print(int arg_count, Value* args) {
+static Value native_print(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     for (int i = 0; i < arg_count; i++) {
-        if (i > 0) printf(" ");
-        value_print(args[i]);
+        if (i > 0) output_write(&interp->out, " ", 1);
+        output_value(&interp->out, args[i]);
     }
+    output_end(&interp->out);
     return NIL_VAL;
 }
 
-static Value native_println(int arg_count, Value* args) {
+static Value native_println(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     for (int i = 0; i < arg_count; i++) {
-        if (i > 0) printf(" ");
-        value_print(args[i]);
+        if (i > 0) output_write(&interp->out, " ", 1);
+        output_value(&interp->out, args[i]);
     }
-    printf("\n");
+    output_write(&interp->out, "\n", 1);
+    output_end(&interp->out);
+    return NIL_VAL;
+}
+
+static Value native_flush(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    (void)args;
+    output_flush(&interp->out);
     return NIL_VAL;
 }
 
-static Value native_input(int arg_count, Value* args) {
+/* output_mode([mode]) - get or set when print output is flushed:
+   "line", "block" or "manual". Returns the previous mode. */
+static Value native_output_mode(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    const char* previous = output_mode_name(interp->out.mode);
+    
+    if (arg_count >= 1) {
+        OutputMode mode;
+        if (!IS_STRING(args[0]) || !output_mode_parse(AS_CSTRING(args[0]), &mode)) {
+            runtime_error(interp, interp->call_line,
+                          "output_mode() expects \"line\", \"block\" or \"manual\"");
+            return NIL_VAL;
+        }
+        interp->out.mode = mode;
+        output_end(&interp->out);
+    }
+    
+    return OBJ_VAL(string_create(previous, strlen(previous)));
+}
+
+static Value native_input(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count > 0 && IS_STRING(args[0])) {
-        printf("%s", AS_CSTRING(args[0]));
-        fflush(stdout);
+        output_write(&interp->out, AS_CSTRING(args[0]), AS_STRING(args[0])->length);
     }
+    output_flush(&interp->out);
     
     char buffer[1024];
     if (fgets(buffer, sizeof(buffer), stdin) == NULL) {
@@ -57,6 +120,83 @@ static Value native_input(int arg_count, Value* args) {
     return OBJ_VAL(string_create(buffer, len));
 }
 
+/* ============ File Functions ============ */
+
+static Value native_read_file(int arg_count, Value* args) {
+    if (arg_count != 1 || !IS_STRING(args[0])) return NIL_VAL;
+    
+    ObjString* contents = file_read_all(AS_CSTRING(args[0]));
+    return contents != NULL ? OBJ_VAL(contents) : NIL_VAL;
+}
+
+static Value write_file_common(int arg_count, Value* args, bool append) {
+    if (arg_count != 2 || !IS_STRING(args[0]) || !IS_STRING(args[1])) return NIL_VAL;
+    
+    ObjString* data = AS_STRING(args[1]);
+    return BOOL_VAL(file_write_all(AS_CSTRING(args[0]), data->chars, data->length, append));
+}
+
+static Value native_write_file(int arg_count, Value* args) {
+    return write_file_common(arg_count, args, false);
+}
+
+static Value native_append_file(int arg_count, Value* args) {
+    return write_file_common(arg_count, args, true);
+}
+
+/* lines(path) - lazy line reader for use with for loops or file_read_line */
+static Value native_lines(int arg_count, Value* args) {
+    if (arg_count != 1 || !IS_STRING(args[0])) return NIL_VAL;
+    
+    ObjFile* file = file_open(AS_CSTRING(args[0]), false, false);
+    return file != NULL ? OBJ_VAL(file) : NIL_VAL;
+}
+
+/* open_writer(path, [append]) - buffered writer */
+static Value native_open_writer(int arg_count, Value* args) {
+    if (arg_count < 1 || arg_count > 2 || !IS_STRING(args[0])) return NIL_VAL;
+    
+    bool append = arg_count == 2 && value_is_truthy(args[1]);
+    ObjFile* file = file_open(AS_CSTRING(args[0]), true, append);
+    return file != NULL ? OBJ_VAL(file) : NIL_VAL;
+}
+
+static Value native_file_read_line(int arg_count, Value* args) {
+    if (arg_count != 1 || !IS_FILE(args[0])) return NIL_VAL;
+    
+    ObjString* line = file_read_line(AS_FILE(args[0]));
+    return line != NULL ? OBJ_VAL(line) : NIL_VAL;
+}
+
+/* Shared body of file_write/file_writeln: values are formatted like print */
+static Value file_write_common(int arg_count, Value* args, bool newline) {
+    if (arg_count < 1 || !IS_FILE(args[0])) return NIL_VAL;
+    
+    ObjFile* file = AS_FILE(args[0]);
+    if (file->out == NULL) return NIL_VAL;
+    
+    for (int i = 1; i < arg_count; i++) {
+        if (i > 1) output_write(file->out, " ", 1);
+        output_value(file->out, args[i]);
+    }
+    if (newline) output_write(file->out, "\n", 1);
+    return NIL_VAL;
+}
+
+static Value native_file_write(int arg_count, Value* args) {
+    return file_write_common(arg_count, args, false);
+}
+
+static Value native_file_writeln(int arg_count, Value* args) {
+    return file_write_common(arg_count, args, true);
+}
+
+static Value native_file_close(int arg_count, Value* args) {
+    if (arg_count != 1 || !IS_FILE(args[0])) return NIL_VAL;
+    file_close(AS_FILE(args[0]));
+    return NIL_VAL;
+}
+
 /* ============ Type Functions ============ */
 
 static Value native_type(int arg_count, Value* args) {
@@ -74,9 +214,10 @@ static Value native_int(int arg_count, Value* args) {
     if (IS_FLOAT(val)) return INT_VAL((int64_t)AS_FLOAT(val));
     if (IS_BOOL(val)) return INT_VAL(AS_BOOL(val) ? 1 : 0);
     if (IS_STRING(val)) {
-        char* end;
-        int64_t result = strtoll(AS_CSTRING(val), &end, 10);
-        if (*end == '\0') return INT_VAL(result);
+        int64_t result;
+        if (num_parse_int(AS_CSTRING(val), AS_STRING(val)->length, 0, &result)) {
+            return INT_VAL(result);
+        }
     }
     return NIL_VAL;
 }
@@ -88,9 +229,10 @@ static Value native_float(int arg_count, Value* args) {
     if (IS_FLOAT(val)) return val;
     if (IS_INT(val)) return FLOAT_VAL((double)AS_INT(val));
     if (IS_STRING(val)) {
-        char* end;
-        double result = strtod(AS_CSTRING(val), &end);
-        if (*end == '\0') return FLOAT_VAL(result);
+        double result;
+        if (num_parse_double(AS_CSTRING(val), AS_STRING(val)->length, 0, &result)) {
+            return FLOAT_VAL(result);
+        }
     }
     return NIL_VAL;
 }
@@ -98,10 +240,12 @@ static Value native_float(int arg_count, Value* args) {
 static Value native_str(int arg_count, Value* args) {
     if (arg_count != 1) return NIL_VAL;
     
-    char* str = value_to_string(args[0]);
-    ObjString* result = string_create(str, strlen(str));
-    mem_free(str, 256);
-    return OBJ_VAL(result);
+    if (IS_STRING(args[0])) return args[0];
+    
+    char buffer[VALUE_TEXT_BUFFER];
+    const char* text;
+    int length = value_text(args[0], buffer, &text);
+    return OBJ_VAL(string_create(text, length));
 }
 
 static Value native_bool(int arg_count, Value* args) {
@@ -121,17 +265,31 @@ static Value native_len(int arg_count, Value* args) {
     return NIL_VAL;
 }
 
-static Value native_push(int arg_count, Value* args) {
+/* Builtins that change an array in place refuse frozen ones */
+static bool check_mutable(Interpreter* interp, const char* name, Value value) {
+    if (IS_FROZEN(value)) {
+        runtime_error(interp, interp->call_line, "%s() cannot modify a frozen %s",
+                      name, value_type_name(value));
+        return false;
+    }
+    return true;
+}
+
+static Value native_push(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count != 2) return NIL_VAL;
     if (!IS_ARRAY(args[0])) return NIL_VAL;
+    if (!check_mutable(interp, "push", args[0])) return NIL_VAL;
     
     array_push(AS_ARRAY(args[0]), args[1]);
     return NIL_VAL;
 }
 
-static Value native_pop(int arg_count, Value* args) {
+static Value native_pop(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count != 1) return NIL_VAL;
     if (!IS_ARRAY(args[0])) return NIL_VAL;
+    if (!check_mutable(interp, "pop", args[0])) return NIL_VAL;
     
     return array_pop(AS_ARRAY(args[0]));
 }
@@ -154,9 +312,11 @@ static Value native_last(int arg_count, Value* args) {
     return arr->elements[arr->count - 1];
 }
 
-static Value native_insert(int arg_count, Value* args) {
+static Value native_insert(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count != 3) return NIL_VAL;
     if (!IS_ARRAY(args[0]) || !IS_INT(args[1])) return NIL_VAL;
+    if (!check_mutable(interp, "insert", args[0])) return NIL_VAL;
     
     ObjArray* arr = AS_ARRAY(args[0]);
     int index = (int)AS_INT(args[1]);
@@ -178,9 +338,11 @@ static Value native_insert(int arg_count, Value* args) {
     return NIL_VAL;
 }
 
-static Value native_remove(int arg_count, Value* args) {
+static Value native_remove(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count != 2) return NIL_VAL;
     if (!IS_ARRAY(args[0]) || !IS_INT(args[1])) return NIL_VAL;
+    if (!check_mutable(interp, "remove", args[0])) return NIL_VAL;
     
     ObjArray* arr = AS_ARRAY(args[0]);
     int index = (int)AS_INT(args[1]);
@@ -198,6 +360,412 @@ static Value native_remove(int arg_count, Value* args) {
     return removed;
 }
 
+/* ============ Higher-Order Functions ============ */
+
+/* Validate (array, fn) arguments shared by the higher-order builtins */
+static bool check_array_fn(Interpreter* interp, const char* name,
+                           int arg_count, Value* args) {
+    if (arg_count < 1 || !IS_ARRAY(args[0])) {
+        runtime_error(interp, interp->call_line, "%s() expects an array", name);
+        return false;
+    }
+    if (arg_count >= 2 && !is_callable(args[1])) {
+        runtime_error(interp, interp->call_line, "%s() expects a function", name);
+        return false;
+    }
+    return true;
+}
+
+/* map/filter over any iterable but an array: a lazy stage that calls fn
+   only as values are pulled through it */
+static Value lazy_stage(Interpreter* interp, const char* name, IteratorKind kind,
+                        ObjIterator* source, Value fn) {
+    if (!is_callable(fn)) {
+        obj_decref((Object*)source);
+        runtime_error(interp, interp->call_line, "%s() expects a function", name);
+        return NIL_VAL;
+    }
+    ObjIterator* stage = kind == ITER_MAP ? iterator_map(source, fn)
+                                          : iterator_filter(source, fn);
+    obj_decref((Object*)source);  /* The stage holds it */
+    return OBJ_VAL(stage);
+}
+
+static Value native_map(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    ObjIterator* source = IS_ARRAY(args[0]) ? NULL : iterator_of(args[0]);
+    if (source != NULL) return lazy_stage(interp, "map", ITER_MAP, source, args[1]);
+    if (!check_array_fn(interp, "map", arg_count, args)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    ObjArray* result = array_create();
+    
+    /* Re-check count each step: the callback may mutate the array */
+    for (int i = 0; i < arr->count; i++) {
+        Value elem = arr->elements[i];
+        Value mapped = brisk_call(interp, args[1], 1, &elem);
+        if (interp->had_error) {
+            obj_decref((Object*)result);
+            return NIL_VAL;
+        }
+        array_push(result, mapped);
+    }
+    
+    return OBJ_VAL(result);
+}
+
+static Value native_filter(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    ObjIterator* source = IS_ARRAY(args[0]) ? NULL : iterator_of(args[0]);
+    if (source != NULL) return lazy_stage(interp, "filter", ITER_FILTER, source, args[1]);
+    if (!check_array_fn(interp, "filter", arg_count, args)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    ObjArray* result = array_create();
+    
+    for (int i = 0; i < arr->count; i++) {
+        Value elem = arr->elements[i];
+        Value keep = brisk_call(interp, args[1], 1, &elem);
+        if (interp->had_error) {
+            obj_decref((Object*)result);
+            return NIL_VAL;
+        }
+        if (value_is_truthy(keep)) {
+            array_push(result, elem);
+        }
+    }
+    
+    return OBJ_VAL(result);
+}
+
+/* reduce over a lazy iterable. The accumulator holds a reference of its
+   own, since the iterator lets go of each value when it moves on. */
+static Value reduce_iterator(Interpreter* interp, ObjIterator* iterator,
+                             int arg_count, Value* args) {
+    bool seeded = arg_count == 3;
+    Value acc = seeded ? args[2] : NIL_VAL;
+    if (IS_OBJ(acc)) obj_incref(AS_OBJ(acc));
+    
+    Value value;
+    Value call_args[2];
+    while (iterator_next(interp, iterator, &value)) {
+        Value next = value;
+        if (seeded) {
+            call_args[0] = acc;
+            call_args[1] = value;
+            next = brisk_call(interp, args[1], 2, call_args);
+            if (interp->had_error) break;
+        }
+        seeded = true;
+        if (IS_OBJ(next)) obj_incref(AS_OBJ(next));
+        if (IS_OBJ(acc)) obj_decref(AS_OBJ(acc));
+        acc = next;
+    }
+    obj_decref((Object*)iterator);
+    
+    if (interp->had_error) {
+        if (IS_OBJ(acc)) obj_decref(AS_OBJ(acc));
+        return NIL_VAL;
+    }
+    return acc;
+}
+
+static Value native_reduce(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 2 || arg_count > 3) {
+        runtime_error(interp, interp->call_line,
+                      "reduce() expects 2 or 3 arguments but got %d", arg_count);
+        return NIL_VAL;
+    }
+    ObjIterator* iterator = IS_ARRAY(args[0]) ? NULL : iterator_of(args[0]);
+    if (iterator != NULL) {
+        if (!is_callable(args[1])) {
+            obj_decref((Object*)iterator);
+            runtime_error(interp, interp->call_line, "reduce() expects a function");
+            return NIL_VAL;
+        }
+        return reduce_iterator(interp, iterator, arg_count, args);
+    }
+    if (!check_array_fn(interp, "reduce", arg_count, args)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    int start = 0;
+    Value acc;
+    
+    if (arg_count == 3) {
+        acc = args[2];
+    } else {
+        /* No initial value: seed with the first element */
+        if (arr->count == 0) return NIL_VAL;
+        acc = arr->elements[0];
+        start = 1;
+    }
+    
+    Value call_args[2];
+    for (int i = start; i < arr->count; i++) {
+        call_args[0] = acc;
+        call_args[1] = arr->elements[i];
+        acc = brisk_call(interp, args[1], 2, call_args);
+        if (interp->had_error) return NIL_VAL;
+    }
+    
+    return acc;
+}
+
+static Value native_each(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    ObjIterator* iterator = IS_ARRAY(args[0]) ? NULL : iterator_of(args[0]);
+    if (iterator != NULL) {
+        Value value;
+        if (is_callable(args[1])) {
+            while (iterator_next(interp, iterator, &value)) {
+                brisk_call(interp, args[1], 1, &value);
+            }
+        } else {
+            runtime_error(interp, interp->call_line, "each() expects a function");
+        }
+        obj_decref((Object*)iterator);
+        return NIL_VAL;
+    }
+    if (!check_array_fn(interp, "each", arg_count, args)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    for (int i = 0; i < arr->count; i++) {
+        Value elem = arr->elements[i];
+        brisk_call(interp, args[1], 1, &elem);
+        if (interp->had_error) return NIL_VAL;
+    }
+    
+    return NIL_VAL;
+}
+
+/* Shared body of any/all: stop at the first element whose truthiness
+   equals `stop_on`. Without a predicate the elements themselves are tested. */
+static Value any_all(Interpreter* interp, const char* name, bool stop_on,
+                     int arg_count, Value* args) {
+    if (arg_count < 1 || arg_count > 2) {
+        runtime_error(interp, interp->call_line,
+                      "%s() expects 1 or 2 arguments but got %d", name, arg_count);
+        return NIL_VAL;
+    }
+    if (!check_array_fn(interp, name, arg_count, args)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    for (int i = 0; i < arr->count; i++) {
+        Value test = arr->elements[i];
+        if (arg_count == 2) {
+            Value elem = test;
+            test = brisk_call(interp, args[1], 1, &elem);
+            if (interp->had_error) return NIL_VAL;
+        }
+        if (value_is_truthy(test) == stop_on) {
+            return BOOL_VAL(stop_on);
+        }
+    }
+    
+    return BOOL_VAL(!stop_on);
+}
+
+static Value native_any(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    return any_all(interp, "any", true, arg_count, args);
+}
+
+static Value native_all(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    return any_all(interp, "all", false, arg_count, args);
+}
+
+/* ============ Iterators ============ */
+
+static Value native_iter(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    ObjIterator* iterator = iterator_of(args[0]);
+    if (iterator == NULL) {
+        runtime_error(interp, interp->call_line, "Cannot iterate over %s",
+                      value_type_name(args[0]));
+        return NIL_VAL;
+    }
+    return OBJ_VAL(iterator);
+}
+
+/* Next value of an iterator, or nil once it is exhausted */
+static Value native_next(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_ITERATOR(args[0])) {
+        runtime_error(interp, interp->call_line, "next() expects an iterator");
+        return NIL_VAL;
+    }
+    Value value;
+    if (!iterator_next(interp, AS_ITERATOR(args[0]), &value)) return NIL_VAL;
+    return value;
+}
+
+static Value native_collect(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    ObjIterator* iterator = iterator_of(args[0]);
+    if (iterator == NULL) {
+        runtime_error(interp, interp->call_line, "Cannot iterate over %s",
+                      value_type_name(args[0]));
+        return NIL_VAL;
+    }
+    
+    ObjArray* result = array_create();
+    Value value;
+    while (iterator_next(interp, iterator, &value)) {
+        array_push(result, value);
+    }
+    obj_decref((Object*)iterator);
+    
+    if (interp->had_error) {
+        obj_decref((Object*)result);
+        return NIL_VAL;
+    }
+    return OBJ_VAL(result);
+}
+
+static Value native_take(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_INT(args[1])) {
+        runtime_error(interp, interp->call_line, "take() expects an integer count");
+        return NIL_VAL;
+    }
+    ObjIterator* source = iterator_of(args[0]);
+    if (source == NULL) {
+        runtime_error(interp, interp->call_line, "Cannot iterate over %s",
+                      value_type_name(args[0]));
+        return NIL_VAL;
+    }
+    ObjIterator* stage = iterator_take(source, AS_INT(args[1]));
+    obj_decref((Object*)source);  /* The stage holds it */
+    return OBJ_VAL(stage);
+}
+
+/* range(end), range(start, end) or range(start, end, step): a lazy a..b */
+static Value native_range(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 1 || arg_count > 3) {
+        runtime_error(interp, interp->call_line,
+                      "range() expects 1 to 3 arguments but got %d", arg_count);
+        return NIL_VAL;
+    }
+    for (int i = 0; i < arg_count; i++) {
+        if (!IS_INT(args[i])) {
+            runtime_error(interp, interp->call_line, "range() expects integers");
+            return NIL_VAL;
+        }
+    }
+    
+    int64_t start = arg_count == 1 ? 0 : AS_INT(args[0]);
+    int64_t end = arg_count == 1 ? AS_INT(args[0]) : AS_INT(args[1]);
+    int64_t step = arg_count == 3 ? AS_INT(args[2]) : (start <= end ? 1 : -1);
+    if (step == 0) {
+        runtime_error(interp, interp->call_line, "range() step cannot be 0");
+        return NIL_VAL;
+    }
+    return OBJ_VAL(iterator_range(start, end, step));
+}
+
+/* ============ Sorting ============ */
+
+/* Shared body of sort/stable_sort: sorts arr in place and returns it */
+static Value sort_array(Interpreter* interp, const char* name, bool stable,
+                        int arg_count, Value* args) {
+    if (arg_count < 1 || arg_count > 2) {
+        runtime_error(interp, interp->call_line,
+                      "%s() expects 1 or 2 arguments but got %d", name, arg_count);
+        return NIL_VAL;
+    }
+    if (!check_array_fn(interp, name, arg_count, args)) return NIL_VAL;
+    if (!check_mutable(interp, name, args[0])) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    Value cmp = arg_count == 2 ? args[1] : NIL_VAL;
+    if (IS_NIL(cmp)) {
+        /* No script code runs, so the array cannot change under the sort */
+        if (!sort_values(interp, arr->elements, arr->count, cmp, stable)) {
+            return NIL_VAL;
+        }
+        return args[0];
+    }
+    
+    /* The comparator may push to or pop from the array, so sort a copy
+       holding its own references and put it back only if the array is
+       still the one that was copied */
+    Value* elements = arr->elements;
+    int count = arr->count;
+    if (count < 2) return args[0];
+    Value* sorted = mem_alloc(sizeof(Value) * count);
+    for (int i = 0; i < count; i++) {
+        sorted[i] = elements[i];
+        if (IS_OBJ(sorted[i])) obj_incref(AS_OBJ(sorted[i]));
+    }
+    
+    bool ok = sort_values(interp, sorted, count, cmp, stable);
+    if (arr->elements != elements || arr->count != count) {
+        if (ok) {
+            runtime_error(interp, interp->call_line,
+                          "%s() comparator modified the array", name);
+            ok = false;
+        }
+        for (int i = 0; i < count; i++) {
+            if (IS_OBJ(sorted[i])) obj_decref(AS_OBJ(sorted[i]));
+        }
+    } else {
+        /* Each slot hands its reference over to the sorted value */
+        for (int i = 0; i < count; i++) {
+            Value old = elements[i];
+            elements[i] = sorted[i];
+            if (IS_OBJ(old)) obj_decref(AS_OBJ(old));
+        }
+    }
+    mem_free(sorted, sizeof(Value) * count);
+    return ok ? args[0] : NIL_VAL;
+}
+
+static Value native_sort(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    return sort_array(interp, "sort", false, arg_count, args);
+}
+
+static Value native_stable_sort(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    return sort_array(interp, "stable_sort", true, arg_count, args);
+}
+
+/* Stable sort by key, calling keyfn once per element */
+static Value native_sort_by(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (!check_array_fn(interp, "sort_by", arg_count, args)) return NIL_VAL;
+    if (!check_mutable(interp, "sort_by", args[0])) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    int count = arr->count;
+    if (count < 2) return args[0];
+    
+    Value* keys = mem_alloc(sizeof(Value) * count);
+    for (int i = 0; i < count; i++) {
+        Value elem = arr->elements[i];
+        keys[i] = brisk_call(interp, args[1], 1, &elem);
+        if (interp->had_error || arr->count != count) {
+            if (!interp->had_error) {
+                runtime_error(interp, interp->call_line,
+                              "sort_by() key function modified the array");
+            }
+            mem_free(keys, sizeof(Value) * count);
+            return NIL_VAL;
+        }
+    }
+    
+    bool ok = sort_values_by_keys(interp, arr->elements, keys, count);
+    mem_free(keys, sizeof(Value) * count);
+    return ok ? args[0] : NIL_VAL;
+}
+
 /* ============ String Functions ============ */
 
 static Value native_substr(int arg_count, Value* args) {
@@ -218,16 +786,37 @@ static Value native_substr(int arg_count, Value* args) {
 }
 
 static Value native_find(int arg_count, Value* args) {
+    if (arg_count < 2 || arg_count > 3) return NIL_VAL;
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) return NIL_VAL;
+    
+    ObjString* haystack = AS_STRING(args[0]);
+    ObjString* needle = AS_STRING(args[1]);
+    int start = (arg_count == 3 && IS_INT(args[2])) ? (int)AS_INT(args[2]) : 0;
+    
+    return INT_VAL(str_find(haystack->chars, haystack->length,
+                            needle->chars, needle->length, start));
+}
+
+static Value native_rfind(int arg_count, Value* args) {
     if (arg_count != 2) return NIL_VAL;
     if (!IS_STRING(args[0]) || !IS_STRING(args[1])) return NIL_VAL;
     
     ObjString* haystack = AS_STRING(args[0]);
     ObjString* needle = AS_STRING(args[1]);
     
-    char* found = strstr(haystack->chars, needle->chars);
-    if (found == NULL) return INT_VAL(-1);
+    return INT_VAL(str_rfind(haystack->chars, haystack->length,
+                             needle->chars, needle->length));
+}
+
+static Value native_count(int arg_count, Value* args) {
+    if (arg_count != 2) return NIL_VAL;
+    if (!IS_STRING(args[0]) || !IS_STRING(args[1])) return NIL_VAL;
     
-    return INT_VAL(found - haystack->chars);
+    ObjString* haystack = AS_STRING(args[0]);
+    ObjString* needle = AS_STRING(args[1]);
+    
+    return INT_VAL(str_count(haystack->chars, haystack->length,
+                             needle->chars, needle->length));
 }
 
 static Value native_replace(int arg_count, Value* args) {
@@ -238,40 +827,68 @@ static Value native_replace(int arg_count, Value* args) {
     ObjString* old = AS_STRING(args[1]);
     ObjString* new = AS_STRING(args[2]);
     
-    /* Count occurrences */
-    int count = 0;
-    char* pos = str->chars;
-    while ((pos = strstr(pos, old->chars)) != NULL) {
-        count++;
-        pos += old->length;
-    }
-    
-    if (count == 0) {
+    int pos = old->length > 0
+              ? str_find(str->chars, str->length, old->chars, old->length, 0)
+              : -1;
+    if (pos < 0) {
         obj_incref((Object*)str);
         return OBJ_VAL(str);
     }
     
-    /* Build new string */
-    int new_len = str->length + count * (new->length - old->length);
-    char* result = mem_alloc(new_len + 1);
-    
-    char* src = str->chars;
-    char* dst = result;
-    while ((pos = strstr(src, old->chars)) != NULL) {
-        int before = pos - src;
-        memcpy(dst, src, before);
-        dst += before;
-        memcpy(dst, new->chars, new->length);
-        dst += new->length;
+    /* Single pass: append segments into a growing buffer */
+    int capacity = str->length + (new->length > old->length ? new->length - old->length : 0) + 1;
+    char* result = mem_alloc(capacity);
+    int length = 0;
+    int src = 0;
+    
+    while (pos >= 0) {
+        int needed = length + (pos - src) + new->length + (str->length - pos) + 1;
+        if (needed > capacity) {
+            int new_capacity = capacity * 2 > needed ? capacity * 2 : needed;
+            result = mem_realloc(result, capacity, new_capacity);
+            capacity = new_capacity;
+        }
+        memcpy(result + length, str->chars + src, pos - src);
+        length += pos - src;
+        memcpy(result + length, new->chars, new->length);
+        length += new->length;
         src = pos + old->length;
+        pos = str_find(str->chars, str->length, old->chars, old->length, src);
     }
-    strcpy(dst, src);
+    memcpy(result + length, str->chars + src, str->length - src);
+    length += str->length - src;
     
-    ObjString* result_str = string_create(result, new_len);
-    mem_free(result, new_len + 1);
+    ObjString* result_str = string_create(result, length);
+    mem_free(result, capacity);
     return OBJ_VAL(result_str);
 }
 
+/* Pieces hashed per pool task when splitting */
+#define SPLIT_GRAIN 4096
+
+typedef struct {
+    ObjString* str;
+    int delim_length;
+    const int* positions;   /* Where each delimiter starts */
+    int count;
+    uint32_t* hashes;       /* One per piece, count + 1 of them */
+} SplitJob;
+
+/* Bounds of piece i, between delimiters i - 1 and i */
+static int piece_span(const SplitJob* job, int i, int* end) {
+    *end = i < job->count ? job->positions[i] : job->str->length;
+    return i > 0 ? job->positions[i - 1] + job->delim_length : 0;
+}
+
+static void hash_pieces(void* context, int64_t begin, int64_t end) {
+    SplitJob* job = context;
+    for (int64_t i = begin; i < end; i++) {
+        int stop;
+        int start = piece_span(job, (int)i, &stop);
+        job->hashes[i] = string_hash(job->str->chars + start, stop - start);
+    }
+}
+
 static Value native_split(int arg_count, Value* args) {
     if (arg_count != 2) return NIL_VAL;
     if (!IS_STRING(args[0]) || !IS_STRING(args[1])) return NIL_VAL;
@@ -287,13 +904,24 @@ static Value native_split(int arg_count, Value* args) {
             array_push(result, OBJ_VAL(string_create(&str->chars[i], 1)));
         }
     } else {
-        char* start = str->chars;
-        char* pos;
-        while ((pos = strstr(start, delim->chars)) != NULL) {
-            array_push(result, OBJ_VAL(string_create(start, pos - start)));
-            start = pos + delim->length;
+        /* Find every piece first so long strings can be searched and
+           hashed on the thread pool; only interning stays serial */
+        int* positions;
+        int count = str_find_all(str->chars, str->length, delim->chars, delim->length,
+                                 &positions);
+        SplitJob job = {str, delim->length, positions, count,
+                        mem_alloc(sizeof(uint32_t) * (count + 1))};
+        pool_for(count + 1, SPLIT_GRAIN, hash_pieces, &job);
+        
+        array_reserve(result, count + 1);
+        for (int i = 0; i <= count; i++) {
+            int end;
+            int start = piece_span(&job, i, &end);
+            array_push(result, OBJ_VAL(string_create_hashed(str->chars + start, end - start,
+                                                            job.hashes[i])));
         }
-        array_push(result, OBJ_VAL(string_create(start, strlen(start))));
+        mem_free(job.hashes, sizeof(uint32_t) * (count + 1));
+        if (positions != NULL) mem_free(positions, sizeof(int) * count);
     }
     
     return OBJ_VAL(result);
@@ -409,6 +1037,12 @@ static Value native_abs(int arg_count, Value* args) {
 }
 
 static Value native_min(int arg_count, Value* args) {
+    if (arg_count == 1 && IS_ARRAY(args[0])) {
+        ObjArray* arr = AS_ARRAY(args[0]);
+        VecKind kind = vec_kind(arr->elements, arr->count);
+        if (kind == VEC_INVALID || arr->count == 0) return NIL_VAL;
+        return arr->elements[vec_argmin(arr->elements, arr->count, kind)];
+    }
     if (arg_count < 2) return NIL_VAL;
     
     Value min = args[0];
@@ -423,6 +1057,12 @@ static Value native_min(int arg_count, Value* args) {
 }
 
 static Value native_max(int arg_count, Value* args) {
+    if (arg_count == 1 && IS_ARRAY(args[0])) {
+        ObjArray* arr = AS_ARRAY(args[0]);
+        VecKind kind = vec_kind(arr->elements, arr->count);
+        if (kind == VEC_INVALID || arr->count == 0) return NIL_VAL;
+        return arr->elements[vec_argmax(arr->elements, arr->count, kind)];
+    }
     if (arg_count < 2) return NIL_VAL;
     
     Value max = args[0];
@@ -484,6 +1124,368 @@ static Value native_tan(int arg_count, Value* args) {
     return FLOAT_VAL(tan(AS_NUMBER(args[0])));
 }
 
+/* ============ Array Math ============ */
+
+/* Validate an array of numbers and report what it holds */
+static bool check_number_array(Interpreter* interp, const char* name,
+                               Value arg, VecKind* kind) {
+    if (!IS_ARRAY(arg)) {
+        runtime_error(interp, interp->call_line, "%s() expects an array", name);
+        return false;
+    }
+    *kind = vec_kind(AS_ARRAY(arg)->elements, AS_ARRAY(arg)->count);
+    if (*kind == VEC_INVALID) {
+        runtime_error(interp, interp->call_line, "%s() expects an array of numbers", name);
+        return false;
+    }
+    return true;
+}
+
+/* Result array with room for count elements, filled in by a kernel */
+static ObjArray* array_with_count(int count) {
+    ObjArray* result = array_create();
+    array_reserve(result, count);
+    result->count = count;
+    return result;
+}
+
+static Value native_sum(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    VecKind kind;
+    if (!check_number_array(interp, "sum", args[0], &kind)) return NIL_VAL;
+    return vec_sum(AS_ARRAY(args[0])->elements, AS_ARRAY(args[0])->count, kind);
+}
+
+static Value native_mean(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    VecKind kind;
+    if (!check_number_array(interp, "mean", args[0], &kind)) return NIL_VAL;
+    
+    ObjArray* arr = AS_ARRAY(args[0]);
+    if (arr->count == 0) return NIL_VAL;
+    Value total = vec_sum(arr->elements, arr->count, kind);
+    return FLOAT_VAL(AS_NUMBER(total) / arr->count);
+}
+
+static Value native_prod(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    VecKind kind;
+    if (!check_number_array(interp, "prod", args[0], &kind)) return NIL_VAL;
+    return vec_prod(AS_ARRAY(args[0])->elements, AS_ARRAY(args[0])->count, kind);
+}
+
+static Value native_argmin(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    VecKind kind;
+    if (!check_number_array(interp, "argmin", args[0], &kind)) return NIL_VAL;
+    int index = vec_argmin(AS_ARRAY(args[0])->elements, AS_ARRAY(args[0])->count, kind);
+    return index < 0 ? NIL_VAL : INT_VAL(index);
+}
+
+static Value native_argmax(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    VecKind kind;
+    if (!check_number_array(interp, "argmax", args[0], &kind)) return NIL_VAL;
+    int index = vec_argmax(AS_ARRAY(args[0])->elements, AS_ARRAY(args[0])->count, kind);
+    return index < 0 ? NIL_VAL : INT_VAL(index);
+}
+
+/* clamp(x, lo, hi) on a number, or on every element of an array */
+static Value native_clamp(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_NUMBER(args[1]) || !IS_NUMBER(args[2])) {
+        runtime_error(interp, interp->call_line, "clamp() bounds must be numbers");
+        return NIL_VAL;
+    }
+    
+    if (IS_NUMBER(args[0])) {
+        Value out;
+        VecKind kind = IS_INT(args[0]) ? VEC_INT : VEC_FLOAT;
+        vec_clamp(&out, &args[0], 1, kind, args[1], args[2]);
+        return out;
+    }
+    
+    VecKind kind;
+    if (!check_number_array(interp, "clamp", args[0], &kind)) return NIL_VAL;
+    ObjArray* arr = AS_ARRAY(args[0]);
+    ObjArray* result = array_with_count(arr->count);
+    vec_clamp(result->elements, arr->elements, arr->count, kind, args[1], args[2]);
+    return OBJ_VAL(result);
+}
+
+/* add(a, b) / mul(a, b): arrays of equal length, or an array and a number */
+static Value elementwise(Interpreter* interp, const char* name, Value* args, char op) {
+    Value a = args[0];
+    Value b = args[1];
+    if (IS_NUMBER(a) && IS_ARRAY(b)) {
+        /* Both operations commute, so put the array first */
+        a = args[1];
+        b = args[0];
+    }
+    
+    VecKind kind;
+    if (!check_number_array(interp, name, a, &kind)) return NIL_VAL;
+    ObjArray* arr = AS_ARRAY(a);
+    
+    const Value* other;
+    int stride;
+    if (IS_NUMBER(b)) {
+        other = &b;
+        stride = 0;
+        kind = vec_kind_join(kind, IS_INT(b) ? VEC_INT : VEC_FLOAT);
+    } else {
+        VecKind other_kind;
+        if (!check_number_array(interp, name, b, &other_kind)) return NIL_VAL;
+        if (AS_ARRAY(b)->count != arr->count) {
+            runtime_error(interp, interp->call_line,
+                          "%s() arrays differ in length (%d and %d)",
+                          name, arr->count, AS_ARRAY(b)->count);
+            return NIL_VAL;
+        }
+        other = AS_ARRAY(b)->elements;
+        stride = 1;
+        kind = vec_kind_join(kind, other_kind);
+    }
+    
+    /* Empty arrays have no elements to disagree on */
+    if (arr->count == 0) kind = VEC_INT;
+    
+    ObjArray* result = array_with_count(arr->count);
+    vec_binary(result->elements, arr->elements, other, stride, arr->count, kind, op);
+    return OBJ_VAL(result);
+}
+
+static Value native_add(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    return elementwise(interp, "add", args, '+');
+}
+
+static Value native_mul(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    return elementwise(interp, "mul", args, '*');
+}
+
+/* ============ JSON ============ */
+
+static Value native_json_parse(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_STRING(args[0])) {
+        runtime_error(interp, interp->call_line, "json_parse() expects a string");
+        return NIL_VAL;
+    }
+    
+    char error[256];
+    Value result;
+    if (!json_parse(AS_CSTRING(args[0]), AS_STRING(args[0])->length, &result,
+                    error, sizeof(error))) {
+        runtime_error(interp, interp->call_line, "Invalid JSON: %s", error);
+        return NIL_VAL;
+    }
+    return result;
+}
+
+static Value native_json_stringify(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    char error[256];
+    ObjString* result = json_stringify(args[0], error, sizeof(error));
+    if (result == NULL) {
+        runtime_error(interp, interp->call_line, "json_stringify(): %s", error);
+        return NIL_VAL;
+    }
+    return OBJ_VAL(result);
+}
+
+/* ============ Parallel ============ */
+
+static Value native_parallel_map(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 2 || arg_count > 3) {
+        runtime_error(interp, interp->call_line, "parallel_map() expects (fn, array, workers?)");
+        return NIL_VAL;
+    }
+    if (!IS_FUNCTION(args[0]) && !IS_NATIVE(args[0])) {
+        runtime_error(interp, interp->call_line, "parallel_map() expects a function");
+        return NIL_VAL;
+    }
+    if (!IS_ARRAY(args[1])) {
+        runtime_error(interp, interp->call_line, "parallel_map() expects an array");
+        return NIL_VAL;
+    }
+    
+    int workers = parallel_cpu_count();
+    if (arg_count == 3) {
+        if (!IS_INT(args[2]) || AS_INT(args[2]) < 1) {
+            runtime_error(interp, interp->call_line, "parallel_map() worker count must be a positive int");
+            return NIL_VAL;
+        }
+        workers = AS_INT(args[2]) < PARALLEL_MAX_WORKERS
+            ? (int)AS_INT(args[2]) : PARALLEL_MAX_WORKERS;
+    }
+    
+    /* Workers write straight to stdout; keep earlier output ahead of them */
+    output_flush(&interp->out);
+    
+    char error[256];
+    Value result;
+    if (!parallel_map(interp, args[0], AS_ARRAY(args[1]), workers, &result,
+                      error, sizeof(error))) {
+        runtime_error(interp, interp->call_line, "parallel_map(): %s", error);
+        return NIL_VAL;
+    }
+    return result;
+}
+
+/* ============ Channels and Threads ============ */
+
+static bool check_channel(Interpreter* interp, const char* name, Value value) {
+    if (!IS_CHANNEL(value)) {
+        runtime_error(interp, interp->call_line, "%s() expects a channel", name);
+        return false;
+    }
+    return true;
+}
+
+static Value native_channel(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    int capacity = 16;
+    if (arg_count > 1) {
+        runtime_error(interp, interp->call_line, "channel() expects (capacity?)");
+        return NIL_VAL;
+    }
+    if (arg_count == 1) {
+        if (!IS_INT(args[0]) || AS_INT(args[0]) < 1 || AS_INT(args[0]) > 1 << 24) {
+            runtime_error(interp, interp->call_line, "channel() capacity must be an int from 1 to 16777216");
+            return NIL_VAL;
+        }
+        capacity = (int)AS_INT(args[0]);
+    }
+    return OBJ_VAL(channel_wrap(channel_create(capacity)));
+}
+
+static Value native_send(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_channel(interp, "send", args[0])) return NIL_VAL;
+    if (IS_NIL(args[1])) {
+        runtime_error(interp, interp->call_line, "send() cannot send nil; recv() returns nil for a closed channel");
+        return NIL_VAL;
+    }
+    
+    char error[256];
+    CloneBuffer message;
+    clone_buffer_init(&message);
+    if (!clone_write(&message, args[1], interp->global, false, error, sizeof(error))) {
+        clone_buffer_free(&message);
+        runtime_error(interp, interp->call_line, "send(): %s", error);
+        return NIL_VAL;
+    }
+    
+    if (channel_send(AS_CHANNEL(args[0])->channel, &message) == CHANNEL_CLOSED) {
+        clone_buffer_free(&message);
+        runtime_error(interp, interp->call_line, "send() on a closed channel");
+    }
+    return NIL_VAL;
+}
+
+/* Shared by recv and try_recv: nil when nothing was taken */
+static Value receive(Interpreter* interp, Value channel, bool block) {
+    CloneBuffer message;
+    if (channel_recv(AS_CHANNEL(channel)->channel, &message, block) != CHANNEL_OK) {
+        return NIL_VAL;
+    }
+    Value value = clone_read(&message, 0, interp->global);
+    clone_buffer_free(&message);
+    return value;
+}
+
+static Value native_recv(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_channel(interp, "recv", args[0])) return NIL_VAL;
+    return receive(interp, args[0], true);
+}
+
+static Value native_try_recv(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_channel(interp, "try_recv", args[0])) return NIL_VAL;
+    return receive(interp, args[0], false);
+}
+
+static Value native_close(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_channel(interp, "close", args[0])) return NIL_VAL;
+    channel_close(AS_CHANNEL(args[0])->channel);
+    return NIL_VAL;
+}
+
+static Value native_thread_start(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 1 || (!IS_FUNCTION(args[0]) && !IS_NATIVE(args[0]))) {
+        runtime_error(interp, interp->call_line, "thread_start() expects a function");
+        return NIL_VAL;
+    }
+    
+    /* The thread writes straight to stdout; keep earlier output ahead */
+    output_flush(&interp->out);
+    
+    char error[256];
+    ObjThread* thread = thread_start(interp, args[0], arg_count - 1, args + 1,
+                                     error, sizeof(error));
+    if (thread == NULL) {
+        runtime_error(interp, interp->call_line, "thread_start(): %s", error);
+        return NIL_VAL;
+    }
+    return OBJ_VAL(thread);
+}
+
+static Value native_thread_join(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_THREAD(args[0])) {
+        runtime_error(interp, interp->call_line, "thread_join() expects a thread");
+        return NIL_VAL;
+    }
+    
+    char error[256];
+    Value result;
+    if (!thread_join(interp, AS_THREAD(args[0]), &result, error, sizeof(error))) {
+        runtime_error(interp, interp->call_line, "thread_join(): %s", error);
+        return NIL_VAL;
+    }
+    return result;
+}
+
+/* freeze(v) - make v and everything inside it immutable, so threads
+   share it instead of copying; returns v */
+static Value native_freeze(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    char error[256];
+    if (!freeze_value(args[0], error, sizeof(error))) {
+        runtime_error(interp, interp->call_line, "freeze(): %s", error);
+        return NIL_VAL;
+    }
+    return args[0];
+}
+
+static Value native_is_frozen(int arg_count, Value* args) {
+    (void)arg_count;
+    /* Numbers, bools and nil never change anyway */
+    return BOOL_VAL(!IS_OBJ(args[0]) || IS_FROZEN(args[0]));
+}
+
 /* ============ Table Functions ============ */
 
 static Value native_keys(int arg_count, Value* args) {
@@ -502,12 +1504,311 @@ static Value native_has(int arg_count, Value* args) {
     return BOOL_VAL(table_has(AS_TABLE(args[0]), AS_STRING(args[1])));
 }
 
+/* ============ Timing ============ */
+
+static Value native_now_ns(int arg_count, Value* args) {
+    (void)arg_count;
+    (void)args;
+    return INT_VAL((int64_t)timer_now_ns());
+}
+
+static Value native_cpu_ns(int arg_count, Value* args) {
+    (void)arg_count;
+    (void)args;
+    return INT_VAL((int64_t)timer_cpu_ns());
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Set table[key] = value, dropping our reference to the key string */
+static void set_field(ObjTable* table, const char* key, Value value) {
+    ObjString* name = string_create(key, (int)strlen(key));
+    table_set(table, name, value, false);
+    obj_decref((Object*)name);
+}
+
+/* bench(fn, [iterations]) - time fn() after a warmup. Returns a table of
+   per-call nanoseconds (min, median, p99, max, mean) and the allocations
+   made by the memory layer during the timed calls. */
+static Value native_bench(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 1 || arg_count > 2 || !is_callable(args[0])) {
+        runtime_error(interp, interp->call_line, "bench() expects a function and an iteration count");
+        return NIL_VAL;
+    }
+    
+    int64_t iterations = 100;
+    if (arg_count == 2) {
+        if (!IS_INT(args[1]) || AS_INT(args[1]) < 1) {
+            runtime_error(interp, interp->call_line, "bench() iteration count must be a positive int");
+            return NIL_VAL;
+        }
+        iterations = AS_INT(args[1]);
+    }
+    
+    /* Warm caches and lazily created state before measuring */
+    int64_t warmup = iterations / 10 > 0 ? iterations / 10 : 1;
+    for (int64_t i = 0; i < warmup; i++) {
+        brisk_call(interp, args[0], 0, NULL);
+        if (interp->had_error) return NIL_VAL;
+    }
+    
+    uint64_t* samples = mem_alloc(sizeof(uint64_t) * iterations);
+    Isolate* isolate = &interp->isolate;
+    size_t allocs_before = isolate->allocation_count;
+    size_t bytes_before = isolate->allocated_total;
+    uint64_t total = 0;
+    
+    for (int64_t i = 0; i < iterations; i++) {
+        uint64_t start = timer_now_ns();
+        brisk_call(interp, args[0], 0, NULL);
+        samples[i] = timer_now_ns() - start;
+        total += samples[i];
+        if (interp->had_error) {
+            mem_free(samples, sizeof(uint64_t) * iterations);
+            return NIL_VAL;
+        }
+    }
+    
+    size_t allocs = isolate->allocation_count - allocs_before;
+    size_t bytes = isolate->allocated_total - bytes_before;
+    
+    qsort(samples, iterations, sizeof(uint64_t), compare_u64);
+    uint64_t median = iterations % 2 == 1
+        ? samples[iterations / 2]
+        : (samples[iterations / 2 - 1] + samples[iterations / 2]) / 2;
+    int64_t p99_index = (iterations * 99 + 99) / 100 - 1;
+    
+    ObjTable* result = table_create();
+    set_field(result, "iterations", INT_VAL(iterations));
+    set_field(result, "min", INT_VAL((int64_t)samples[0]));
+    set_field(result, "median", INT_VAL((int64_t)median));
+    set_field(result, "p99", INT_VAL((int64_t)samples[p99_index]));
+    set_field(result, "max", INT_VAL((int64_t)samples[iterations - 1]));
+    set_field(result, "mean", FLOAT_VAL((double)total / (double)iterations));
+    set_field(result, "total", INT_VAL((int64_t)total));
+    set_field(result, "allocs", INT_VAL((int64_t)allocs));
+    set_field(result, "alloc_bytes", INT_VAL((int64_t)bytes));
+    
+    mem_free(samples, sizeof(uint64_t) * iterations);
+    return OBJ_VAL(result);
+}
+
+/* ============ Coroutines ============ */
+
+static bool check_fd(Interpreter* interp, const char* name, Value value) {
+    if (!IS_INT(value) || AS_INT(value) < 0 || AS_INT(value) > INT32_MAX) {
+        runtime_error(interp, interp->call_line, "%s() expects a file descriptor", name);
+        return false;
+    }
+    return true;
+}
+
+static bool check_path(Interpreter* interp, const char* name, Value value) {
+    if (!IS_STRING(value)) {
+        runtime_error(interp, interp->call_line, "%s() expects a path string", name);
+        return false;
+    }
+    return true;
+}
+
+static Value fd_pair(int fds[2]) {
+    ObjArray* pair = array_create();
+    array_push(pair, INT_VAL(fds[0]));
+    array_push(pair, INT_VAL(fds[1]));
+    return OBJ_VAL(pair);
+}
+
+static Value native_spawn(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 1 || !IS_FUNCTION(args[0]) || AS_FUNCTION(args[0])->is_generator) {
+        runtime_error(interp, interp->call_line, "spawn() expects a function that is not a generator");
+        return NIL_VAL;
+    }
+    
+    ObjFunction* fn = AS_FUNCTION(args[0]);
+    if (fn->arity != arg_count - 1) {
+        runtime_error(interp, interp->call_line, "spawn() function expects %d arguments but got %d",
+                      fn->arity, arg_count - 1);
+        return NIL_VAL;
+    }
+    return OBJ_VAL(event_spawn(interp, fn, arg_count - 1, args + 1));
+}
+
+static Value native_await(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_TASK(args[0])) {
+        runtime_error(interp, interp->call_line, "await() expects a task");
+        return NIL_VAL;
+    }
+    
+    Value result;
+    if (!event_await(interp, AS_TASK(args[0]), &result)) return NIL_VAL;
+    return result;
+}
+
+/* sleep(ms) - let other coroutines run for at least ms milliseconds */
+static Value native_sleep(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    double ms;
+    if (IS_INT(args[0])) {
+        ms = (double)AS_INT(args[0]);
+    } else if (IS_FLOAT(args[0])) {
+        ms = AS_FLOAT(args[0]);
+    } else {
+        runtime_error(interp, interp->call_line, "sleep() expects a number of milliseconds");
+        return NIL_VAL;
+    }
+    if (!(ms >= 0)) {
+        runtime_error(interp, interp->call_line, "sleep() milliseconds cannot be negative");
+        return NIL_VAL;
+    }
+    event_sleep(interp, (int64_t)(ms * 1e6));
+    return NIL_VAL;
+}
+
+static Value native_pipe(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    (void)args;
+    int fds[2];
+    if (!event_pipe(fds)) {
+        runtime_error(interp, interp->call_line, "pipe(): %s", strerror(errno));
+        return NIL_VAL;
+    }
+    return fd_pair(fds);
+}
+
+static Value native_socketpair(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    (void)args;
+    int fds[2];
+    if (!event_socketpair(fds)) {
+        runtime_error(interp, interp->call_line, "socketpair(): %s", strerror(errno));
+        return NIL_VAL;
+    }
+    return fd_pair(fds);
+}
+
+/* fd_read(fd, [max]) - whatever is available, up to max bytes; "" at end
+   of input, nil on error */
+static Value native_fd_read(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    if (arg_count < 1 || arg_count > 2) {
+        runtime_error(interp, interp->call_line, "fd_read() expects (fd, max?)");
+        return NIL_VAL;
+    }
+    if (!check_fd(interp, "fd_read", args[0])) return NIL_VAL;
+    
+    int max = EVENT_READ_MAX;
+    if (arg_count == 2) {
+        if (!IS_INT(args[1]) || AS_INT(args[1]) < 1 || AS_INT(args[1]) > 1 << 24) {
+            runtime_error(interp, interp->call_line, "fd_read() max must be an int from 1 to 16777216");
+            return NIL_VAL;
+        }
+        max = (int)AS_INT(args[1]);
+    }
+    return event_read(interp, (int)AS_INT(args[0]), max);
+}
+
+/* fd_write(fd, s) - bytes written, or -1 on error */
+static Value native_fd_write(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_fd(interp, "fd_write", args[0])) return NIL_VAL;
+    if (!IS_STRING(args[1])) {
+        runtime_error(interp, interp->call_line, "fd_write() expects a string");
+        return NIL_VAL;
+    }
+    
+    /* Other coroutines run while this one waits; keep the text alive */
+    ObjString* text = AS_STRING(args[1]);
+    obj_incref((Object*)text);
+    int64_t written = event_write(interp, (int)AS_INT(args[0]), text->chars, (size_t)text->length);
+    obj_decref((Object*)text);
+    return INT_VAL(written);
+}
+
+static Value native_fd_close(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_fd(interp, "fd_close", args[0])) return NIL_VAL;
+    event_close(interp, (int)AS_INT(args[0]));
+    return NIL_VAL;
+}
+
+static Value native_unix_listen(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_path(interp, "unix_listen", args[0])) return NIL_VAL;
+    return INT_VAL(event_unix_listen(AS_STRING(args[0])->chars));
+}
+
+static Value native_unix_connect(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_path(interp, "unix_connect", args[0])) return NIL_VAL;
+    return INT_VAL(event_unix_connect(interp, AS_STRING(args[0])->chars));
+}
+
+static Value native_accept(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!check_fd(interp, "accept", args[0])) return NIL_VAL;
+    return INT_VAL(event_accept(interp, (int)AS_INT(args[0])));
+}
+
+/* spawn_process(cmd) - {pid, stdin, stdout}, the pipes non-blocking */
+static Value native_spawn_process(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_STRING(args[0])) {
+        runtime_error(interp, interp->call_line, "spawn_process() expects a command string");
+        return NIL_VAL;
+    }
+    
+    /* The child inherits stdout; keep earlier output ahead of its own */
+    output_flush(&interp->out);
+    
+    int input, output;
+    int pid = event_process(AS_STRING(args[0])->chars, &input, &output);
+    if (pid < 0) {
+        runtime_error(interp, interp->call_line, "spawn_process(): %s", strerror(errno));
+        return NIL_VAL;
+    }
+    
+    ObjTable* result = table_create();
+    set_field(result, "pid", INT_VAL(pid));
+    set_field(result, "stdin", INT_VAL(input));
+    set_field(result, "stdout", INT_VAL(output));
+    return OBJ_VAL(result);
+}
+
+static Value native_wait_process(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    if (!IS_INT(args[0]) || AS_INT(args[0]) < 1 || AS_INT(args[0]) > INT32_MAX) {
+        runtime_error(interp, interp->call_line, "wait_process() expects a process id");
+        return NIL_VAL;
+    }
+    return INT_VAL(event_wait_process(interp, (int)AS_INT(args[0])));
+}
+
 /* ============ Utility Functions ============ */
 
-static Value native_assert(int arg_count, Value* args) {
+static Value native_assert(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     if (arg_count < 1) return NIL_VAL;
     
     if (!value_is_truthy(args[0])) {
+        output_flush(&interp->out);
         if (arg_count >= 2 && IS_STRING(args[1])) {
             fprintf(stderr, "Assertion failed: %s\n", AS_CSTRING(args[1]));
         } else {
@@ -518,7 +1819,9 @@ static Value native_assert(int arg_count, Value* args) {
     return NIL_VAL;
 }
 
-static Value native_error(int arg_count, Value* args) {
+static Value native_error(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    output_flush(&interp->out);
     if (arg_count >= 1 && IS_STRING(args[0])) {
         fprintf(stderr, "Error: %s\n", AS_CSTRING(args[0]));
     } else {
@@ -534,21 +1837,53 @@ static Value native_clock(int arg_count, Value* args) {
     return FLOAT_VAL((double)clock() / CLOCKS_PER_SEC);
 }
 
-static Value native_exit(int arg_count, Value* args) {
+static Value native_exit(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
     int code = 0;
     if (arg_count >= 1 && IS_INT(args[0])) {
         code = (int)AS_INT(args[0]);
     }
+    output_flush(&interp->out);
     exit(code);
     return NIL_VAL;
 }
 
+static Value native_heap_report(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    (void)args;
+    heap_report(interp);
+    return NIL_VAL;
+}
+
+static Value native_ffi_stats(Interpreter* interp, void* data, int arg_count, Value* args) {
+    (void)data;
+    (void)arg_count;
+    (void)args;
+    output_flush(&interp->out);
+    ffi_trace_report();
+    return NIL_VAL;
+}
+
 /* Register all built-in functions */
 void register_all_builtins(Environment* env) {
     /* I/O */
-    register_native(env, "print", native_print, -1);
-    register_native(env, "println", native_println, -1);
-    register_native(env, "input", native_input, -1);
+    register_native_interp(env, "print", native_print, -1);
+    register_native_interp(env, "println", native_println, -1);
+    register_native_interp(env, "input", native_input, -1);
+    register_native_interp(env, "flush", native_flush, 0);
+    register_native_interp(env, "output_mode", native_output_mode, -1);
+    
+    /* Files */
+    register_native(env, "read_file", native_read_file, 1);
+    register_native(env, "write_file", native_write_file, 2);
+    register_native(env, "append_file", native_append_file, 2);
+    register_native(env, "lines", native_lines, 1);
+    register_native(env, "open_writer", native_open_writer, -1);
+    register_native(env, "file_read_line", native_file_read_line, 1);
+    register_native(env, "file_write", native_file_write, -1);
+    register_native(env, "file_writeln", native_file_writeln, -1);
+    register_native(env, "file_close", native_file_close, 1);
     
     /* Type conversion */
     register_native(env, "type", native_type, 1);
@@ -559,16 +1894,38 @@ void register_all_builtins(Environment* env) {
     
     /* Array */
     register_native(env, "len", native_len, 1);
-    register_native(env, "push", native_push, 2);
-    register_native(env, "pop", native_pop, 1);
+    register_native_interp(env, "push", native_push, 2);
+    register_native_interp(env, "pop", native_pop, 1);
     register_native(env, "first", native_first, 1);
     register_native(env, "last", native_last, 1);
-    register_native(env, "insert", native_insert, 3);
-    register_native(env, "remove", native_remove, 2);
+    register_native_interp(env, "insert", native_insert, 3);
+    register_native_interp(env, "remove", native_remove, 2);
+    
+    /* Higher-order */
+    register_native_interp(env, "map", native_map, 2);
+    register_native_interp(env, "filter", native_filter, 2);
+    register_native_interp(env, "reduce", native_reduce, -1);
+    register_native_interp(env, "each", native_each, 2);
+    register_native_interp(env, "any", native_any, -1);
+    register_native_interp(env, "all", native_all, -1);
+    
+    /* Iterators */
+    register_native_interp(env, "iter", native_iter, 1);
+    register_native_interp(env, "next", native_next, 1);
+    register_native_interp(env, "collect", native_collect, 1);
+    register_native_interp(env, "take", native_take, 2);
+    register_native_interp(env, "range", native_range, -1);
+    
+    /* Sorting */
+    register_native_interp(env, "sort", native_sort, -1);
+    register_native_interp(env, "stable_sort", native_stable_sort, -1);
+    register_native_interp(env, "sort_by", native_sort_by, 2);
     
     /* String */
     register_native(env, "substr", native_substr, -1);
-    register_native(env, "find", native_find, 2);
+    register_native(env, "find", native_find, -1);
+    register_native(env, "rfind", native_rfind, 2);
+    register_native(env, "count", native_count, 2);
     register_native(env, "replace", native_replace, 3);
     register_native(env, "split", native_split, 2);
     register_native(env, "join", native_join, 2);
@@ -589,14 +1946,62 @@ void register_all_builtins(Environment* env) {
     register_native(env, "cos", native_cos, 1);
     register_native(env, "tan", native_tan, 1);
     
+    /* Array math */
+    register_native_interp(env, "sum", native_sum, 1);
+    register_native_interp(env, "mean", native_mean, 1);
+    register_native_interp(env, "prod", native_prod, 1);
+    register_native_interp(env, "argmin", native_argmin, 1);
+    register_native_interp(env, "argmax", native_argmax, 1);
+    register_native_interp(env, "clamp", native_clamp, 3);
+    register_native_interp(env, "add", native_add, 2);
+    register_native_interp(env, "mul", native_mul, 2);
+    
+    /* JSON */
+    register_native_interp(env, "json_parse", native_json_parse, 1);
+    register_native_interp(env, "json_stringify", native_json_stringify, 1);
+    
+    /* Parallel */
+    register_native_interp(env, "parallel_map", native_parallel_map, -1);
+    
+    /* Channels and threads */
+    register_native_interp(env, "channel", native_channel, -1);
+    register_native_interp(env, "send", native_send, 2);
+    register_native_interp(env, "recv", native_recv, 1);
+    register_native_interp(env, "try_recv", native_try_recv, 1);
+    register_native_interp(env, "close", native_close, 1);
+    register_native_interp(env, "thread_start", native_thread_start, -1);
+    register_native_interp(env, "thread_join", native_thread_join, 1);
+    register_native_interp(env, "freeze", native_freeze, 1);
+    register_native(env, "is_frozen", native_is_frozen, 1);
+    
+    /* Coroutines */
+    register_native_interp(env, "spawn", native_spawn, -1);
+    register_native_interp(env, "await", native_await, 1);
+    register_native_interp(env, "sleep", native_sleep, 1);
+    register_native_interp(env, "pipe", native_pipe, 0);
+    register_native_interp(env, "socketpair", native_socketpair, 0);
+    register_native_interp(env, "fd_read", native_fd_read, -1);
+    register_native_interp(env, "fd_write", native_fd_write, 2);
+    register_native_interp(env, "fd_close", native_fd_close, 1);
+    register_native_interp(env, "unix_listen", native_unix_listen, 1);
+    register_native_interp(env, "unix_connect", native_unix_connect, 1);
+    register_native_interp(env, "accept", native_accept, 1);
+    register_native_interp(env, "spawn_process", native_spawn_process, 1);
+    register_native_interp(env, "wait_process", native_wait_process, 1);
+    
     /* Table */
     register_native(env, "keys", native_keys, 1);
     register_native(env, "values", native_values, 1);
     register_native(env, "has", native_has, 2);
     
     /* Utility */
-    register_native(env, "assert", native_assert, -1);
-    register_native(env, "error", native_error, -1);
+    register_native_interp(env, "assert", native_assert, -1);
+    register_native_interp(env, "error", native_error, -1);
     register_native(env, "clock", native_clock, 0);
-    register_native(env, "exit", native_exit, -1);
+    register_native(env, "now_ns", native_now_ns, 0);
+    register_native(env, "cpu_ns", native_cpu_ns, 0);
+    register_native_interp(env, "bench", native_bench, -1);
+    register_native_interp(env, "heap_report", native_heap_report, 0);
+    register_native_interp(env, "ffi_stats", native_ffi_stats, 0);
+    register_native_interp(env, "exit", native_exit, -1);
 }
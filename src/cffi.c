@@ -8,6 +8,9 @@
 #include <ffi.h>
 #include "cffi.h"
 #include "memory.h"
+#include "stats.h"
+#include "timer.h"
+#include "ffitrace.h"
 
 /* Get ffi_type for a CType */
 ffi_type* ctype_to_ffi(CType type) {
@@ -159,6 +162,7 @@ CFunctionDesc* cfunc_create(const char* name, CType return_type,
     desc->is_variadic = is_variadic;
     desc->func_ptr = func_ptr;
     desc->cif_prepared = false;
+    desc->trace = NULL;
     
     if (param_count > 0) {
         desc->param_types = mem_alloc(sizeof(CType) * param_count);
@@ -445,6 +449,10 @@ Value marshal_from_c(void* in, CType type) {
 
 /* Call a C function */
 Value cffi_call(CFunctionDesc* desc, int arg_count, Value* args) {
+    STAT_INC(ffi_calls);
+    bool tracing = ffi_tracing;
+    uint64_t start = tracing ? timer_now_ns() : 0;
+    
     if (!desc->cif_prepared) {
         if (!cfunc_prepare(desc)) {
             fprintf(stderr, "FFI Error: Failed to prepare call to %s\n", desc->name);
@@ -502,7 +510,9 @@ Value cffi_call(CFunctionDesc* desc, int arg_count, Value* args) {
     long long ret_storage[2] = {0, 0};  /* 16 bytes is enough for any return type */
     
     /* Make the call */
+    uint64_t called = tracing ? timer_now_ns() : 0;
     ffi_call(&desc->cif, FFI_FN(desc->func_ptr), &ret_storage, arg_values);
+    uint64_t returned = tracing ? timer_now_ns() : 0;
     
     /* Marshal return value */
     Value result = marshal_from_c(&ret_storage, desc->return_type);
@@ -511,6 +521,10 @@ Value cffi_call(CFunctionDesc* desc, int arg_count, Value* args) {
     if (arg_values) mem_free(arg_values, sizeof(void*) * arg_count);
     if (arg_storage) mem_free(arg_storage, 16 * arg_count);
     
+    if (tracing) {
+        ffi_trace_record(desc, called - start, returned - called,
+                         timer_now_ns() - returned);
+    }
     return result;
 }
 
@@ -0,0 +1,241 @@
+/*
+ * Brisk Language - Channels Implementation
+ * A bounded MPMC ring (Vyukov): every slot carries a sequence number that
+ * tells producers and consumers whose turn it is, so neither side takes a
+ * lock. Only a thread that finds the ring full or empty parks, on a futex
+ * word the other side bumps after each operation.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "channel.h"
+#include "memory.h"
+
+#define CACHE_LINE 64
+
+typedef struct {
+    size_t sequence;
+    CloneBuffer message;
+} ChannelSlot;
+
+struct Channel {
+    /* Producer and consumer positions on their own cache lines */
+    size_t send_position;
+    char send_pad[CACHE_LINE - sizeof(size_t)];
+    size_t recv_position;
+    char recv_pad[CACHE_LINE - sizeof(size_t)];
+    
+    ChannelSlot* slots;
+    size_t mask;
+    int ref_count;
+    int closed;
+    
+    /* Futex words, bumped after every send / receive, and how many
+       threads are parked on each */
+    uint32_t items;
+    uint32_t spaces;
+    int recv_waiters;
+    int send_waiters;
+};
+
+/* ============ Parking ============ */
+
+static void futex_wait(uint32_t* word, uint32_t seen) {
+    /* Returns at once if the word moved on since it was read */
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+}
+
+static void futex_wake(uint32_t* word, int count) {
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/* Tell one parked thread on the other side that something changed. The
+   counter is bumped before waiters is read, and a parker registers before
+   its last look at the ring, so a wakeup cannot fall between the two. */
+static void signal_event(uint32_t* word, int* waiters) {
+    __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(waiters, __ATOMIC_SEQ_CST) > 0) {
+        futex_wake(word, 1);
+    }
+}
+
+static bool is_closed(Channel* channel) {
+    return __atomic_load_n(&channel->closed, __ATOMIC_SEQ_CST) != 0;
+}
+
+/* ============ Ring ============ */
+
+static bool ring_push(Channel* channel, CloneBuffer* message) {
+    size_t position = __atomic_load_n(&channel->send_position, __ATOMIC_RELAXED);
+    ChannelSlot* slot;
+    
+    for (;;) {
+        slot = &channel->slots[position & channel->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&channel->send_position, &position,
+                                            position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  /* Full */
+        } else {
+            position = __atomic_load_n(&channel->send_position, __ATOMIC_RELAXED);
+        }
+    }
+    
+    slot->message = *message;
+    clone_buffer_init(message);
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+static bool ring_pop(Channel* channel, CloneBuffer* message) {
+    size_t position = __atomic_load_n(&channel->recv_position, __ATOMIC_RELAXED);
+    ChannelSlot* slot;
+    
+    for (;;) {
+        slot = &channel->slots[position & channel->mask];
+        size_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(position + 1);
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&channel->recv_position, &position,
+                                            position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  /* Empty */
+        } else {
+            position = __atomic_load_n(&channel->recv_position, __ATOMIC_RELAXED);
+        }
+    }
+    
+    *message = slot->message;
+    __atomic_store_n(&slot->sequence, position + channel->mask + 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+/* Whether the next push / pop would find its slot ready */
+static bool ring_has_space(Channel* channel) {
+    size_t position = __atomic_load_n(&channel->send_position, __ATOMIC_SEQ_CST);
+    ChannelSlot* slot = &channel->slots[position & channel->mask];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) >= position;
+}
+
+static bool ring_has_item(Channel* channel) {
+    size_t position = __atomic_load_n(&channel->recv_position, __ATOMIC_SEQ_CST);
+    ChannelSlot* slot = &channel->slots[position & channel->mask];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) >= position + 1;
+}
+
+/* ============ Channels ============ */
+
+Channel* channel_create(int capacity) {
+    size_t size = 2;
+    while ((int)size < capacity) size *= 2;
+    
+    /* Shared by every isolate, so outside their allocation counters */
+    void* memory = NULL;
+    ChannelSlot* slots = malloc(sizeof(ChannelSlot) * size);
+    if (slots == NULL || posix_memalign(&memory, CACHE_LINE, sizeof(Channel)) != 0) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    Channel* channel = memory;
+    memset(channel, 0, sizeof(Channel));
+    channel->slots = slots;
+    
+    for (size_t i = 0; i < size; i++) {
+        channel->slots[i].sequence = i;
+        clone_buffer_init(&channel->slots[i].message);
+    }
+    channel->mask = size - 1;
+    channel->ref_count = 1;
+    return channel;
+}
+
+void channel_retain(Channel* channel) {
+    __atomic_add_fetch(&channel->ref_count, 1, __ATOMIC_RELAXED);
+}
+
+void channel_release(Channel* channel) {
+    if (__atomic_sub_fetch(&channel->ref_count, 1, __ATOMIC_ACQ_REL) > 0) return;
+    
+    /* Messages nobody received still own their attachments */
+    CloneBuffer message;
+    while (ring_pop(channel, &message)) {
+        clone_buffer_free(&message);
+    }
+    free(channel->slots);
+    free(channel);
+}
+
+int channel_capacity(Channel* channel) {
+    return (int)channel->mask + 1;
+}
+
+ObjChannel* channel_wrap(Channel* channel) {
+    ObjChannel* handle = (ObjChannel*)allocate_object(sizeof(ObjChannel), OBJ_CHANNEL);
+    handle->channel = channel;
+    return handle;
+}
+
+ChannelStatus channel_send(Channel* channel, CloneBuffer* message) {
+    for (;;) {
+        if (is_closed(channel)) return CHANNEL_CLOSED;
+        if (ring_push(channel, message)) {
+            signal_event(&channel->items, &channel->recv_waiters);
+            return CHANNEL_OK;
+        }
+        
+        uint32_t seen = __atomic_load_n(&channel->spaces, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&channel->send_waiters, 1, __ATOMIC_SEQ_CST);
+        if (!ring_has_space(channel) && !is_closed(channel)) {
+            futex_wait(&channel->spaces, seen);
+        }
+        __atomic_sub_fetch(&channel->send_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+ChannelStatus channel_recv(Channel* channel, CloneBuffer* message, bool block) {
+    for (;;) {
+        if (ring_pop(channel, message)) {
+            signal_event(&channel->spaces, &channel->send_waiters);
+            return CHANNEL_OK;
+        }
+        if (is_closed(channel)) {
+            /* A send may have landed just before the close */
+            if (ring_pop(channel, message)) return CHANNEL_OK;
+            return CHANNEL_CLOSED;
+        }
+        if (!block) return CHANNEL_EMPTY;
+        
+        uint32_t seen = __atomic_load_n(&channel->items, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&channel->recv_waiters, 1, __ATOMIC_SEQ_CST);
+        if (!ring_has_item(channel) && !is_closed(channel)) {
+            futex_wait(&channel->items, seen);
+        }
+        __atomic_sub_fetch(&channel->recv_waiters, 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void channel_close(Channel* channel) {
+    __atomic_store_n(&channel->closed, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&channel->items, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&channel->spaces, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&channel->items, INT_MAX);
+    futex_wake(&channel->spaces, INT_MAX);
+}
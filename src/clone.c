@@ -0,0 +1,694 @@
+/*
+ * Brisk Language - Value Cloning Between Isolates Implementation
+ * Values are flattened into a tagged byte stream: varints for ints and
+ * lengths, raw bytes for floats and strings, and back-references for
+ * containers, functions and scopes already written in the same message.
+ * Frozen objects travel as a reference to the object itself.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clone.h"
+#include "memory.h"
+#include "vecmath.h"
+#include "channel.h"
+
+/* Deeper graphs are refused rather than risking the C stack */
+#define CLONE_MAX_DEPTH 4096
+
+typedef enum {
+    CLONE_NIL,
+    CLONE_FALSE,
+    CLONE_TRUE,
+    CLONE_INT,
+    CLONE_FLOAT,
+    CLONE_STRING,
+    CLONE_STRING_MOVED,    /* Attachment holding a finished ObjString */
+    CLONE_ARRAY,
+    CLONE_NUMBERS_MOVED,   /* Attachment holding the elements of a number array */
+    CLONE_TABLE,
+    CLONE_FUNCTION,
+    CLONE_NATIVE,
+    CLONE_CHANNEL,
+    CLONE_FROZEN,          /* Attachment holding a frozen object */
+    CLONE_REF,
+    CLONE_ENV,
+    CLONE_ENV_GLOBAL,      /* The receiver's global scope */
+    CLONE_ENV_GLOBALS,     /* Same, with the sender's globals following */
+    CLONE_ENV_BUILTINS
+} CloneTag;
+
+/* ============ Buffer ============ */
+
+void clone_buffer_init(CloneBuffer* buffer) {
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->attachments = NULL;
+    buffer->attachment_count = 0;
+    buffer->attachment_capacity = 0;
+}
+
+void clone_buffer_free(CloneBuffer* buffer) {
+    for (int i = 0; i < buffer->attachment_count; i++) {
+        CloneAttachment* attachment = &buffer->attachments[i];
+        if (attachment->kind == ATTACH_CHANNEL) {
+            channel_release(attachment->pointer);
+        } else if (attachment->kind == ATTACH_FROZEN) {
+            obj_decref(attachment->pointer);
+        } else {
+            free(attachment->pointer);  /* NULL once adopted */
+        }
+    }
+    free(buffer->attachments);
+    free(buffer->data);
+    clone_buffer_init(buffer);
+}
+
+static void* checked_malloc(size_t size) {
+    void* pointer = malloc(size);
+    if (pointer == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    return pointer;
+}
+
+static int attach(CloneBuffer* buffer, void* pointer, CloneAttachmentKind kind) {
+    if (buffer->attachment_count == buffer->attachment_capacity) {
+        int capacity = buffer->attachment_capacity < 8 ? 8 : buffer->attachment_capacity * 2;
+        CloneAttachment* attachments = realloc(buffer->attachments,
+                                               sizeof(CloneAttachment) * capacity);
+        if (attachments == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        buffer->attachments = attachments;
+        buffer->attachment_capacity = capacity;
+    }
+    buffer->attachments[buffer->attachment_count].pointer = pointer;
+    buffer->attachments[buffer->attachment_count].kind = kind;
+    return buffer->attachment_count++;
+}
+
+static void buffer_grow(CloneBuffer* buffer, size_t needed) {
+    size_t capacity = buffer->capacity < 64 ? 64 : buffer->capacity * 2;
+    while (capacity < buffer->length + needed) capacity *= 2;
+    
+    uint8_t* data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+static inline void put_bytes(CloneBuffer* buffer, const void* bytes, size_t count) {
+    if (buffer->capacity - buffer->length < count) buffer_grow(buffer, count);
+    memcpy(buffer->data + buffer->length, bytes, count);
+    buffer->length += count;
+}
+
+static inline void put_byte(CloneBuffer* buffer, uint8_t byte) {
+    if (buffer->length == buffer->capacity) buffer_grow(buffer, 1);
+    buffer->data[buffer->length++] = byte;
+}
+
+static void put_varint(CloneBuffer* buffer, uint64_t value) {
+    uint8_t bytes[10];
+    int count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (uint8_t)value;
+    put_bytes(buffer, bytes, count);
+}
+
+static void put_pointer(CloneBuffer* buffer, const void* pointer) {
+    put_bytes(buffer, &pointer, sizeof(pointer));
+}
+
+static void put_chars(CloneBuffer* buffer, const char* chars, int length) {
+    put_varint(buffer, (uint64_t)length);
+    put_bytes(buffer, chars, length);
+}
+
+/* ============ Writer ============ */
+
+typedef struct {
+    CloneBuffer* buffer;
+    Environment* global;
+    Environment* builtins;
+    bool module;
+    bool globals_sent;
+    
+    /* Objects and scopes already written, by address; ids count up in
+       write order so the reader can number them the same way */
+    const void** memo_keys;
+    int* memo_ids;
+    int memo_count;
+    int memo_capacity;
+    
+    char* error;
+    int error_size;
+} CloneWriter;
+
+static uint32_t pointer_hash(const void* pointer) {
+    uint64_t bits = (uint64_t)(uintptr_t)pointer;
+    return (uint32_t)((bits >> 4) * 0x9E3779B97F4A7C15ULL >> 32);
+}
+
+static int memo_find(CloneWriter* w, const void* key) {
+    if (w->memo_count == 0) return -1;
+    uint32_t mask = (uint32_t)w->memo_capacity - 1;
+    for (uint32_t i = pointer_hash(key) & mask;; i = (i + 1) & mask) {
+        if (w->memo_keys[i] == NULL) return -1;
+        if (w->memo_keys[i] == key) return w->memo_ids[i];
+    }
+}
+
+static void memo_insert(const void** keys, int* ids, int capacity, const void* key, int id) {
+    uint32_t mask = (uint32_t)capacity - 1;
+    uint32_t i = pointer_hash(key) & mask;
+    while (keys[i] != NULL) i = (i + 1) & mask;
+    keys[i] = key;
+    ids[i] = id;
+}
+
+static void memo_add(CloneWriter* w, const void* key) {
+    /* Keep the load under one half */
+    if ((w->memo_count + 1) * 2 > w->memo_capacity) {
+        int capacity = w->memo_capacity < 16 ? 16 : w->memo_capacity * 2;
+        const void** keys = mem_alloc(sizeof(void*) * capacity);
+        int* ids = mem_alloc(sizeof(int) * capacity);
+        memset(keys, 0, sizeof(void*) * capacity);
+        
+        for (int i = 0; i < w->memo_capacity; i++) {
+            if (w->memo_keys[i] != NULL) {
+                memo_insert(keys, ids, capacity, w->memo_keys[i], w->memo_ids[i]);
+            }
+        }
+        if (w->memo_keys != NULL) {
+            mem_free(w->memo_keys, sizeof(void*) * w->memo_capacity);
+            mem_free(w->memo_ids, sizeof(int) * w->memo_capacity);
+        }
+        w->memo_keys = keys;
+        w->memo_ids = ids;
+        w->memo_capacity = capacity;
+    }
+    
+    memo_insert(w->memo_keys, w->memo_ids, w->memo_capacity, key, w->memo_count);
+    w->memo_count++;
+}
+
+/* A value that cannot cross: nil inside a module, an error otherwise */
+static bool refuse(CloneWriter* w, const char* what) {
+    if (w->module) {
+        put_byte(w->buffer, CLONE_NIL);
+        return true;
+    }
+    snprintf(w->error, w->error_size, "cannot send %s to another thread", what);
+    return false;
+}
+
+static bool write_value(CloneWriter* w, Value value, int depth);
+static bool write_env(CloneWriter* w, Environment* env, int depth);
+
+static bool write_entries(CloneWriter* w, ObjTable* table, bool with_const, int depth) {
+    int live = 0;
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->entries[i].key != NULL) live++;
+    }
+    
+    put_varint(w->buffer, (uint64_t)live);
+    for (int i = 0; i < table->capacity; i++) {
+        TableEntry* entry = &table->entries[i];
+        if (entry->key == NULL) continue;
+        
+        put_chars(w->buffer, entry->key->chars, entry->key->length);
+        if (with_const) put_byte(w->buffer, entry->is_const ? 1 : 0);
+        if (!write_value(w, entry->value, depth + 1)) return false;
+    }
+    return true;
+}
+
+static bool write_env(CloneWriter* w, Environment* env, int depth) {
+    if (env == NULL) {
+        put_byte(w->buffer, CLONE_NIL);
+        return true;
+    }
+    if (env == w->builtins) {
+        put_byte(w->buffer, CLONE_ENV_BUILTINS);
+        return true;
+    }
+    if (env == w->global) {
+        if (!w->module || w->globals_sent) {
+            put_byte(w->buffer, CLONE_ENV_GLOBAL);
+            return true;
+        }
+        w->globals_sent = true;
+        put_byte(w->buffer, CLONE_ENV_GLOBALS);
+        return write_entries(w, env->variables, true, depth);
+    }
+    if (depth > CLONE_MAX_DEPTH) return refuse(w, "a value nested this deeply");
+    
+    int id = memo_find(w, env);
+    if (id >= 0) {
+        put_byte(w->buffer, CLONE_REF);
+        put_varint(w->buffer, (uint64_t)id);
+        return true;
+    }
+    memo_add(w, env);
+    
+    put_byte(w->buffer, CLONE_ENV);
+    if (!write_env(w, env->enclosing, depth + 1)) return false;
+    return write_entries(w, env->variables, true, depth);
+}
+
+static bool write_object(CloneWriter* w, Object* obj, int depth) {
+    switch (obj->type) {
+        case OBJ_ARRAY: {
+            ObjArray* array = (ObjArray*)obj;
+            size_t size = sizeof(Value) * array->count;
+            if (!w->module && size >= CLONE_MOVE_MIN &&
+                vec_kind(array->elements, array->count) != VEC_INVALID) {
+                /* Numbers hold no references, so the elements are copied
+                   once and handed over as a block */
+                Value* elements = checked_malloc(size);
+                memcpy(elements, array->elements, size);
+                put_byte(w->buffer, CLONE_NUMBERS_MOVED);
+                put_varint(w->buffer, (uint64_t)array->count);
+                put_varint(w->buffer, (uint64_t)attach(w->buffer, elements, ATTACH_MEMORY));
+                return true;
+            }
+            
+            put_byte(w->buffer, CLONE_ARRAY);
+            put_varint(w->buffer, (uint64_t)array->count);
+            for (int i = 0; i < array->count; i++) {
+                if (!write_value(w, array->elements[i], depth + 1)) return false;
+            }
+            return true;
+        }
+        
+        case OBJ_TABLE:
+            put_byte(w->buffer, CLONE_TABLE);
+            return write_entries(w, (ObjTable*)obj, false, depth);
+        
+        case OBJ_FUNCTION: {
+            /* The AST is never modified while running, so the receiver
+               can share parameters, body and compiled code with the sender */
+            ObjFunction* fn = (ObjFunction*)obj;
+            put_byte(w->buffer, CLONE_FUNCTION);
+            if (fn->name != NULL) {
+                put_varint(w->buffer, strlen(fn->name) + 1);
+                put_bytes(w->buffer, fn->name, strlen(fn->name));
+            } else {
+                put_varint(w->buffer, 0);
+            }
+            put_varint(w->buffer, (uint64_t)fn->arity);
+            put_byte(w->buffer, fn->is_generator ? 1 : 0);
+            put_pointer(w->buffer, fn->params);
+            put_pointer(w->buffer, fn->param_lengths);
+            put_pointer(w->buffer, fn->body);
+            put_bytes(w->buffer, &fn->compiled, sizeof(fn->compiled));
+            return write_env(w, fn->closure, depth + 1);
+        }
+        
+        default:
+            return false;
+    }
+}
+
+static bool write_value(CloneWriter* w, Value value, int depth) {
+    switch (value.type) {
+        case VAL_NIL:
+            put_byte(w->buffer, CLONE_NIL);
+            return true;
+        case VAL_BOOL:
+            put_byte(w->buffer, AS_BOOL(value) ? CLONE_TRUE : CLONE_FALSE);
+            return true;
+        case VAL_INT: {
+            /* Zigzag so small negative numbers stay short */
+            int64_t x = AS_INT(value);
+            put_byte(w->buffer, CLONE_INT);
+            put_varint(w->buffer, ((uint64_t)x << 1) ^ (uint64_t)(x >> 63));
+            return true;
+        }
+        case VAL_FLOAT:
+            put_byte(w->buffer, CLONE_FLOAT);
+            put_bytes(w->buffer, &value.as.floating, sizeof(double));
+            return true;
+        case VAL_OBJ:
+            break;
+    }
+    
+    Object* obj = AS_OBJ(value);
+    if (obj->frozen) {
+        /* Nothing can change it, so the receiver shares this one; the
+           message holds a reference until it is freed */
+        obj_incref(obj);
+        put_byte(w->buffer, CLONE_FROZEN);
+        put_varint(w->buffer, (uint64_t)attach(w->buffer, obj, ATTACH_FROZEN));
+        return true;
+    }
+    
+    switch (obj->type) {
+        case OBJ_STRING: {
+            ObjString* string = (ObjString*)obj;
+            if (w->module || string->length < CLONE_MOVE_MIN) {
+                put_byte(w->buffer, CLONE_STRING);
+                put_chars(w->buffer, string->chars, string->length);
+                return true;
+            }
+            
+            /* Build the receiver's string here so it adopts it as is */
+            size_t size = sizeof(ObjString) + string->length + 1;
+            ObjString* moved = checked_malloc(size);
+            moved->obj.type = OBJ_STRING;
+            moved->obj.ref_count = 1;
+            moved->obj.marked = false;
+            moved->obj.frozen = false;
+            moved->obj.heap_slot = 0;
+            moved->obj.next = NULL;
+            moved->length = string->length;
+            moved->hash = string->hash;
+            memcpy(moved->chars, string->chars, string->length + 1);
+            put_byte(w->buffer, CLONE_STRING_MOVED);
+            put_varint(w->buffer, (uint64_t)attach(w->buffer, moved, ATTACH_MEMORY));
+            return true;
+        }
+        
+        case OBJ_CHANNEL: {
+            /* The message holds its own reference until it is freed */
+            Channel* channel = ((ObjChannel*)obj)->channel;
+            channel_retain(channel);
+            put_byte(w->buffer, CLONE_CHANNEL);
+            put_varint(w->buffer, (uint64_t)attach(w->buffer, channel, ATTACH_CHANNEL));
+            return true;
+        }
+        
+        case OBJ_NATIVE: {
+            /* Builtins are plain C functions, valid in every isolate */
+            ObjNative* native = (ObjNative*)obj;
+            if (native->user_data != NULL) return refuse(w, "a bound native function");
+            put_byte(w->buffer, CLONE_NATIVE);
+            put_bytes(w->buffer, &native->function, sizeof(native->function));
+            put_bytes(w->buffer, &native->interp_function, sizeof(native->interp_function));
+            put_varint(w->buffer, (uint64_t)(native->arity + 1));
+            put_pointer(w->buffer, native->name);
+            return true;
+        }
+        
+        case OBJ_ARRAY:
+        case OBJ_TABLE:
+        case OBJ_FUNCTION: {
+            if (depth > CLONE_MAX_DEPTH) return refuse(w, "a value nested this deeply");
+            
+            int id = memo_find(w, obj);
+            if (id >= 0) {
+                put_byte(w->buffer, CLONE_REF);
+                put_varint(w->buffer, (uint64_t)id);
+                return true;
+            }
+            memo_add(w, obj);
+            return write_object(w, obj, depth);
+        }
+        
+        case OBJ_ITERATOR:
+            /* A paused generator lives on this thread's stack */
+            return refuse(w, "an iterator");
+        
+        default: {
+            char what[64];
+            snprintf(what, sizeof(what), "a %s", value_type_name(value));
+            return refuse(w, what);
+        }
+    }
+}
+
+bool clone_write(CloneBuffer* buffer, Value value, Environment* global,
+                 bool module, char* error, int error_size) {
+    CloneWriter w;
+    w.buffer = buffer;
+    w.global = global;
+    w.builtins = global != NULL ? global->enclosing : NULL;
+    w.module = module;
+    w.globals_sent = false;
+    w.memo_keys = NULL;
+    w.memo_ids = NULL;
+    w.memo_count = 0;
+    w.memo_capacity = 0;
+    w.error = error;
+    w.error_size = error_size;
+    
+    bool ok = write_value(&w, value, 0);
+    
+    if (w.memo_keys != NULL) {
+        mem_free(w.memo_keys, sizeof(void*) * w.memo_capacity);
+        mem_free(w.memo_ids, sizeof(int) * w.memo_capacity);
+    }
+    return ok;
+}
+
+/* ============ Reader ============ */
+
+typedef struct {
+    CloneBuffer* buffer;
+    const uint8_t* position;
+    Environment* global;
+    Environment* builtins;
+    
+    /* Objects and scopes in the order the writer numbered them */
+    void** nodes;
+    int node_count;
+    int node_capacity;
+} CloneReader;
+
+static uint64_t get_varint(CloneReader* r) {
+    uint64_t value = 0;
+    int shift = 0;
+    for (;;) {
+        uint8_t byte = *r->position++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) return value;
+        shift += 7;
+    }
+}
+
+static void* get_pointer(CloneReader* r) {
+    void* pointer;
+    memcpy(&pointer, r->position, sizeof(pointer));
+    r->position += sizeof(pointer);
+    return pointer;
+}
+
+static void add_node(CloneReader* r, void* node) {
+    if (r->node_count == r->node_capacity) {
+        int capacity = r->node_capacity < 8 ? 8 : r->node_capacity * 2;
+        r->nodes = mem_realloc(r->nodes, sizeof(void*) * r->node_capacity,
+                               sizeof(void*) * capacity);
+        r->node_capacity = capacity;
+    }
+    r->nodes[r->node_count++] = node;
+}
+
+static void release(Value value) {
+    if (IS_OBJ(value)) obj_decref(AS_OBJ(value));
+}
+
+static Value read_value(CloneReader* r);
+static Environment* read_env(CloneReader* r);
+
+static void read_entries(CloneReader* r, ObjTable* table, bool with_const) {
+    int count = (int)get_varint(r);
+    table_reserve(table, table->count + count);
+    
+    for (int i = 0; i < count; i++) {
+        int length = (int)get_varint(r);
+        ObjString* key = string_create((const char*)r->position, length);
+        r->position += length;
+        bool is_const = with_const ? *r->position++ != 0 : false;
+        
+        Value value = read_value(r);
+        table_set(table, key, value, is_const);
+        obj_decref((Object*)key);
+        release(value);
+    }
+}
+
+static Environment* read_env(CloneReader* r) {
+    uint8_t tag = *r->position++;
+    Environment* env = NULL;
+    
+    switch (tag) {
+        case CLONE_NIL:
+            return NULL;
+        case CLONE_ENV_BUILTINS:
+            env = r->builtins;
+            break;
+        case CLONE_ENV_GLOBAL:
+            env = r->global;
+            break;
+        case CLONE_ENV_GLOBALS:
+            read_entries(r, r->global->variables, true);
+            env = r->global;
+            break;
+        case CLONE_REF:
+            env = r->nodes[get_varint(r)];
+            break;
+        default: {
+            /* CLONE_ENV: number it before its contents, which may refer
+               back to it through a closure */
+            Environment* created = env_create(NULL);
+            add_node(r, created);
+            created->enclosing = read_env(r);
+            read_entries(r, created->variables, true);
+            return created;
+        }
+    }
+    
+    env_incref(env);
+    return env;
+}
+
+static Value read_value(CloneReader* r) {
+    uint8_t tag = *r->position++;
+    
+    switch (tag) {
+        case CLONE_NIL:
+            return NIL_VAL;
+        case CLONE_FALSE:
+            return BOOL_VAL(false);
+        case CLONE_TRUE:
+            return BOOL_VAL(true);
+        case CLONE_INT: {
+            uint64_t bits = get_varint(r);
+            return INT_VAL((int64_t)(bits >> 1) ^ -(int64_t)(bits & 1));
+        }
+        case CLONE_FLOAT: {
+            double x;
+            memcpy(&x, r->position, sizeof(double));
+            r->position += sizeof(double);
+            return FLOAT_VAL(x);
+        }
+        case CLONE_STRING: {
+            int length = (int)get_varint(r);
+            ObjString* string = string_create_uninterned((const char*)r->position, length);
+            r->position += length;
+            return OBJ_VAL(string);
+        }
+        case CLONE_STRING_MOVED: {
+            CloneAttachment* attachment = &r->buffer->attachments[get_varint(r)];
+            ObjString* string = attachment->pointer;
+            attachment->pointer = NULL;
+            object_adopt((Object*)string, sizeof(ObjString) + string->length + 1);
+            return OBJ_VAL(string);
+        }
+        case CLONE_NUMBERS_MOVED: {
+            int count = (int)get_varint(r);
+            CloneAttachment* attachment = &r->buffer->attachments[get_varint(r)];
+            ObjArray* array = array_create();
+            add_node(r, array);
+            array->elements = attachment->pointer;
+            array->count = count;
+            array->capacity = count;
+            attachment->pointer = NULL;
+            mem_adopt(sizeof(Value) * count);
+            return OBJ_VAL(array);
+        }
+        case CLONE_CHANNEL: {
+            Channel* channel = r->buffer->attachments[get_varint(r)].pointer;
+            channel_retain(channel);
+            return OBJ_VAL(channel_wrap(channel));
+        }
+        case CLONE_FROZEN: {
+            Object* obj = r->buffer->attachments[get_varint(r)].pointer;
+            obj_incref(obj);
+            return OBJ_VAL(obj);
+        }
+        case CLONE_ARRAY: {
+            ObjArray* array = array_create();
+            add_node(r, array);
+            int count = (int)get_varint(r);
+            array_reserve(array, count);
+            for (int i = 0; i < count; i++) {
+                Value element = read_value(r);
+                array_push(array, element);
+                release(element);
+            }
+            return OBJ_VAL(array);
+        }
+        case CLONE_TABLE: {
+            ObjTable* table = table_create();
+            add_node(r, table);
+            read_entries(r, table, false);
+            return OBJ_VAL(table);
+        }
+        case CLONE_FUNCTION: {
+            int name_length = (int)get_varint(r);
+            const char* name = NULL;
+            if (name_length > 0) {
+                name_length--;
+                name = (const char*)r->position;
+                r->position += name_length;
+            }
+            int arity = (int)get_varint(r);
+            bool is_generator = *r->position++ != 0;
+            char** params = get_pointer(r);
+            int* param_lengths = get_pointer(r);
+            AstNode* body = get_pointer(r);
+            CompiledBody compiled;
+            memcpy(&compiled, r->position, sizeof(compiled));
+            r->position += sizeof(compiled);
+            
+            ObjFunction* fn = function_create(name, name_length, params,
+                                              param_lengths, arity, body, NULL);
+            fn->is_generator = is_generator;
+            fn->compiled = compiled;
+            add_node(r, fn);
+            fn->closure = read_env(r);
+            return OBJ_VAL(fn);
+        }
+        case CLONE_NATIVE: {
+            NativeFn function;
+            NativeInterpFn interp_function;
+            memcpy(&function, r->position, sizeof(function));
+            r->position += sizeof(function);
+            memcpy(&interp_function, r->position, sizeof(interp_function));
+            r->position += sizeof(interp_function);
+            int arity = (int)get_varint(r) - 1;
+            const char* name = get_pointer(r);
+            
+            ObjNative* native = native_create(function, arity, name);
+            native->interp_function = interp_function;
+            return OBJ_VAL(native);
+        }
+        default: {
+            /* CLONE_REF */
+            Object* obj = r->nodes[get_varint(r)];
+            obj_incref(obj);
+            return OBJ_VAL(obj);
+        }
+    }
+}
+
+Value clone_read(CloneBuffer* buffer, size_t offset, Environment* global) {
+    CloneReader r;
+    r.buffer = buffer;
+    r.position = buffer->data + offset;
+    r.global = global;
+    r.builtins = global != NULL ? global->enclosing : NULL;
+    r.nodes = NULL;
+    r.node_count = 0;
+    r.node_capacity = 0;
+    
+    Value value = read_value(&r);
+    
+    if (r.nodes != NULL) {
+        mem_free(r.nodes, sizeof(void*) * r.node_capacity);
+    }
+    return value;
+}
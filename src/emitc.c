@@ -0,0 +1,1947 @@
+/*
+ * Brisk Language - C Code Generator Implementation
+ * Each function (and the program itself) becomes one C function that does
+ * what exec and eval would do for its body, calling the same operations:
+ * variable_get, binary_op, call_value and so on, with the common integer
+ * and float cases inline (aot.h). Control flow is a pending reason plus a
+ * goto to the cleanup of the innermost scope, which runs that scope's
+ * defers, drops its locals and passes the jump on to the next scope out.
+ *
+ * Variables that no nested function can see are kept in C locals that
+ * hold a reference the way a scope would; all others, and everything at
+ * the top level of the program, live in environments as they do in the
+ * interpreter, so closures, modules and threads find them by name.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <unistd.h>
+#include "emitc.h"
+#include "lexer.h"
+#include "parser.h"
+#include "cheader.h"
+#include "memory.h"
+
+/* Modules importing modules past this depth are taken to import each
+   other forever */
+#define MAX_MODULE_DEPTH 32
+
+/* Room for the C expression of an operand: a temporary, a local or a
+   literal */
+#define OPERAND_SIZE 64
+
+/* ============ Text ============ */
+
+typedef struct {
+    char* chars;
+    size_t length;
+    size_t capacity;
+} Text;
+
+static void text_write(Text* text, const char* chars, size_t length) {
+    if (text->length + length + 1 > text->capacity) {
+        size_t capacity = text->capacity < 256 ? 256 : text->capacity;
+        while (capacity < text->length + length + 1) capacity *= 2;
+        char* grown = realloc(text->chars, capacity);
+        if (grown == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        text->chars = grown;
+        text->capacity = capacity;
+    }
+    memcpy(text->chars + text->length, chars, length);
+    text->length += length;
+    text->chars[text->length] = '\0';
+}
+
+static void text_vprintf(Text* text, const char* format, va_list args) {
+    char buffer[256];
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(buffer, sizeof(buffer), format, copy);
+    va_end(copy);
+    if (length < (int)sizeof(buffer)) {
+        text_write(text, buffer, length);
+        return;
+    }
+    
+    char* large = malloc(length + 1);
+    if (large == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    vsnprintf(large, length + 1, format, args);
+    text_write(text, large, length);
+    free(large);
+}
+
+static void text_printf(Text* text, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    text_vprintf(text, format, args);
+    va_end(args);
+}
+
+/* chars as a C string literal; '?' is escaped so no trigraph forms */
+static void text_quote(Text* text, const char* chars, int length) {
+    text_write(text, "\"", 1);
+    for (int i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)chars[i];
+        if (c == '"' || c == '\\' || c == '?') {
+            char escaped[2] = {'\\', (char)c};
+            text_write(text, escaped, 2);
+        } else if (c >= 0x20 && c < 0x7f) {
+            text_write(text, &chars[i], 1);
+        } else {
+            text_printf(text, "\\%03o", c);
+        }
+    }
+    text_write(text, "\"", 1);
+}
+
+static void text_free(Text* text) {
+    free(text->chars);
+    text->chars = NULL;
+    text->length = 0;
+    text->capacity = 0;
+}
+
+/* ============ Names ============ */
+
+/* Borrowed from the AST, which outlives the emitter */
+typedef struct {
+    const char* chars;
+    int length;
+} Name;
+
+typedef struct {
+    Name* names;
+    int count;
+    int capacity;
+} NameList;
+
+static int name_find(const NameList* list, const char* chars, int length) {
+    for (int i = 0; i < list->count; i++) {
+        if (list->names[i].length == length &&
+            memcmp(list->names[i].chars, chars, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Index of chars in list, added if it is not there yet */
+static int name_intern(NameList* list, const char* chars, int length) {
+    int index = name_find(list, chars, length);
+    if (index >= 0) return index;
+    
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity < 16 ? 16 : list->capacity * 2;
+        list->names = realloc(list->names, sizeof(Name) * list->capacity);
+    }
+    list->names[list->count].chars = chars;
+    list->names[list->count].length = length;
+    return list->count++;
+}
+
+/* ============ Emitter State ============ */
+
+/* A module compiled in where an @import names it */
+typedef struct {
+    AstNode* import;
+    AstNode* program;        /* NULL if it could not be read or parsed */
+    char* source;
+    char error[600];         /* Reported at run time instead */
+} Module;
+
+/* C signature of a direct call helper, direct_N */
+typedef struct {
+    CType return_type;
+    CType* param_types;
+    int param_count;
+    bool called;             /* Only helpers a call uses are written out */
+} Helper;
+
+/* A header function the program may call */
+typedef struct {
+    const char* name;
+    int helper;              /* -1 if it cannot be called directly */
+    int param_count;
+} Signature;
+
+typedef struct {
+    NameList constants;
+    NameList headers;        /* Headers whose signatures were read */
+
+    Module** modules;
+    int module_count;
+    int module_capacity;
+    int module_depth;
+
+    Signature* signatures;
+    int signature_count;
+    int signature_capacity;
+    char** signature_names;  /* Owned copies; header parsers are freed */
+
+    Helper* helpers;
+    int helper_count;
+    int helper_capacity;
+
+    Text descriptors;        /* params_N, body_N, function_N and parts_N */
+    Text bodies;
+    int function_count;
+    int part_count;
+    bool failed;
+} Emitter;
+
+/* A name declared in a scope */
+typedef struct {
+    const char* name;
+    int length;
+    int local;               /* lN holding it, or -1 if it is in an environment */
+    bool is_const;
+} Binding;
+
+typedef struct {
+    AstNode* statement;
+    int flag;                /* dN, set when the defer statement ran */
+} Defer;
+
+typedef struct Scope {
+    struct Scope* parent;    /* NULL at the function's parameters */
+    Binding* bindings;
+    int binding_count;
+    int binding_capacity;
+    Defer* defers;
+    int defer_count;
+    int defer_capacity;
+    bool global;             /* Top level of the program */
+    int inlining;            /* Modules being compiled into it */
+} Scope;
+
+/* The C function being written */
+typedef struct {
+    Emitter* emitter;
+    Text decls;
+    Text code;
+    int indent;
+    NameList captured;       /* Names nested functions refer to */
+    Scope* scope;
+    int exit;                /* Label to go to once pending or had_error is set */
+    int temps;
+    int locals;
+    int arrays;
+    int envs;
+    int flags;
+    int loops;
+    int saves;
+    int labels;
+} FnState;
+
+static void emit_stmt(FnState* fs, AstNode* node);
+static void emit_expr(FnState* fs, AstNode* node, char* out);
+static int emit_function(Emitter* e, const char* name, int name_length,
+                         char** params, int* param_lengths, int param_count,
+                         AstNode* body, bool is_generator);
+
+static int constant(FnState* fs, const char* chars, int length) {
+    return name_intern(&fs->emitter->constants, chars, length);
+}
+
+static bool is_module_path(const char* path) {
+    size_t length = strlen(path);
+    return length > 6 && strcmp(path + length - 6, ".brisk") == 0;
+}
+
+/* ============ Modules ============ */
+
+/* Read and parse the module an @import names, found the way the
+   interpreter's import_module finds it */
+static Module* module_for(Emitter* e, AstNode* import) {
+    for (int i = 0; i < e->module_count; i++) {
+        if (e->modules[i]->import == import) return e->modules[i];
+    }
+    
+    Module* module = calloc(1, sizeof(Module));
+    if (e->module_count == e->module_capacity) {
+        e->module_capacity = e->module_capacity < 8 ? 8 : e->module_capacity * 2;
+        e->modules = realloc(e->modules, sizeof(Module*) * e->module_capacity);
+    }
+    e->modules[e->module_count++] = module;
+    module->import = import;
+    
+    const char* import_path = import->as.import.path;
+    char resolved_path[512];
+    if (import_path[0] == '/' || import_path[0] == '.') {
+        snprintf(resolved_path, sizeof(resolved_path), "%s", import_path);
+    } else {
+        snprintf(resolved_path, sizeof(resolved_path), "./%s", import_path);
+    }
+    
+    FILE* file = fopen(resolved_path, "rb");
+    if (!file) {
+        snprintf(resolved_path, sizeof(resolved_path), "lib/%s", import_path);
+        file = fopen(resolved_path, "rb");
+    }
+    if (!file) {
+        snprintf(module->error, sizeof(module->error), "Cannot find module '%s'", import_path);
+        return module;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    
+    module->source = malloc(size + 1);
+    size_t read_size = fread(module->source, 1, size, file);
+    module->source[read_size] = '\0';
+    fclose(file);
+    
+    Lexer lexer;
+    lexer_init(&lexer, module->source);
+    Parser parser;
+    parser_init(&parser, &lexer);
+    AstNode* program = parse_program(&parser);
+    
+    if (parser.had_error || !program) {
+        snprintf(module->error, sizeof(module->error), "Failed to parse module '%s'", import_path);
+        return module;
+    }
+    module->program = program;
+    return module;
+}
+
+/* The program of a module, or NULL if it is nested too deeply */
+static AstNode* module_enter(Emitter* e, Module* module) {
+    if (module->program == NULL) return NULL;
+    if (e->module_depth >= MAX_MODULE_DEPTH) {
+        if (!e->failed) {
+            fprintf(stderr, "Error: Modules import each other more than %d deep at '%s'\n",
+                    MAX_MODULE_DEPTH, module->import->as.import.path);
+        }
+        e->failed = true;
+        return NULL;
+    }
+    e->module_depth++;
+    return module->program;
+}
+
+/* ============ Tree Walks ============ */
+
+typedef void (*Visit)(Emitter* e, AstNode* node, void* data);
+
+/* Call visit on each node directly inside node, taking the program of a
+   module it imports as one of them */
+static void each_child(Emitter* e, AstNode* node, Visit visit, void* data) {
+#define VISIT(child) do { if ((child) != NULL) visit(e, (child), data); } while (0)
+    switch (node->type) {
+        case NODE_BINARY:
+            VISIT(node->as.binary.left);
+            VISIT(node->as.binary.right);
+            break;
+        case NODE_UNARY:
+        case NODE_EXPR_STMT:
+            VISIT(node->as.unary.operand);
+            break;
+        case NODE_CALL:
+            VISIT(node->as.call.callee);
+            for (int i = 0; i < node->as.call.arg_count; i++) VISIT(node->as.call.arguments[i]);
+            break;
+        case NODE_INDEX:
+            VISIT(node->as.index.object);
+            VISIT(node->as.index.index);
+            break;
+        case NODE_FIELD:
+            VISIT(node->as.field.object);
+            break;
+        case NODE_ARRAY:
+            for (int i = 0; i < node->as.array.element_count; i++) VISIT(node->as.array.elements[i]);
+            break;
+        case NODE_TABLE:
+            for (int i = 0; i < node->as.table.count; i++) VISIT(node->as.table.values[i]);
+            break;
+        case NODE_RANGE:
+            VISIT(node->as.range.start);
+            VISIT(node->as.range.end);
+            break;
+        case NODE_LAMBDA:
+            VISIT(node->as.lambda.body);
+            break;
+        case NODE_FN_DECL:
+            VISIT(node->as.fn_decl.body);
+            break;
+        case NODE_ADDRESS_OF:
+            VISIT(node->as.address_of.operand);
+            break;
+        case NODE_INTERP:
+            for (int i = 0; i < node->as.interp_string.part_count; i++) {
+                VISIT(node->as.interp_string.parts[i].expr);
+            }
+            break;
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            VISIT(node->as.var_decl.initializer);
+            break;
+        case NODE_ASSIGNMENT:
+            VISIT(node->as.assignment.target);
+            VISIT(node->as.assignment.value);
+            break;
+        case NODE_BLOCK:
+            for (int i = 0; i < node->as.block.statement_count; i++) VISIT(node->as.block.statements[i]);
+            break;
+        case NODE_PROGRAM:
+            for (int i = 0; i < node->as.program.statement_count; i++) VISIT(node->as.program.statements[i]);
+            break;
+        case NODE_IF:
+            VISIT(node->as.if_stmt.condition);
+            VISIT(node->as.if_stmt.then_branch);
+            VISIT(node->as.if_stmt.else_branch);
+            break;
+        case NODE_WHILE:
+            VISIT(node->as.while_stmt.condition);
+            VISIT(node->as.while_stmt.body);
+            break;
+        case NODE_FOR:
+            VISIT(node->as.for_stmt.iterable);
+            VISIT(node->as.for_stmt.body);
+            break;
+        case NODE_RETURN:
+            VISIT(node->as.return_stmt.value);
+            break;
+        case NODE_YIELD:
+            VISIT(node->as.yield_stmt.value);
+            break;
+        case NODE_MATCH:
+            VISIT(node->as.match_stmt.value);
+            for (int i = 0; i < node->as.match_stmt.arm_count; i++) {
+                VISIT(node->as.match_stmt.patterns[i]);
+                VISIT(node->as.match_stmt.bodies[i]);
+            }
+            break;
+        case NODE_DEFER:
+            VISIT(node->as.defer_stmt.statement);
+            break;
+        case NODE_IMPORT:
+            if (is_module_path(node->as.import.path)) {
+                Module* module = module_for(e, node);
+                AstNode* program = module_enter(e, module);
+                if (program != NULL) {
+                    visit(e, program, data);
+                    e->module_depth--;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+#undef VISIT
+}
+
+static void collect_names(Emitter* e, AstNode* node, void* data) {
+    if (node->type == NODE_IDENTIFIER) {
+        name_intern(data, node->as.identifier.name, node->as.identifier.name_length);
+    }
+    each_child(e, node, collect_names, data);
+}
+
+/* Every name a function nested in node refers to */
+static void collect_captured(Emitter* e, AstNode* node, void* data) {
+    if (node->type == NODE_FN_DECL || node->type == NODE_LAMBDA) {
+        collect_names(e, node, data);
+        return;
+    }
+    each_child(e, node, collect_captured, data);
+}
+
+/* ============ Header Signatures ============ */
+
+/* C type a value of type is marshalled into, or NULL if direct calls do
+   not handle it */
+static const char* ctype_storage(CType type) {
+    switch (type) {
+        case CTYPE_VOID: return "void";
+        case CTYPE_CHAR:
+        case CTYPE_SCHAR: return "char";
+        case CTYPE_UCHAR:
+        case CTYPE_UINT8: return "unsigned char";
+        case CTYPE_SHORT:
+        case CTYPE_INT16: return "short";
+        case CTYPE_USHORT:
+        case CTYPE_UINT16: return "unsigned short";
+        case CTYPE_INT:
+        case CTYPE_INT32:
+        case CTYPE_BOOL: return "int";
+        case CTYPE_UINT:
+        case CTYPE_UINT32: return "unsigned int";
+        case CTYPE_LONG:
+        case CTYPE_INT64: return "long";
+        case CTYPE_ULONG:
+        case CTYPE_UINT64:
+        case CTYPE_SIZE_T: return "unsigned long";
+        case CTYPE_LONGLONG: return "long long";
+        case CTYPE_ULONGLONG: return "unsigned long long";
+        case CTYPE_FLOAT: return "float";
+        case CTYPE_DOUBLE: return "double";
+        case CTYPE_STRING: return "char*";
+        case CTYPE_POINTER: return "void*";
+        default: return NULL;
+    }
+}
+
+static const char* ctype_constant(CType type) {
+    static const char* names[] = {
+        "CTYPE_VOID", "CTYPE_CHAR", "CTYPE_SCHAR", "CTYPE_UCHAR",
+        "CTYPE_SHORT", "CTYPE_USHORT", "CTYPE_INT", "CTYPE_UINT",
+        "CTYPE_LONG", "CTYPE_ULONG", "CTYPE_LONGLONG", "CTYPE_ULONGLONG",
+        "CTYPE_FLOAT", "CTYPE_DOUBLE", "CTYPE_POINTER", "CTYPE_STRING",
+        "CTYPE_STRUCT", "CTYPE_BOOL", "CTYPE_SIZE_T", "CTYPE_INT8",
+        "CTYPE_INT16", "CTYPE_INT32", "CTYPE_INT64", "CTYPE_UINT8",
+        "CTYPE_UINT16", "CTYPE_UINT32", "CTYPE_UINT64"
+    };
+    return names[type];
+}
+
+/* Index of the helper calling functions of this signature */
+static int helper_for(Emitter* e, CType return_type, const CType* param_types, int param_count) {
+    for (int i = 0; i < e->helper_count; i++) {
+        Helper* helper = &e->helpers[i];
+        if (helper->return_type == return_type && helper->param_count == param_count &&
+            memcmp(helper->param_types, param_types, sizeof(CType) * param_count) == 0) {
+            return i;
+        }
+    }
+    
+    if (e->helper_count == e->helper_capacity) {
+        e->helper_capacity = e->helper_capacity < 8 ? 8 : e->helper_capacity * 2;
+        e->helpers = realloc(e->helpers, sizeof(Helper) * e->helper_capacity);
+    }
+    Helper* helper = &e->helpers[e->helper_count];
+    helper->return_type = return_type;
+    helper->param_count = param_count;
+    helper->called = false;
+    helper->param_types = malloc(sizeof(CType) * (param_count > 0 ? param_count : 1));
+    memcpy(helper->param_types, param_types, sizeof(CType) * param_count);
+    return e->helper_count++;
+}
+
+static Signature* signature_find(Emitter* e, const char* name, int length) {
+    for (int i = 0; i < e->signature_count; i++) {
+        if ((int)strlen(e->signatures[i].name) == length &&
+            memcmp(e->signatures[i].name, name, length) == 0) {
+            return &e->signatures[i];
+        }
+    }
+    return NULL;
+}
+
+/* Record a header function; like its registration, the first
+   declaration of a name wins */
+static void signature_add(Emitter* e, const char* name, CType return_type,
+                          const CType* param_types, int param_count, bool is_variadic) {
+    if (signature_find(e, name, (int)strlen(name)) != NULL) return;
+    
+    bool supported = !is_variadic && ctype_storage(return_type) != NULL;
+    for (int i = 0; i < param_count && supported; i++) {
+        supported = param_types[i] != CTYPE_VOID && ctype_storage(param_types[i]) != NULL;
+    }
+    
+    if (e->signature_count == e->signature_capacity) {
+        e->signature_capacity = e->signature_capacity < 64 ? 64 : e->signature_capacity * 2;
+        e->signatures = realloc(e->signatures, sizeof(Signature) * e->signature_capacity);
+        e->signature_names = realloc(e->signature_names, sizeof(char*) * e->signature_capacity);
+    }
+    char* copy = malloc(strlen(name) + 1);
+    strcpy(copy, name);
+    e->signature_names[e->signature_count] = copy;
+    
+    Signature* signature = &e->signatures[e->signature_count++];
+    signature->name = copy;
+    signature->param_count = param_count;
+    signature->helper = supported ? helper_for(e, return_type, param_types, param_count) : -1;
+}
+
+/* Read the functions a header declares, as import_header will bind them */
+static void header_signatures(Emitter* e, const char* header_path) {
+    if (name_find(&e->headers, header_path, (int)strlen(header_path)) >= 0) return;
+    name_intern(&e->headers, header_path, (int)strlen(header_path));
+    
+    char* full_path = cheader_find_include(header_path, true);
+    if (!full_path) return;
+    
+    CHeaderParser hparser;
+    cheader_init(&hparser);
+    if (cheader_load(&hparser, full_path)) {
+        for (int i = 0; i < hparser.function_count; i++) {
+            ParsedFunction* fn = &hparser.functions[i];
+            signature_add(e, fn->name, fn->return_type, fn->param_types,
+                          fn->param_count, fn->is_variadic);
+        }
+    }
+    
+    /* The math.h functions import_header registers itself */
+    if (strstr(header_path, "math.h")) {
+        static const char* math_funcs_1[] = {
+            "sin", "cos", "tan", "asin", "acos", "atan",
+            "sinh", "cosh", "tanh", "asinh", "acosh", "atanh",
+            "exp", "exp2", "log", "log10", "log2",
+            "sqrt", "cbrt", "fabs", "floor", "ceil", "round", "trunc",
+            NULL
+        };
+        static const char* math_funcs_2[] = {
+            "atan2", "pow", "fmod", "hypot", "remainder", "copysign",
+            "fmin", "fmax", "fdim",
+            NULL
+        };
+        CType params[2] = {CTYPE_DOUBLE, CTYPE_DOUBLE};
+        for (int i = 0; math_funcs_1[i]; i++) {
+            signature_add(e, math_funcs_1[i], CTYPE_DOUBLE, params, 1, false);
+        }
+        for (int i = 0; math_funcs_2[i]; i++) {
+            signature_add(e, math_funcs_2[i], CTYPE_DOUBLE, params, 2, false);
+        }
+    }
+    
+    cheader_free(&hparser);
+    mem_free(full_path, strlen(full_path) + 1);
+}
+
+static void collect_headers(Emitter* e, AstNode* node, void* data) {
+    if (node->type == NODE_IMPORT && !is_module_path(node->as.import.path)) {
+        header_signatures(e, node->as.import.path);
+    }
+    each_child(e, node, collect_headers, data);
+}
+
+static void emit_helper(Text* out, const Helper* helper, int index) {
+    const char* return_storage = ctype_storage(helper->return_type);
+    
+    text_printf(out, "static bool direct_%d(Interpreter* interp, Value callee, Value* args, Value* result) {\n", index);
+    text_printf(out, "    static const CType types[] = {");
+    for (int i = 0; i < helper->param_count; i++) {
+        text_printf(out, "%s%s", i > 0 ? ", " : "", ctype_constant(helper->param_types[i]));
+    }
+    if (helper->param_count == 0) text_printf(out, "CTYPE_VOID");
+    text_printf(out, "};\n");
+    text_printf(out, "    static const AotSignature signature = {%s, types, %d};\n",
+                ctype_constant(helper->return_type), helper->param_count);
+    text_printf(out, "    CFunctionDesc* desc = aot_direct(callee, &signature);\n");
+    text_printf(out, "    if (desc == NULL) return false;\n");
+    for (int i = 0; i < helper->param_count; i++) {
+        text_printf(out, "    %s p%d;\n", ctype_storage(helper->param_types[i]), i);
+    }
+    for (int i = 0; i < helper->param_count; i++) {
+        text_printf(out, "    if (!marshal_to_c(args[%d], %s, &p%d)) return false;\n",
+                    i, ctype_constant(helper->param_types[i]), i);
+    }
+    if (helper->param_count == 0) text_printf(out, "    (void)args;\n");
+    text_printf(out, "    aot_flush(interp);\n");
+    
+    Text call = {0};
+    text_printf(&call, "((%s (*)(", return_storage);
+    for (int i = 0; i < helper->param_count; i++) {
+        text_printf(&call, "%s%s", i > 0 ? ", " : "", ctype_storage(helper->param_types[i]));
+    }
+    text_printf(&call, "%s))desc->func_ptr)(", helper->param_count == 0 ? "void" : "");
+    for (int i = 0; i < helper->param_count; i++) {
+        text_printf(&call, "%sp%d", i > 0 ? ", " : "", i);
+    }
+    text_printf(&call, ")");
+    
+    if (helper->return_type == CTYPE_VOID) {
+        text_printf(out, "    %s;\n", call.chars);
+        text_printf(out, "    *result = NIL_VAL;\n");
+    } else {
+        text_printf(out, "    %s returned = %s;\n", return_storage, call.chars);
+        text_printf(out, "    *result = marshal_from_c(&returned, %s);\n",
+                    ctype_constant(helper->return_type));
+    }
+    text_printf(out, "    return true;\n");
+    text_printf(out, "}\n\n");
+    text_free(&call);
+}
+
+/* ============ Scopes ============ */
+
+static void scope_init(Scope* scope, Scope* parent) {
+    memset(scope, 0, sizeof(Scope));
+    scope->parent = parent;
+}
+
+static void scope_free(Scope* scope) {
+    free(scope->bindings);
+    free(scope->defers);
+}
+
+/* The binding of name in scope itself */
+static Binding* scope_binding(Scope* scope, const char* name, int length) {
+    for (int i = 0; i < scope->binding_count; i++) {
+        Binding* binding = &scope->bindings[i];
+        if (binding->length == length && memcmp(binding->name, name, length) == 0) {
+            return binding;
+        }
+    }
+    return NULL;
+}
+
+static void scope_bind(Scope* scope, const char* name, int length, int local, bool is_const) {
+    if (scope->binding_count == scope->binding_capacity) {
+        scope->binding_capacity = scope->binding_capacity < 8 ? 8 : scope->binding_capacity * 2;
+        scope->bindings = realloc(scope->bindings, sizeof(Binding) * scope->binding_capacity);
+    }
+    Binding* binding = &scope->bindings[scope->binding_count++];
+    binding->name = name;
+    binding->length = length;
+    binding->local = local;
+    binding->is_const = is_const;
+}
+
+/* The innermost declaration of name so far in this function, or NULL if
+   it can only be found at run time */
+static Binding* resolve(FnState* fs, const char* name, int length) {
+    for (Scope* scope = fs->scope; scope != NULL; scope = scope->parent) {
+        Binding* binding = scope_binding(scope, name, length);
+        if (binding != NULL) return binding;
+    }
+    return NULL;
+}
+
+static bool is_captured(FnState* fs, const char* name, int length) {
+    return name_find(&fs->captured, name, length) >= 0;
+}
+
+/* Whether a declaration of name in the current scope goes into its
+   environment rather than a C local */
+static bool declares_env(FnState* fs, const char* name, int length) {
+    return fs->scope->global || fs->scope->inlining > 0 || is_captured(fs, name, length);
+}
+
+/* Whether a block declares anything that has to live in an environment */
+static bool block_needs_env(FnState* fs, AstNode** statements, int count) {
+    for (int i = 0; i < count; i++) {
+        AstNode* node = statements[i];
+        if (node == NULL) continue;
+        switch (node->type) {
+            case NODE_VAR_DECL:
+            case NODE_CONST_DECL:
+                if (is_captured(fs, node->as.var_decl.name, node->as.var_decl.name_length)) {
+                    return true;
+                }
+                break;
+            case NODE_FN_DECL:
+                if (is_captured(fs, node->as.fn_decl.name, node->as.fn_decl.name_length)) {
+                    return true;
+                }
+                break;
+            case NODE_IMPORT:
+                if (is_module_path(node->as.import.path)) return true;
+                break;
+            case NODE_DEFER:
+                if (block_needs_env(fs, &node->as.defer_stmt.statement, 1)) return true;
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
+}
+
+/* ============ Function State ============ */
+
+static void emit(FnState* fs, const char* format, ...) {
+    for (int i = 0; i < fs->indent; i++) text_write(&fs->code, "    ", 4);
+    va_list args;
+    va_start(args, format);
+    text_vprintf(&fs->code, format, args);
+    va_end(args);
+    text_write(&fs->code, "\n", 1);
+}
+
+static void emit_label(FnState* fs, int label) {
+    for (int i = 1; i < fs->indent; i++) text_write(&fs->code, "    ", 4);
+    text_printf(&fs->code, "L%d: ;\n", label);
+}
+
+static void emit_check(FnState* fs) {
+    emit(fs, "if (interp->had_error) goto L%d;", fs->exit);
+}
+
+/* Report a runtime error at line and leave the scope */
+static void emit_error(FnState* fs, int line, const char* message) {
+    for (int i = 0; i < fs->indent; i++) text_write(&fs->code, "    ", 4);
+    text_printf(&fs->code, "runtime_error(interp, %d, \"%%s\", ", line);
+    text_quote(&fs->code, message, (int)strlen(message));
+    text_printf(&fs->code, ");\n");
+    emit(fs, "goto L%d;", fs->exit);
+}
+
+static int new_temp(FnState* fs) {
+    text_printf(&fs->decls, "    Value t%d;\n", ++fs->temps);
+    return fs->temps;
+}
+
+static int new_local(FnState* fs) {
+    text_printf(&fs->decls, "    Value l%d = NIL_VAL;\n", ++fs->locals);
+    return fs->locals;
+}
+
+static int new_array(FnState* fs, int count) {
+    text_printf(&fs->decls, "    Value a%d[%d];\n", ++fs->arrays, count);
+    return fs->arrays;
+}
+
+static int new_env(FnState* fs) {
+    text_printf(&fs->decls, "    Environment* e%d;\n", ++fs->envs);
+    return fs->envs;
+}
+
+static int new_flag(FnState* fs) {
+    text_printf(&fs->decls, "    bool d%d = false;\n", ++fs->flags);
+    return fs->flags;
+}
+
+static int new_loop(FnState* fs) {
+    text_printf(&fs->decls, "    AotLoop loop%d;\n", ++fs->loops);
+    return fs->loops;
+}
+
+static int new_save(FnState* fs) {
+    ++fs->saves;
+    text_printf(&fs->decls, "    int s%d;\n    bool r%d;\n", fs->saves, fs->saves);
+    return fs->saves;
+}
+
+static int new_label(FnState* fs) {
+    return ++fs->labels;
+}
+
+/* Make scope the innermost one, with its environment if it needs one */
+static void enter_env(FnState* fs, int env) {
+    emit(fs, "e%d = interp->current;", env);
+    emit(fs, "interp->current = env_create(e%d);", env);
+}
+
+static void leave_env(FnState* fs, int env) {
+    emit(fs, "env_decref(interp->current);");
+    emit(fs, "interp->current = e%d;", env);
+}
+
+/* ============ Expressions ============ */
+
+/* The inline fast path for op, if aot.h has one */
+static const char* inline_operator(TokenType op) {
+    switch (op) {
+        case TOKEN_PLUS: return "aot_add";
+        case TOKEN_MINUS: return "aot_subtract";
+        case TOKEN_STAR: return "aot_multiply";
+        case TOKEN_LT: return "aot_less";
+        case TOKEN_GT: return "aot_greater";
+        case TOKEN_LTE: return "aot_less_equal";
+        case TOKEN_GTE: return "aot_greater_equal";
+        default: return NULL;
+    }
+}
+
+static void token_constant(TokenType op, char* out) {
+    switch (op) {
+        case TOKEN_PLUS: strcpy(out, "TOKEN_PLUS"); break;
+        case TOKEN_MINUS: strcpy(out, "TOKEN_MINUS"); break;
+        case TOKEN_STAR: strcpy(out, "TOKEN_STAR"); break;
+        case TOKEN_SLASH: strcpy(out, "TOKEN_SLASH"); break;
+        case TOKEN_PERCENT: strcpy(out, "TOKEN_PERCENT"); break;
+        case TOKEN_NOT: strcpy(out, "TOKEN_NOT"); break;
+        case TOKEN_BANG: strcpy(out, "TOKEN_BANG"); break;
+        default: sprintf(out, "(TokenType)%d", (int)op); break;
+    }
+}
+
+static void emit_identifier(FnState* fs, AstNode* node, char* out) {
+    const char* name = node->as.identifier.name;
+    int length = node->as.identifier.name_length;
+    Binding* binding = resolve(fs, name, length);
+    if (binding != NULL && binding->local >= 0) {
+        snprintf(out, OPERAND_SIZE, "l%d", binding->local);
+        return;
+    }
+    
+    int t = new_temp(fs);
+    emit(fs, "t%d = variable_get(interp, aot_key(interp, %d), %d);",
+         t, constant(fs, name, length), node->line);
+    emit_check(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+}
+
+static void emit_binary(FnState* fs, AstNode* node, char* out) {
+    TokenType op = node->as.binary.operator;
+    char left[OPERAND_SIZE];
+    char right[OPERAND_SIZE];
+    int t = new_temp(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+    
+    emit_expr(fs, node->as.binary.left, left);
+    
+    /* and/or leave the deciding operand as the value */
+    if (op == TOKEN_AND || op == TOKEN_OR) {
+        emit(fs, "t%d = %s;", t, left);
+        emit(fs, "if (%saot_truthy(t%d)) {", op == TOKEN_AND ? "" : "!", t);
+        fs->indent++;
+        emit_expr(fs, node->as.binary.right, right);
+        emit(fs, "t%d = %s;", t, right);
+        fs->indent--;
+        emit(fs, "}");
+        return;
+    }
+    
+    emit_expr(fs, node->as.binary.right, right);
+    
+    if (op == TOKEN_EQEQ || op == TOKEN_NEQ) {
+        emit(fs, "t%d = BOOL_VAL(%svalue_equals(%s, %s));",
+             t, op == TOKEN_NEQ ? "!" : "", left, right);
+        return;
+    }
+    
+    const char* fast = inline_operator(op);
+    if (fast != NULL) {
+        emit(fs, "t%d = %s(interp, %s, %s, %d);", t, fast, left, right, node->line);
+    } else {
+        char token[32];
+        token_constant(op, token);
+        emit(fs, "t%d = binary_op(interp, %s, %s, %s, %d);", t, token, left, right, node->line);
+    }
+    emit_check(fs);
+}
+
+static void emit_unary(FnState* fs, AstNode* node, char* out) {
+    TokenType op = node->as.unary.operator;
+    char operand[OPERAND_SIZE];
+    emit_expr(fs, node->as.unary.operand, operand);
+    int t = new_temp(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+    
+    if (op == TOKEN_NOT || op == TOKEN_BANG) {
+        emit(fs, "t%d = BOOL_VAL(!aot_truthy(%s));", t, operand);
+        return;
+    }
+    if (op == TOKEN_MINUS) {
+        emit(fs, "t%d = aot_negate(interp, %s, %d);", t, operand, node->line);
+    } else {
+        char token[32];
+        token_constant(op, token);
+        emit(fs, "t%d = unary_op(interp, %s, %s, %d);", t, token, operand, node->line);
+    }
+    emit_check(fs);
+}
+
+/* The header function a call can go to directly, if any */
+static Signature* direct_signature(FnState* fs, AstNode* callee, int arg_count) {
+    if (callee->type != NODE_IDENTIFIER) return NULL;
+    
+    const char* name = callee->as.identifier.name;
+    int length = callee->as.identifier.name_length;
+    Binding* binding = resolve(fs, name, length);
+    if (binding != NULL && binding->local >= 0) return NULL;
+    
+    Signature* signature = signature_find(fs->emitter, name, length);
+    if (signature == NULL || signature->helper < 0 || signature->param_count != arg_count) {
+        return NULL;
+    }
+    return signature;
+}
+
+static void emit_call(FnState* fs, AstNode* node, char* out) {
+    char callee[OPERAND_SIZE];
+    char operand[OPERAND_SIZE];
+    char args[OPERAND_SIZE];
+    int count = node->as.call.arg_count;
+    
+    emit_expr(fs, node->as.call.callee, callee);
+    
+    strcpy(args, "NULL");
+    if (count > 0) {
+        int array = new_array(fs, count);
+        for (int i = 0; i < count; i++) {
+            emit_expr(fs, node->as.call.arguments[i], operand);
+            emit(fs, "a%d[%d] = %s;", array, i, operand);
+        }
+        snprintf(args, sizeof(args), "a%d", array);
+    }
+    
+    int t = new_temp(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+    
+    /* A C function from a header is called through a pointer of its type
+       when the value called is the one the header declared */
+    Signature* signature = direct_signature(fs, node->as.call.callee, count);
+    if (signature != NULL) {
+        fs->emitter->helpers[signature->helper].called = true;
+        emit(fs, "if (!direct_%d(interp, %s, %s, &t%d)) {", signature->helper, callee, args, t);
+        fs->indent++;
+    }
+    emit(fs, "t%d = call_value(interp, %s, %d, %s, %d);", t, callee, count, args, node->line);
+    emit_check(fs);
+    if (signature != NULL) {
+        fs->indent--;
+        emit(fs, "}");
+    }
+}
+
+static void emit_interp(FnState* fs, AstNode* node, char* out) {
+    InterpString* string = &node->as.interp_string;
+    int t = new_temp(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+    if (string->part_count == 0) {
+        emit(fs, "t%d = interpolate(NULL, 0, NULL);", t);
+        return;
+    }
+    
+    Emitter* e = fs->emitter;
+    int parts = ++e->part_count;
+    text_printf(&e->descriptors, "static const InterpPart parts_%d[] = {\n", parts);
+    for (int i = 0; i < string->part_count; i++) {
+        InterpPart* part = &string->parts[i];
+        text_printf(&e->descriptors, "    {");
+        if (part->literal != NULL) {
+            text_quote(&e->descriptors, part->literal, part->literal_length);
+        } else {
+            text_printf(&e->descriptors, "NULL");
+        }
+        text_printf(&e->descriptors, ", %d, NULL, {%d, %d, %d, %d, %d}},\n",
+                    part->literal_length, part->spec.align, part->spec.zero_pad ? 1 : 0,
+                    part->spec.width, part->spec.precision, part->spec.type);
+    }
+    text_printf(&e->descriptors, "};\n\n");
+    
+    int values = new_array(fs, string->part_count);
+    char operand[OPERAND_SIZE];
+    for (int i = 0; i < string->part_count; i++) {
+        if (string->parts[i].literal != NULL) continue;
+        emit_expr(fs, string->parts[i].expr, operand);
+        emit(fs, "a%d[%d] = %s;", values, i, operand);
+    }
+    emit(fs, "t%d = interpolate(parts_%d, %d, a%d);", t, parts, string->part_count, values);
+}
+
+static void emit_expr(FnState* fs, AstNode* node, char* out) {
+    char first[OPERAND_SIZE];
+    char second[OPERAND_SIZE];
+    int t;
+    
+    if (node == NULL) {
+        strcpy(out, "NIL_VAL");
+        return;
+    }
+    
+    switch (node->type) {
+        case NODE_LITERAL_INT:
+            snprintf(out, OPERAND_SIZE, "INT_VAL(INT64_C(%lld))",
+                     (long long)node->as.int_literal.value);
+            return;
+        
+        case NODE_LITERAL_FLOAT:
+            if (isinf(node->as.float_literal.value)) {
+                strcpy(out, "FLOAT_VAL(HUGE_VAL)");
+            } else {
+                snprintf(out, OPERAND_SIZE, "FLOAT_VAL(%a)", node->as.float_literal.value);
+            }
+            return;
+        
+        case NODE_LITERAL_STRING:
+            snprintf(out, OPERAND_SIZE, "OBJ_VAL(aot_key(interp, %d))",
+                     constant(fs, node->as.string_literal.value, node->as.string_literal.length));
+            return;
+        
+        case NODE_LITERAL_BOOL:
+            strcpy(out, node->as.bool_literal.value ? "BOOL_VAL(true)" : "BOOL_VAL(false)");
+            return;
+        
+        case NODE_LITERAL_NIL:
+            strcpy(out, "NIL_VAL");
+            return;
+        
+        case NODE_IDENTIFIER:
+            emit_identifier(fs, node, out);
+            return;
+        
+        case NODE_BINARY:
+            emit_binary(fs, node, out);
+            return;
+        
+        case NODE_UNARY:
+            emit_unary(fs, node, out);
+            return;
+        
+        case NODE_CALL:
+            emit_call(fs, node, out);
+            return;
+        
+        case NODE_INTERP:
+            emit_interp(fs, node, out);
+            return;
+        
+        default:
+            break;
+    }
+    
+    t = new_temp(fs);
+    snprintf(out, OPERAND_SIZE, "t%d", t);
+    
+    switch (node->type) {
+        case NODE_INDEX:
+            emit_expr(fs, node->as.index.object, first);
+            emit_expr(fs, node->as.index.index, second);
+            emit(fs, "t%d = aot_index(interp, %s, %s, %d);", t, first, second, node->line);
+            emit_check(fs);
+            break;
+        
+        case NODE_FIELD:
+            emit_expr(fs, node->as.field.object, first);
+            emit(fs, "t%d = field_get(interp, %s, aot_key(interp, %d), %d);", t, first,
+                 constant(fs, node->as.field.field_name, node->as.field.field_name_length),
+                 node->line);
+            emit_check(fs);
+            break;
+        
+        case NODE_ARRAY:
+            emit(fs, "t%d = OBJ_VAL(array_create());", t);
+            for (int i = 0; i < node->as.array.element_count; i++) {
+                emit_expr(fs, node->as.array.elements[i], first);
+                emit(fs, "array_push(AS_ARRAY(t%d), %s);", t, first);
+            }
+            break;
+        
+        case NODE_TABLE:
+            emit(fs, "t%d = OBJ_VAL(table_create());", t);
+            for (int i = 0; i < node->as.table.count; i++) {
+                emit_expr(fs, node->as.table.values[i], first);
+                emit(fs, "table_set(AS_TABLE(t%d), aot_key(interp, %d), %s, false);", t,
+                     constant(fs, node->as.table.keys[i], node->as.table.key_lengths[i]), first);
+            }
+            break;
+        
+        case NODE_RANGE:
+            emit_expr(fs, node->as.range.start, first);
+            emit_expr(fs, node->as.range.end, second);
+            emit(fs, "t%d = range_array(interp, %s, %s, %d);", t, first, second, node->line);
+            emit_check(fs);
+            break;
+        
+        case NODE_LAMBDA: {
+            int function = emit_function(fs->emitter, NULL, 0,
+                                         node->as.lambda.parameters,
+                                         node->as.lambda.param_lengths,
+                                         node->as.lambda.param_count,
+                                         node->as.lambda.body,
+                                         node->as.lambda.is_generator);
+            emit(fs, "t%d = aot_closure(interp, &function_%d);", t, function);
+            break;
+        }
+        
+        case NODE_ADDRESS_OF:
+            emit_expr(fs, node->as.address_of.operand, first);
+            emit(fs, "t%d = address_of(interp, %s, %d);", t, first, node->line);
+            emit_check(fs);
+            break;
+        
+        default:
+            emit_error(fs, node->line, "Unknown expression type");
+            break;
+    }
+}
+
+/* ============ Statements ============ */
+
+/* Declare name in the current scope with value */
+static void emit_declare(FnState* fs, AstNode* node, const char* name, int length,
+                         const char* value, bool is_const) {
+    Binding* existing = scope_binding(fs->scope, name, length);
+    bool env = declares_env(fs, name, length);
+    char message[300];
+    
+    if (existing != NULL && (existing->local >= 0 || !env)) {
+        snprintf(message, sizeof(message), "Variable '%.*s' already defined", length, name);
+        emit_error(fs, node->line, message);
+        return;
+    }
+    
+    if (env) {
+        emit(fs, "variable_define(interp, aot_key(interp, %d), %s, %s, %d);",
+             constant(fs, name, length), value, is_const ? "true" : "false", node->line);
+        emit_check(fs);
+        if (existing == NULL) scope_bind(fs->scope, name, length, -1, is_const);
+    } else {
+        int local = new_local(fs);
+        scope_bind(fs->scope, name, length, local, is_const);
+        emit(fs, "aot_store(&l%d, %s);", local, value);
+    }
+}
+
+static void emit_fn_decl(FnState* fs, AstNode* node) {
+    FnDecl* decl = &node->as.fn_decl;
+    Binding* existing = scope_binding(fs->scope, decl->name, decl->name_length);
+    bool env = declares_env(fs, decl->name, decl->name_length);
+    
+    /* A second definition in one scope is ignored, as env_define ignores it */
+    if (existing != NULL && (existing->local >= 0 || !env)) return;
+    
+    int function = emit_function(fs->emitter, decl->name, decl->name_length,
+                                 decl->parameters, decl->param_lengths, decl->param_count,
+                                 decl->body, decl->is_generator);
+    int t = new_temp(fs);
+    emit(fs, "t%d = aot_closure(interp, &function_%d);", t, function);
+    if (env) {
+        emit(fs, "env_define_key(interp->current, aot_key(interp, %d), t%d, false);",
+             constant(fs, decl->name, decl->name_length), t);
+        if (existing == NULL) scope_bind(fs->scope, decl->name, decl->name_length, -1, false);
+    } else {
+        int local = new_local(fs);
+        scope_bind(fs->scope, decl->name, decl->name_length, local, false);
+        emit(fs, "aot_store(&l%d, t%d);", local, t);
+    }
+    emit(fs, "obj_decref(AS_OBJ(t%d));  /* The scope holds it now */", t);
+}
+
+static void emit_assignment(FnState* fs, AstNode* node) {
+    AstNode* target = node->as.assignment.target;
+    char value[OPERAND_SIZE];
+    char object[OPERAND_SIZE];
+    char index[OPERAND_SIZE];
+    char message[300];
+    
+    emit_expr(fs, node->as.assignment.value, value);
+    
+    switch (target->type) {
+        case NODE_IDENTIFIER: {
+            const char* name = target->as.identifier.name;
+            int length = target->as.identifier.name_length;
+            Binding* binding = resolve(fs, name, length);
+            if (binding != NULL && binding->local >= 0) {
+                if (binding->is_const) {
+                    snprintf(message, sizeof(message), "Cannot assign to constant '%.*s'",
+                             length, name);
+                    emit_error(fs, node->line, message);
+                } else {
+                    emit(fs, "aot_store(&l%d, %s);", binding->local, value);
+                }
+                break;
+            }
+            emit(fs, "variable_set(interp, aot_key(interp, %d), %s, %d);",
+                 constant(fs, name, length), value, node->line);
+            emit_check(fs);
+            break;
+        }
+        
+        case NODE_INDEX:
+            emit_expr(fs, target->as.index.object, object);
+            emit_expr(fs, target->as.index.index, index);
+            emit(fs, "index_set(interp, %s, %s, %s, %d);", object, index, value, node->line);
+            emit_check(fs);
+            break;
+        
+        case NODE_FIELD:
+            emit_expr(fs, target->as.field.object, object);
+            emit(fs, "field_set(interp, %s, aot_key(interp, %d), %s, %d);", object,
+                 constant(fs, target->as.field.field_name, target->as.field.field_name_length),
+                 value, node->line);
+            emit_check(fs);
+            break;
+        
+        default:
+            emit_error(fs, node->line, "Invalid assignment target");
+            break;
+    }
+}
+
+/* Run a scope's defers, last first, each with the reason the scope is
+   being left set aside while it runs, as pop_defers does */
+static void emit_defers(FnState* fs, Scope* scope) {
+    int exit = fs->exit;
+    for (int i = scope->defer_count - 1; i >= 0; i--) {
+        Defer defer = scope->defers[i];
+        int save = new_save(fs);
+        int end = new_label(fs);
+        
+        emit(fs, "if (d%d) {", defer.flag);
+        fs->indent++;
+        emit(fs, "d%d = false;", defer.flag);
+        emit(fs, "if (!interp->had_error) {");
+        fs->indent++;
+        emit(fs, "s%d = pending;", save);
+        emit(fs, "r%d = interp->returning;", save);
+        emit(fs, "pending = AOT_NONE;");
+        emit(fs, "interp->returning = false;");
+        fs->exit = end;
+        emit_stmt(fs, defer.statement);
+        emit_label(fs, end);
+        emit(fs, "pending = s%d;", save);
+        emit(fs, "interp->returning = r%d;", save);
+        fs->indent--;
+        emit(fs, "}");
+        fs->indent--;
+        emit(fs, "}");
+    }
+    fs->exit = exit;
+}
+
+/* Statements as one scope, as exec_block runs a block */
+static void emit_block(FnState* fs, AstNode** statements, int count) {
+    Scope scope;
+    scope_init(&scope, fs->scope);
+    int parent_exit = fs->exit;
+    int cleanup = new_label(fs);
+    int env = block_needs_env(fs, statements, count) ? new_env(fs) : -1;
+    
+    emit(fs, "{");
+    fs->indent++;
+    if (env >= 0) enter_env(fs, env);
+    
+    fs->scope = &scope;
+    fs->exit = cleanup;
+    for (int i = 0; i < count; i++) {
+        emit_stmt(fs, statements[i]);
+    }
+    
+    emit_label(fs, cleanup);
+    emit_defers(fs, &scope);
+    for (int i = 0; i < scope.binding_count; i++) {
+        if (scope.bindings[i].local >= 0) {
+            emit(fs, "aot_release(&l%d);", scope.bindings[i].local);
+        }
+    }
+    if (env >= 0) leave_env(fs, env);
+    fs->scope = scope.parent;
+    fs->exit = parent_exit;
+    emit(fs, "if (pending != AOT_NONE || interp->had_error) goto L%d;", parent_exit);
+    fs->indent--;
+    emit(fs, "}");
+    scope_free(&scope);
+}
+
+static void emit_body(FnState* fs, AstNode* body) {
+    if (body != NULL && body->type == NODE_BLOCK) {
+        emit_block(fs, body->as.block.statements, body->as.block.statement_count);
+    } else {
+        emit_block(fs, &body, 1);
+    }
+}
+
+/* Where a loop body ends up: continue goes round again, break stops */
+static void emit_loop_next(FnState* fs, int next, int top) {
+    emit_label(fs, next);
+    emit(fs, "if (pending == AOT_CONTINUE) pending = AOT_NONE;");
+    emit(fs, "if (pending == AOT_NONE && !interp->had_error) goto L%d;", top);
+    emit(fs, "if (pending == AOT_BREAK) pending = AOT_NONE;");
+}
+
+static void emit_while(FnState* fs, AstNode* node) {
+    char condition[OPERAND_SIZE];
+    int parent_exit = fs->exit;
+    int top = new_label(fs);
+    int next = new_label(fs);
+    int end = new_label(fs);
+    
+    emit(fs, "{");
+    fs->indent++;
+    emit_label(fs, top);
+    emit_expr(fs, node->as.while_stmt.condition, condition);
+    emit(fs, "if (!aot_truthy(%s)) goto L%d;", condition, end);
+    
+    fs->exit = next;
+    emit_stmt(fs, node->as.while_stmt.body);
+    fs->exit = parent_exit;
+    
+    emit_loop_next(fs, next, top);
+    emit_label(fs, end);
+    emit(fs, "if (pending != AOT_NONE || interp->had_error) goto L%d;", parent_exit);
+    fs->indent--;
+    emit(fs, "}");
+}
+
+/* One scope holds the loop variable for the whole loop, as in exec_for */
+static void emit_for(FnState* fs, AstNode* node) {
+    ForStmt* stmt = &node->as.for_stmt;
+    AstNode* iterable = stmt->iterable;
+    char first[OPERAND_SIZE];
+    char second[OPERAND_SIZE];
+    int parent_exit = fs->exit;
+    int loop = new_loop(fs);
+    
+    emit(fs, "{");
+    fs->indent++;
+    
+    /* for i in a..b counts without building the array */
+    if (iterable->type == NODE_RANGE) {
+        emit_expr(fs, iterable->as.range.start, first);
+        emit_expr(fs, iterable->as.range.end, second);
+        emit(fs, "if (!aot_loop_range(interp, &loop%d, %s, %s, %d)) goto L%d;",
+             loop, first, second, iterable->line, parent_exit);
+    } else {
+        emit_expr(fs, iterable, first);
+        emit(fs, "if (!aot_loop_start(interp, &loop%d, %s, %s, %d)) goto L%d;",
+             loop, first, iterable->type == NODE_CALL ? "true" : "false",
+             node->line, parent_exit);
+    }
+    
+    Scope scope;
+    scope_init(&scope, fs->scope);
+    int key = constant(fs, stmt->iterator_name, stmt->iterator_name_length);
+    int env = -1;
+    int local = -1;
+    if (is_captured(fs, stmt->iterator_name, stmt->iterator_name_length)) {
+        env = new_env(fs);
+        enter_env(fs, env);
+        emit(fs, "env_define_key(interp->current, aot_key(interp, %d), NIL_VAL, false);", key);
+    } else {
+        local = new_local(fs);
+    }
+    scope_bind(&scope, stmt->iterator_name, stmt->iterator_name_length, local, false);
+    
+    int top = new_label(fs);
+    int next = new_label(fs);
+    int end = new_label(fs);
+    int value = new_temp(fs);
+    
+    emit_label(fs, top);
+    emit(fs, "if (!aot_loop_next(interp, &loop%d, &t%d)) goto L%d;", loop, value, end);
+    if (env >= 0) {
+        emit(fs, "env_set_key(interp->current, aot_key(interp, %d), t%d);", key, value);
+    } else {
+        emit(fs, "aot_store(&l%d, t%d);", local, value);
+    }
+    
+    fs->scope = &scope;
+    fs->exit = next;
+    emit_stmt(fs, stmt->body);
+    fs->scope = scope.parent;
+    fs->exit = parent_exit;
+    
+    emit_loop_next(fs, next, top);
+    emit_label(fs, end);
+    if (local >= 0) emit(fs, "aot_release(&l%d);", local);
+    emit(fs, "aot_loop_end(&loop%d);", loop);
+    if (env >= 0) leave_env(fs, env);
+    emit(fs, "if (pending != AOT_NONE || interp->had_error) goto L%d;", parent_exit);
+    fs->indent--;
+    emit(fs, "}");
+    scope_free(&scope);
+}
+
+static void emit_match_body(FnState* fs, AstNode* body, int end) {
+    char value[OPERAND_SIZE];
+    fs->indent++;
+    if (body->type == NODE_BLOCK) {
+        emit_stmt(fs, body);
+    } else {
+        emit_expr(fs, body, value);
+        emit(fs, "interp->last_value = %s;", value);
+    }
+    emit(fs, "goto L%d;", end);
+    fs->indent--;
+    emit(fs, "}");
+}
+
+static void emit_match(FnState* fs, AstNode* node) {
+    MatchStmt* stmt = &node->as.match_stmt;
+    char value[OPERAND_SIZE];
+    char first[OPERAND_SIZE];
+    char second[OPERAND_SIZE];
+    int end = new_label(fs);
+    
+    emit_expr(fs, stmt->value, value);
+    for (int i = 0; i < stmt->arm_count; i++) {
+        AstNode* pattern = stmt->patterns[i];
+        
+        /* Wildcard matches everything */
+        if (pattern->type == NODE_IDENTIFIER &&
+            pattern->as.identifier.name_length == 1 &&
+            pattern->as.identifier.name[0] == '_') {
+            emit(fs, "{");
+            emit_match_body(fs, stmt->bodies[i], end);
+        }
+        /* Range pattern */
+        else if (pattern->type == NODE_RANGE) {
+            emit(fs, "if (IS_INT(%s)) {", value);
+            fs->indent++;
+            emit_expr(fs, pattern->as.range.start, first);
+            emit_expr(fs, pattern->as.range.end, second);
+            emit(fs, "if (IS_INT(%s) && IS_INT(%s) && AS_INT(%s) >= AS_INT(%s) && AS_INT(%s) < AS_INT(%s)) {",
+                 first, second, value, first, value, second);
+            emit_match_body(fs, stmt->bodies[i], end);
+            fs->indent--;
+            emit(fs, "}");
+        }
+        /* Literal pattern */
+        else {
+            emit_expr(fs, pattern, first);
+            emit(fs, "if (value_equals(%s, %s)) {", value, first);
+            emit_match_body(fs, stmt->bodies[i], end);
+        }
+    }
+    emit_label(fs, end);
+}
+
+/* A module's statements run in the scope importing it */
+static void emit_module(FnState* fs, AstNode* node) {
+    Emitter* e = fs->emitter;
+    Module* module = module_for(e, node);
+    if (module->program == NULL) {
+        emit_error(fs, node->line, module->error);
+        return;
+    }
+    
+    AstNode* program = module_enter(e, module);
+    if (program == NULL) return;
+    fs->scope->inlining++;
+    for (int i = 0; i < program->as.program.statement_count; i++) {
+        emit_stmt(fs, program->as.program.statements[i]);
+    }
+    fs->scope->inlining--;
+    e->module_depth--;
+}
+
+static void emit_stmt(FnState* fs, AstNode* node) {
+    char value[OPERAND_SIZE];
+    if (node == NULL) return;
+    
+    switch (node->type) {
+        case NODE_VAR_DECL:
+        case NODE_CONST_DECL:
+            emit_expr(fs, node->as.var_decl.initializer, value);
+            emit_declare(fs, node, node->as.var_decl.name, node->as.var_decl.name_length,
+                         value, node->as.var_decl.is_const);
+            break;
+        
+        case NODE_ASSIGNMENT:
+            emit_assignment(fs, node);
+            break;
+        
+        case NODE_EXPR_STMT:
+            /* Track last expression value for implicit return */
+            emit_expr(fs, node->as.unary.operand, value);
+            emit(fs, "interp->last_value = %s;", value);
+            break;
+        
+        case NODE_BLOCK:
+            emit_block(fs, node->as.block.statements, node->as.block.statement_count);
+            break;
+        
+        case NODE_PROGRAM:
+            for (int i = 0; i < node->as.program.statement_count; i++) {
+                emit_stmt(fs, node->as.program.statements[i]);
+            }
+            break;
+        
+        case NODE_IF:
+            emit_expr(fs, node->as.if_stmt.condition, value);
+            emit(fs, "if (aot_truthy(%s)) {", value);
+            fs->indent++;
+            emit_stmt(fs, node->as.if_stmt.then_branch);
+            fs->indent--;
+            if (node->as.if_stmt.else_branch != NULL) {
+                emit(fs, "} else {");
+                fs->indent++;
+                emit_stmt(fs, node->as.if_stmt.else_branch);
+                fs->indent--;
+            }
+            emit(fs, "}");
+            break;
+        
+        case NODE_WHILE:
+            emit_while(fs, node);
+            break;
+        
+        case NODE_FOR:
+            emit_for(fs, node);
+            break;
+        
+        case NODE_RETURN:
+            emit_expr(fs, node->as.return_stmt.value, value);
+            emit(fs, "interp->return_value = %s;", value);
+            emit(fs, "interp->returning = true;");
+            emit(fs, "pending = AOT_RETURN;");
+            emit(fs, "goto L%d;", fs->exit);
+            break;
+        
+        case NODE_YIELD:
+            emit_expr(fs, node->as.yield_stmt.value, value);
+            emit(fs, "if (interp->generator == NULL) {");
+            fs->indent++;
+            emit_error(fs, node->line, "Can only yield inside a generator");
+            fs->indent--;
+            emit(fs, "}");
+            emit(fs, "generator_yield(interp, %s);", value);
+            break;
+        
+        case NODE_BREAK:
+            emit(fs, "pending = AOT_BREAK;");
+            emit(fs, "goto L%d;", fs->exit);
+            break;
+        
+        case NODE_CONTINUE:
+            emit(fs, "pending = AOT_CONTINUE;");
+            emit(fs, "goto L%d;", fs->exit);
+            break;
+        
+        case NODE_FN_DECL:
+            emit_fn_decl(fs, node);
+            break;
+        
+        case NODE_MATCH:
+            emit_match(fs, node);
+            break;
+        
+        case NODE_DEFER: {
+            Scope* scope = fs->scope;
+            if (scope->defer_count == scope->defer_capacity) {
+                scope->defer_capacity = scope->defer_capacity < 4 ? 4 : scope->defer_capacity * 2;
+                scope->defers = realloc(scope->defers, sizeof(Defer) * scope->defer_capacity);
+            }
+            Defer* defer = &scope->defers[scope->defer_count++];
+            defer->statement = node->as.defer_stmt.statement;
+            defer->flag = new_flag(fs);
+            emit(fs, "d%d = true;", defer->flag);
+            break;
+        }
+        
+        case NODE_IMPORT:
+            if (is_module_path(node->as.import.path)) {
+                emit_module(fs, node);
+            } else {
+                for (int i = 0; i < fs->indent; i++) text_write(&fs->code, "    ", 4);
+                text_printf(&fs->code, "interp_import(interp, ");
+                text_quote(&fs->code, node->as.import.path, node->as.import.path_length);
+                text_printf(&fs->code, ", %d);\n", node->line);
+                emit_check(fs);
+            }
+            break;
+        
+        case NODE_C_BLOCK:
+            emit_error(fs, node->line, "@c blocks not yet implemented");
+            break;
+        
+        default:
+            emit_error(fs, node->line, "Unknown statement type");
+            break;
+    }
+}
+
+/* ============ Functions ============ */
+
+static void fn_init(FnState* fs, Emitter* e) {
+    memset(fs, 0, sizeof(FnState));
+    fs->emitter = e;
+    fs->indent = 1;
+    fs->exit = 0;    /* L0 ends the function */
+}
+
+/* Copy code to out without the labels no goto names, which -Wall would
+   report; labels are emitted before it is known whether anything jumps
+   to them */
+static void write_used_labels(Text* out, const Text* code, int label_count) {
+    bool* used = calloc(label_count + 1, sizeof(bool));
+    for (const char* p = code->chars; (p = strstr(p, "goto L")) != NULL; p += 6) {
+        int label = atoi(p + 6);
+        if (label >= 0 && label <= label_count) used[label] = true;
+    }
+    
+    const char* line = code->chars;
+    const char* end = code->chars + code->length;
+    while (line < end) {
+        const char* newline = memchr(line, '\n', end - line);
+        const char* next = newline != NULL ? newline + 1 : end;
+        const char* text = line;
+        while (text < next && *text == ' ') text++;
+        int label;
+        int length = 0;
+        if (sscanf(text, "L%d: ;%n", &label, &length) == 1 && length > 0 &&
+            text + length == (newline != NULL ? newline : end) &&
+            label >= 0 && label <= label_count && !used[label]) {
+            line = next;
+            continue;
+        }
+        text_write(out, line, next - line);
+        line = next;
+    }
+    free(used);
+}
+
+/* Append the finished function to the emitter's output */
+static void fn_finish(FnState* fs, const char* signature) {
+    Text* out = &fs->emitter->bodies;
+    text_printf(out, "%s {\n", signature);
+    text_printf(out, "    int pending = AOT_NONE;\n");
+    if (fs->decls.chars != NULL) text_write(out, fs->decls.chars, fs->decls.length);
+    text_printf(out, "    (void)args;\n");
+    if (fs->code.chars != NULL) write_used_labels(out, &fs->code, fs->labels);
+    text_printf(out, "    (void)pending;\n");
+    text_printf(out, "}\n\n");
+    
+    text_free(&fs->decls);
+    text_free(&fs->code);
+    free(fs->captured.names);
+}
+
+/* Compile a fn declaration or lambda to fn_N and its descriptor
+   function_N; returns N */
+static int emit_function(Emitter* e, const char* name, int name_length,
+                         char** params, int* param_lengths, int param_count,
+                         AstNode* body, bool is_generator) {
+    int index = ++e->function_count;
+    FnState fs;
+    fn_init(&fs, e);
+    if (body != NULL) collect_captured(e, body, &fs.captured);
+    
+    /* Parameters, as call_function binds them */
+    Scope scope;
+    scope_init(&scope, NULL);
+    fs.scope = &scope;
+    int env = -1;
+    for (int i = 0; i < param_count; i++) {
+        bool seen = scope_binding(&scope, params[i], param_lengths[i]) != NULL;
+        if (is_captured(&fs, params[i], param_lengths[i])) {
+            if (env < 0) {
+                env = new_env(&fs);
+                enter_env(&fs, env);
+            }
+            emit(&fs, "env_define_key(interp->current, aot_key(interp, %d), args[%d], false);",
+                 constant(&fs, params[i], param_lengths[i]), i);
+            if (!seen) scope_bind(&scope, params[i], param_lengths[i], -1, false);
+        } else if (!seen) {
+            int local = new_local(&fs);
+            scope_bind(&scope, params[i], param_lengths[i], local, false);
+            emit(&fs, "aot_store(&l%d, args[%d]);", local, i);
+        }
+    }
+    
+    emit_body(&fs, body);
+    
+    emit_label(&fs, 0);
+    for (int i = 0; i < scope.binding_count; i++) {
+        if (scope.bindings[i].local >= 0) emit(&fs, "aot_release(&l%d);", scope.bindings[i].local);
+    }
+    if (env >= 0) leave_env(&fs, env);
+    scope_free(&scope);
+    
+    char signature[64];
+    snprintf(signature, sizeof(signature), "static void fn_%d(Interpreter* interp, Value* args)", index);
+    fn_finish(&fs, signature);
+    
+    /* What function_create needs; only the body's line is ever read */
+    Text* out = &e->descriptors;
+    if (param_count > 0) {
+        text_printf(out, "static char* params_%d[] = {", index);
+        for (int i = 0; i < param_count; i++) {
+            if (i > 0) text_printf(out, ", ");
+            text_quote(out, params[i], param_lengths[i]);
+        }
+        text_printf(out, "};\n");
+        text_printf(out, "static int param_lengths_%d[] = {", index);
+        for (int i = 0; i < param_count; i++) {
+            text_printf(out, "%s%d", i > 0 ? ", " : "", param_lengths[i]);
+        }
+        text_printf(out, "};\n");
+    }
+    text_printf(out, "static AstNode body_%d = {.type = NODE_BLOCK, .line = %d, .column = %d};\n", index,
+                body != NULL ? body->line : 0, body != NULL ? body->column : 0);
+    text_printf(out, "static const AotFunction function_%d = {", index);
+    if (name != NULL) {
+        text_quote(out, name, name_length);
+    } else {
+        text_printf(out, "NULL");
+    }
+    if (param_count > 0) {
+        text_printf(out, ", params_%d, param_lengths_%d", index, index);
+    } else {
+        text_printf(out, ", NULL, NULL");
+    }
+    text_printf(out, ", %d, &body_%d, %s, fn_%d};\n\n", param_count, index,
+                is_generator ? "true" : "false", index);
+    return index;
+}
+
+/* The program runs in the global scope; its defers run after it, unless
+   it failed or returned, as interp_destroy runs them */
+static void emit_program(Emitter* e, AstNode* program) {
+    FnState fs;
+    fn_init(&fs, e);
+    collect_captured(e, program, &fs.captured);
+    
+    Scope scope;
+    scope_init(&scope, NULL);
+    scope.global = true;
+    fs.scope = &scope;
+    for (int i = 0; i < program->as.program.statement_count; i++) {
+        emit_stmt(&fs, program->as.program.statements[i]);
+    }
+    emit_label(&fs, 0);
+    
+    for (int i = scope.defer_count - 1; i >= 0; i--) {
+        int end = new_label(&fs);
+        emit(&fs, "if (d%d && pending == AOT_NONE && !interp->had_error) {", scope.defers[i].flag);
+        fs.indent++;
+        fs.exit = end;
+        emit_stmt(&fs, scope.defers[i].statement);
+        emit_label(&fs, end);
+        fs.indent--;
+        emit(&fs, "}");
+    }
+    scope_free(&scope);
+    
+    fn_finish(&fs, "static void program(Interpreter* interp, Value* args)");
+}
+
+/* ============ Output ============ */
+
+static void emitter_free(Emitter* e) {
+    for (int i = 0; i < e->module_count; i++) {
+        if (e->modules[i]->program != NULL) ast_free_tree(e->modules[i]->program);
+        free(e->modules[i]->source);
+        free(e->modules[i]);
+    }
+    free(e->modules);
+    for (int i = 0; i < e->signature_count; i++) free(e->signature_names[i]);
+    free(e->signatures);
+    free(e->signature_names);
+    for (int i = 0; i < e->helper_count; i++) free(e->helpers[i].param_types);
+    free(e->helpers);
+    free(e->constants.names);
+    free(e->headers.names);
+    text_free(&e->descriptors);
+    text_free(&e->bodies);
+}
+
+bool emit_c(AstNode* program, const char* path) {
+    Emitter e;
+    memset(&e, 0, sizeof(Emitter));
+    
+    collect_headers(&e, program, NULL);
+    emit_program(&e, program);
+    if (e.failed) {
+        emitter_free(&e);
+        return false;
+    }
+    
+    Text out = {0};
+    text_printf(&out, "/* Generated by brisk --emit-c */\n\n");
+    text_printf(&out, "#include \"aot.h\"\n\n");
+    
+    text_printf(&out, "static const AotConstant constants[] = {\n");
+    for (int i = 0; i < e.constants.count; i++) {
+        text_printf(&out, "    {");
+        text_quote(&out, e.constants.names[i].chars, e.constants.names[i].length);
+        text_printf(&out, ", %d},\n", e.constants.names[i].length);
+    }
+    if (e.constants.count == 0) text_printf(&out, "    {NULL, 0}\n");
+    text_printf(&out, "};\n\n");
+    
+    text_printf(&out, "static void program(Interpreter* interp, Value* args);\n");
+    for (int i = 1; i <= e.function_count; i++) {
+        text_printf(&out, "static void fn_%d(Interpreter* interp, Value* args);\n", i);
+    }
+    text_printf(&out, "\n");
+    if (e.descriptors.chars != NULL) text_write(&out, e.descriptors.chars, e.descriptors.length);
+    for (int i = 0; i < e.helper_count; i++) {
+        if (e.helpers[i].called) emit_helper(&out, &e.helpers[i], i);
+    }
+    if (e.bodies.chars != NULL) text_write(&out, e.bodies.chars, e.bodies.length);
+    text_printf(&out, "int main(void) {\n");
+    text_printf(&out, "    return aot_main(program, constants, %d);\n", e.constants.count);
+    text_printf(&out, "}\n");
+    emitter_free(&e);
+    
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not write '%s'\n", path);
+        text_free(&out);
+        return false;
+    }
+    fwrite(out.chars, 1, out.length, file);
+    bool written = fclose(file) == 0;
+    text_free(&out);
+    if (!written) {
+        fprintf(stderr, "Error: Could not write '%s'\n", path);
+    }
+    return written;
+}
+
+int emit_c_file(const char* script_path, const char* c_path) {
+    FILE* file = fopen(script_path, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: Could not open file '%s'\n", script_path);
+        return 1;
+    }
+    
+    fseek(file, 0L, SEEK_END);
+    size_t file_size = ftell(file);
+    rewind(file);
+    
+    char* source = malloc(file_size + 1);
+    if (source == NULL) {
+        fprintf(stderr, "Error: Not enough memory to read '%s'\n", script_path);
+        fclose(file);
+        return 1;
+    }
+    size_t bytes_read = fread(source, 1, file_size, file);
+    source[bytes_read] = '\0';
+    fclose(file);
+    
+    AstNode* program = parse(source);
+    free(source);
+    if (program == NULL) {
+        return 1;  /* Parse error */
+    }
+    
+    bool written = emit_c(program, c_path);
+    ast_free_tree(program);
+    return written ? 0 : 1;
+}
+
+/* The source tree holding include/ and build/libbrisk.a */
+static bool runtime_home(char* home, size_t size) {
+    const char* env = getenv("BRISK_HOME");
+    if (env != NULL && env[0] != '\0') {
+        snprintf(home, size, "%s", env);
+    } else {
+        ssize_t length = readlink("/proc/self/exe", home, size - 1);
+        if (length <= 0) return false;
+        home[length] = '\0';
+        char* slash = strrchr(home, '/');
+        if (slash == NULL) return false;
+        *slash = '\0';
+    }
+    
+    char library[1100];
+    snprintf(library, sizeof(library), "%s/build/libbrisk.a", home);
+    return access(library, R_OK) == 0;
+}
+
+int emit_c_build(const char* c_path, const char* binary_path) {
+    char home[1024];
+    if (!runtime_home(home, sizeof(home))) {
+        fprintf(stderr, "Error: Cannot find build/libbrisk.a; run make in the Brisk "
+                        "source tree and set BRISK_HOME to it\n");
+        return 1;
+    }
+    if (strchr(home, '\'') || strchr(c_path, '\'') || strchr(binary_path, '\'')) {
+        fprintf(stderr, "Error: Paths with quotes are not supported by --compile\n");
+        return 1;
+    }
+    
+    const char* cc = getenv("CC");
+    if (cc == NULL || cc[0] == '\0') cc = "cc";
+    
+    char command[4096];
+    snprintf(command, sizeof(command),
+             "%s -std=c99 -O2 -I'%s/include' '%s' '%s/build/libbrisk.a' "
+             "-o '%s' -lm -lffi -ldl -lpthread",
+             cc, home, c_path, home, binary_path);
+    if (system(command) != 0) {
+        fprintf(stderr, "Error: Building '%s' failed: %s\n", binary_path, command);
+        return 1;
+    }
+    return 0;
+}
@@ -7,9 +7,11 @@
 #include <string.h>
 #include "env.h"
 #include "memory.h"
+#include "stats.h"
 
 Environment* env_create(Environment* enclosing) {
     Environment* env = mem_alloc(sizeof(Environment));
+    STAT_INC(environments);
     env->variables = table_create();
     env->enclosing = enclosing;
     env->ref_count = 1;
@@ -50,42 +52,72 @@ void env_destroy(Environment* env) {
 
 bool env_define(Environment* env, const char* name, int length, Value value, bool is_const) {
     ObjString* key = string_create(name, length);
-    
+    bool defined = env_define_key(env, key, value, is_const);
+    obj_decref((Object*)key);
+    return defined;
+}
+
+bool env_get(Environment* env, const char* name, int length, Value* value) {
+    ObjString* key = string_create(name, length);
+    bool found = env_get_key(env, key, value);
+    obj_decref((Object*)key);
+    return found;
+}
+
+bool env_get_local(Environment* env, const char* name, int length, Value* value) {
+    ObjString* key = string_create(name, length);
+    bool found = table_get(env->variables, key, value);
+    obj_decref((Object*)key);
+    return found;
+}
+
+bool env_is_const(Environment* env, const char* name, int length) {
+    ObjString* key = string_create(name, length);
+    bool is_const = env_is_const_key(env, key);
+    obj_decref((Object*)key);
+    return is_const;
+}
+
+bool env_set(Environment* env, const char* name, int length, Value value) {
+    ObjString* key = string_create(name, length);
+    bool set = env_set_key(env, key, value);
+    obj_decref((Object*)key);
+    return set;
+}
+
+/* ============ Interned Names ============ */
+
+bool env_define_key(Environment* env, ObjString* key, Value value, bool is_const) {
     /* Check if already defined in this scope */
     Value existing;
     if (table_get(env->variables, key, &existing)) {
-        obj_decref((Object*)key);
         return false;  /* Already defined */
     }
     
     table_set(env->variables, key, value, is_const);
-    obj_decref((Object*)key);  /* table_set increfs */
     return true;
 }
 
-bool env_get(Environment* env, const char* name, int length, Value* value) {
-    ObjString* key = string_create(name, length);
-    
+bool env_get_key(Environment* env, ObjString* key, Value* value) {
     Environment* current = env;
+#ifdef BRISK_STATS
+    int depth = 0;
+#endif
     while (current != NULL) {
         if (table_get(current->variables, key, value)) {
-            obj_decref((Object*)key);
+            STAT_INC(env_depth[depth < STATS_DEPTHS ? depth : STATS_DEPTHS - 1]);
             return true;
         }
         current = current->enclosing;
+#ifdef BRISK_STATS
+        depth++;
+#endif
     }
     
-    obj_decref((Object*)key);
+    STAT_INC(env_misses);
     return false;
 }
 
-bool env_get_local(Environment* env, const char* name, int length, Value* value) {
-    ObjString* key = string_create(name, length);
-    bool found = table_get(env->variables, key, value);
-    obj_decref((Object*)key);
-    return found;
-}
-
 /* Check if variable is const - helper */
 static bool find_entry_const(Environment* env, ObjString* key, bool* is_const) {
     if (env->variables->count == 0) return false;
@@ -110,26 +142,21 @@ static bool find_entry_const(Environment* env, ObjString* key, bool* is_const) {
     }
 }
 
-bool env_is_const(Environment* env, const char* name, int length) {
-    ObjString* key = string_create(name, length);
+bool env_is_const_key(Environment* env, ObjString* key) {
     bool is_const = false;
     
     Environment* current = env;
     while (current != NULL) {
         if (find_entry_const(current, key, &is_const)) {
-            obj_decref((Object*)key);
             return is_const;
         }
         current = current->enclosing;
     }
     
-    obj_decref((Object*)key);
     return false;
 }
 
-bool env_set(Environment* env, const char* name, int length, Value value) {
-    ObjString* key = string_create(name, length);
-    
+bool env_set_key(Environment* env, ObjString* key, Value value) {
     Environment* current = env;
     while (current != NULL) {
         Value existing;
@@ -137,17 +164,14 @@ bool env_set(Environment* env, const char* name, int length, Value value) {
             /* Check if const */
             bool is_const = false;
             if (find_entry_const(current, key, &is_const) && is_const) {
-                obj_decref((Object*)key);
                 return false;  /* Cannot assign to const */
             }
             
             table_set(current->variables, key, value, false);
-            obj_decref((Object*)key);
             return true;
         }
         current = current->enclosing;
     }
     
-    obj_decref((Object*)key);
     return false;  /* Variable not found */
 }
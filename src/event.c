@@ -0,0 +1,576 @@
+/*
+ * Brisk Language - Event Loop Implementation
+ * Coroutines started with spawn run on generator stacks. Anything that
+ * would block (sleep, await, a descriptor that is not ready) parks the
+ * coroutine and switches back to the loop, which runs the next ready one
+ * or waits in epoll for a descriptor or the nearest timer.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "event.h"
+#include "generator.h"
+#include "memory.h"
+
+#define EVENT_BATCH 64
+
+/* Coroutines parked on one descriptor */
+typedef struct {
+    ObjTask* reader;
+    ObjTask* writer;
+    uint32_t events;         /* What epoll is watching for now */
+} FdWatch;
+
+struct EventLoop {
+    int epoll_fd;            /* -1 until a descriptor is first waited on */
+    ObjTask* current;        /* Coroutine running now, NULL for the main flow */
+    ObjTask root;            /* Stands in for the main flow when it waits */
+    bool root_ready;
+
+    ObjTask* ready_head;
+    ObjTask* ready_tail;
+
+    ObjTask** timers;        /* Min-heap on wake_at */
+    int timer_count;
+    int timer_capacity;
+
+    FdWatch* watches;        /* Indexed by descriptor */
+    int watch_capacity;
+    int watching;            /* Descriptors registered with epoll */
+
+    ObjTask** tasks;         /* Unfinished; the loop holds a reference */
+    int task_count;
+    int task_capacity;
+};
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static pthread_once_t ignore_sigpipe_once = PTHREAD_ONCE_INIT;
+
+static void ignore_sigpipe(void) {
+    /* Writing to a closed pipe or socket fails with EPIPE instead */
+    signal(SIGPIPE, SIG_IGN);
+}
+
+static EventLoop* loop_get(Interpreter* interp) {
+    if (interp->loop == NULL) {
+        EventLoop* loop = mem_alloc(sizeof(EventLoop));
+        memset(loop, 0, sizeof(EventLoop));
+        loop->epoll_fd = -1;
+        loop->root.obj.type = OBJ_TASK;
+        interp->loop = loop;
+        pthread_once(&ignore_sigpipe_once, ignore_sigpipe);
+    }
+    return interp->loop;
+}
+
+/* Whoever is running: a coroutine, or the main flow */
+static ObjTask* current_task(EventLoop* loop) {
+    return loop->current != NULL ? loop->current : &loop->root;
+}
+
+static void wake(EventLoop* loop, ObjTask* task) {
+    if (task == &loop->root) {
+        loop->root_ready = true;
+        return;
+    }
+    task->next = NULL;
+    if (loop->ready_tail != NULL) {
+        loop->ready_tail->next = task;
+    } else {
+        loop->ready_head = task;
+    }
+    loop->ready_tail = task;
+}
+
+/* ============ Timers ============ */
+
+static void timer_push(EventLoop* loop, ObjTask* task) {
+    if (loop->timer_count >= loop->timer_capacity) {
+        int old_capacity = loop->timer_capacity;
+        loop->timer_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+        loop->timers = mem_realloc(loop->timers, sizeof(ObjTask*) * old_capacity,
+                                   sizeof(ObjTask*) * loop->timer_capacity);
+    }
+    
+    int i = loop->timer_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (loop->timers[parent]->wake_at <= task->wake_at) break;
+        loop->timers[i] = loop->timers[parent];
+        i = parent;
+    }
+    loop->timers[i] = task;
+}
+
+static ObjTask* timer_pop(EventLoop* loop) {
+    ObjTask* top = loop->timers[0];
+    ObjTask* last = loop->timers[--loop->timer_count];
+    
+    int i = 0;
+    for (;;) {
+        int child = i * 2 + 1;
+        if (child >= loop->timer_count) break;
+        if (child + 1 < loop->timer_count &&
+            loop->timers[child + 1]->wake_at < loop->timers[child]->wake_at) {
+            child++;
+        }
+        if (last->wake_at <= loop->timers[child]->wake_at) break;
+        loop->timers[i] = loop->timers[child];
+        i = child;
+    }
+    if (loop->timer_count > 0) loop->timers[i] = last;
+    return top;
+}
+
+/* ============ Descriptors ============ */
+
+/* Tell epoll what the parked coroutines on fd are waiting for */
+static bool watch_update(EventLoop* loop, int fd) {
+    FdWatch* watch = &loop->watches[fd];
+    uint32_t events = (watch->reader != NULL ? EPOLLIN : 0) |
+                      (watch->writer != NULL ? EPOLLOUT : 0);
+    if (events == watch->events) return true;
+    
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = fd;
+    
+    int op = watch->events == 0 ? EPOLL_CTL_ADD
+           : events == 0 ? EPOLL_CTL_DEL
+           : EPOLL_CTL_MOD;
+    if (epoll_ctl(loop->epoll_fd, op, fd, &event) != 0 && op != EPOLL_CTL_DEL) {
+        return false;
+    }
+    
+    if (watch->events == 0) loop->watching++;
+    if (events == 0) loop->watching--;
+    watch->events = events;
+    return true;
+}
+
+static void watch_reserve(EventLoop* loop, int fd) {
+    if (fd < loop->watch_capacity) return;
+    
+    int old_capacity = loop->watch_capacity;
+    int capacity = old_capacity < 8 ? 8 : old_capacity;
+    while (capacity <= fd) capacity *= 2;
+    loop->watches = mem_realloc(loop->watches, sizeof(FdWatch) * old_capacity,
+                                sizeof(FdWatch) * capacity);
+    memset(loop->watches + old_capacity, 0, sizeof(FdWatch) * (capacity - old_capacity));
+    loop->watch_capacity = capacity;
+}
+
+/* Wait up to timeout_ms (-1: no limit) for descriptors, then wake whoever
+   they or the expired timers were holding */
+static void poll_events(EventLoop* loop, int timeout_ms) {
+    if (loop->watching > 0) {
+        struct epoll_event events[EVENT_BATCH];
+        int count = epoll_wait(loop->epoll_fd, events, EVENT_BATCH, timeout_ms);
+        
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            uint32_t happened = events[i].events;
+            FdWatch* watch = &loop->watches[fd];
+            
+            /* Hangups and errors wake both sides; the retried call reports them */
+            if ((happened & (EPOLLIN | EPOLLHUP | EPOLLERR)) && watch->reader != NULL) {
+                wake(loop, watch->reader);
+                watch->reader = NULL;
+            }
+            if ((happened & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && watch->writer != NULL) {
+                wake(loop, watch->writer);
+                watch->writer = NULL;
+            }
+            watch_update(loop, fd);
+        }
+    } else if (timeout_ms > 0) {
+        struct timespec ts;
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+        nanosleep(&ts, NULL);
+    }
+    
+    int64_t now = now_ns();
+    while (loop->timer_count > 0 && loop->timers[0]->wake_at <= now) {
+        wake(loop, timer_pop(loop));
+    }
+}
+
+/* ============ Scheduling ============ */
+
+static void task_release(EventLoop* loop, ObjTask* task) {
+    ObjTask* moved = loop->tasks[--loop->task_count];
+    loop->tasks[task->slot] = moved;
+    moved->slot = task->slot;
+    obj_decref((Object*)task);
+}
+
+static void finish_task(EventLoop* loop, ObjTask* task, Value result) {
+    task->done = true;
+    task->result = result;
+    if (IS_OBJ(result)) obj_incref(AS_OBJ(result));
+    
+    while (task->waiters != NULL) {
+        ObjTask* waiter = task->waiters;
+        task->waiters = waiter->next;
+        wake(loop, waiter);
+    }
+    task_release(loop, task);
+}
+
+/* Resume every coroutine that was ready when the round began, so one that
+   keeps waking itself cannot starve the others or the poll */
+static void run_ready(Interpreter* interp, EventLoop* loop) {
+    ObjTask* task = loop->ready_head;
+    loop->ready_head = NULL;
+    loop->ready_tail = NULL;
+    
+    while (task != NULL && !interp->had_error) {
+        ObjTask* next = task->next;
+        Value value;
+        
+        loop->current = task;
+        GeneratorStatus status = generator_resume(interp, task->body, &value);
+        loop->current = NULL;
+        
+        if (status == GENERATOR_DONE) finish_task(loop, task, value);
+        task = next;
+    }
+}
+
+/* Park the current flow until something wakes it. A coroutine switches
+   back to the loop; the main flow runs the loop until then. */
+static bool park(Interpreter* interp, EventLoop* loop, ObjTask* self) {
+    if (self != &loop->root) {
+        generator_suspend(self->body);
+        return !interp->had_error;
+    }
+    
+    loop->root_ready = false;
+    while (!loop->root_ready && !interp->had_error) {
+        run_ready(interp, loop);
+        if (loop->root_ready || interp->had_error) break;
+        
+        int timeout_ms = -1;
+        if (loop->ready_head != NULL) {
+            timeout_ms = 0;
+        } else if (loop->timer_count > 0) {
+            int64_t wait = loop->timers[0]->wake_at - now_ns();
+            timeout_ms = wait <= 0 ? 0 : (int)((wait + 999999) / 1000000);
+        } else if (loop->watching == 0) {
+            runtime_error(interp, interp->call_line,
+                          "Deadlock: every task is waiting and nothing can wake them");
+            return false;
+        }
+        
+        /* Show what was printed before going to sleep */
+        if (timeout_ms != 0) output_flush(&interp->out);
+        poll_events(loop, timeout_ms);
+    }
+    return !interp->had_error;
+}
+
+ObjTask* event_spawn(Interpreter* interp, ObjFunction* fn, int arg_count, Value* args) {
+    EventLoop* loop = loop_get(interp);
+    
+    ObjTask* task = (ObjTask*)allocate_object(sizeof(ObjTask), OBJ_TASK);
+    task->body = generator_create(fn, arg_count, args);
+    task->done = false;
+    task->result = NIL_VAL;
+    task->next = NULL;
+    task->waiters = NULL;
+    task->wake_at = 0;
+    
+    if (loop->task_count >= loop->task_capacity) {
+        int old_capacity = loop->task_capacity;
+        loop->task_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+        loop->tasks = mem_realloc(loop->tasks, sizeof(ObjTask*) * old_capacity,
+                                  sizeof(ObjTask*) * loop->task_capacity);
+    }
+    task->slot = loop->task_count;
+    loop->tasks[loop->task_count++] = task;
+    obj_incref((Object*)task);
+    
+    wake(loop, task);
+    return task;
+}
+
+bool event_await(Interpreter* interp, ObjTask* task, Value* out) {
+    EventLoop* loop = loop_get(interp);
+    ObjTask* self = current_task(loop);
+    
+    if (!task->done) {
+        if (task == self) {
+            runtime_error(interp, interp->call_line, "A task cannot await itself");
+            return false;
+        }
+        self->next = task->waiters;
+        task->waiters = self;
+        if (!park(interp, loop, self)) return false;
+    }
+    
+    *out = task->result;
+    return true;
+}
+
+bool event_sleep(Interpreter* interp, int64_t ns) {
+    EventLoop* loop = loop_get(interp);
+    ObjTask* self = current_task(loop);
+    
+    self->wake_at = now_ns() + (ns > 0 ? ns : 0);
+    timer_push(loop, self);
+    return park(interp, loop, self);
+}
+
+bool event_wait_fd(Interpreter* interp, int fd, bool write) {
+    EventLoop* loop = loop_get(interp);
+    ObjTask* self = current_task(loop);
+    
+    if (loop->epoll_fd < 0) {
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epoll_fd < 0) {
+            runtime_error(interp, interp->call_line, "Could not create an epoll instance");
+            return false;
+        }
+    }
+    if (fd < 0) return true;  /* The retried call reports EBADF */
+    watch_reserve(loop, fd);
+    
+    FdWatch* watch = &loop->watches[fd];
+    ObjTask** slot = write ? &watch->writer : &watch->reader;
+    if (*slot != NULL) {
+        runtime_error(interp, interp->call_line, "Another task is already waiting to %s fd %d",
+                      write ? "write" : "read", fd);
+        return false;
+    }
+    
+    *slot = self;
+    if (!watch_update(loop, fd)) {
+        *slot = NULL;
+        /* Regular files cannot be polled but never block, and a bad
+           descriptor fails again when retried */
+        if (errno == EPERM || errno == EBADF) return true;
+        runtime_error(interp, interp->call_line, "Could not wait on fd %d", fd);
+        return false;
+    }
+    return park(interp, loop, self);
+}
+
+void event_loop_free(EventLoop* loop) {
+    /* Coroutines still parked are dropped where they stand */
+    for (int i = 0; i < loop->task_count; i++) {
+        obj_decref((Object*)loop->tasks[i]);
+    }
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    
+    if (loop->tasks != NULL) mem_free(loop->tasks, sizeof(ObjTask*) * loop->task_capacity);
+    if (loop->timers != NULL) mem_free(loop->timers, sizeof(ObjTask*) * loop->timer_capacity);
+    if (loop->watches != NULL) mem_free(loop->watches, sizeof(FdWatch) * loop->watch_capacity);
+    mem_free(loop, sizeof(EventLoop));
+}
+
+void task_free(ObjTask* task) {
+    if (task->body != NULL) generator_free(task->body);
+    if (IS_OBJ(task->result)) obj_decref(AS_OBJ(task->result));
+}
+
+/* ============ I/O ============ */
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool would_block(void) {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+bool event_pipe(int fds[2]) {
+    return pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0;
+}
+
+bool event_socketpair(int fds[2]) {
+    return socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) == 0;
+}
+
+static bool unix_address(const char* path, struct sockaddr_un* address) {
+    if (strlen(path) >= sizeof(address->sun_path)) return false;
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, path);
+    return true;
+}
+
+int event_unix_listen(const char* path) {
+    struct sockaddr_un address;
+    if (!unix_address(path, &address)) return -1;
+    
+    /* A socket left behind by an earlier run would make bind fail */
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int event_unix_connect(Interpreter* interp, const char* path) {
+    struct sockaddr_un address;
+    if (!unix_address(path, &address)) return -1;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0) return fd;
+    
+    if (errno == EINPROGRESS && event_wait_fd(interp, fd, true)) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+            return fd;
+        }
+    }
+    close(fd);
+    return -1;
+}
+
+int event_accept(Interpreter* interp, int fd) {
+    for (;;) {
+        int client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client >= 0) return client;
+        if (errno == EINTR) continue;
+        if (!would_block() || !event_wait_fd(interp, fd, false)) return -1;
+    }
+}
+
+Value event_read(Interpreter* interp, int fd, int max) {
+    char* buffer = mem_alloc(max);
+    Value result = NIL_VAL;
+    
+    for (;;) {
+        ssize_t count = read(fd, buffer, max);
+        if (count >= 0) {
+            result = OBJ_VAL(string_create_uninterned(buffer, (int)count));
+            break;
+        }
+        if (errno == EINTR) continue;
+        if (!would_block() || !event_wait_fd(interp, fd, false)) break;
+    }
+    
+    mem_free(buffer, max);
+    return result;
+}
+
+int64_t event_write(Interpreter* interp, int fd, const char* chars, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t count = write(fd, chars + written, length - written);
+        if (count >= 0) {
+            written += (size_t)count;
+            continue;
+        }
+        if (errno == EINTR) continue;
+        if (!would_block() || !event_wait_fd(interp, fd, true)) return -1;
+    }
+    return (int64_t)written;
+}
+
+void event_close(Interpreter* interp, int fd) {
+    EventLoop* loop = interp->loop;
+    if (loop != NULL && fd >= 0 && fd < loop->watch_capacity) {
+        FdWatch* watch = &loop->watches[fd];
+        if (watch->reader != NULL) wake(loop, watch->reader);
+        if (watch->writer != NULL) wake(loop, watch->writer);
+        watch->reader = NULL;
+        watch->writer = NULL;
+        watch_update(loop, fd);
+    }
+    close(fd);
+}
+
+/* ============ Processes ============ */
+
+int event_process(const char* command, int* input, int* output) {
+    int to_child[2];
+    int from_child[2];
+    if (pipe2(to_child, O_CLOEXEC) != 0) return -1;
+    if (pipe2(from_child, O_CLOEXEC) != 0) {
+        close(to_child[0]);
+        close(to_child[1]);
+        return -1;
+    }
+    
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+        _exit(127);
+    }
+    
+    close(to_child[0]);
+    close(from_child[1]);
+    if (pid < 0) {
+        close(to_child[1]);
+        close(from_child[0]);
+        return -1;
+    }
+    
+    set_nonblocking(to_child[1]);
+    set_nonblocking(from_child[0]);
+    *input = to_child[1];
+    *output = from_child[0];
+    return (int)pid;
+}
+
+int event_wait_process(Interpreter* interp, int pid) {
+    int status;
+    
+    /* A pidfd turns readable when the child exits, so waiting on it parks
+       like any descriptor; older kernels fall back to polling */
+    int pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (pidfd >= 0) {
+        bool ok = event_wait_fd(interp, pidfd, false);
+        event_close(interp, pidfd);
+        if (!ok) return -1;
+        if (waitpid(pid, &status, 0) != pid) return -1;
+    } else {
+        /* The poll that sees the exit also reaps the child, so its status
+           is the one to keep */
+        for (;;) {
+            pid_t done = waitpid(pid, &status, WNOHANG);
+            if (done == pid) break;
+            if (done < 0) return -1;
+            if (!event_sleep(interp, 1000000)) return -1;
+        }
+    }
+    
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return -1;
+}
@@ -0,0 +1,217 @@
+/*
+ * Brisk Language - FFI Call Tracer Implementation
+ * Each traced C function gets three log-linear histograms in the style of
+ * HdrHistogram: exact counts below 16 ns, then 16 buckets per power of two,
+ * so any percentile is within about 6% of the true time. The records
+ * outlive their descriptors so the exit report still sees every call.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "ffitrace.h"
+
+#define SUB_BITS 4
+#define SUB_BUCKETS (1 << SUB_BITS)
+#define BUCKETS ((64 - SUB_BITS + 1) * SUB_BUCKETS)
+
+typedef enum {
+    PHASE_MARSHAL,
+    PHASE_CALL,
+    PHASE_UNMARSHAL,
+    PHASE_COUNT
+} Phase;
+
+static const char* phase_names[PHASE_COUNT] = { "marshal", "call", "unmarshal" };
+
+typedef struct {
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[BUCKETS];
+} Histogram;
+
+struct FfiTrace {
+    char* name;
+    uint64_t calls;
+    Histogram phases[PHASE_COUNT];
+    struct FfiTrace* next;
+};
+
+typedef struct FfiTrace FfiTrace;
+
+bool ffi_tracing = false;
+
+/* Worker threads call C functions too */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static FfiTrace* traces = NULL;
+static int trace_count = 0;
+
+void ffi_trace_configure(void) {
+    const char* setting = getenv("BRISK_FFI_TRACE");
+    ffi_tracing = setting != NULL && setting[0] != '\0' && strcmp(setting, "0") != 0;
+}
+
+/* ============ Histograms ============ */
+
+static int bucket_index(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return (int)ns;
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/* Largest time that lands in bucket index */
+static uint64_t bucket_limit(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+    int exponent = index / SUB_BUCKETS + SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(index % SUB_BUCKETS);
+    int shift = exponent - SUB_BITS;
+    return (((SUB_BUCKETS + sub + 1) << shift) - 1);
+}
+
+static void histogram_add(Histogram* histogram, uint64_t ns) {
+    histogram->buckets[bucket_index(ns)]++;
+    histogram->total_ns += ns;
+    if (ns > histogram->max_ns) histogram->max_ns = ns;
+}
+
+/* Time at or below which fraction of the calls finished */
+static uint64_t histogram_percentile(const Histogram* histogram, uint64_t calls,
+                                     double fraction) {
+    uint64_t rank = (uint64_t)(fraction * (double)calls + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= rank) {
+            uint64_t limit = bucket_limit(i);
+            return limit < histogram->max_ns ? limit : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+void ffi_trace_record(CFunctionDesc* desc, uint64_t marshal_ns,
+                      uint64_t call_ns, uint64_t unmarshal_ns) {
+    pthread_mutex_lock(&trace_lock);
+    if (!ffi_tracing) {
+        /* A worker thread finishing a call after the final report */
+        pthread_mutex_unlock(&trace_lock);
+        return;
+    }
+    FfiTrace* trace = desc->trace;
+    if (trace == NULL) {
+        trace = calloc(1, sizeof(FfiTrace));
+        size_t length = strlen(desc->name);
+        if (trace != NULL) trace->name = malloc(length + 1);
+        if (trace == NULL || trace->name == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        memcpy(trace->name, desc->name, length + 1);
+        trace->next = traces;
+        traces = trace;
+        trace_count++;
+        desc->trace = trace;
+    }
+    trace->calls++;
+    histogram_add(&trace->phases[PHASE_MARSHAL], marshal_ns);
+    histogram_add(&trace->phases[PHASE_CALL], call_ns);
+    histogram_add(&trace->phases[PHASE_UNMARSHAL], unmarshal_ns);
+    pthread_mutex_unlock(&trace_lock);
+}
+
+/* ============ Report ============ */
+
+static void format_ns(char* out, size_t size, uint64_t ns) {
+    if (ns >= 1000000000u) {
+        snprintf(out, size, "%.2f s", (double)ns / 1e9);
+    } else if (ns >= 1000000u) {
+        snprintf(out, size, "%.2f ms", (double)ns / 1e6);
+    } else if (ns >= 1000u) {
+        snprintf(out, size, "%.2f us", (double)ns / 1e3);
+    } else {
+        snprintf(out, size, "%llu ns", (unsigned long long)ns);
+    }
+}
+
+static uint64_t trace_total(const FfiTrace* trace) {
+    uint64_t total = 0;
+    for (int p = 0; p < PHASE_COUNT; p++) total += trace->phases[p].total_ns;
+    return total;
+}
+
+static int compare_traces(const void* a, const void* b) {
+    uint64_t x = trace_total(*(FfiTrace* const*)a);
+    uint64_t y = trace_total(*(FfiTrace* const*)b);
+    if (x != y) return x < y ? 1 : -1;
+    return 0;
+}
+
+void ffi_trace_report(void) {
+    if (!ffi_tracing) {
+        fprintf(stderr, "\nFFI trace: set BRISK_FFI_TRACE=1 to time C function calls\n");
+        return;
+    }
+    
+    pthread_mutex_lock(&trace_lock);
+    FfiTrace** order = malloc(sizeof(FfiTrace*) * (trace_count + 1));
+    if (order == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    uint64_t calls = 0;
+    uint64_t total = 0;
+    int count = 0;
+    for (FfiTrace* trace = traces; trace != NULL; trace = trace->next) {
+        order[count++] = trace;
+        calls += trace->calls;
+        total += trace_total(trace);
+    }
+    qsort(order, count, sizeof(FfiTrace*), compare_traces);
+    
+    char text[5][24];
+    format_ns(text[0], sizeof(text[0]), total);
+    fprintf(stderr, "\nFFI trace: %llu calls to %d C function%s, %s in total\n",
+            (unsigned long long)calls, count, count == 1 ? "" : "s", text[0]);
+    fprintf(stderr, "  %-22s %10s %10s %10s %10s %10s %10s\n",
+            "Function", "Calls", "p50", "p90", "p99", "Max", "Total");
+    for (int i = 0; i < count; i++) {
+        const FfiTrace* trace = order[i];
+        format_ns(text[0], sizeof(text[0]), trace_total(trace));
+        fprintf(stderr, "  %-22s %10llu %54s\n", trace->name,
+                (unsigned long long)trace->calls, text[0]);
+        
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            const Histogram* histogram = &trace->phases[p];
+            format_ns(text[0], sizeof(text[0]), histogram_percentile(histogram, trace->calls, 0.50));
+            format_ns(text[1], sizeof(text[1]), histogram_percentile(histogram, trace->calls, 0.90));
+            format_ns(text[2], sizeof(text[2]), histogram_percentile(histogram, trace->calls, 0.99));
+            format_ns(text[3], sizeof(text[3]), histogram->max_ns);
+            format_ns(text[4], sizeof(text[4]), histogram->total_ns);
+            fprintf(stderr, "    %-20s %10s %10s %10s %10s %10s %10s\n", phase_names[p], "",
+                    text[0], text[1], text[2], text[3], text[4]);
+        }
+    }
+    free(order);
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void ffi_trace_finish(void) {
+    if (!ffi_tracing) return;
+    ffi_trace_report();
+    
+    /* Tracing is off from here on, so descriptors still pointing at these
+       records never read them again */
+    pthread_mutex_lock(&trace_lock);
+    ffi_tracing = false;
+    while (traces != NULL) {
+        FfiTrace* next = traces->next;
+        free(traces->name);
+        free(traces);
+        traces = next;
+    }
+    trace_count = 0;
+    pthread_mutex_unlock(&trace_lock);
+}
@@ -0,0 +1,138 @@
+/*
+ * Brisk Language - File I/O Implementation
+ * mmap for whole-file reads, getline with a reused buffer for line
+ * readers, and the output buffer for writers
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "fileio.h"
+#include "output.h"
+#include "memory.h"
+#include "isolate.h"
+
+/* Open files are tracked per isolate, so writers still get flushed if
+   the program exits without closing them */
+static pthread_once_t exit_hook_once = PTHREAD_ONCE_INIT;
+
+static void close_open_files(void) {
+    Isolate* isolate = isolate_current();
+    while (isolate->open_files != NULL) {
+        file_close(isolate->open_files);
+    }
+}
+
+static void install_exit_hook(void) {
+    atexit(close_open_files);
+}
+
+ObjString* file_read_all(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > 0x7fffffff) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return string_create("", 0);
+    }
+    
+    char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return NULL;
+    
+    /* Copy straight from the page cache into the string */
+    ObjString* result = string_create_uninterned(data, (int)size);
+    munmap(data, size);
+    return result;
+}
+
+bool file_write_all(const char* path, const char* chars, size_t length, bool append) {
+    FILE* file = fopen(path, append ? "ab" : "wb");
+    if (file == NULL) return false;
+    
+    bool ok = fwrite(chars, 1, length, file) == length;
+    if (fclose(file) != 0) ok = false;
+    return ok;
+}
+
+ObjFile* file_open(const char* path, bool write, bool append) {
+    FILE* stream = fopen(path, write ? (append ? "ab" : "wb") : "rb");
+    if (stream == NULL) return NULL;
+    
+    ObjFile* file = (ObjFile*)allocate_object(sizeof(ObjFile), OBJ_FILE);
+    file->file = stream;
+    file->out = NULL;
+    file->line = NULL;
+    file->line_capacity = 0;
+    
+    if (write) {
+        /* The output buffer does the batching; skip stdio's copy */
+        setvbuf(stream, NULL, _IONBF, 0);
+        file->out = mem_alloc(sizeof(Output));
+        output_init(file->out, stream);
+        file->out->mode = OUTPUT_BLOCK;
+    }
+    
+    Isolate* isolate = isolate_current();
+    file->prev_open = NULL;
+    file->next_open = isolate->open_files;
+    if (isolate->open_files != NULL) isolate->open_files->prev_open = file;
+    isolate->open_files = file;
+    
+    pthread_once(&exit_hook_once, install_exit_hook);
+    
+    return file;
+}
+
+ObjString* file_read_line(ObjFile* file) {
+    if (file->file == NULL || file->out != NULL) return NULL;
+    
+    ssize_t length = getline(&file->line, &file->line_capacity, file->file);
+    if (length < 0) return NULL;
+    
+    /* Strip \n or \r\n */
+    if (length > 0 && file->line[length - 1] == '\n') length--;
+    if (length > 0 && file->line[length - 1] == '\r') length--;
+    
+    return string_create_uninterned(file->line, (int)length);
+}
+
+void file_close(ObjFile* file) {
+    if (file->file == NULL) return;
+    
+    if (file->out != NULL) {
+        output_free(file->out);
+        mem_free(file->out, sizeof(Output));
+        file->out = NULL;
+    }
+    fclose(file->file);
+    file->file = NULL;
+    
+    /* getline allocates with malloc */
+    free(file->line);
+    file->line = NULL;
+    file->line_capacity = 0;
+    
+    if (file->prev_open != NULL) {
+        file->prev_open->next_open = file->next_open;
+    } else {
+        isolate_current()->open_files = file->next_open;
+    }
+    if (file->next_open != NULL) file->next_open->prev_open = file->prev_open;
+    file->next_open = NULL;
+    file->prev_open = NULL;
+}
@@ -0,0 +1,138 @@
+/*
+ * Brisk Language - Value Formatting Implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "format.h"
+#include "numconv.h"
+
+/* Write digits of n in the given base ending just before end */
+static int render_digits(char* end, uint64_t n, int base, bool upper) {
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char* p = end;
+    
+    do {
+        *--p = digits[n % base];
+        n /= base;
+    } while (n != 0);
+    
+    return (int)(end - p);
+}
+
+/* Pad sign + body out to the spec width. Zero padding goes between the
+   sign and the digits and only applies to numbers. */
+static int write_padded(char* out, int capacity, const char* sign, int sign_len,
+                        const char* body, int body_len, const FormatSpec* spec,
+                        bool numeric) {
+    int length = sign_len + body_len;
+    int total = length > spec->width ? length : spec->width;
+    if (total > capacity) return total;
+    
+    int fill = total - length;
+    char align = spec->align ? spec->align : (numeric ? '>' : '<');
+    
+    if (numeric && spec->zero_pad && align == '>') {
+        memcpy(out, sign, sign_len);
+        memset(out + sign_len, '0', fill);
+        memcpy(out + sign_len + fill, body, body_len);
+    } else if (align == '<') {
+        memcpy(out, sign, sign_len);
+        memcpy(out + sign_len, body, body_len);
+        memset(out + length, ' ', fill);
+    } else {
+        memset(out, ' ', fill);
+        memcpy(out + fill, sign, sign_len);
+        memcpy(out + fill + sign_len, body, body_len);
+    }
+    
+    return total;
+}
+
+static int format_int(char* out, int capacity, int64_t n, const FormatSpec* spec) {
+    char buffer[72];
+    char* end = buffer + sizeof(buffer);
+    uint64_t magnitude = n < 0 ? (uint64_t)0 - (uint64_t)n : (uint64_t)n;
+    int length;
+    
+    switch (spec->type) {
+        case 'x': length = render_digits(end, magnitude, 16, false); break;
+        case 'X': length = render_digits(end, magnitude, 16, true); break;
+        case 'o': length = render_digits(end, magnitude, 8, false); break;
+        case 'b': length = render_digits(end, magnitude, 2, false); break;
+        default: length = render_digits(end, magnitude, 10, false); break;
+    }
+    
+    return write_padded(out, capacity, "-", n < 0 ? 1 : 0,
+                        end - length, length, spec, true);
+}
+
+static int format_float(char* out, int capacity, double d, const FormatSpec* spec) {
+    /* Precision is capped at 100 by the parser, so %f of any double fits */
+    char buffer[512];
+    int length;
+    
+    if (spec->precision < 0 && spec->type == 0) {
+        length = num_format_double(buffer, d);
+    } else {
+        char conversion = spec->type == 0 ? 'f' : spec->type;
+        char fmt[8] = {'%', '.', '*', conversion, '\0'};
+        int precision = spec->precision < 0 ? 6 : spec->precision;
+        length = snprintf(buffer, sizeof(buffer), fmt, precision, d);
+    }
+    
+    int sign_len = buffer[0] == '-' ? 1 : 0;
+    return write_padded(out, capacity, buffer, sign_len,
+                        buffer + sign_len, length - sign_len, spec, true);
+}
+
+int format_value(char* out, int capacity, Value value, const FormatSpec* spec) {
+    const char* text;
+    int length;
+    
+    switch (value.type) {
+        case VAL_INT:
+            if (spec->type == 'f' || spec->type == 'e' || spec->type == 'g') {
+                return format_float(out, capacity, (double)AS_INT(value), spec);
+            }
+            return format_int(out, capacity, AS_INT(value), spec);
+        case VAL_FLOAT:
+            if (spec->type != 0 && strchr("dxXob", spec->type) != NULL) {
+                return format_int(out, capacity, (int64_t)AS_FLOAT(value), spec);
+            }
+            return format_float(out, capacity, AS_FLOAT(value), spec);
+        case VAL_NIL:
+            text = "nil";
+            length = 3;
+            break;
+        case VAL_BOOL:
+            text = AS_BOOL(value) ? "true" : "false";
+            length = AS_BOOL(value) ? 4 : 5;
+            break;
+        case VAL_OBJ:
+            if (IS_STRING(value)) {
+                text = AS_STRING(value)->chars;
+                length = AS_STRING(value)->length;
+            } else {
+                /* Same "<type>" form as value_to_string */
+                char buffer[64];
+                length = snprintf(buffer, sizeof(buffer), "<%s>", value_type_name(value));
+                if (spec->precision >= 0 && spec->precision < length) {
+                    length = spec->precision;
+                }
+                return write_padded(out, capacity, "", 0, buffer, length, spec, false);
+            }
+            break;
+        default:
+            text = "";
+            length = 0;
+            break;
+    }
+    
+    /* Precision truncates text */
+    if (spec->precision >= 0 && spec->precision < length) {
+        length = spec->precision;
+    }
+    return write_padded(out, capacity, "", 0, text, length, spec, false);
+}
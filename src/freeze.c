@@ -0,0 +1,85 @@
+/*
+ * Brisk Language - Frozen Values Implementation
+ * The graph is walked twice with an explicit stack: once to check that
+ * every object can be frozen, using the marked flag to visit each one
+ * only once, then over the visited list to flip frozen and clear marked.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freeze.h"
+#include "memory.h"
+
+typedef struct {
+    Object** items;
+    int count;
+    int capacity;
+} ObjectList;
+
+static void list_push(ObjectList* list, Object* obj) {
+    if (list->count == list->capacity) {
+        int old_capacity = list->capacity;
+        list->capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+        list->items = mem_realloc(list->items, sizeof(Object*) * old_capacity,
+                                  sizeof(Object*) * list->capacity);
+    }
+    list->items[list->count++] = obj;
+}
+
+/* Queue an object not yet seen; frozen ones are done already */
+static void visit(ObjectList* pending, ObjectList* seen, Value value) {
+    if (!IS_OBJ(value)) return;
+    Object* obj = AS_OBJ(value);
+    if (obj->frozen || obj->marked) return;
+    
+    obj->marked = true;
+    list_push(seen, obj);
+    list_push(pending, obj);
+}
+
+bool freeze_value(Value value, char* error, int error_size) {
+    ObjectList pending = {NULL, 0, 0};
+    ObjectList seen = {NULL, 0, 0};
+    bool ok = true;
+    
+    visit(&pending, &seen, value);
+    while (ok && pending.count > 0) {
+        Object* obj = pending.items[--pending.count];
+        switch (obj->type) {
+            case OBJ_STRING:
+                break;
+            case OBJ_ARRAY: {
+                ObjArray* array = (ObjArray*)obj;
+                for (int i = 0; i < array->count; i++) {
+                    visit(&pending, &seen, array->elements[i]);
+                }
+                break;
+            }
+            case OBJ_TABLE: {
+                ObjTable* table = (ObjTable*)obj;
+                for (int i = 0; i < table->capacity; i++) {
+                    TableEntry* entry = &table->entries[i];
+                    if (entry->key == NULL) continue;
+                    visit(&pending, &seen, OBJ_VAL(entry->key));
+                    visit(&pending, &seen, entry->value);
+                }
+                break;
+            }
+            default:
+                /* Functions, files and handles hold state that keeps changing */
+                snprintf(error, error_size, "cannot freeze a %s", value_type_name(OBJ_VAL(obj)));
+                ok = false;
+                break;
+        }
+    }
+    
+    for (int i = 0; i < seen.count; i++) {
+        seen.items[i]->marked = false;
+        if (ok) seen.items[i]->frozen = true;
+    }
+    
+    if (pending.items != NULL) mem_free(pending.items, sizeof(Object*) * pending.capacity);
+    if (seen.items != NULL) mem_free(seen.items, sizeof(Object*) * seen.capacity);
+    return ok;
+}
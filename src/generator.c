@@ -0,0 +1,196 @@
+/*
+ * Brisk Language - Generators Implementation
+ * Each generator body runs on its own C stack, so the tree walker can stop
+ * at a yield anywhere in it (inside loops, matches, nested calls) and pick
+ * up there on the next resume, without turning exec into a state machine.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "generator.h"
+#include "memory.h"
+
+struct Generator {
+    ObjFunction* function;
+    Value* args;
+    int arg_count;
+    
+    void* stack;             /* Mapped on the first resume */
+    ucontext_t context;      /* The body, while paused */
+    ucontext_t caller;       /* Whoever resumed it last */
+    bool running;
+    bool finished;
+    Value value;             /* Last yielded, then the return value */
+    
+    /* Interpreter state of the body while it is paused */
+    Interpreter* interp;
+    Environment* current;
+    DeferEntry* defer_stack;
+    Value last_value;
+    Generator* inner;        /* Innermost generator running at the pause */
+    CallFrame* frame;        /* Innermost call at the pause */
+    CallFrame* base;         /* The body's own call, relinked on each resume */
+};
+
+/* Hands the generator to its body's entry point on the first switch */
+static __thread Generator* generator_starting = NULL;
+
+static void generator_main(void) {
+    Generator* generator = generator_starting;
+    generator->value = call_function(generator->interp, generator->function,
+                                     generator->args);
+    generator->finished = true;
+    /* Returning switches to the caller through uc_link */
+}
+
+static void* stack_map(void) {
+    void* stack = mmap(NULL, GENERATOR_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (stack == MAP_FAILED) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    
+    /* An overflow faults on the guard page instead of running into
+       whatever is mapped below */
+    mprotect(stack, (size_t)sysconf(_SC_PAGESIZE), PROT_NONE);
+    return stack;
+}
+
+Generator* generator_create(ObjFunction* fn, int arg_count, Value* args) {
+    Generator* generator = mem_alloc(sizeof(Generator));
+    generator->function = fn;
+    obj_incref((Object*)fn);
+    generator->arg_count = arg_count;
+    generator->args = NULL;
+    if (arg_count > 0) {
+        generator->args = mem_alloc(sizeof(Value) * arg_count);
+        for (int i = 0; i < arg_count; i++) {
+            generator->args[i] = args[i];
+            if (IS_OBJ(args[i])) obj_incref(AS_OBJ(args[i]));
+        }
+    }
+    
+    generator->stack = NULL;
+    generator->running = false;
+    generator->finished = false;
+    generator->value = NIL_VAL;
+    generator->interp = NULL;
+    generator->current = NULL;
+    generator->defer_stack = NULL;
+    generator->last_value = NIL_VAL;
+    generator->inner = NULL;
+    generator->frame = NULL;
+    generator->base = NULL;
+    return generator;
+}
+
+GeneratorStatus generator_resume(Interpreter* interp, Generator* generator, Value* out) {
+    if (generator->finished) return GENERATOR_DONE;
+    if (generator->running) {
+        runtime_error(interp, interp->call_line, "Generator is already running");
+        return GENERATOR_ERROR;
+    }
+    
+    if (generator->stack == NULL) {
+        generator->stack = stack_map();
+        getcontext(&generator->context);
+        generator->context.uc_stack.ss_sp = generator->stack;
+        generator->context.uc_stack.ss_size = GENERATOR_STACK_SIZE;
+        generator->context.uc_link = &generator->caller;
+        makecontext(&generator->context, generator_main, 0);
+        generator_starting = generator;
+    }
+    
+    /* Swap the caller's scope and defers for the body's */
+    Environment* current = interp->current;
+    DeferEntry* defer_stack = interp->defer_stack;
+    Value last_value = interp->last_value;
+    Generator* outer = interp->generator;
+    CallFrame* frame = interp->frame;
+    
+    /* The body's calls continue from whoever resumes it this time */
+    if (generator->base != NULL) {
+        generator->base->caller = frame;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        interp->frame = generator->frame;
+    }
+    
+    interp->current = generator->current;
+    interp->defer_stack = generator->defer_stack;
+    interp->last_value = generator->last_value;
+    interp->generator = generator->inner != NULL ? generator->inner : generator;
+    generator->interp = interp;
+    generator->running = true;
+    
+    swapcontext(&generator->caller, &generator->context);
+    
+    generator->running = false;
+    generator->current = interp->current;
+    generator->defer_stack = interp->defer_stack;
+    generator->last_value = interp->last_value;
+    generator->inner = interp->generator;
+    generator->frame = interp->frame;
+    if (generator->base == NULL && !generator->finished) {
+        /* First pause: find the body's call among the frames it pushed */
+        generator->base = generator->frame;
+        while (generator->base->caller != frame) {
+            generator->base = generator->base->caller;
+        }
+    }
+    
+    /* A finished body never needs its stack again */
+    if (generator->finished) {
+        munmap(generator->stack, GENERATOR_STACK_SIZE);
+        generator->stack = NULL;
+    }
+    
+    interp->current = current;
+    interp->defer_stack = defer_stack;
+    interp->last_value = last_value;
+    interp->generator = outer;
+    interp->frame = frame;
+    
+    if (interp->had_error) return GENERATOR_ERROR;
+    *out = generator->value;
+    return generator->finished ? GENERATOR_DONE : GENERATOR_YIELDED;
+}
+
+void generator_yield(Interpreter* interp, Value value) {
+    Generator* generator = interp->generator;
+    generator->value = value;
+    generator_suspend(generator);
+}
+
+void generator_suspend(Generator* generator) {
+    swapcontext(&generator->context, &generator->caller);
+}
+
+void generator_free(Generator* generator) {
+    if (generator->stack != NULL) {
+        munmap(generator->stack, GENERATOR_STACK_SIZE);
+    }
+    
+    /* Defers registered by a body that never finished */
+    if (!generator->finished) {
+        while (generator->defer_stack != NULL) {
+            DeferEntry* entry = generator->defer_stack;
+            generator->defer_stack = entry->next;
+            mem_free(entry, sizeof(DeferEntry));
+        }
+    }
+    
+    for (int i = 0; i < generator->arg_count; i++) {
+        if (IS_OBJ(generator->args[i])) obj_decref(AS_OBJ(generator->args[i]));
+    }
+    if (generator->args != NULL) {
+        mem_free(generator->args, sizeof(Value) * generator->arg_count);
+    }
+    obj_decref((Object*)generator->function);
+    mem_free(generator, sizeof(Generator));
+}
@@ -0,0 +1,584 @@
+/*
+ * Brisk Language - Allocation Site Profiler Implementation
+ * Every object the script thread makes while profiling is recorded in a
+ * dense registry with the site (function, line and builtin) that made it;
+ * the object keeps its registry slot in its header, so a free is a swap
+ * with the last entry. Live bytes are read off the registry when a report
+ * is printed, which also counts arrays and tables that grew since.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "heap.h"
+#include "env.h"
+
+#define HEAP_TOP 10                 /* Rows in each report table */
+
+typedef struct {
+    char* function;          /* NULL for anonymous functions */
+    int def_line;
+    int line;
+    char* native;            /* Builtin that made the object, if any */
+    uint32_t hash;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    
+    /* Filled in while a report is built */
+    uint64_t live_objects;
+    uint64_t live_bytes;
+} HeapSite;
+
+typedef struct {
+    Object* obj;
+    uint32_t site;
+} HeapEntry;
+
+Isolate* heap_isolate = NULL;
+
+static bool profiling = false;
+static bool leak_checking = false;
+static Interpreter* heap_interp = NULL;
+
+/* Frozen objects can be freed by any thread, so the registry is locked */
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static HeapEntry* entries = NULL;
+static uint32_t entry_count = 0;
+static uint32_t entry_capacity = 0;
+
+static HeapSite* sites = NULL;
+static uint32_t site_count = 0;
+static uint32_t site_capacity = 0;
+static uint32_t* site_index = NULL;     /* Open addressing: site number + 1 */
+static uint32_t index_capacity = 0;
+
+void heap_profile_configure(void) {
+    profiling = true;
+}
+
+void heap_leak_configure(void) {
+    leak_checking = true;
+}
+
+static void* checked_realloc(void* block, size_t size) {
+    block = realloc(block, size);
+    if (block == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    return block;
+}
+
+static char* copy_name(const char* name) {
+    if (name == NULL) return NULL;
+    size_t length = strlen(name);
+    char* copy = checked_realloc(NULL, length + 1);
+    memcpy(copy, name, length + 1);
+    return copy;
+}
+
+/* ============ Sites ============ */
+
+static uint32_t hash_mix(uint32_t hash, uint32_t value) {
+    return (hash ^ value) * 16777619u;
+}
+
+static uint32_t hash_name(uint32_t hash, const char* name) {
+    if (name == NULL) return hash_mix(hash, 0xFFu);
+    for (; *name != '\0'; name++) hash = hash_mix(hash, (unsigned char)*name);
+    return hash_mix(hash, 0);
+}
+
+static bool same_name(const char* a, const char* b) {
+    if (a == NULL || b == NULL) return a == b;
+    return strcmp(a, b) == 0;
+}
+
+static void index_insert(uint32_t site) {
+    uint32_t mask = index_capacity - 1;
+    uint32_t i = sites[site].hash & mask;
+    while (site_index[i] != 0) i = (i + 1) & mask;
+    site_index[i] = site + 1;
+}
+
+/* The site for the innermost Brisk frame, naming the builtin it was in
+   when one is running */
+static uint32_t current_site(void) {
+    const CallFrame* frame = heap_interp->frame;
+    const char* native = NULL;
+    while (frame->def_line == 0 && frame->caller != NULL) {
+        if (native == NULL) native = frame->name;
+        frame = frame->caller;
+    }
+    
+    uint32_t hash = hash_mix(hash_mix(2166136261u, (uint32_t)frame->def_line),
+                             (uint32_t)frame->line);
+    hash = hash_name(hash_name(hash, frame->name), native);
+    
+    if (index_capacity > 0) {
+        uint32_t mask = index_capacity - 1;
+        for (uint32_t i = hash & mask; site_index[i] != 0; i = (i + 1) & mask) {
+            HeapSite* site = &sites[site_index[i] - 1];
+            if (site->hash == hash && site->line == frame->line &&
+                site->def_line == frame->def_line &&
+                same_name(site->function, frame->name) && same_name(site->native, native)) {
+                return site_index[i] - 1;
+            }
+        }
+    }
+    
+    if (site_count == site_capacity) {
+        site_capacity = site_capacity < 8 ? 8 : site_capacity * 2;
+        sites = checked_realloc(sites, sizeof(HeapSite) * site_capacity);
+    }
+    HeapSite* site = &sites[site_count];
+    memset(site, 0, sizeof(HeapSite));
+    site->function = copy_name(frame->name);
+    site->def_line = frame->def_line;
+    site->line = frame->line;
+    site->native = copy_name(native);
+    site->hash = hash;
+    site_count++;
+    
+    /* Keep the index at most half full */
+    if (site_count * 2 > index_capacity) {
+        free(site_index);
+        index_capacity = index_capacity < 64 ? 64 : index_capacity * 2;
+        site_index = calloc(index_capacity, sizeof(uint32_t));
+        if (site_index == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        for (uint32_t s = 0; s < site_count; s++) index_insert(s);
+    } else {
+        index_insert(site_count - 1);
+    }
+    return site_count - 1;
+}
+
+/* ============ Tracking ============ */
+
+void heap_track(Object* obj, size_t size) {
+    pthread_mutex_lock(&heap_lock);
+    uint32_t site = current_site();
+    sites[site].allocations++;
+    sites[site].allocated_bytes += size;
+    
+    if (entry_count == entry_capacity) {
+        entry_capacity = entry_capacity < 1024 ? 1024 : entry_capacity * 2;
+        entries = checked_realloc(entries, sizeof(HeapEntry) * entry_capacity);
+    }
+    entries[entry_count].obj = obj;
+    entries[entry_count].site = site;
+    entry_count++;
+    __atomic_store_n(&obj->heap_slot, entry_count, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&heap_lock);
+}
+
+void heap_untrack(Object* obj) {
+    pthread_mutex_lock(&heap_lock);
+    uint32_t slot = obj->heap_slot - 1;
+    HeapEntry last = entries[--entry_count];
+    if (last.obj != obj) {
+        entries[slot] = last;
+        __atomic_store_n(&last.obj->heap_slot, slot + 1, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&obj->heap_slot, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&heap_lock);
+}
+
+void heap_profile_start(Interpreter* interp) {
+    if (!profiling && !leak_checking) return;
+    heap_interp = interp;
+    heap_isolate = &interp->isolate;
+}
+
+/* ============ Reachable View ============ */
+
+/* Objects already counted, so shared ones go to the first variable */
+typedef struct {
+    Object** slots;
+    size_t capacity;
+    size_t count;
+} ObjectSet;
+
+static bool set_add(ObjectSet* set, Object* obj) {
+    if ((set->count + 1) * 2 > set->capacity) {
+        Object** old = set->slots;
+        size_t old_capacity = set->capacity;
+        set->capacity = old_capacity < 1024 ? 1024 : old_capacity * 2;
+        set->slots = calloc(set->capacity, sizeof(Object*));
+        if (set->slots == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        set->count = 0;
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old[i] != NULL) set_add(set, old[i]);
+        }
+        free(old);
+    }
+    
+    size_t mask = set->capacity - 1;
+    size_t i = ((uintptr_t)obj >> 4) * 0x9E3779B97F4A7C15ULL & mask;
+    for (; set->slots[i] != NULL; i = (i + 1) & mask) {
+        if (set->slots[i] == obj) return false;
+    }
+    set->slots[i] = obj;
+    set->count++;
+    return true;
+}
+
+typedef struct {
+    ObjectSet seen;
+    Object** stack;
+    size_t depth;
+    size_t capacity;
+    Environment* global;     /* Closures stop here; globals are roots */
+} HeapWalk;
+
+typedef struct {
+    const char* name;
+    uint64_t bytes;
+    uint64_t objects;
+} HeapRoot;
+
+static void walk_push(HeapWalk* walk, Value value) {
+    if (!IS_OBJ(value)) return;
+    Object* obj = AS_OBJ(value);
+    if (!set_add(&walk->seen, obj)) return;
+    if (walk->depth == walk->capacity) {
+        walk->capacity = walk->capacity < 256 ? 256 : walk->capacity * 2;
+        walk->stack = checked_realloc(walk->stack, sizeof(Object*) * walk->capacity);
+    }
+    walk->stack[walk->depth++] = obj;
+}
+
+static void walk_scopes(HeapWalk* walk, Environment* env) {
+    for (; env != NULL && env != walk->global; env = env->enclosing) {
+        walk_push(walk, OBJ_VAL(env->variables));
+    }
+}
+
+/* Count everything pushed so far, and what it reaches, toward root */
+static void walk_drain(HeapWalk* walk, HeapRoot* root) {
+    while (walk->depth > 0) {
+        Object* obj = walk->stack[--walk->depth];
+        root->bytes += object_size(obj);
+        root->objects++;
+        
+        switch (obj->type) {
+            case OBJ_ARRAY: {
+                ObjArray* array = (ObjArray*)obj;
+                for (int i = 0; i < array->count; i++) walk_push(walk, array->elements[i]);
+                break;
+            }
+            case OBJ_TABLE: {
+                ObjTable* table = (ObjTable*)obj;
+                for (int i = 0; i < table->capacity; i++) {
+                    TableEntry* entry = &table->entries[i];
+                    if (entry->key == NULL) continue;
+                    walk_push(walk, OBJ_VAL(entry->key));
+                    walk_push(walk, entry->value);
+                }
+                break;
+            }
+            case OBJ_FUNCTION:
+                walk_scopes(walk, ((ObjFunction*)obj)->closure);
+                break;
+            case OBJ_THREAD:
+                walk_push(walk, ((ObjThread*)obj)->result);
+                break;
+            case OBJ_ITERATOR: {
+                ObjIterator* iterator = (ObjIterator*)obj;
+                walk_push(walk, iterator->source);
+                walk_push(walk, iterator->function);
+                walk_push(walk, iterator->current);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+/* ============ Report ============ */
+
+static void format_bytes(char* out, size_t size, uint64_t bytes) {
+    if (bytes >= 1024 * 1024 * 1024) {
+        snprintf(out, size, "%.1f GB", (double)bytes / (1024.0 * 1024.0 * 1024.0));
+    } else if (bytes >= 1024 * 1024) {
+        snprintf(out, size, "%.1f MB", (double)bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024) {
+        snprintf(out, size, "%.1f KB", (double)bytes / 1024.0);
+    } else {
+        snprintf(out, size, "%llu B", (unsigned long long)bytes);
+    }
+}
+
+/* "function:line (builtin)"; the text lasts until the next call */
+static const char* site_label(const HeapSite* site) {
+    static char label[256];
+    int length;
+    if (site->function != NULL) {
+        length = snprintf(label, sizeof(label), "%s", site->function);
+    } else {
+        length = snprintf(label, sizeof(label), "<fn@%d>", site->def_line);
+    }
+    if (site->line > 0 && length < (int)sizeof(label)) {
+        length += snprintf(label + length, sizeof(label) - length, ":%d", site->line);
+    }
+    if (site->native != NULL && length < (int)sizeof(label)) {
+        snprintf(label + length, sizeof(label) - length, " (%s)", site->native);
+    }
+    return label;
+}
+
+static int compare_sites(const void* a, const void* b) {
+    const HeapSite* x = &sites[*(const uint32_t*)a];
+    const HeapSite* y = &sites[*(const uint32_t*)b];
+    if (x->live_bytes != y->live_bytes) return x->live_bytes < y->live_bytes ? 1 : -1;
+    if (x->allocations != y->allocations) return x->allocations < y->allocations ? 1 : -1;
+    return 0;
+}
+
+static void report_sites(void) {
+    pthread_mutex_lock(&heap_lock);
+    for (uint32_t s = 0; s < site_count; s++) {
+        sites[s].live_objects = 0;
+        sites[s].live_bytes = 0;
+    }
+    uint64_t live_bytes = 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        HeapSite* site = &sites[entries[i].site];
+        size_t size = object_size(entries[i].obj);
+        site->live_objects++;
+        site->live_bytes += size;
+        live_bytes += size;
+    }
+    uint32_t live_objects = entry_count;
+    
+    uint32_t* order = checked_realloc(NULL, sizeof(uint32_t) * (site_count + 1));
+    uint64_t allocations = 0;
+    for (uint32_t s = 0; s < site_count; s++) {
+        order[s] = s;
+        allocations += sites[s].allocations;
+    }
+    qsort(order, site_count, sizeof(uint32_t), compare_sites);
+    
+    char text[32];
+    format_bytes(text, sizeof(text), live_bytes);
+    fprintf(stderr, "\nHeap profile: %u live objects, %s, from %llu allocations at %u sites\n",
+            live_objects, text, (unsigned long long)allocations, site_count);
+    fprintf(stderr, "  %10s  %10s  %12s  %s\n", "Live", "Objects", "Allocations", "Site");
+    for (uint32_t i = 0; i < site_count && i < HEAP_TOP; i++) {
+        const HeapSite* site = &sites[order[i]];
+        format_bytes(text, sizeof(text), site->live_bytes);
+        fprintf(stderr, "  %10s  %10llu  %12llu  %s\n", text,
+                (unsigned long long)site->live_objects, (unsigned long long)site->allocations,
+                site_label(site));
+    }
+    free(order);
+    pthread_mutex_unlock(&heap_lock);
+}
+
+static int compare_roots(const void* a, const void* b) {
+    const HeapRoot* x = a;
+    const HeapRoot* y = b;
+    if (x->bytes != y->bytes) return x->bytes < y->bytes ? 1 : -1;
+    return 0;
+}
+
+static void report_reachable(Interpreter* interp) {
+    HeapWalk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.global = interp->global;
+    
+    ObjTable* globals = interp->global->variables;
+    HeapRoot* roots = checked_realloc(NULL, sizeof(HeapRoot) * (globals->count + 1));
+    int root_count = 0;
+    
+    /* Locals of the calls in progress first, then each global */
+    if (interp->current != interp->global) {
+        HeapRoot* root = &roots[root_count++];
+        root->name = "<locals>";
+        root->bytes = 0;
+        root->objects = 0;
+        walk_scopes(&walk, interp->current);
+        walk_drain(&walk, root);
+    }
+    for (int i = 0; i < globals->capacity; i++) {
+        TableEntry* entry = &globals->entries[i];
+        if (entry->key == NULL || !IS_OBJ(entry->value)) continue;
+        HeapRoot* root = &roots[root_count++];
+        root->name = entry->key->chars;
+        root->bytes = 0;
+        root->objects = 0;
+        walk_push(&walk, entry->value);
+        walk_drain(&walk, root);
+    }
+    qsort(roots, root_count, sizeof(HeapRoot), compare_roots);
+    
+    fprintf(stderr, "\n  %10s  %10s  %s\n", "Reachable", "Objects", "From");
+    char text[32];
+    for (int i = 0; i < root_count && i < HEAP_TOP; i++) {
+        if (roots[i].objects == 0) break;
+        format_bytes(text, sizeof(text), roots[i].bytes);
+        fprintf(stderr, "  %10s  %10llu  %s\n", text,
+                (unsigned long long)roots[i].objects, roots[i].name);
+    }
+    
+    free(roots);
+    free(walk.seen.slots);
+    free(walk.stack);
+}
+
+void heap_report(Interpreter* interp) {
+    output_flush(&interp->out);
+    if (heap_isolate == &interp->isolate) {
+        report_sites();
+    } else {
+        fprintf(stderr, "\nHeap profile: allocation sites are tracked with --heap-profile\n");
+    }
+    report_reachable(interp);
+}
+
+/* Stop tracking; objects still alive forget their slots, so freeing them
+   later does not touch the registry */
+static void heap_forget(void) {
+    pthread_mutex_lock(&heap_lock);
+    heap_isolate = NULL;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        __atomic_store_n(&entries[i].obj->heap_slot, 0, __ATOMIC_RELAXED);
+    }
+    free(entries);
+    entries = NULL;
+    entry_count = 0;
+    entry_capacity = 0;
+    for (uint32_t s = 0; s < site_count; s++) {
+        free(sites[s].function);
+        free(sites[s].native);
+    }
+    free(sites);
+    free(site_index);
+    sites = NULL;
+    site_index = NULL;
+    site_count = 0;
+    site_capacity = 0;
+    index_capacity = 0;
+    pthread_mutex_unlock(&heap_lock);
+}
+
+void heap_profile_stop(Interpreter* interp) {
+    if (heap_isolate != &interp->isolate) return;
+    if (profiling) heap_report(interp);
+    
+    /* The leak check keeps tracking through teardown */
+    if (!leak_checking) heap_forget();
+}
+
+/* ============ Leak Check ============ */
+
+/* Short description of a leaked object. Its contents are not followed:
+   leaks are often cycles, and what they point to may be leaked too. */
+static void describe_object(char* out, size_t size, Object* obj) {
+    switch (obj->type) {
+        case OBJ_STRING: {
+            ObjString* string = (ObjString*)obj;
+            int shown = string->length < 40 ? string->length : 40;
+            snprintf(out, size, "\"%.*s%s\"", shown, string->chars,
+                     string->length > shown ? "..." : "");
+            break;
+        }
+        case OBJ_ARRAY:
+            snprintf(out, size, "array of %d", ((ObjArray*)obj)->count);
+            break;
+        case OBJ_TABLE:
+            snprintf(out, size, "table of %d", ((ObjTable*)obj)->count);
+            break;
+        case OBJ_FUNCTION: {
+            ObjFunction* function = (ObjFunction*)obj;
+            if (function->name != NULL) {
+                snprintf(out, size, "fn %s", function->name);
+            } else {
+                snprintf(out, size, "fn@%d", function->body->line);
+            }
+            break;
+        }
+        default:
+            snprintf(out, size, "%s", object_type_name(obj->type));
+            break;
+    }
+    /* One line per row */
+    for (char* c = out; *c != '\0'; c++) {
+        if (*c == '\n' || *c == '\t' || *c == '\r') *c = ' ';
+    }
+}
+
+int heap_leak_check(void) {
+    if (!leak_checking || heap_isolate == NULL) return 0;
+    
+    pthread_mutex_lock(&heap_lock);
+    uint32_t leaked = entry_count;
+    if (leaked > 0) {
+        uint64_t type_objects[OBJ_TYPE_COUNT] = {0};
+        uint64_t type_bytes[OBJ_TYPE_COUNT] = {0};
+        uint32_t* samples = checked_realloc(NULL, sizeof(uint32_t) * (site_count + 1));
+        uint64_t bytes = 0;
+        
+        for (uint32_t s = 0; s < site_count; s++) {
+            sites[s].live_objects = 0;
+            sites[s].live_bytes = 0;
+        }
+        for (uint32_t i = 0; i < entry_count; i++) {
+            Object* obj = entries[i].obj;
+            HeapSite* site = &sites[entries[i].site];
+            size_t size = object_size(obj);
+            if (site->live_objects == 0) samples[entries[i].site] = i;
+            site->live_objects++;
+            site->live_bytes += size;
+            type_objects[obj->type]++;
+            type_bytes[obj->type] += size;
+            bytes += size;
+        }
+        
+        char text[32];
+        format_bytes(text, sizeof(text), bytes);
+        fprintf(stderr, "\nLeak check: %u objects (%s) outlived the interpreter\n", leaked, text);
+        fprintf(stderr, "  %10s  %10s  %s\n", "Objects", "Bytes", "Type");
+        for (int t = 0; t < OBJ_TYPE_COUNT; t++) {
+            if (type_objects[t] == 0) continue;
+            format_bytes(text, sizeof(text), type_bytes[t]);
+            fprintf(stderr, "  %10llu  %10s  %s\n", (unsigned long long)type_objects[t],
+                    text, object_type_name((ObjectType)t));
+        }
+        
+        uint32_t* order = checked_realloc(NULL, sizeof(uint32_t) * (site_count + 1));
+        uint32_t leaking_sites = 0;
+        for (uint32_t s = 0; s < site_count; s++) {
+            if (sites[s].live_objects > 0) order[leaking_sites++] = s;
+        }
+        qsort(order, leaking_sites, sizeof(uint32_t), compare_sites);
+        
+        fprintf(stderr, "\n  %10s  %10s  %-28s  %s\n", "Objects", "Bytes", "Site", "Sample");
+        char sample[64];
+        for (uint32_t i = 0; i < leaking_sites && i < HEAP_TOP; i++) {
+            const HeapSite* site = &sites[order[i]];
+            format_bytes(text, sizeof(text), site->live_bytes);
+            describe_object(sample, sizeof(sample), entries[samples[order[i]]].obj);
+            fprintf(stderr, "  %10llu  %10s  %-28s  %s\n", (unsigned long long)site->live_objects,
+                    text, site_label(site), sample);
+        }
+        if (leaking_sites > HEAP_TOP) {
+            fprintf(stderr, "  ... and %u more sites\n", leaking_sites - HEAP_TOP);
+        }
+        free(order);
+        free(samples);
+    }
+    pthread_mutex_unlock(&heap_lock);
+    
+    heap_forget();
+    return (int)leaked;
+}
@@ -13,15 +13,29 @@
 #include "cffi.h"
 #include "cheader.h"
 #include "dynload.h"
+#include "format.h"
+#include "fileio.h"
+#include "parallel.h"
+#include "generator.h"
+#include "event.h"
+#include "iter.h"
+#include "profile.h"
+#include "stats.h"
+#include "heap.h"
+#include "ffitrace.h"
+#include "trace.h"
+#include "timer.h"
 
 /* Forward declarations */
 static Value eval_binary(Interpreter* interp, AstNode* node);
-static Value eval_unary(Interpreter* interp, AstNode* node);
 static Value eval_call(Interpreter* interp, AstNode* node);
+static Value eval_interp(Interpreter* interp, AstNode* node);
 static void exec_block(Interpreter* interp, AstNode* node);
 static void exec_if(Interpreter* interp, AstNode* node);
 static void exec_while(Interpreter* interp, AstNode* node);
 static void exec_for(Interpreter* interp, AstNode* node);
+static void import_module(Interpreter* interp, const char* import_path, int line);
+static void import_header(Interpreter* interp, const char* header_path, int line);
 static void register_builtins(Interpreter* interp);
 
 /* Runtime error */
@@ -34,13 +48,17 @@ void runtime_error(Interpreter* interp, int line, const char* format, ...) {
     vsnprintf(interp->error_message, sizeof(interp->error_message), format, args);
     va_end(args);
     
+    /* Keep program output ahead of the error */
+    output_flush(&interp->out);
     fprintf(stderr, "[line %d] Runtime Error: %s\n", line, interp->error_message);
 }
 
 /* Initialize interpreter */
 void interp_init(Interpreter* interp) {
-    interp->global = env_create(NULL);
-    interp->current = interp->global;
+    isolate_init(&interp->isolate);
+    interp->previous_isolate = isolate_enter(&interp->isolate);
+    
+    register_builtins(interp);
     interp->return_value = NIL_VAL;
     interp->last_value = NIL_VAL;
     interp->returning = false;
@@ -49,9 +67,19 @@ void interp_init(Interpreter* interp) {
     interp->had_error = false;
     interp->error_message[0] = '\0';
     interp->error_line = 0;
+    interp->call_line = 0;
+    interp->script_frame.name = "<script>";
+    interp->script_frame.def_line = 0;
+    interp->script_frame.line = 0;
+    interp->script_frame.caller = NULL;
+    interp->frame = &interp->script_frame;
     interp->defer_stack = NULL;
-    
-    register_builtins(interp);
+    interp->generator = NULL;
+    interp->fresh_generator = NULL;
+    interp->loop = NULL;
+    interp->constants = NULL;
+    interp->constant_count = 0;
+    output_init(&interp->out, stdout);
 }
 
 /* Destroy interpreter */
@@ -64,7 +92,29 @@ void interp_destroy(Interpreter* interp) {
         mem_free(entry, sizeof(DeferEntry));
     }
     
+    if (interp->loop != NULL) event_loop_free(interp->loop);
+    
+    /* Top-level functions hold the global scope they close over, so the
+       two keep each other alive; empty the scope first to break that */
+    ObjTable* globals = interp->global->variables;
+    interp->global->variables = table_create();
+    obj_decref((Object*)globals);
     env_decref(interp->global);
+    output_free(&interp->out);
+    
+    if (interp->constants != NULL) {
+        for (int i = 0; i < interp->constant_count; i++) {
+            obj_decref((Object*)interp->constants[i]);
+        }
+        mem_free(interp->constants, sizeof(ObjString*) * interp->constant_count);
+    }
+    
+    isolate_free(&interp->isolate);
+    isolate_enter(interp->previous_isolate);
+    
+#ifdef BRISK_STATS
+    stats_merge();
+#endif
 }
 
 /* Push defer */
@@ -100,11 +150,403 @@ static void pop_defers(Interpreter* interp, DeferEntry* marker) {
     }
 }
 
+/* Make frame the innermost call. The fences stop the compiler from moving
+   the link ahead of the fields, or the unlink past the frame's lifetime,
+   since a profiler signal can read the chain between any two instructions */
+static void push_frame(Interpreter* interp, CallFrame* frame, const char* name, int def_line) {
+    frame->name = name;
+    frame->def_line = def_line;
+    frame->line = def_line;
+    frame->caller = interp->frame;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    interp->frame = frame;
+}
+
+static void pop_frame(Interpreter* interp, CallFrame* frame) {
+    interp->frame = frame->caller;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+/* Look up a variable, or report it undefined */
+Value variable_get(Interpreter* interp, ObjString* name, int line) {
+    Value value;
+    if (!env_get_key(interp->current, name, &value)) {
+        runtime_error(interp, line, "Undefined variable '%.*s'",
+                     name->length, name->chars);
+        return NIL_VAL;
+    }
+    return value;
+}
+
+/* Assign to an existing, non-constant variable */
+void variable_set(Interpreter* interp, ObjString* name, Value value, int line) {
+    if (env_is_const_key(interp->current, name)) {
+        runtime_error(interp, line, "Cannot assign to constant '%.*s'",
+                     name->length, name->chars);
+        return;
+    }
+    if (!env_set_key(interp->current, name, value)) {
+        runtime_error(interp, line, "Undefined variable '%.*s'",
+                     name->length, name->chars);
+    }
+}
+
+/* Declare a variable in the current scope */
+void variable_define(Interpreter* interp, ObjString* name, Value value,
+                     bool is_const, int line) {
+    if (!env_define_key(interp->current, name, value, is_const)) {
+        runtime_error(interp, line, "Variable '%.*s' already defined",
+                     name->length, name->chars);
+    }
+}
+
+/* Apply a binary operator other than and/or */
+Value binary_op(Interpreter* interp, TokenType op, Value left, Value right, int line) {
+    /* Equality - works for all types */
+    if (op == TOKEN_EQEQ) {
+        return BOOL_VAL(value_equals(left, right));
+    }
+    if (op == TOKEN_NEQ) {
+        return BOOL_VAL(!value_equals(left, right));
+    }
+    
+    /* String concatenation */
+    if (op == TOKEN_PLUS && IS_STRING(left) && IS_STRING(right)) {
+        ObjString* result = string_concat(AS_STRING(left), AS_STRING(right));
+        return OBJ_VAL(result);
+    }
+    
+    /* String + anything = string concatenation, formatted in place */
+    if (op == TOKEN_PLUS && IS_STRING(left)) {
+        ObjString* left_str = AS_STRING(left);
+        char buffer[VALUE_TEXT_BUFFER];
+        const char* text;
+        int length = value_text(right, buffer, &text);
+        
+        ObjString* result = string_allocate(left_str->length + length);
+        memcpy(result->chars, left_str->chars, left_str->length);
+        memcpy(result->chars + left_str->length, text, length);
+        return OBJ_VAL(string_finish(result));
+    }
+    
+    /* Numeric operations */
+    if (!IS_NUMBER(left) || !IS_NUMBER(right)) {
+        runtime_error(interp, line, "Operands must be numbers");
+        return NIL_VAL;
+    }
+    
+    /* If either is float, result is float */
+    bool use_float = IS_FLOAT(left) || IS_FLOAT(right);
+    
+    if (use_float) {
+        double l = AS_NUMBER(left);
+        double r = AS_NUMBER(right);
+        
+        switch (op) {
+            case TOKEN_PLUS: return FLOAT_VAL(l + r);
+            case TOKEN_MINUS: return FLOAT_VAL(l - r);
+            case TOKEN_STAR: return FLOAT_VAL(l * r);
+            case TOKEN_SLASH:
+                if (r == 0) {
+                    runtime_error(interp, line, "Division by zero");
+                    return NIL_VAL;
+                }
+                return FLOAT_VAL(l / r);
+            case TOKEN_PERCENT:
+                if (r == 0) {
+                    runtime_error(interp, line, "Modulo by zero");
+                    return NIL_VAL;
+                }
+                return FLOAT_VAL(fmod(l, r));
+            case TOKEN_LT: return BOOL_VAL(l < r);
+            case TOKEN_GT: return BOOL_VAL(l > r);
+            case TOKEN_LTE: return BOOL_VAL(l <= r);
+            case TOKEN_GTE: return BOOL_VAL(l >= r);
+            default:
+                runtime_error(interp, line, "Unknown operator");
+                return NIL_VAL;
+        }
+    } else {
+        int64_t l = AS_INT(left);
+        int64_t r = AS_INT(right);
+        
+        switch (op) {
+            case TOKEN_PLUS: return INT_VAL(l + r);
+            case TOKEN_MINUS: return INT_VAL(l - r);
+            case TOKEN_STAR: return INT_VAL(l * r);
+            case TOKEN_SLASH:
+                if (r == 0) {
+                    runtime_error(interp, line, "Division by zero");
+                    return NIL_VAL;
+                }
+                return INT_VAL(l / r);
+            case TOKEN_PERCENT:
+                if (r == 0) {
+                    runtime_error(interp, line, "Modulo by zero");
+                    return NIL_VAL;
+                }
+                return INT_VAL(l % r);
+            case TOKEN_LT: return BOOL_VAL(l < r);
+            case TOKEN_GT: return BOOL_VAL(l > r);
+            case TOKEN_LTE: return BOOL_VAL(l <= r);
+            case TOKEN_GTE: return BOOL_VAL(l >= r);
+            default:
+                runtime_error(interp, line, "Unknown operator");
+                return NIL_VAL;
+        }
+    }
+}
+
+/* Apply a unary operator */
+Value unary_op(Interpreter* interp, TokenType op, Value operand, int line) {
+    switch (op) {
+        case TOKEN_MINUS:
+            if (IS_INT(operand)) {
+                return INT_VAL(-AS_INT(operand));
+            }
+            if (IS_FLOAT(operand)) {
+                return FLOAT_VAL(-AS_FLOAT(operand));
+            }
+            runtime_error(interp, line, "Operand must be a number");
+            return NIL_VAL;
+            
+        case TOKEN_NOT:
+        case TOKEN_BANG:
+            return BOOL_VAL(!value_is_truthy(operand));
+            
+        default:
+            runtime_error(interp, line, "Unknown unary operator");
+            return NIL_VAL;
+    }
+}
+
+/* object[index] */
+Value index_get(Interpreter* interp, Value object, Value index, int line) {
+    if (IS_ARRAY(object)) {
+        if (!IS_INT(index)) {
+            runtime_error(interp, line, "Array index must be integer");
+            return NIL_VAL;
+        }
+        int idx = (int)AS_INT(index);
+        ObjArray* arr = AS_ARRAY(object);
+        if (idx < 0 || idx >= arr->count) {
+            runtime_error(interp, line, "Array index out of bounds");
+            return NIL_VAL;
+        }
+        return arr->elements[idx];
+    }
+    else if (IS_TABLE(object)) {
+        if (!IS_STRING(index)) {
+            runtime_error(interp, line, "Table key must be string");
+            return NIL_VAL;
+        }
+        Value value;
+        if (!table_get(AS_TABLE(object), AS_STRING(index), &value)) {
+            return NIL_VAL;
+        }
+        return value;
+    }
+    else if (IS_STRING(object)) {
+        if (!IS_INT(index)) {
+            runtime_error(interp, line, "String index must be integer");
+            return NIL_VAL;
+        }
+        int idx = (int)AS_INT(index);
+        ObjString* str = AS_STRING(object);
+        if (idx < 0 || idx >= str->length) {
+            runtime_error(interp, line, "String index out of bounds");
+            return NIL_VAL;
+        }
+        return OBJ_VAL(string_create(&str->chars[idx], 1));
+    }
+    else {
+        runtime_error(interp, line, "Cannot index type %s",
+                     value_type_name(object));
+        return NIL_VAL;
+    }
+}
+
+/* object[index] = value */
+void index_set(Interpreter* interp, Value object, Value index, Value value, int line) {
+    if (IS_FROZEN(object)) {
+        runtime_error(interp, line, "Cannot modify a frozen %s",
+                     value_type_name(object));
+    }
+    else if (IS_ARRAY(object)) {
+        if (!IS_INT(index)) {
+            runtime_error(interp, line, "Array index must be integer");
+            return;
+        }
+        array_set(AS_ARRAY(object), (int)AS_INT(index), value);
+    }
+    else if (IS_TABLE(object)) {
+        if (!IS_STRING(index)) {
+            runtime_error(interp, line, "Table key must be string");
+            return;
+        }
+        table_set(AS_TABLE(object), AS_STRING(index), value, false);
+    }
+    else {
+        runtime_error(interp, line, "Cannot index type %s",
+                     value_type_name(object));
+    }
+}
+
+/* object.key */
+Value field_get(Interpreter* interp, Value object, ObjString* key, int line) {
+    if (!IS_TABLE(object)) {
+        runtime_error(interp, line, "Cannot access field on type %s",
+                     value_type_name(object));
+        return NIL_VAL;
+    }
+    Value value;
+    if (!table_get(AS_TABLE(object), key, &value)) {
+        return NIL_VAL;
+    }
+    return value;
+}
+
+/* object.key = value */
+void field_set(Interpreter* interp, Value object, ObjString* key, Value value, int line) {
+    if (IS_FROZEN(object)) {
+        runtime_error(interp, line, "Cannot modify a frozen %s",
+                     value_type_name(object));
+    }
+    else if (IS_TABLE(object)) {
+        table_set(AS_TABLE(object), key, value, false);
+    }
+    else {
+        runtime_error(interp, line, "Cannot set field on type %s",
+                     value_type_name(object));
+    }
+}
+
+/* start..end as an array, counting down if end is below start */
+Value range_array(Interpreter* interp, Value start, Value end, int line) {
+    if (!IS_INT(start) || !IS_INT(end)) {
+        runtime_error(interp, line, "Range bounds must be integers");
+        return NIL_VAL;
+    }
+    
+    int64_t s = AS_INT(start);
+    int64_t e = AS_INT(end);
+    ObjArray* arr = array_create();
+    
+    if (s <= e) {
+        for (int64_t i = s; i < e; i++) {
+            array_push(arr, INT_VAL(i));
+        }
+    } else {
+        for (int64_t i = s; i > e; i--) {
+            array_push(arr, INT_VAL(i));
+        }
+    }
+    
+    return OBJ_VAL(arr);
+}
+
+/* &operand, for C interop */
+Value address_of(Interpreter* interp, Value operand, int line) {
+    if (IS_CSTRUCT(operand)) {
+        /* Return pointer to struct data */
+        ObjCStruct* cs = AS_CSTRUCT(operand);
+        return OBJ_VAL(pointer_create(cs->data, "void*"));
+    }
+    
+    runtime_error(interp, line, "Cannot take address of this value");
+    return NIL_VAL;
+}
+
+/* Piece of an interpolated string: either borrowed chars or a range
+   of the scratch buffer (chars == NULL) */
+typedef struct {
+    const char* chars;
+    int offset;
+    int length;
+} InterpSegment;
+
+/* Build an interpolated string from its parts, values[i] standing in for
+   each expression part. Values are formatted into a scratch buffer
+   (strings are borrowed as-is), then every part is copied once into a
+   result string allocated at its final size. */
+Value interpolate(const InterpPart* parts, int count, const Value* values) {
+    InterpSegment stack_segments[16];
+    InterpSegment* segments = stack_segments;
+    char stack_scratch[256];
+    char* scratch = stack_scratch;
+    int scratch_capacity = (int)sizeof(stack_scratch);
+    int scratch_used = 0;
+    int total = 0;
+    
+    if (count > 16) {
+        segments = mem_alloc(sizeof(InterpSegment) * count);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const InterpPart* part = &parts[i];
+        InterpSegment* segment = &segments[i];
+        
+        if (part->literal != NULL) {
+            segment->chars = part->literal;
+            segment->length = part->literal_length;
+            total += segment->length;
+            continue;
+        }
+        
+        Value value = values[i];
+        if (IS_STRING(value) && part->spec.width == 0 && part->spec.precision < 0) {
+            segment->chars = AS_STRING(value)->chars;
+            segment->length = AS_STRING(value)->length;
+            total += segment->length;
+            continue;
+        }
+        
+        int length = format_value(scratch + scratch_used, scratch_capacity - scratch_used,
+                                  value, &part->spec);
+        if (length > scratch_capacity - scratch_used) {
+            int new_capacity = scratch_capacity * 2;
+            if (new_capacity < scratch_used + length) new_capacity = scratch_used + length;
+            
+            if (scratch == stack_scratch) {
+                scratch = mem_alloc(new_capacity);
+                memcpy(scratch, stack_scratch, scratch_used);
+            } else {
+                scratch = mem_realloc(scratch, scratch_capacity, new_capacity);
+            }
+            scratch_capacity = new_capacity;
+            format_value(scratch + scratch_used, scratch_capacity - scratch_used,
+                         value, &part->spec);
+        }
+        
+        segment->chars = NULL;
+        segment->offset = scratch_used;
+        segment->length = length;
+        scratch_used += length;
+        total += length;
+    }
+    
+    ObjString* string = string_allocate(total);
+    char* dest = string->chars;
+    for (int i = 0; i < count; i++) {
+        const char* chars = segments[i].chars != NULL
+            ? segments[i].chars : scratch + segments[i].offset;
+        memcpy(dest, chars, segments[i].length);
+        dest += segments[i].length;
+    }
+    
+    if (scratch != stack_scratch) mem_free(scratch, scratch_capacity);
+    if (segments != stack_segments) {
+        mem_free(segments, sizeof(InterpSegment) * count);
+    }
+    return OBJ_VAL(string_finish(string));
+}
+
 /* Evaluate expression */
 Value eval(Interpreter* interp, AstNode* node) {
     if (node == NULL || interp->had_error) {
         return NIL_VAL;
     }
+    STAT_INC(nodes[node->type]);
     
     switch (node->type) {
         case NODE_LITERAL_INT:
@@ -114,8 +556,11 @@ Value eval(Interpreter* interp, AstNode* node) {
             return FLOAT_VAL(node->as.float_literal.value);
             
         case NODE_LITERAL_STRING: {
+            /* The intern table keeps it alive, so like a variable's value
+               it is returned without a reference of its own */
             ObjString* str = string_create(node->as.string_literal.value,
                                            node->as.string_literal.length);
+            obj_decref((Object*)str);
             return OBJ_VAL(str);
         }
         
@@ -126,24 +571,21 @@ Value eval(Interpreter* interp, AstNode* node) {
             return NIL_VAL;
             
         case NODE_IDENTIFIER: {
-            Value value;
-            if (!env_get(interp->current, 
-                         node->as.identifier.name,
-                         node->as.identifier.name_length,
-                         &value)) {
-                runtime_error(interp, node->line, "Undefined variable '%.*s'",
-                             node->as.identifier.name_length,
-                             node->as.identifier.name);
-                return NIL_VAL;
-            }
+            ObjString* name = string_create(node->as.identifier.name,
+                                            node->as.identifier.name_length);
+            Value value = variable_get(interp, name, node->line);
+            obj_decref((Object*)name);
             return value;
         }
         
         case NODE_BINARY:
             return eval_binary(interp, node);
             
-        case NODE_UNARY:
-            return eval_unary(interp, node);
+        case NODE_UNARY: {
+            Value operand = eval(interp, node->as.unary.operand);
+            if (interp->had_error) return NIL_VAL;
+            return unary_op(interp, node->as.unary.operator, operand, node->line);
+        }
             
         case NODE_CALL:
             return eval_call(interp, node);
@@ -155,70 +597,18 @@ Value eval(Interpreter* interp, AstNode* node) {
             Value index = eval(interp, node->as.index.index);
             if (interp->had_error) return NIL_VAL;
             
-            if (IS_ARRAY(object)) {
-                if (!IS_INT(index)) {
-                    runtime_error(interp, node->line, "Array index must be integer");
-                    return NIL_VAL;
-                }
-                int idx = (int)AS_INT(index);
-                ObjArray* arr = AS_ARRAY(object);
-                if (idx < 0 || idx >= arr->count) {
-                    runtime_error(interp, node->line, "Array index out of bounds");
-                    return NIL_VAL;
-                }
-                return arr->elements[idx];
-            }
-            else if (IS_TABLE(object)) {
-                if (!IS_STRING(index)) {
-                    runtime_error(interp, node->line, "Table key must be string");
-                    return NIL_VAL;
-                }
-                Value value;
-                if (!table_get(AS_TABLE(object), AS_STRING(index), &value)) {
-                    return NIL_VAL;
-                }
-                return value;
-            }
-            else if (IS_STRING(object)) {
-                if (!IS_INT(index)) {
-                    runtime_error(interp, node->line, "String index must be integer");
-                    return NIL_VAL;
-                }
-                int idx = (int)AS_INT(index);
-                ObjString* str = AS_STRING(object);
-                if (idx < 0 || idx >= str->length) {
-                    runtime_error(interp, node->line, "String index out of bounds");
-                    return NIL_VAL;
-                }
-                return OBJ_VAL(string_create(&str->chars[idx], 1));
-            }
-            else {
-                runtime_error(interp, node->line, "Cannot index type %s",
-                             value_type_name(object));
-                return NIL_VAL;
-            }
+            return index_get(interp, object, index, node->line);
         }
         
         case NODE_FIELD: {
             Value object = eval(interp, node->as.field.object);
             if (interp->had_error) return NIL_VAL;
             
-            if (IS_TABLE(object)) {
-                ObjString* key = string_create(node->as.field.field_name,
-                                               node->as.field.field_name_length);
-                Value value;
-                if (!table_get(AS_TABLE(object), key, &value)) {
-                    obj_decref((Object*)key);
-                    return NIL_VAL;
-                }
-                obj_decref((Object*)key);
-                return value;
-            }
-            else {
-                runtime_error(interp, node->line, "Cannot access field on type %s",
-                             value_type_name(object));
-                return NIL_VAL;
-            }
+            ObjString* key = string_create(node->as.field.field_name,
+                                           node->as.field.field_name_length);
+            Value value = field_get(interp, object, key, node->line);
+            obj_decref((Object*)key);
+            return value;
         }
         
         case NODE_ARRAY: {
@@ -258,27 +648,7 @@ Value eval(Interpreter* interp, AstNode* node) {
             Value end = eval(interp, node->as.range.end);
             if (interp->had_error) return NIL_VAL;
             
-            if (!IS_INT(start) || !IS_INT(end)) {
-                runtime_error(interp, node->line, "Range bounds must be integers");
-                return NIL_VAL;
-            }
-            
-            /* Create array from range */
-            int64_t s = AS_INT(start);
-            int64_t e = AS_INT(end);
-            ObjArray* arr = array_create();
-            
-            if (s <= e) {
-                for (int64_t i = s; i < e; i++) {
-                    array_push(arr, INT_VAL(i));
-                }
-            } else {
-                for (int64_t i = s; i > e; i--) {
-                    array_push(arr, INT_VAL(i));
-                }
-            }
-            
-            return OBJ_VAL(arr);
+            return range_array(interp, start, end, node->line);
         }
         
         case NODE_LAMBDA: {
@@ -290,6 +660,7 @@ Value eval(Interpreter* interp, AstNode* node) {
                 node->as.lambda.body,
                 interp->current
             );
+            fn->is_generator = node->as.lambda.is_generator;
             env_incref(interp->current);
             return OBJ_VAL(fn);
         }
@@ -298,23 +669,44 @@ Value eval(Interpreter* interp, AstNode* node) {
             /* For C interop - get address of a value */
             Value operand = eval(interp, node->as.address_of.operand);
             if (interp->had_error) return NIL_VAL;
-            
-            if (IS_CSTRUCT(operand)) {
-                /* Return pointer to struct data */
-                ObjCStruct* cs = AS_CSTRUCT(operand);
-                return OBJ_VAL(pointer_create(cs->data, "void*"));
-            }
-            
-            runtime_error(interp, node->line, "Cannot take address of this value");
-            return NIL_VAL;
+            return address_of(interp, operand, node->line);
         }
         
+        case NODE_INTERP:
+            return eval_interp(interp, node);
+        
         default:
             runtime_error(interp, node->line, "Unknown expression type");
             return NIL_VAL;
     }
 }
 
+/* Evaluate interpolated string */
+static Value eval_interp(Interpreter* interp, AstNode* node) {
+    InterpString* fs = &node->as.interp_string;
+    Value stack_values[16];
+    Value* values = stack_values;
+    if (fs->part_count > 16) {
+        values = mem_alloc(sizeof(Value) * fs->part_count);
+    }
+    
+    for (int i = 0; i < fs->part_count; i++) {
+        if (fs->parts[i].literal != NULL) continue;
+        values[i] = eval(interp, fs->parts[i].expr);
+        if (interp->had_error) break;
+    }
+    
+    Value result = NIL_VAL;
+    if (!interp->had_error) {
+        result = interpolate(fs->parts, fs->part_count, values);
+    }
+    
+    if (values != stack_values) {
+        mem_free(values, sizeof(Value) * fs->part_count);
+    }
+    return result;
+}
+
 /* Evaluate binary expression */
 static Value eval_binary(Interpreter* interp, AstNode* node) {
     Value left = eval(interp, node->as.binary.left);
@@ -333,124 +725,140 @@ static Value eval_binary(Interpreter* interp, AstNode* node) {
     Value right = eval(interp, node->as.binary.right);
     if (interp->had_error) return NIL_VAL;
     
-    TokenType op = node->as.binary.operator;
+    return binary_op(interp, node->as.binary.operator, left, right, node->line);
+}
+
+/* Call a function value with already-evaluated arguments */
+Value call_value(Interpreter* interp, Value callee, int arg_count,
+                 Value* args, int line) {
+    Value result = NIL_VAL;
+    Object* fresh = NULL;
     
-    /* Equality - works for all types */
-    if (op == TOKEN_EQEQ) {
-        return BOOL_VAL(value_equals(left, right));
-    }
-    if (op == TOKEN_NEQ) {
-        return BOOL_VAL(!value_equals(left, right));
+    if (IS_NATIVE(callee)) {
+        ObjNative* native = AS_NATIVE(callee);
+        
+        /* Check arity (-1 means variadic) */
+        if (native->arity >= 0 && arg_count != native->arity) {
+            runtime_error(interp, line, "Expected %d arguments but got %d",
+                         native->arity, arg_count);
+            return NIL_VAL;
+        }
+        
+        CallFrame frame;
+        push_frame(interp, &frame, native->name, 0);
+        if (native->interp_function != NULL) {
+            int saved_line = interp->call_line;
+            interp->call_line = line;
+            result = native->interp_function(interp, native->user_data,
+                                             arg_count, args);
+            interp->call_line = saved_line;
+        } else {
+            result = native->function(arg_count, args);
+        }
+        pop_frame(interp, &frame);
     }
-    
-    /* String concatenation */
-    if (op == TOKEN_PLUS && IS_STRING(left) && IS_STRING(right)) {
-        ObjString* result = string_concat(AS_STRING(left), AS_STRING(right));
-        return OBJ_VAL(result);
+    else if (IS_CFUNCTION(callee)) {
+        ObjCFunction* cfn = AS_CFUNCTION(callee);
+        /* C code may write to stdout directly; keep it in order */
+        if (interp->out.length > 0) output_flush(&interp->out);
+        CallFrame frame;
+        push_frame(interp, &frame, cfn->desc->name, 0);
+        result = cffi_call(cfn->desc, arg_count, args);
+        pop_frame(interp, &frame);
     }
-    
-    /* String + anything = string concatenation */
-    if (op == TOKEN_PLUS && IS_STRING(left)) {
-        char* right_str = value_to_string(right);
-        ObjString* right_obj = string_create(right_str, strlen(right_str));
-        mem_free(right_str, 256);
-        ObjString* result = string_concat(AS_STRING(left), right_obj);
-        obj_decref((Object*)right_obj);
-        return OBJ_VAL(result);
+    else if (IS_FUNCTION(callee)) {
+        ObjFunction* fn = AS_FUNCTION(callee);
+        
+        /* Check arity */
+        if (arg_count != fn->arity) {
+            runtime_error(interp, line, "Expected %d arguments but got %d",
+                         fn->arity, arg_count);
+            return NIL_VAL;
+        }
+        
+        /* The scope may hold the only reference, and the body may
+           reassign the name; frames and traces still point into fn */
+        obj_incref((Object*)fn);
+        if (fn->is_generator) {
+            /* The body runs a yield at a time as the iterator is pulled */
+            Generator* generator = generator_create(fn, arg_count, args);
+            result = OBJ_VAL(iterator_generator(generator));
+            fresh = AS_OBJ(result);
+        } else {
+            result = call_function(interp, fn, args);
+        }
+        obj_decref((Object*)fn);
     }
-    
-    /* Numeric operations */
-    if (!IS_NUMBER(left) || !IS_NUMBER(right)) {
-        runtime_error(interp, node->line, "Operands must be numbers");
-        return NIL_VAL;
+    else {
+        runtime_error(interp, line, "Can only call functions");
     }
     
-    /* If either is float, result is float */
-    bool use_float = IS_FLOAT(left) || IS_FLOAT(right);
+    interp->fresh_generator = fresh;
+    return result;
+}
+
+/* Run a Brisk function's body */
+Value call_function(Interpreter* interp, ObjFunction* fn, Value* args) {
+    /* Save current environment */
+    Environment* previous = interp->current;
+    Environment* fn_env = NULL;
     
-    if (use_float) {
-        double l = AS_NUMBER(left);
-        double r = AS_NUMBER(right);
-        
-        switch (op) {
-            case TOKEN_PLUS: return FLOAT_VAL(l + r);
-            case TOKEN_MINUS: return FLOAT_VAL(l - r);
-            case TOKEN_STAR: return FLOAT_VAL(l * r);
-            case TOKEN_SLASH:
-                if (r == 0) {
-                    runtime_error(interp, node->line, "Division by zero");
-                    return NIL_VAL;
-                }
-                return FLOAT_VAL(l / r);
-            case TOKEN_PERCENT:
-                if (r == 0) {
-                    runtime_error(interp, node->line, "Modulo by zero");
-                    return NIL_VAL;
-                }
-                return FLOAT_VAL(fmod(l, r));
-            case TOKEN_LT: return BOOL_VAL(l < r);
-            case TOKEN_GT: return BOOL_VAL(l > r);
-            case TOKEN_LTE: return BOOL_VAL(l <= r);
-            case TOKEN_GTE: return BOOL_VAL(l >= r);
-            default:
-                runtime_error(interp, node->line, "Unknown operator");
-                return NIL_VAL;
-        }
+    if (fn->compiled != NULL) {
+        /* Compiled bodies keep their own parameters */
+        interp->current = fn->closure;
     } else {
-        int64_t l = AS_INT(left);
-        int64_t r = AS_INT(right);
+        /* Create new environment for function */
+        fn_env = env_create(fn->closure);
         
-        switch (op) {
-            case TOKEN_PLUS: return INT_VAL(l + r);
-            case TOKEN_MINUS: return INT_VAL(l - r);
-            case TOKEN_STAR: return INT_VAL(l * r);
-            case TOKEN_SLASH:
-                if (r == 0) {
-                    runtime_error(interp, node->line, "Division by zero");
-                    return NIL_VAL;
-                }
-                return INT_VAL(l / r);
-            case TOKEN_PERCENT:
-                if (r == 0) {
-                    runtime_error(interp, node->line, "Modulo by zero");
-                    return NIL_VAL;
-                }
-                return INT_VAL(l % r);
-            case TOKEN_LT: return BOOL_VAL(l < r);
-            case TOKEN_GT: return BOOL_VAL(l > r);
-            case TOKEN_LTE: return BOOL_VAL(l <= r);
-            case TOKEN_GTE: return BOOL_VAL(l >= r);
-            default:
-                runtime_error(interp, node->line, "Unknown operator");
-                return NIL_VAL;
+        /* Bind parameters to arguments */
+        for (int i = 0; i < fn->arity; i++) {
+            env_define(fn_env, fn->params[i], fn->param_lengths[i], args[i], false);
         }
+        interp->current = fn_env;
     }
-}
-
-/* Evaluate unary expression */
-static Value eval_unary(Interpreter* interp, AstNode* node) {
-    Value operand = eval(interp, node->as.unary.operand);
-    if (interp->had_error) return NIL_VAL;
     
-    switch (node->as.unary.operator) {
-        case TOKEN_MINUS:
-            if (IS_INT(operand)) {
-                return INT_VAL(-AS_INT(operand));
-            }
-            if (IS_FLOAT(operand)) {
-                return FLOAT_VAL(-AS_FLOAT(operand));
-            }
-            runtime_error(interp, node->line, "Operand must be a number");
-            return NIL_VAL;
-            
-        case TOKEN_NOT:
-        case TOKEN_BANG:
-            return BOOL_VAL(!value_is_truthy(operand));
-            
-        default:
-            runtime_error(interp, node->line, "Unknown unary operator");
-            return NIL_VAL;
+    /* Remember defer stack position */
+    DeferEntry* defer_marker = interp->defer_stack;
+    
+    CallFrame frame;
+    push_frame(interp, &frame, fn->name, fn->body->line);
+    uint64_t started = trace_calls ? timer_now_ns() : 0;
+    
+    /* Reset last_value for implicit return tracking */
+    interp->last_value = NIL_VAL;
+    
+    /* Execute function body */
+    if (fn->compiled != NULL) {
+        fn->compiled(interp, args);
+    } else {
+        exec(interp, fn->body);
+    }
+    
+    /* Pop defers */
+    pop_defers(interp, defer_marker);
+    if (trace_calls) trace_call(fn->name, fn->body->line, started);
+    pop_frame(interp, &frame);
+    
+    /* Restore environment */
+    interp->current = previous;
+    env_decref(fn_env);
+    
+    /* Get return value (explicit or implicit) */
+    Value result;
+    if (interp->returning) {
+        result = interp->return_value;
+        interp->returning = false;
+    } else {
+        /* Use last expression value as implicit return */
+        result = interp->last_value;
     }
+    return result;
+}
+
+/* Call a function value from native code */
+Value brisk_call(Interpreter* interp, Value callee, int arg_count, Value* args) {
+    if (interp->had_error) return NIL_VAL;
+    return call_value(interp, callee, arg_count, args, interp->call_line);
 }
 
 /* Evaluate function call */
@@ -472,76 +880,7 @@ static Value eval_call(Interpreter* interp, AstNode* node) {
         }
     }
     
-    Value result = NIL_VAL;
-    
-    if (IS_NATIVE(callee)) {
-        ObjNative* native = AS_NATIVE(callee);
-        
-        /* Check arity (-1 means variadic) */
-        if (native->arity >= 0 && arg_count != native->arity) {
-            runtime_error(interp, node->line, "Expected %d arguments but got %d",
-                         native->arity, arg_count);
-            if (args) mem_free(args, sizeof(Value) * arg_count);
-            return NIL_VAL;
-        }
-        
-        result = native->function(arg_count, args);
-    }
-    else if (IS_CFUNCTION(callee)) {
-        ObjCFunction* cfn = AS_CFUNCTION(callee);
-        result = cffi_call(cfn->desc, arg_count, args);
-    }
-    else if (IS_FUNCTION(callee)) {
-        ObjFunction* fn = AS_FUNCTION(callee);
-        
-        /* Check arity */
-        if (arg_count != fn->arity) {
-            runtime_error(interp, node->line, "Expected %d arguments but got %d",
-                         fn->arity, arg_count);
-            if (args) mem_free(args, sizeof(Value) * arg_count);
-            return NIL_VAL;
-        }
-        
-        /* Create new environment for function */
-        Environment* fn_env = env_create(fn->closure);
-        
-        /* Bind parameters to arguments */
-        for (int i = 0; i < fn->arity; i++) {
-            env_define(fn_env, fn->params[i], fn->param_lengths[i], args[i], false);
-        }
-        
-        /* Save current environment */
-        Environment* previous = interp->current;
-        interp->current = fn_env;
-        
-        /* Remember defer stack position */
-        DeferEntry* defer_marker = interp->defer_stack;
-        
-        /* Reset last_value for implicit return tracking */
-        interp->last_value = NIL_VAL;
-        
-        /* Execute function body */
-        exec(interp, fn->body);
-        
-        /* Pop defers */
-        pop_defers(interp, defer_marker);
-        
-        /* Restore environment */
-        interp->current = previous;
-        env_decref(fn_env);
-        
-        /* Get return value (explicit or implicit) */
-        if (interp->returning) {
-            result = interp->return_value;
-            interp->returning = false;
-        } else {
-            /* Use last expression value as implicit return */
-            result = interp->last_value;
-        }
-    }
-    else {
-        runtime_error(interp, node->line, "Can only call functions");
-    }
+    Value result = call_value(interp, callee, arg_count, args, node->line);
     
     if (args) mem_free(args, sizeof(Value) * arg_count);
     return result;
@@ -551,6 +890,8 @@ static Value eval_call(Interpreter* interp, AstNode* node) {
 void exec(Interpreter* interp, AstNode* node) {
     if (node == NULL || interp->had_error) return;
     if (interp->returning || interp->breaking || interp->continuing) return;
+    interp->frame->line = node->line;
+    STAT_INC(nodes[node->type]);
     
     switch (node->type) {
         case NODE_VAR_DECL:
@@ -558,15 +899,10 @@ void exec(Interpreter* interp, AstNode* node) {
             Value value = eval(interp, node->as.var_decl.initializer);
             if (interp->had_error) return;
             
-            bool is_const = node->as.var_decl.is_const;
-            if (!env_define(interp->current, 
-                           node->as.var_decl.name,
-                           node->as.var_decl.name_length,
-                           value, is_const)) {
-                runtime_error(interp, node->line, "Variable '%.*s' already defined",
-                             node->as.var_decl.name_length,
-                             node->as.var_decl.name);
-            }
+            ObjString* name = string_create(node->as.var_decl.name,
+                                            node->as.var_decl.name_length);
+            variable_define(interp, name, value, node->as.var_decl.is_const, node->line);
+            obj_decref((Object*)name);
             break;
         }
         
@@ -577,24 +913,10 @@ void exec(Interpreter* interp, AstNode* node) {
             AstNode* target = node->as.assignment.target;
             
             if (target->type == NODE_IDENTIFIER) {
-                /* Check if const */
-                if (env_is_const(interp->current,
-                                target->as.identifier.name,
-                                target->as.identifier.name_length)) {
-                    runtime_error(interp, node->line, "Cannot assign to constant '%.*s'",
-                                 target->as.identifier.name_length,
-                                 target->as.identifier.name);
-                    return;
-                }
-                
-                if (!env_set(interp->current,
-                            target->as.identifier.name,
-                            target->as.identifier.name_length,
-                            value)) {
-                    runtime_error(interp, node->line, "Undefined variable '%.*s'",
-                                 target->as.identifier.name_length,
-                                 target->as.identifier.name);
-                }
+                ObjString* name = string_create(target->as.identifier.name,
+                                                target->as.identifier.name_length);
+                variable_set(interp, name, value, node->line);
+                obj_decref((Object*)name);
             }
             else if (target->type == NODE_INDEX) {
                 Value object = eval(interp, target->as.index.object);
@@ -603,39 +925,16 @@ void exec(Interpreter* interp, AstNode* node) {
                 Value index = eval(interp, target->as.index.index);
                 if (interp->had_error) return;
                 
-                if (IS_ARRAY(object)) {
-                    if (!IS_INT(index)) {
-                        runtime_error(interp, node->line, "Array index must be integer");
-                        return;
-                    }
-                    array_set(AS_ARRAY(object), (int)AS_INT(index), value);
-                }
-                else if (IS_TABLE(object)) {
-                    if (!IS_STRING(index)) {
-                        runtime_error(interp, node->line, "Table key must be string");
-                        return;
-                    }
-                    table_set(AS_TABLE(object), AS_STRING(index), value, false);
-                }
-                else {
-                    runtime_error(interp, node->line, "Cannot index type %s",
-                                 value_type_name(object));
-                }
+                index_set(interp, object, index, value, node->line);
             }
             else if (target->type == NODE_FIELD) {
                 Value object = eval(interp, target->as.field.object);
                 if (interp->had_error) return;
                 
-                if (IS_TABLE(object)) {
-                    ObjString* key = string_create(target->as.field.field_name,
-                                                   target->as.field.field_name_length);
-                    table_set(AS_TABLE(object), key, value, false);
-                    obj_decref((Object*)key);
-                }
-                else {
-                    runtime_error(interp, node->line, "Cannot set field on type %s",
-                                 value_type_name(object));
-                }
+                ObjString* key = string_create(target->as.field.field_name,
+                                               target->as.field.field_name_length);
+                field_set(interp, object, key, value, node->line);
+                obj_decref((Object*)key);
             }
             else {
                 runtime_error(interp, node->line, "Invalid assignment target");
@@ -683,6 +982,20 @@ void exec(Interpreter* interp, AstNode* node) {
             break;
         }
         
+        case NODE_YIELD: {
+            Value value = NIL_VAL;
+            if (node->as.yield_stmt.value != NULL) {
+                value = eval(interp, node->as.yield_stmt.value);
+                if (interp->had_error) return;
+            }
+            if (interp->generator == NULL) {
+                runtime_error(interp, node->line, "Can only yield inside a generator");
+                return;
+            }
+            generator_yield(interp, value);
+            break;
+        }
+        
         case NODE_BREAK:
             interp->breaking = true;
             break;
@@ -701,12 +1014,14 @@ void exec(Interpreter* interp, AstNode* node) {
                 node->as.fn_decl.body,
                 interp->current
             );
+            fn->is_generator = node->as.fn_decl.is_generator;
             env_incref(interp->current);
             
             env_define(interp->current,
                       node->as.fn_decl.name,
                       node->as.fn_decl.name_length,
                       OBJ_VAL(fn), false);
+            obj_decref((Object*)fn);  /* The scope holds it now */
             break;
         }
         
@@ -769,203 +1084,9 @@ void exec(Interpreter* interp, AstNode* node) {
             push_defer(interp, node->as.defer_stmt.statement);
             break;
             
-        case NODE_IMPORT: {
-            /* Execute @import */
-            const char* import_path = node->as.import.path;
-            size_t path_len = strlen(import_path);
-            
-            /* Check if it's a Brisk module (.brisk file) */
-            if (path_len > 6 && strcmp(import_path + path_len - 6, ".brisk") == 0) {
-                /* Import a Brisk module */
-                char resolved_path[512];
-                
-                /* Try relative to current file first, then current directory */
-                if (import_path[0] == '/' || import_path[0] == '.') {
-                    snprintf(resolved_path, sizeof(resolved_path), "%s", import_path);
-                } else {
-                    snprintf(resolved_path, sizeof(resolved_path), "./%s", import_path);
-                }
-                
-                /* Read the module file */
-                FILE* file = fopen(resolved_path, "rb");
-                if (!file) {
-                    /* Try lib/ directory */
-                    snprintf(resolved_path, sizeof(resolved_path), "lib/%s", import_path);
-                    file = fopen(resolved_path, "rb");
-                }
-                
-                if (!file) {
-                    runtime_error(interp, node->line, "Cannot find module '%s'", import_path);
-                    break;
-                }
-                
-                fseek(file, 0, SEEK_END);
-                long size = ftell(file);
-                rewind(file);
-                
-                char* source = mem_alloc(size + 1);
-                size_t read_size = fread(source, 1, size, file);
-                source[read_size] = '\0';
-                fclose(file);
-                
-                /* Parse the module */
-                Lexer lexer;
-                lexer_init(&lexer, source);
-                
-                Parser parser;
-                parser_init(&parser, &lexer);
-                
-                AstNode* module_ast = parse_program(&parser);
-                
-                if (parser.had_error || !module_ast) {
-                    runtime_error(interp, node->line, "Failed to parse module '%s'", import_path);
-                    mem_free(source, size + 1);
-                    break;
-                }
-                
-                /* Execute the module in the current global environment */
-                /* This makes all top-level definitions available */
-                exec(interp, module_ast);
-                
-                /* Note: We do NOT free module_ast or source here because
-                   ObjFunction stores pointers to the AST nodes.
-                   TODO: Implement proper module caching to manage this memory */
-                break;
-            }
-            
-            /* Otherwise, it's a C header */
-            const char* header_path = import_path;
-            
-            /* Find the header file */
-            char* full_path = cheader_find_include(header_path, true);
-            if (!full_path) {
-                runtime_error(interp, node->line, "Cannot find header '%s'", header_path);
-                break;
-            }
-            
-            /* Parse the header */
-            CHeaderParser hparser;
-            cheader_init(&hparser);
-            
-            if (!cheader_load(&hparser, full_path)) {
-                runtime_error(interp, node->line, "Failed to parse header '%s'", header_path);
-                mem_free(full_path, strlen(full_path) + 1);
-                cheader_free(&hparser);
-                break;
-            }
-            
-            /* Get library handle - automatic discovery based on header path */
-            LibHandle lib = lib_open(NULL);
-            
-            /* Extract directory and base name from header path */
-            char header_dir[512] = {0};
-            char header_base[256] = {0};
-            
-            /* Find last slash to get directory */
-            const char* last_slash = strrchr(full_path, '/');
-            if (last_slash) {
-                int dir_len = last_slash - full_path;
-                strncpy(header_dir, full_path, dir_len);
-                header_dir[dir_len] = '\0';
-                strncpy(header_base, last_slash + 1, sizeof(header_base) - 1);
-            } else {
-                strcpy(header_dir, ".");
-                strncpy(header_base, full_path, sizeof(header_base) - 1);
-            }
-            
-            /* Remove .h extension to get library name */
-            char lib_name[256] = {0};
-            strncpy(lib_name, header_base, sizeof(lib_name) - 1);
-            char* dot = strrchr(lib_name, '.');
-            if (dot) *dot = '\0';
-            
-            /* Try to find library in same directory as header */
-            char lib_path[768];
-            
-            /* Try: header_dir/lib<name>.so */
-            snprintf(lib_path, sizeof(lib_path), "%s/lib%s.so", header_dir, lib_name);
-            LibHandle found_lib = lib_open(lib_path);
-            
-            /* Try: header_dir/<name>.so */
-            if (!found_lib) {
-                snprintf(lib_path, sizeof(lib_path), "%s/%s.so", header_dir, lib_name);
-                found_lib = lib_open(lib_path);
-            }
-            
-            /* Try system library: lib<name> */
-            if (!found_lib) {
-                found_lib = lib_open(lib_name);
-            }
-            
-            /* Special case for standard headers */
-            if (!found_lib && strstr(header_path, "math.h")) {
-                found_lib = lib_open("m");
-            }
-            
-            if (found_lib) {
-                lib = found_lib;
-            }
-            
-            /* Register declarations */
-            cheader_register(&hparser, interp->global, lib);
-            
-            /* For math.h, many functions are defined via macros (__MATHCALL).
-               Register common math functions directly if not already present */
-            if (strstr(header_path, "math.h")) {
-                static const char* math_funcs_1[] = {
-                    "sin", "cos", "tan", "asin", "acos", "atan",
-                    "sinh", "cosh", "tanh", "asinh", "acosh", "atanh",
-                    "exp", "exp2", "log", "log10", "log2",
-                    "sqrt", "cbrt", "fabs", "floor", "ceil", "round", "trunc",
-                    NULL
-                };
-                static const char* math_funcs_2[] = {
-                    "atan2", "pow", "fmod", "hypot", "remainder", "copysign",
-                    "fmin", "fmax", "fdim",
-                    NULL
-                };
-                
-                CType param1[1] = {CTYPE_DOUBLE};
-                CType param2[2] = {CTYPE_DOUBLE, CTYPE_DOUBLE};
-                
-                for (int i = 0; math_funcs_1[i]; i++) {
-                    /* Skip if already defined */
-                    Value existing;
-                    if (env_get(interp->global, math_funcs_1[i], strlen(math_funcs_1[i]), &existing))
-                        continue;
-                        
-                    void* fn_ptr = lib_symbol(lib, math_funcs_1[i]);
-                    if (fn_ptr) {
-                        CFunctionDesc* desc = cfunc_create(math_funcs_1[i], CTYPE_DOUBLE, param1, 1, false, fn_ptr);
-                        if (desc && cfunc_prepare(desc)) {
-                            ObjCFunction* cfn = cfunction_create(desc);
-                            env_define(interp->global, math_funcs_1[i], strlen(math_funcs_1[i]),
-                                       OBJ_VAL((Object*)cfn), false);
-                        }
-                    }
-                }
-                
-                for (int i = 0; math_funcs_2[i]; i++) {
-                    Value existing;
-                    if (env_get(interp->global, math_funcs_2[i], strlen(math_funcs_2[i]), &existing))
-                        continue;
-                        
-                    void* fn_ptr = lib_symbol(lib, math_funcs_2[i]);
-                    if (fn_ptr) {
-                        CFunctionDesc* desc = cfunc_create(math_funcs_2[i], CTYPE_DOUBLE, param2, 2, false, fn_ptr);
-                        if (desc && cfunc_prepare(desc)) {
-                            ObjCFunction* cfn = cfunction_create(desc);
-                            env_define(interp->global, math_funcs_2[i], strlen(math_funcs_2[i]),
-                                       OBJ_VAL((Object*)cfn), false);
-                        }
-                    }
-                }
-            }
-            
-            cheader_free(&hparser);
-            mem_free(full_path, strlen(full_path) + 1);
+        case NODE_IMPORT:
+            interp_import(interp, node->as.import.path, node->line);
             break;
-        }
             
         case NODE_C_BLOCK:
             /* TODO: Implement @c blocks */
@@ -978,6 +1099,221 @@ void exec(Interpreter* interp, AstNode* node) {
     }
 }
 
+/* Execute @import of a Brisk module or a C header */
+void interp_import(Interpreter* interp, const char* import_path, int line) {
+    size_t path_len = strlen(import_path);
+    uint64_t started = trace_clock();
+    
+    /* Check if it's a Brisk module (.brisk file) */
+    if (path_len > 6 && strcmp(import_path + path_len - 6, ".brisk") == 0) {
+        import_module(interp, import_path, line);
+        trace_span("module", import_path, started);
+    } else {
+        import_header(interp, import_path, line);
+        trace_span("header", import_path, started);
+    }
+}
+
+/* Import a Brisk module */
+static void import_module(Interpreter* interp, const char* import_path, int line) {
+    char resolved_path[512];
+    
+    /* Try relative to current file first, then current directory */
+    if (import_path[0] == '/' || import_path[0] == '.') {
+        snprintf(resolved_path, sizeof(resolved_path), "%s", import_path);
+    } else {
+        snprintf(resolved_path, sizeof(resolved_path), "./%s", import_path);
+    }
+    
+    /* Read the module file */
+    FILE* file = fopen(resolved_path, "rb");
+    if (!file) {
+        /* Try lib/ directory */
+        snprintf(resolved_path, sizeof(resolved_path), "lib/%s", import_path);
+        file = fopen(resolved_path, "rb");
+    }
+    
+    if (!file) {
+        runtime_error(interp, line, "Cannot find module '%s'", import_path);
+        return;
+    }
+    
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    
+    char* source = mem_alloc(size + 1);
+    size_t read_size = fread(source, 1, size, file);
+    source[read_size] = '\0';
+    fclose(file);
+    
+    /* Parse the module */
+    uint64_t started = trace_clock();
+    Lexer lexer;
+    lexer_init(&lexer, source);
+    
+    Parser parser;
+    parser_init(&parser, &lexer);
+    
+    AstNode* module_ast = parse_program(&parser);
+    trace_span("module", "parse", started);
+    
+    if (parser.had_error || !module_ast) {
+        runtime_error(interp, line, "Failed to parse module '%s'", import_path);
+        mem_free(source, size + 1);
+        return;
+    }
+    
+    /* Execute the module in the current global environment */
+    /* This makes all top-level definitions available */
+    started = trace_clock();
+    exec(interp, module_ast);
+    trace_span("module", "execute", started);
+    
+    /* Note: We do NOT free module_ast or source here because
+       ObjFunction stores pointers to the AST nodes.
+       TODO: Implement proper module caching to manage this memory */
+}
+
+/* Import a C header and bind its functions from the matching library */
+static void import_header(Interpreter* interp, const char* header_path, int line) {
+    /* Find the header file */
+    char* full_path = cheader_find_include(header_path, true);
+    if (!full_path) {
+        runtime_error(interp, line, "Cannot find header '%s'", header_path);
+        return;
+    }
+    
+    /* Parse the header */
+    uint64_t started = trace_clock();
+    CHeaderParser hparser;
+    cheader_init(&hparser);
+    bool loaded = cheader_load(&hparser, full_path);
+    trace_span("header", "cheader_load", started);
+    
+    if (!loaded) {
+        runtime_error(interp, line, "Failed to parse header '%s'", header_path);
+        mem_free(full_path, strlen(full_path) + 1);
+        cheader_free(&hparser);
+        return;
+    }
+    
+    /* Get library handle - automatic discovery based on header path */
+    started = trace_clock();
+    LibHandle lib = lib_open(NULL);
+    
+    /* Extract directory and base name from header path */
+    char header_dir[512] = {0};
+    char header_base[256] = {0};
+    
+    /* Find last slash to get directory */
+    const char* last_slash = strrchr(full_path, '/');
+    if (last_slash) {
+        int dir_len = last_slash - full_path;
+        strncpy(header_dir, full_path, dir_len);
+        header_dir[dir_len] = '\0';
+        strncpy(header_base, last_slash + 1, sizeof(header_base) - 1);
+    } else {
+        strcpy(header_dir, ".");
+        strncpy(header_base, full_path, sizeof(header_base) - 1);
+    }
+    
+    /* Remove .h extension to get library name */
+    char lib_name[256] = {0};
+    strncpy(lib_name, header_base, sizeof(lib_name) - 1);
+    char* dot = strrchr(lib_name, '.');
+    if (dot) *dot = '\0';
+    
+    /* Try to find library in same directory as header */
+    char lib_path[768];
+    
+    /* Try: header_dir/lib<name>.so */
+    snprintf(lib_path, sizeof(lib_path), "%s/lib%s.so", header_dir, lib_name);
+    LibHandle found_lib = lib_open(lib_path);
+    
+    /* Try: header_dir/<name>.so */
+    if (!found_lib) {
+        snprintf(lib_path, sizeof(lib_path), "%s/%s.so", header_dir, lib_name);
+        found_lib = lib_open(lib_path);
+    }
+    
+    /* Try system library: lib<name> */
+    if (!found_lib) {
+        found_lib = lib_open(lib_name);
+    }
+    
+    /* Special case for standard headers */
+    if (!found_lib && strstr(header_path, "math.h")) {
+        found_lib = lib_open("m");
+    }
+    
+    if (found_lib) {
+        lib = found_lib;
+    }
+    trace_span("header", "dlopen", started);
+    
+    /* Register declarations */
+    started = trace_clock();
+    cheader_register(&hparser, interp->global, lib);
+    trace_span("header", "cheader_register", started);
+    
+    /* For math.h, many functions are defined via macros (__MATHCALL).
+       Register common math functions directly if not already present */
+    if (strstr(header_path, "math.h")) {
+        static const char* math_funcs_1[] = {
+            "sin", "cos", "tan", "asin", "acos", "atan",
+            "sinh", "cosh", "tanh", "asinh", "acosh", "atanh",
+            "exp", "exp2", "log", "log10", "log2",
+            "sqrt", "cbrt", "fabs", "floor", "ceil", "round", "trunc",
+            NULL
+        };
+        static const char* math_funcs_2[] = {
+            "atan2", "pow", "fmod", "hypot", "remainder", "copysign",
+            "fmin", "fmax", "fdim",
+            NULL
+        };
+        
+        CType param1[1] = {CTYPE_DOUBLE};
+        CType param2[2] = {CTYPE_DOUBLE, CTYPE_DOUBLE};
+        
+        for (int i = 0; math_funcs_1[i]; i++) {
+            /* Skip if already defined */
+            Value existing;
+            if (env_get(interp->global, math_funcs_1[i], strlen(math_funcs_1[i]), &existing))
+                continue;
+                
+            void* fn_ptr = lib_symbol(lib, math_funcs_1[i]);
+            if (fn_ptr) {
+                CFunctionDesc* desc = cfunc_create(math_funcs_1[i], CTYPE_DOUBLE, param1, 1, false, fn_ptr);
+                if (desc && cfunc_prepare(desc)) {
+                    ObjCFunction* cfn = cfunction_create(desc);
+                    env_define(interp->global, math_funcs_1[i], strlen(math_funcs_1[i]),
+                               OBJ_VAL((Object*)cfn), false);
+                }
+            }
+        }
+        
+        for (int i = 0; math_funcs_2[i]; i++) {
+            Value existing;
+            if (env_get(interp->global, math_funcs_2[i], strlen(math_funcs_2[i]), &existing))
+                continue;
+                
+            void* fn_ptr = lib_symbol(lib, math_funcs_2[i]);
+            if (fn_ptr) {
+                CFunctionDesc* desc = cfunc_create(math_funcs_2[i], CTYPE_DOUBLE, param2, 2, false, fn_ptr);
+                if (desc && cfunc_prepare(desc)) {
+                    ObjCFunction* cfn = cfunction_create(desc);
+                    env_define(interp->global, math_funcs_2[i], strlen(math_funcs_2[i]),
+                               OBJ_VAL((Object*)cfn), false);
+                }
+            }
+        }
+    }
+    
+    cheader_free(&hparser);
+    mem_free(full_path, strlen(full_path) + 1);
+}
+
 /* Execute block */
 static void exec_block(Interpreter* interp, AstNode* node) {
     Environment* previous = interp->current;
@@ -1033,12 +1369,83 @@ static void exec_while(Interpreter* interp, AstNode* node) {
 }
 
 /* Execute for loop */
+/* Any other iterable is pulled one value at a time; the iterator keeps
+   each value alive only until the next, so for line in lines(path) frees
+   every line the body does not keep */
+static void exec_for_iterator(Interpreter* interp, AstNode* node, ObjIterator* iterator) {
+    Environment* previous = interp->current;
+    interp->current = env_create(previous);
+    
+    env_define(interp->current,
+               node->as.for_stmt.iterator_name,
+               node->as.for_stmt.iterator_name_length,
+               NIL_VAL, false);
+    
+    Value value;
+    while (iterator_next(interp, iterator, &value)) {
+        env_set(interp->current,
+                node->as.for_stmt.iterator_name,
+                node->as.for_stmt.iterator_name_length,
+                value);
+        
+        exec(interp, node->as.for_stmt.body);
+        
+        if (interp->returning) break;
+        if (interp->breaking) {
+            interp->breaking = false;
+            break;
+        }
+        if (interp->continuing) {
+            interp->continuing = false;
+        }
+    }
+    
+    env_decref(interp->current);
+    interp->current = previous;
+}
+
 static void exec_for(Interpreter* interp, AstNode* node) {
-    Value iterable = eval(interp, node->as.for_stmt.iterable);
+    AstNode* iterable_node = node->as.for_stmt.iterable;
+    
+    /* for i in a..b counts without building the array */
+    if (iterable_node->type == NODE_RANGE) {
+        Value start = eval(interp, iterable_node->as.range.start);
+        if (interp->had_error) return;
+        Value end = eval(interp, iterable_node->as.range.end);
+        if (interp->had_error) return;
+        
+        if (!IS_INT(start) || !IS_INT(end)) {
+            runtime_error(interp, iterable_node->line, "Range bounds must be integers");
+            return;
+        }
+        
+        ObjIterator* range = iterator_range(AS_INT(start), AS_INT(end),
+                                            AS_INT(start) <= AS_INT(end) ? 1 : -1);
+        exec_for_iterator(interp, node, range);
+        obj_decref((Object*)range);
+        return;
+    }
+    
+    Value iterable = eval(interp, iterable_node);
     if (interp->had_error) return;
     
+    /* A generator made by the loop's own call belongs to the loop alone;
+       releasing its creation reference too frees its stack even when the
+       loop breaks out early */
+    bool owned = iterable_node->type == NODE_CALL && IS_OBJ(iterable) &&
+                 AS_OBJ(iterable) == interp->fresh_generator;
+    interp->fresh_generator = NULL;
+    
     if (!IS_ARRAY(iterable)) {
-        runtime_error(interp, node->line, "Can only iterate over arrays");
+        ObjIterator* iterator = iterator_of(iterable);
+        if (iterator == NULL) {
+            runtime_error(interp, node->line, "Cannot iterate over %s",
+                          value_type_name(iterable));
+            return;
+        }
+        exec_for_iterator(interp, node, iterator);
+        obj_decref((Object*)iterator);
+        if (owned) obj_decref((Object*)iterator);
         return;
     }
     
@@ -1090,31 +1497,77 @@ void exec_program(Interpreter* interp, AstNode* program) {
 #include "builtins.h"
 
 static void register_builtins(Interpreter* interp) {
-    register_all_builtins(interp->global);
+    /* Builtins get their own scope enclosing the globals, so a script's
+       own fn add() or sum := 0 shadows a builtin instead of clashing */
+    Environment* builtins = env_create(NULL);
+    register_all_builtins(builtins);
+    
+    interp->global = env_create(builtins);
+    interp->current = interp->global;
+    env_decref(builtins);  /* Kept alive by the global scope */
 }
 
 /* Main entry point */
-int interpret(const char* source) {
-    AstNode* ast = parse(source);
-    if (ast == NULL) {
-        return 1;  /* Parse error */
-    }
-    
+/* Run a parsed program, or a compiled one if ast is NULL */
+static int run_program(AstNode* ast, CompiledBody compiled) {
+    uint64_t started = trace_clock();
     Interpreter interp;
     interp_init(&interp);
+    trace_span("phase", "init", started);
     
-    exec_program(&interp, ast);
-    
-    int result = interp.had_error ? 1 : 0;
+    int result = 1;
+    heap_profile_start(&interp);
+    if (profile_start(&interp)) {
+        started = trace_clock();
+        if (compiled != NULL) {
+            compiled(&interp, NULL);
+        } else {
+            exec_program(&interp, ast);
+        }
+        trace_span("phase", "execute", started);
+        profile_stop(&interp);
+        result = interp.had_error ? 1 : 0;
+    }
+    heap_profile_stop(&interp);
+    ffi_trace_finish();
     
+    started = trace_clock();
     interp_destroy(&interp);
-    ast_free_tree(ast);
+    if (heap_leak_check() > 0) result = 1;
+    
+#ifdef BRISK_STATS
+    stats_report();
+#endif
+    
+    /* Threads never joined may still be running the program's functions;
+       the process is about to exit, so leave the tree to them */
+    if (ast != NULL && !thread_any_running()) {
+        ast_free_tree(ast);
+    }
+    trace_span("phase", "teardown", started);
     
     return result;
 }
 
+int interpret(const char* source) {
+    /* The lexer runs on demand as the parser asks for tokens */
+    uint64_t started = trace_clock();
+    AstNode* ast = parse(source);
+    trace_span("phase", "parse", started);
+    if (ast == NULL) {
+        return 1;  /* Parse error */
+    }
+    return run_program(ast, NULL);
+}
+
+/* Run a program compiled by --emit-c */
+int interpret_compiled(CompiledBody program) {
+    return run_program(NULL, program);
+}
+
 /* Run from file */
 int interpret_file(const char* path) {
+    uint64_t started = trace_clock();
     FILE* file = fopen(path, "rb");
     if (file == NULL) {
         fprintf(stderr, "Error: Could not open file '%s'\n", path);
@@ -1135,6 +1588,7 @@ int interpret_file(const char* path) {
     size_t bytes_read = fread(source, 1, file_size, file);
     source[bytes_read] = '\0';
     fclose(file);
+    trace_span("phase", "read", started);
     
     int result = interpret(source);
     free(source);
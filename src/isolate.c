@@ -0,0 +1,33 @@
+/*
+ * Brisk Language - Isolates Implementation
+ */
+
+#include <string.h>
+#include "isolate.h"
+#include "fileio.h"
+
+__thread Isolate* isolate_active = NULL;
+__thread Isolate isolate_thread;
+
+void isolate_init(Isolate* isolate) {
+    memset(isolate, 0, sizeof(Isolate));
+    isolate->last_error.type = ERR_NONE;
+}
+
+void isolate_free(Isolate* isolate) {
+    while (isolate->open_files != NULL) {
+        file_close(isolate->open_files);
+    }
+    
+    if (isolate->string_table != NULL) {
+        ObjTable* table = isolate->string_table;
+        isolate->string_table = NULL;
+        obj_decref((Object*)table);
+    }
+}
+
+Isolate* isolate_enter(Isolate* isolate) {
+    Isolate* previous = isolate_active;
+    isolate_active = isolate;
+    return previous;
+}
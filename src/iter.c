@@ -0,0 +1,232 @@
+/*
+ * Brisk Language - Iterators Implementation
+ * Every iterable is walked through one next operation, so for loops and
+ * pipelines like map(filter(lines(path), f), g) pull a value at a time
+ * instead of building an array per stage.
+ */
+
+#include "iter.h"
+#include "generator.h"
+#include "fileio.h"
+#include "memory.h"
+
+static ObjIterator* iterator_create(IteratorKind kind, Value source) {
+    ObjIterator* iterator = (ObjIterator*)allocate_object(sizeof(ObjIterator), OBJ_ITERATOR);
+    iterator->kind = kind;
+    iterator->done = false;
+    iterator->source = source;
+    if (IS_OBJ(source)) obj_incref(AS_OBJ(source));
+    iterator->function = NIL_VAL;
+    iterator->current = NIL_VAL;
+    iterator->position = 0;
+    iterator->end = 0;
+    iterator->step = 1;
+    iterator->generator = NULL;
+    return iterator;
+}
+
+static ObjIterator* iterator_stage(IteratorKind kind, ObjIterator* source, Value fn) {
+    ObjIterator* iterator = iterator_create(kind, OBJ_VAL(source));
+    iterator->function = fn;
+    if (IS_OBJ(fn)) obj_incref(AS_OBJ(fn));
+    return iterator;
+}
+
+ObjIterator* iterator_range(int64_t start, int64_t end, int64_t step) {
+    ObjIterator* iterator = iterator_create(ITER_RANGE, NIL_VAL);
+    iterator->position = start;
+    iterator->end = end;
+    iterator->step = step;
+    return iterator;
+}
+
+ObjIterator* iterator_generator(struct Generator* generator) {
+    ObjIterator* iterator = iterator_create(ITER_GENERATOR, NIL_VAL);
+    iterator->generator = generator;
+    return iterator;
+}
+
+ObjIterator* iterator_map(ObjIterator* source, Value fn) {
+    return iterator_stage(ITER_MAP, source, fn);
+}
+
+ObjIterator* iterator_filter(ObjIterator* source, Value fn) {
+    return iterator_stage(ITER_FILTER, source, fn);
+}
+
+ObjIterator* iterator_take(ObjIterator* source, int64_t count) {
+    ObjIterator* iterator = iterator_stage(ITER_TAKE, source, NIL_VAL);
+    iterator->end = count;
+    return iterator;
+}
+
+ObjIterator* iterator_of(Value value) {
+    if (!IS_OBJ(value)) return NULL;
+    
+    switch (OBJ_TYPE(value)) {
+        case OBJ_ITERATOR:
+            obj_incref(AS_OBJ(value));
+            return AS_ITERATOR(value);
+        case OBJ_ARRAY:
+            return iterator_create(ITER_ARRAY, value);
+        case OBJ_STRING:
+            return iterator_create(ITER_STRING, value);
+        case OBJ_FILE:
+            /* Writers from open_writer() have nothing to read */
+            if (AS_FILE(value)->out != NULL) return NULL;
+            return iterator_create(ITER_LINES, value);
+        case OBJ_TABLE: {
+            ObjString* key = string_create("next", 4);
+            Value next;
+            bool found = table_get(AS_TABLE(value), key, &next);
+            obj_decref((Object*)key);
+            
+            if (found && (IS_FUNCTION(next) || IS_NATIVE(next) || IS_CFUNCTION(next))) {
+                ObjIterator* iterator = iterator_create(ITER_OBJECT, value);
+                iterator->function = next;
+                obj_incref(AS_OBJ(next));
+                return iterator;
+            }
+            return iterator_create(ITER_TABLE, value);
+        }
+        default:
+            return NULL;
+    }
+}
+
+/* ============ Stepping ============ */
+
+/* Make value the iterator's current one. A fresh value arrives with a
+   reference the iterator takes over; any other is borrowed, so take one. */
+static bool produce(ObjIterator* iterator, Value value, bool fresh, Value* out) {
+    if (!fresh && IS_OBJ(value)) obj_incref(AS_OBJ(value));
+    if (IS_OBJ(iterator->current)) obj_decref(AS_OBJ(iterator->current));
+    iterator->current = value;
+    *out = value;
+    return true;
+}
+
+static bool finish(ObjIterator* iterator) {
+    iterator->done = true;
+    if (IS_OBJ(iterator->current)) obj_decref(AS_OBJ(iterator->current));
+    iterator->current = NIL_VAL;
+    return false;
+}
+
+static bool next_generator(Interpreter* interp, ObjIterator* iterator, Value* out) {
+    /* The body may drop the last reference to its own iterator */
+    obj_incref((Object*)iterator);
+    
+    Value value;
+    bool produced = generator_resume(interp, iterator->generator, &value) == GENERATOR_YIELDED;
+    if (produced) {
+        produce(iterator, value, false, out);
+    } else {
+        finish(iterator);
+    }
+    
+    obj_decref((Object*)iterator);
+    return produced;
+}
+
+bool iterator_next(Interpreter* interp, ObjIterator* iterator, Value* out) {
+    if (iterator->done || interp->had_error) return false;
+    
+    switch (iterator->kind) {
+        case ITER_RANGE: {
+            int64_t position = iterator->position;
+            if (iterator->step > 0 ? position >= iterator->end : position <= iterator->end) {
+                return finish(iterator);
+            }
+            iterator->position += iterator->step;
+            return produce(iterator, INT_VAL(position), true, out);
+        }
+        
+        case ITER_ARRAY: {
+            /* Re-check count each step: the loop body may change the array */
+            ObjArray* array = AS_ARRAY(iterator->source);
+            if (iterator->position >= array->count) return finish(iterator);
+            return produce(iterator, array->elements[iterator->position++], false, out);
+        }
+        
+        case ITER_STRING: {
+            ObjString* string = AS_STRING(iterator->source);
+            if (iterator->position >= string->length) return finish(iterator);
+            ObjString* character = string_create(&string->chars[iterator->position++], 1);
+            return produce(iterator, OBJ_VAL(character), true, out);
+        }
+        
+        case ITER_TABLE: {
+            ObjTable* table = AS_TABLE(iterator->source);
+            while (iterator->position < table->capacity) {
+                TableEntry* entry = &table->entries[iterator->position++];
+                if (entry->key == NULL) continue;
+                
+                ObjArray* pair = array_create();
+                array_push(pair, OBJ_VAL(entry->key));
+                array_push(pair, entry->value);
+                return produce(iterator, OBJ_VAL(pair), true, out);
+            }
+            return finish(iterator);
+        }
+        
+        case ITER_LINES: {
+            /* Each line is freed once the next one replaces it, unless kept */
+            ObjFile* file = AS_FILE(iterator->source);
+            ObjString* line = file_read_line(file);
+            if (line == NULL) {
+                file_close(file);
+                return finish(iterator);
+            }
+            return produce(iterator, OBJ_VAL(line), true, out);
+        }
+        
+        case ITER_GENERATOR:
+            return next_generator(interp, iterator, out);
+        
+        case ITER_OBJECT: {
+            Value value = brisk_call(interp, iterator->function, 0, NULL);
+            if (interp->had_error || IS_NIL(value)) return finish(iterator);
+            return produce(iterator, value, false, out);
+        }
+        
+        case ITER_MAP: {
+            Value value;
+            if (!iterator_next(interp, AS_ITERATOR(iterator->source), &value)) {
+                return finish(iterator);
+            }
+            Value mapped = brisk_call(interp, iterator->function, 1, &value);
+            if (interp->had_error) return finish(iterator);
+            return produce(iterator, mapped, false, out);
+        }
+        
+        case ITER_FILTER: {
+            Value value;
+            while (iterator_next(interp, AS_ITERATOR(iterator->source), &value)) {
+                Value keep = brisk_call(interp, iterator->function, 1, &value);
+                if (interp->had_error) break;
+                if (value_is_truthy(keep)) return produce(iterator, value, false, out);
+            }
+            return finish(iterator);
+        }
+        
+        case ITER_TAKE: {
+            Value value;
+            if (iterator->position >= iterator->end ||
+                !iterator_next(interp, AS_ITERATOR(iterator->source), &value)) {
+                return finish(iterator);
+            }
+            iterator->position++;
+            return produce(iterator, value, false, out);
+        }
+    }
+    
+    return finish(iterator);
+}
+
+void iterator_free(ObjIterator* iterator) {
+    if (iterator->generator != NULL) generator_free(iterator->generator);
+    if (IS_OBJ(iterator->current)) obj_decref(AS_OBJ(iterator->current));
+    if (IS_OBJ(iterator->function)) obj_decref(AS_OBJ(iterator->function));
+    if (IS_OBJ(iterator->source)) obj_decref(AS_OBJ(iterator->source));
+}
@@ -0,0 +1,736 @@
+/*
+ * Brisk Language - JSON Implementation
+ * Single-pass recursive descent parser and a one-buffer serializer. Both
+ * find the end of plain string runs 16/32 bytes at a time where SIMD is
+ * available, since string bodies are most of a typical document.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "json.h"
+#include "numconv.h"
+#include "memory.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* ============ String Scanning ============ */
+
+/* Bytes that end a plain run inside a JSON string: the closing quote,
+   a backslash, or an unescaped control character */
+static bool is_string_special(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+#if defined(__AVX2__)
+
+static const char* scan_string(const char* p, const char* end) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)p);
+        /* Unsigned c <= 0x1F is max(c, 0x1F) == 0x1F */
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote),
+                            _mm256_cmpeq_epi8(chunk, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    while (p < end && !is_string_special((unsigned char)*p)) p++;
+    return p;
+}
+
+#elif defined(__SSE2__)
+
+static const char* scan_string(const char* p, const char* end) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+        /* Unsigned c <= 0x1F is max(c, 0x1F) == 0x1F */
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                         _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+        if (mask != 0) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    while (p < end && !is_string_special((unsigned char)*p)) p++;
+    return p;
+}
+
+#else
+
+/* Return the first special byte at or after p, or end */
+static const char* scan_string(const char* p, const char* end) {
+    while (p < end && !is_string_special((unsigned char)*p)) p++;
+    return p;
+}
+
+#endif
+
+/* ============ Parser ============ */
+
+/* Keys seen recently, indexed by length and edge bytes; documents tend to
+   repeat the same few keys in every object */
+#define JSON_KEY_CACHE 64
+
+/* Object member waiting for its table */
+typedef struct {
+    ObjString* key;
+    Value value;
+} JsonMember;
+
+typedef struct {
+    const char* start;
+    const char* current;
+    const char* end;
+    char* scratch;          /* Decoded text of strings with escapes */
+    int scratch_capacity;
+    ObjString* key_cache[JSON_KEY_CACHE];  /* Recently seen keys, no references held */
+    JsonMember* members;    /* Members of the objects being parsed, innermost last */
+    int member_count;
+    int member_capacity;
+    int depth;
+    char* error;
+    int error_size;
+} JsonParser;
+
+static bool parse_value(JsonParser* p, Value* out);
+
+/* Record an error at the current position; always returns false */
+static bool parse_fail(JsonParser* p, const char* format, ...) {
+    int line = 1;
+    int column = 1;
+    for (const char* c = p->start; c < p->current; c++) {
+        if (*c == '\n') {
+            line++;
+            column = 1;
+        } else {
+            column++;
+        }
+    }
+    
+    char message[128];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    
+    snprintf(p->error, p->error_size, "%s at line %d, column %d", message, line, column);
+    return false;
+}
+
+static void skip_whitespace(JsonParser* p) {
+    while (p->current < p->end) {
+        char c = *p->current;
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return;
+        p->current++;
+    }
+}
+
+/* Consume an exact keyword such as "true" */
+static bool match_word(JsonParser* p, const char* word, int length) {
+    if (p->end - p->current < length || memcmp(p->current, word, length) != 0) {
+        return false;
+    }
+    p->current += length;
+    return true;
+}
+
+static void scratch_append(JsonParser* p, int* length, const char* chars, int count) {
+    if (count == 0) return;
+    if (*length + count > p->scratch_capacity) {
+        int new_capacity = p->scratch_capacity < 8 ? 8 : p->scratch_capacity * 2;
+        while (new_capacity < *length + count) new_capacity *= 2;
+        p->scratch = mem_realloc(p->scratch, p->scratch_capacity, new_capacity);
+        p->scratch_capacity = new_capacity;
+    }
+    memcpy(p->scratch + *length, chars, count);
+    *length += count;
+}
+
+static int hex4(const char* s) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else return -1;
+        value = value * 16 + d;
+    }
+    return value;
+}
+
+static int encode_utf8(char* out, int cp) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* Decode a \uXXXX escape (and its low surrogate) at p->current, which
+   points just past the 'u'. Lone surrogates become U+FFFD. */
+static bool parse_unicode_escape(JsonParser* p, int* length) {
+    if (p->end - p->current < 4 || hex4(p->current) < 0) {
+        return parse_fail(p, "Invalid \\u escape");
+    }
+    int cp = hex4(p->current);
+    p->current += 4;
+    
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        int low = -1;
+        if (p->end - p->current >= 6 && p->current[0] == '\\' && p->current[1] == 'u') {
+            low = hex4(p->current + 2);
+        }
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            p->current += 6;
+        } else {
+            cp = 0xFFFD;
+        }
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        cp = 0xFFFD;
+    }
+    
+    char utf8[4];
+    scratch_append(p, length, utf8, encode_utf8(utf8, cp));
+    return true;
+}
+
+/* Parse a string starting at the opening quote. Strings without escapes
+   are taken straight from the input; others are decoded into scratch.
+   Sets *chars and *length to the decoded text. */
+static bool parse_string_text(JsonParser* p, const char** chars, int* length) {
+    p->current++;  /* Opening quote */
+    const char* run = p->current;
+    const char* stop = scan_string(run, p->end);
+    
+    if (stop < p->end && *stop == '"') {
+        *chars = run;
+        *length = (int)(stop - run);
+        p->current = stop + 1;
+        return true;
+    }
+    
+    int decoded = 0;
+    for (;;) {
+        scratch_append(p, &decoded, run, (int)(stop - run));
+        p->current = stop;
+        
+        if (stop == p->end) return parse_fail(p, "Unterminated string");
+        if (*stop == '"') break;
+        if (*stop != '\\') return parse_fail(p, "Control character in string");
+        
+        p->current++;
+        if (p->current == p->end) return parse_fail(p, "Unterminated string");
+        char c = *p->current++;
+        char e;
+        switch (c) {
+            case '"': e = '"'; break;
+            case '\\': e = '\\'; break;
+            case '/': e = '/'; break;
+            case 'b': e = '\b'; break;
+            case 'f': e = '\f'; break;
+            case 'n': e = '\n'; break;
+            case 'r': e = '\r'; break;
+            case 't': e = '\t'; break;
+            case 'u':
+                if (!parse_unicode_escape(p, &decoded)) return false;
+                e = 0;
+                break;
+            default:
+                p->current--;
+                return parse_fail(p, "Invalid escape '\\%c'", c);
+        }
+        if (c != 'u') scratch_append(p, &decoded, &e, 1);
+        
+        run = p->current;
+        stop = scan_string(run, p->end);
+    }
+    
+    *chars = p->scratch;
+    *length = decoded;
+    p->current++;  /* Closing quote */
+    return true;
+}
+
+static bool parse_number(JsonParser* p, Value* out) {
+    const char* begin = p->current;
+    const char* c = begin;
+    bool integral = true;
+    
+    if (c < p->end && *c == '-') c++;
+    if (c < p->end && *c == '0') {
+        c++;
+    } else if (c < p->end && *c >= '1' && *c <= '9') {
+        while (c < p->end && *c >= '0' && *c <= '9') c++;
+    } else {
+        p->current = c;
+        return parse_fail(p, "Invalid number");
+    }
+    
+    if (c < p->end && *c == '.') {
+        integral = false;
+        c++;
+        if (c == p->end || *c < '0' || *c > '9') {
+            p->current = c;
+            return parse_fail(p, "Expected digit after '.'");
+        }
+        while (c < p->end && *c >= '0' && *c <= '9') c++;
+    }
+    if (c < p->end && (*c == 'e' || *c == 'E')) {
+        integral = false;
+        c++;
+        if (c < p->end && (*c == '+' || *c == '-')) c++;
+        if (c == p->end || *c < '0' || *c > '9') {
+            p->current = c;
+            return parse_fail(p, "Expected digit in exponent");
+        }
+        while (c < p->end && *c >= '0' && *c <= '9') c++;
+    }
+    
+    p->current = c;
+    int length = (int)(c - begin);
+    
+    if (integral) {
+        bool negative = begin[0] == '-';
+        uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+        uint64_t magnitude = 0;
+        const char* d = negative ? begin + 1 : begin;
+        for (; d < c; d++) {
+            uint64_t digit = (uint64_t)(*d - '0');
+            if (magnitude > (limit - digit) / 10) break;
+            magnitude = magnitude * 10 + digit;
+        }
+        if (d == c) {
+            *out = INT_VAL(negative ? (int64_t)((uint64_t)0 - magnitude) : (int64_t)magnitude);
+            return true;
+        }
+        /* Too large for an int: keep the magnitude as a float */
+    }
+    
+    double d;
+    num_parse_double(begin, length, 0, &d);
+    *out = FLOAT_VAL(d);
+    return true;
+}
+
+static bool parse_array(JsonParser* p, Value* out) {
+    p->current++;  /* '[' */
+    ObjArray* array = array_create();
+    
+    skip_whitespace(p);
+    if (p->current < p->end && *p->current == ']') {
+        p->current++;
+        *out = OBJ_VAL(array);
+        return true;
+    }
+    
+    for (;;) {
+        Value element;
+        if (!parse_value(p, &element)) {
+            obj_decref((Object*)array);
+            return false;
+        }
+        array_push(array, element);
+        if (IS_OBJ(element)) obj_decref(AS_OBJ(element));  /* Array holds it */
+        
+        skip_whitespace(p);
+        if (p->current < p->end && *p->current == ',') {
+            p->current++;
+            continue;
+        }
+        if (p->current < p->end && *p->current == ']') {
+            p->current++;
+            break;
+        }
+        obj_decref((Object*)array);
+        return parse_fail(p, "Expected ',' or ']'");
+    }
+    
+    *out = OBJ_VAL(array);
+    return true;
+}
+
+static void push_member(JsonParser* p, ObjString* key, Value value) {
+    if (p->member_count >= p->member_capacity) {
+        int new_capacity = p->member_capacity < 8 ? 8 : p->member_capacity * 2;
+        p->members = mem_realloc(p->members, sizeof(JsonMember) * p->member_capacity,
+                                 sizeof(JsonMember) * new_capacity);
+        p->member_capacity = new_capacity;
+    }
+    p->members[p->member_count].key = key;
+    p->members[p->member_count].value = value;
+    p->member_count++;
+}
+
+/* Release members from base up, after a failed parse */
+static void drop_members(JsonParser* p, int base) {
+    for (int i = base; i < p->member_count; i++) {
+        obj_decref((Object*)p->members[i].key);
+        if (IS_OBJ(p->members[i].value)) obj_decref(AS_OBJ(p->members[i].value));
+    }
+    p->member_count = base;
+}
+
+/* Keys repeat across objects, so they go through the intern table; the
+   cache skips hashing and probing for keys seen a moment ago. Interned
+   strings live as long as the table, so the cache needs no references. */
+static ObjString* intern_key(JsonParser* p, const char* chars, int length) {
+    unsigned slot = 0;
+    if (length > 0) {
+        slot = ((unsigned)length * 31u + (unsigned char)chars[0] * 7u +
+                (unsigned char)chars[length - 1]) % JSON_KEY_CACHE;
+    }
+    
+    ObjString* cached = p->key_cache[slot];
+    if (cached != NULL && cached->length == length &&
+        memcmp(cached->chars, chars, length) == 0) {
+        obj_incref((Object*)cached);
+        return cached;
+    }
+    
+    ObjString* key = string_create(chars, length);
+    p->key_cache[slot] = key;
+    return key;
+}
+
+/* Members are collected first so the table is sized once and never
+   rehashed while it fills */
+static bool parse_object(JsonParser* p, Value* out) {
+    p->current++;  /* '{' */
+    int base = p->member_count;
+    
+    skip_whitespace(p);
+    if (p->current < p->end && *p->current == '}') {
+        p->current++;
+        *out = OBJ_VAL(table_create());
+        return true;
+    }
+    
+    for (;;) {
+        skip_whitespace(p);
+        if (p->current == p->end || *p->current != '"') {
+            drop_members(p, base);
+            return parse_fail(p, "Expected string key");
+        }
+        
+        const char* chars;
+        int length;
+        if (!parse_string_text(p, &chars, &length)) {
+            drop_members(p, base);
+            return false;
+        }
+        ObjString* key = intern_key(p, chars, length);
+        
+        skip_whitespace(p);
+        if (p->current == p->end || *p->current != ':') {
+            obj_decref((Object*)key);
+            drop_members(p, base);
+            return parse_fail(p, "Expected ':' after key");
+        }
+        p->current++;
+        
+        Value value;
+        if (!parse_value(p, &value)) {
+            obj_decref((Object*)key);
+            drop_members(p, base);
+            return false;
+        }
+        push_member(p, key, value);
+        
+        skip_whitespace(p);
+        if (p->current < p->end && *p->current == ',') {
+            p->current++;
+            continue;
+        }
+        if (p->current < p->end && *p->current == '}') {
+            p->current++;
+            break;
+        }
+        drop_members(p, base);
+        return parse_fail(p, "Expected ',' or '}'");
+    }
+    
+    ObjTable* table = table_create();
+    table_reserve(table, p->member_count - base);
+    for (int i = base; i < p->member_count; i++) {
+        /* The table takes its own references */
+        table_set(table, p->members[i].key, p->members[i].value, false);
+        obj_decref((Object*)p->members[i].key);
+        if (IS_OBJ(p->members[i].value)) obj_decref(AS_OBJ(p->members[i].value));
+    }
+    p->member_count = base;
+    
+    *out = OBJ_VAL(table);
+    return true;
+}
+
+static bool parse_value(JsonParser* p, Value* out) {
+    skip_whitespace(p);
+    if (p->current == p->end) return parse_fail(p, "Unexpected end of input");
+    
+    bool ok;
+    switch (*p->current) {
+        case '{':
+        case '[':
+            if (++p->depth > JSON_MAX_DEPTH) return parse_fail(p, "Nesting too deep");
+            ok = *p->current == '{' ? parse_object(p, out) : parse_array(p, out);
+            p->depth--;
+            return ok;
+        case '"': {
+            const char* chars;
+            int length;
+            if (!parse_string_text(p, &chars, &length)) return false;
+            /* Values are mostly unique; leave them out of the intern table
+               so a large document is freed with its tables */
+            *out = OBJ_VAL(string_create_uninterned(chars, length));
+            return true;
+        }
+        case 't':
+            if (!match_word(p, "true", 4)) break;
+            *out = BOOL_VAL(true);
+            return true;
+        case 'f':
+            if (!match_word(p, "false", 5)) break;
+            *out = BOOL_VAL(false);
+            return true;
+        case 'n':
+            if (!match_word(p, "null", 4)) break;
+            *out = NIL_VAL;
+            return true;
+        default:
+            if (*p->current == '-' || (*p->current >= '0' && *p->current <= '9')) {
+                return parse_number(p, out);
+            }
+            break;
+    }
+    
+    unsigned char c = (unsigned char)*p->current;
+    if (c >= 0x20 && c < 0x7F) return parse_fail(p, "Unexpected character '%c'", c);
+    return parse_fail(p, "Unexpected byte 0x%02X", c);
+}
+
+bool json_parse(const char* text, int length, Value* out,
+                char* error, int error_size) {
+    JsonParser p;
+    p.start = text;
+    p.current = text;
+    p.end = text + length;
+    p.scratch = NULL;
+    p.scratch_capacity = 0;
+    memset(p.key_cache, 0, sizeof(p.key_cache));
+    p.members = NULL;
+    p.member_count = 0;
+    p.member_capacity = 0;
+    p.depth = 0;
+    p.error = error;
+    p.error_size = error_size;
+    
+    bool ok = parse_value(&p, out);
+    if (ok) {
+        skip_whitespace(&p);
+        if (p.current != p.end) {
+            if (IS_OBJ(*out)) obj_decref(AS_OBJ(*out));
+            ok = parse_fail(&p, "Unexpected data after the document");
+        }
+    }
+    
+    if (p.scratch != NULL) mem_free(p.scratch, p.scratch_capacity);
+    if (p.members != NULL) mem_free(p.members, sizeof(JsonMember) * p.member_capacity);
+    return ok;
+}
+
+/* ============ Serializer ============ */
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+    char* error;
+    int error_size;
+} JsonWriter;
+
+static void writer_grow(JsonWriter* w, size_t n) {
+    size_t new_capacity = w->capacity * 2;
+    while (new_capacity < w->length + n) new_capacity *= 2;
+    w->data = mem_realloc(w->data, w->capacity, new_capacity);
+    w->capacity = new_capacity;
+}
+
+/* The fast path stays small enough to inline at every call site */
+static inline void writer_reserve(JsonWriter* w, size_t n) {
+    if (w->length + n > w->capacity) writer_grow(w, n);
+}
+
+static inline void writer_write(JsonWriter* w, const char* chars, size_t length) {
+    writer_reserve(w, length);
+    memcpy(w->data + w->length, chars, length);
+    w->length += length;
+}
+
+static void write_string(JsonWriter* w, const char* chars, int length) {
+    static const char hex[] = "0123456789abcdef";
+    const char* p = chars;
+    const char* end = chars + length;
+    
+    writer_write(w, "\"", 1);
+    while (p < end) {
+        /* Copy the plain run up to the next byte that needs escaping */
+        const char* stop = scan_string(p, end);
+        writer_write(w, p, stop - p);
+        if (stop == end) break;
+        
+        char c = *stop;
+        char escape[6] = {'\\', 0, 0, 0, 0, 0};
+        int escape_length = 2;
+        switch (c) {
+            case '"': escape[1] = '"'; break;
+            case '\\': escape[1] = '\\'; break;
+            case '\b': escape[1] = 'b'; break;
+            case '\f': escape[1] = 'f'; break;
+            case '\n': escape[1] = 'n'; break;
+            case '\r': escape[1] = 'r'; break;
+            case '\t': escape[1] = 't'; break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[(c >> 4) & 0xF];
+                escape[5] = hex[c & 0xF];
+                escape_length = 6;
+                break;
+        }
+        writer_write(w, escape, escape_length);
+        p = stop + 1;
+    }
+    writer_write(w, "\"", 1);
+}
+
+static bool write_value(JsonWriter* w, Value value, int depth) {
+    switch (value.type) {
+        case VAL_NIL:
+            writer_write(w, "null", 4);
+            return true;
+        case VAL_BOOL:
+            if (AS_BOOL(value)) {
+                writer_write(w, "true", 4);
+            } else {
+                writer_write(w, "false", 5);
+            }
+            return true;
+        case VAL_INT:
+            writer_reserve(w, NUM_INT_BUFFER);
+            w->length += num_format_int(w->data + w->length, AS_INT(value));
+            return true;
+        case VAL_FLOAT: {
+            double d = AS_FLOAT(value);
+            if (d != d || d - d != 0.0) {
+                /* JSON has no NaN or infinity */
+                writer_write(w, "null", 4);
+                return true;
+            }
+            writer_reserve(w, NUM_DOUBLE_BUFFER + 2);
+            char* start = w->data + w->length;
+            int length = num_format_double(start, d);
+            /* Keep a fraction so the value parses back as a float */
+            if (memchr(start, '.', length) == NULL && memchr(start, 'e', length) == NULL) {
+                start[length++] = '.';
+                start[length++] = '0';
+            }
+            w->length += length;
+            return true;
+        }
+        case VAL_OBJ:
+            break;
+    }
+    
+    if (depth > JSON_MAX_DEPTH) {
+        snprintf(w->error, w->error_size, "Nesting too deep (is the value cyclic?)");
+        return false;
+    }
+    
+    switch (AS_OBJ(value)->type) {
+        case OBJ_STRING:
+            write_string(w, AS_STRING(value)->chars, AS_STRING(value)->length);
+            return true;
+        case OBJ_ARRAY: {
+            ObjArray* array = AS_ARRAY(value);
+            writer_write(w, "[", 1);
+            for (int i = 0; i < array->count; i++) {
+                if (i > 0) writer_write(w, ",", 1);
+                if (!write_value(w, array->elements[i], depth + 1)) return false;
+            }
+            writer_write(w, "]", 1);
+            return true;
+        }
+        case OBJ_TABLE: {
+            ObjTable* table = AS_TABLE(value);
+            bool first = true;
+            writer_write(w, "{", 1);
+            for (int i = 0; i < table->capacity; i++) {
+                TableEntry* entry = &table->entries[i];
+                if (entry->key == NULL) continue;
+                if (!first) writer_write(w, ",", 1);
+                first = false;
+                write_string(w, entry->key->chars, entry->key->length);
+                writer_write(w, ":", 1);
+                if (!write_value(w, entry->value, depth + 1)) return false;
+            }
+            writer_write(w, "}", 1);
+            return true;
+        }
+        default:
+            snprintf(w->error, w->error_size, "Cannot serialize a value of type %s",
+                     value_type_name(value));
+            return false;
+    }
+}
+
+ObjString* json_stringify(Value value, char* error, int error_size) {
+    JsonWriter w;
+    w.capacity = 256;
+    w.data = mem_alloc(w.capacity);
+    w.length = 0;
+    w.error = error;
+    w.error_size = error_size;
+    
+    ObjString* result = NULL;
+    if (write_value(&w, value, 0)) {
+        result = string_create_uninterned(w.data, (int)w.length);
+    }
+    
+    mem_free(w.data, w.capacity);
+    return result;
+}
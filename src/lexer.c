@@ -17,6 +17,7 @@ static const char* token_names[] = {
     [TOKEN_INT] = "INT",
     [TOKEN_FLOAT] = "FLOAT",
     [TOKEN_STRING] = "STRING",
+    [TOKEN_FSTRING] = "FSTRING",
     [TOKEN_TRUE] = "TRUE",
     [TOKEN_FALSE] = "FALSE",
     [TOKEN_NIL] = "NIL",
@@ -33,6 +34,7 @@ static const char* token_names[] = {
     [TOKEN_CONTINUE] = "CONTINUE",
     [TOKEN_MATCH] = "MATCH",
     [TOKEN_DEFER] = "DEFER",
+    [TOKEN_YIELD] = "YIELD",
     [TOKEN_AND] = "AND",
     [TOKEN_OR] = "OR",
     [TOKEN_NOT] = "NOT",
@@ -228,6 +230,54 @@ static Token scan_string(Lexer* lexer) {
     return make_token(lexer, TOKEN_STRING);
 }
 
+/* Interpolated string f"...": the parser splits the parts, so here we only
+   need to find the closing quote. Quotes inside {expr} belong to nested
+   string literals; {{ and }} are escaped braces. */
+static Token scan_fstring(Lexer* lexer) {
+    int depth = 0;
+    
+    while (!is_at_end(lexer)) {
+        char c = peek(lexer);
+        
+        if (c == '"' && depth == 0) break;
+        
+        if (c == '\n') {
+            lexer->line++;
+            lexer->column = 0;
+            advance(lexer);
+        } else if (c == '\\') {
+            advance(lexer);
+            if (!is_at_end(lexer)) advance(lexer);
+        } else if (depth == 0 && (c == '{' || c == '}') && peek_next(lexer) == c) {
+            advance(lexer);
+            advance(lexer);
+        } else if (c == '{') {
+            depth++;
+            advance(lexer);
+        } else if (c == '}') {
+            if (depth > 0) depth--;
+            advance(lexer);
+        } else if (c == '"') {
+            /* Nested string literal inside an expression */
+            advance(lexer);
+            while (peek(lexer) != '"' && !is_at_end(lexer)) {
+                if (peek(lexer) == '\\') advance(lexer);
+                if (!is_at_end(lexer)) advance(lexer);
+            }
+            if (!is_at_end(lexer)) advance(lexer);
+        } else {
+            advance(lexer);
+        }
+    }
+    
+    if (is_at_end(lexer)) {
+        return error_token(lexer, "Unterminated string");
+    }
+    
+    advance(lexer); /* Closing quote */
+    return make_token(lexer, TOKEN_FSTRING);
+}
+
 /* Keyword lookup using a trie-like approach (simplified) */
 static TokenType check_keyword(const char* start, int length, 
                                int offset, int rest_len, 
@@ -324,6 +374,11 @@ static TokenType identifier_type(Lexer* lexer) {
                 if (start[1] == 'h') return check_keyword(start, length, 2, 3, "ile", TOKEN_WHILE);
             }
             break;
+        case 'y':
+            if (length > 1) {
+                if (start[1] == 'i') return check_keyword(start, length, 2, 3, "eld", TOKEN_YIELD);
+            }
+            break;
         case '_':
             if (length == 1) return TOKEN_UNDERSCORE;
             break;
@@ -363,6 +418,10 @@ Token lexer_next_token(Lexer* lexer) {
     
     /* Identifiers and keywords */
     if (is_alpha(c)) {
+        if (c == 'f' && peek(lexer) == '"') {
+            advance(lexer); /* Opening quote */
+            return scan_fstring(lexer);
+        }
         return scan_identifier(lexer);
     }
     
@@ -10,6 +10,12 @@
 #include "parser.h"
 #include "interp.h"
 #include "memory.h"
+#include "profile.h"
+#include "stats.h"
+#include "heap.h"
+#include "ffitrace.h"
+#include "trace.h"
+#include "emitc.h"
 
 #define BRISK_VERSION "0.1.0"
 #define BRISK_NAME "Brisk"
@@ -19,14 +25,24 @@ static void print_help(const char* program_name);
 static void print_version(void);
 static void run_file(const char* path);
 static void run_repl(void);
+static int compile_file(const char* path, const char* c_path, const char* binary_path);
 
 int main(int argc, char* argv[]) {
+    ffi_trace_configure();
+    
     /* No arguments - run REPL */
     if (argc == 1) {
         run_repl();
         return 0;
     }
     
+    const char* profile_path = NULL;
+    int profile_rate = PROFILE_DEFAULT_RATE;
+    const char* trace_path = NULL;
+    double trace_call_us = -1;
+    const char* emit_path = NULL;
+    const char* compile_path = NULL;
+    
     /* Parse command-line arguments */
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -37,6 +53,49 @@ int main(int argc, char* argv[]) {
             print_version();
             return 0;
         }
+        else if (strncmp(argv[i], "--profile=", 10) == 0 && argv[i][10] != '\0') {
+            profile_path = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--profile-rate=", 15) == 0) {
+            char* end;
+            long rate = strtol(argv[i] + 15, &end, 10);
+            if (argv[i][15] == '\0' || *end != '\0' || rate < 1 || rate > 100000) {
+                fprintf(stderr, "Error: --profile-rate expects samples per second (1-100000)\n");
+                return 1;
+            }
+            profile_rate = (int)rate;
+        }
+        else if (strncmp(argv[i], "--trace=", 8) == 0 && argv[i][8] != '\0') {
+            trace_path = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--trace-calls=", 14) == 0) {
+            char* end;
+            trace_call_us = strtod(argv[i] + 14, &end);
+            if (argv[i][14] == '\0' || *end != '\0' || trace_call_us < 0) {
+                fprintf(stderr, "Error: --trace-calls expects a duration in microseconds\n");
+                return 1;
+            }
+        }
+        else if (strncmp(argv[i], "--emit-c=", 9) == 0 && argv[i][9] != '\0') {
+            emit_path = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--compile=", 10) == 0 && argv[i][10] != '\0') {
+            compile_path = argv[i] + 10;
+        }
+        else if (strcmp(argv[i], "--heap-profile") == 0) {
+            heap_profile_configure();
+        }
+        else if (strcmp(argv[i], "--leak-check") == 0) {
+            heap_leak_configure();
+        }
+        else if (strcmp(argv[i], "--stats") == 0 || strncmp(argv[i], "--stats=", 8) == 0) {
+#ifdef BRISK_STATS
+            stats_enable(argv[i][7] == '=' ? argv[i] + 8 : NULL);
+#else
+            fprintf(stderr, "Error: --stats needs a build with statistics (make clean stats)\n");
+            return 1;
+#endif
+        }
         else if (argv[i][0] == '-') {
             fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
             fprintf(stderr, "Try '%s --help' for more information.\n", argv[0]);
@@ -44,6 +103,11 @@ int main(int argc, char* argv[]) {
         }
         else {
             /* Treat as file path */
+            if (emit_path != NULL || compile_path != NULL) {
+                return compile_file(argv[i], emit_path, compile_path);
+            }
+            if (profile_path != NULL) profile_configure(profile_path, profile_rate);
+            if (trace_path != NULL) trace_configure(trace_path, trace_call_us);
             run_file(argv[i]);
             return 0;
         }
@@ -56,8 +120,31 @@ static void print_help(const char* program_name) {
     printf("Usage: %s [options] [file]\n", program_name);
     printf("\n");
     printf("Options:\n");
-    printf("  -h, --help     Show this help message and exit\n");
-    printf("  -v, --version  Show version information and exit\n");
+    printf("  -h, --help           Show this help message and exit\n");
+    printf("  -v, --version        Show version information and exit\n");
+    printf("  --profile=FILE       Sample the script's calls, write collapsed stacks\n");
+    printf("                       to FILE and print the hottest functions and lines\n");
+    printf("  --profile-rate=HZ    Samples per second of CPU time (default %d)\n",
+           PROFILE_DEFAULT_RATE);
+    printf("  --trace=FILE         Write startup phases, imports and header loads to\n");
+    printf("                       FILE as Chrome trace events (Perfetto, chrome://tracing)\n");
+    printf("  --trace-calls=US     With --trace, also record calls taking US microseconds\n");
+    printf("  --heap-profile       Record the line that made each object and print\n");
+    printf("                       the lines holding the most memory at exit\n");
+    printf("  --leak-check         List objects still alive after the interpreter is\n");
+    printf("                       torn down and exit with status 1 if there are any\n");
+    printf("  --stats[=FILE]       Count evaluated nodes, lookups and allocations and\n");
+    printf("                       print them at exit, also as JSON to FILE (make stats)\n");
+    printf("  --emit-c=FILE        Translate the script to C in FILE instead of running it\n");
+    printf("  --compile=BINARY     Translate the script to C and build it with cc into\n");
+    printf("                       BINARY (keeps the C in BINARY.c unless --emit-c)\n");
+    printf("\n");
+    printf("Environment:\n");
+    printf("  BRISK_FFI_TRACE=1    Time each C function call (marshalling, the call,\n");
+    printf("                       the result) and print latency percentiles at exit\n");
+    printf("  CC                   C compiler used by --compile (default cc)\n");
+    printf("  BRISK_HOME           Source tree whose build/libbrisk.a --compile links\n");
+    printf("                       (default: the directory of this brisk binary)\n");
     printf("\n");
     printf("If no file is given, starts an interactive REPL.\n");
     printf("\n");
@@ -65,6 +152,8 @@ static void print_help(const char* program_name) {
     printf("  %s                    # Start REPL\n", program_name);
     printf("  %s script.brisk       # Run a Brisk script\n", program_name);
     printf("  %s --version          # Show version\n", program_name);
+    printf("  %s --profile=out.folded script.brisk\n", program_name);
+    printf("  %s --compile=script script.brisk\n", program_name);
 }
 
 static void print_version(void) {
@@ -79,6 +168,21 @@ static void run_file(const char* path) {
     }
 }
 
+/* --emit-c and --compile: write the C, then build it if asked */
+static int compile_file(const char* path, const char* c_path, const char* binary_path) {
+    char generated[1024];
+    if (c_path == NULL) {
+        snprintf(generated, sizeof(generated), "%s.c", binary_path);
+        c_path = generated;
+    }
+    
+    int result = emit_c_file(path, c_path);
+    if (result != 0 || binary_path == NULL) {
+        return result;
+    }
+    return emit_c_build(c_path, binary_path);
+}
+
 /* Check if input is incomplete (unclosed braces/parens) */
 static bool is_incomplete(const char* input) {
     int braces = 0;
@@ -226,11 +330,12 @@ static void run_repl(void) {
             Value result = eval(&interp, expr);
             
             if (!IS_NIL(result)) {
-                printf("=> ");
-                value_print(result);
-                printf("\n");
+                output_write(&interp.out, "=> ", 3);
+                output_value(&interp.out, result);
+                output_write(&interp.out, "\n", 1);
             }
         }
+        output_flush(&interp.out);
         
         ast_free_tree(ast);
     }
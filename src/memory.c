@@ -6,11 +6,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include "memory.h"
-
-size_t bytes_allocated = 0;
+#include "isolate.h"
 
 void* mem_alloc(size_t size) {
-    bytes_allocated += size;
+    Isolate* isolate = isolate_current();
+    isolate->bytes_allocated += size;
+    isolate->allocation_count++;
+    isolate->allocated_total += size;
     void* ptr = malloc(size);
     if (ptr == NULL && size > 0) {
         fprintf(stderr, "Fatal: Out of memory\n");
@@ -20,7 +22,12 @@ void* mem_alloc(size_t size) {
 }
 
 void* mem_realloc(void* ptr, size_t old_size, size_t new_size) {
-    bytes_allocated += new_size - old_size;
+    Isolate* isolate = isolate_current();
+    isolate->bytes_allocated += new_size - old_size;
+    if (new_size > old_size) {
+        isolate->allocation_count++;
+        isolate->allocated_total += new_size - old_size;
+    }
     
     if (new_size == 0) {
         free(ptr);
@@ -37,10 +44,17 @@ void* mem_realloc(void* ptr, size_t old_size, size_t new_size) {
 
 void mem_free(void* ptr, size_t size) {
     if (ptr == NULL) return;
-    bytes_allocated -= size;
+    isolate_current()->bytes_allocated -= size;
     free(ptr);
 }
 
+void mem_adopt(size_t size) {
+    Isolate* isolate = isolate_current();
+    isolate->bytes_allocated += size;
+    isolate->allocation_count++;
+    isolate->allocated_total += size;
+}
+
 void mem_print_stats(void) {
-    printf("Memory: %zu bytes allocated\n", bytes_allocated);
+    printf("Memory: %zu bytes allocated\n", isolate_current()->bytes_allocated);
 }
@@ -0,0 +1,188 @@
+/*
+ * Brisk Language - Buffered Output Implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "output.h"
+#include "numconv.h"
+#include "memory.h"
+
+#define OUTPUT_BLOCK_SIZE 65536
+
+void output_init(Output* out, FILE* stream) {
+    out->stream = stream;
+    out->data = mem_alloc(OUTPUT_BLOCK_SIZE);
+    out->length = 0;
+    out->capacity = OUTPUT_BLOCK_SIZE;
+    out->mode = isatty(fileno(stream)) ? OUTPUT_LINE : OUTPUT_BLOCK;
+    out->newline = false;
+}
+
+void output_free(Output* out) {
+    output_flush(out);
+    mem_free(out->data, out->capacity);
+    out->data = NULL;
+    out->capacity = 0;
+}
+
+void output_flush(Output* out) {
+    if (out->length > 0) {
+        fwrite(out->data, 1, out->length, out->stream);
+        out->length = 0;
+    }
+    out->newline = false;
+    fflush(out->stream);
+}
+
+/* Make room for n more bytes: flush in line/block mode, grow in manual mode */
+static void output_reserve(Output* out, size_t n) {
+    if (out->length + n <= out->capacity) return;
+    
+    if (out->mode != OUTPUT_MANUAL) {
+        output_flush(out);
+        if (n <= out->capacity) return;
+    }
+    
+    size_t new_capacity = out->capacity * 2;
+    while (new_capacity < out->length + n) new_capacity *= 2;
+    out->data = mem_realloc(out->data, out->capacity, new_capacity);
+    out->capacity = new_capacity;
+}
+
+void output_write(Output* out, const char* chars, size_t length) {
+    if (length > out->capacity && out->mode != OUTPUT_MANUAL) {
+        /* Too big to batch: pass straight through */
+        output_flush(out);
+        fwrite(chars, 1, length, out->stream);
+    } else {
+        output_reserve(out, length);
+        memcpy(out->data + out->length, chars, length);
+        out->length += length;
+    }
+    
+    /* Only the new bytes are scanned, so output_end needs no rescan */
+    if (!out->newline && memchr(chars, '\n', length) != NULL) {
+        out->newline = true;
+    }
+}
+
+/* Write a NUL-terminated constant */
+static void output_cstring(Output* out, const char* chars) {
+    output_write(out, chars, strlen(chars));
+}
+
+void output_value(Output* out, Value value) {
+    switch (value.type) {
+        case VAL_NIL:
+            output_write(out, "nil", 3);
+            break;
+        case VAL_BOOL:
+            if (AS_BOOL(value)) {
+                output_write(out, "true", 4);
+            } else {
+                output_write(out, "false", 5);
+            }
+            break;
+        case VAL_INT:
+            output_reserve(out, NUM_INT_BUFFER);
+            out->length += num_format_int(out->data + out->length, AS_INT(value));
+            break;
+        case VAL_FLOAT:
+            output_reserve(out, NUM_DOUBLE_BUFFER);
+            out->length += num_format_double(out->data + out->length, AS_FLOAT(value));
+            break;
+        case VAL_OBJ:
+            switch (AS_OBJ(value)->type) {
+                case OBJ_STRING:
+                    output_write(out, AS_STRING(value)->chars, AS_STRING(value)->length);
+                    break;
+                case OBJ_ARRAY: {
+                    ObjArray* arr = AS_ARRAY(value);
+                    output_write(out, "[", 1);
+                    for (int i = 0; i < arr->count; i++) {
+                        if (i > 0) output_write(out, ", ", 2);
+                        output_value(out, arr->elements[i]);
+                    }
+                    output_write(out, "]", 1);
+                    break;
+                }
+                case OBJ_TABLE:
+                    output_cstring(out, "<table>");
+                    break;
+                case OBJ_FUNCTION: {
+                    ObjFunction* fn = AS_FUNCTION(value);
+                    if (fn->name != NULL) {
+                        output_cstring(out, "<fn ");
+                        output_cstring(out, fn->name);
+                        output_cstring(out, ">");
+                    } else {
+                        output_cstring(out, "<fn>");
+                    }
+                    break;
+                }
+                case OBJ_NATIVE:
+                    output_cstring(out, "<native fn>");
+                    break;
+                case OBJ_POINTER:
+                    output_reserve(out, 32);
+                    out->length += snprintf(out->data + out->length, 32, "<ptr %p>",
+                                            AS_POINTER(value)->ptr);
+                    break;
+                case OBJ_CSTRUCT:
+                    output_cstring(out, "<cstruct>");
+                    break;
+                case OBJ_CFUNCTION:
+                    output_cstring(out, "<cfn>");
+                    break;
+                case OBJ_FILE:
+                    output_cstring(out, "<file>");
+                    break;
+                case OBJ_CHANNEL:
+                    output_cstring(out, "<channel>");
+                    break;
+                case OBJ_THREAD:
+                    output_cstring(out, "<thread>");
+                    break;
+                case OBJ_ITERATOR:
+                    output_cstring(out, "<iterator>");
+                    break;
+                case OBJ_TASK:
+                    output_cstring(out, "<task>");
+                    break;
+            }
+            break;
+    }
+}
+
+void output_end(Output* out) {
+    if (out->mode == OUTPUT_LINE && out->newline) {
+        output_flush(out);
+    }
+}
+
+bool output_mode_parse(const char* name, OutputMode* mode) {
+    if (strcmp(name, "line") == 0) {
+        *mode = OUTPUT_LINE;
+    } else if (strcmp(name, "block") == 0) {
+        *mode = OUTPUT_BLOCK;
+    } else if (strcmp(name, "manual") == 0) {
+        *mode = OUTPUT_MANUAL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* output_mode_name(OutputMode mode) {
+    switch (mode) {
+        case OUTPUT_LINE: return "line";
+        case OUTPUT_BLOCK: return "block";
+        case OUTPUT_MANUAL: return "manual";
+    }
+    return "block";
+}
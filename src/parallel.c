@@ -0,0 +1,384 @@
+/*
+ * Brisk Language - Parallel Map Implementation
+ * Each worker owns a contiguous range of indices and takes small chunks
+ * from its front; a worker that runs dry steals the back half of another
+ * worker's range, so uneven element costs still keep every thread busy
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "parallel.h"
+#include "clone.h"
+#include "memory.h"
+
+typedef struct ParallelJob ParallelJob;
+typedef struct ThreadState ThreadState;
+
+/* Indices [next, end) not yet claimed; thieves shrink end */
+typedef struct {
+    pthread_mutex_t lock;
+    int next;
+    int end;
+} WorkRange;
+
+typedef struct {
+    ParallelJob* job;
+    int id;
+    pthread_t thread;
+    WorkRange range;
+    CloneBuffer results;    /* One message per finished element */
+} Worker;
+
+struct ParallelJob {
+    CloneBuffer* module;            /* The function and its globals */
+    CloneBuffer* elements;
+    const size_t* element_offsets;
+    size_t* result_offsets;         /* Per element, into its worker's results */
+    int* result_workers;
+    Worker* workers;
+    int worker_count;
+    int chunk;
+    
+    pthread_mutex_t error_lock;
+    int failed;                     /* Read and set atomically */
+    char error[256];
+};
+
+int parallel_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count < 1 ? 1 : (int)count;
+}
+
+/* ============ Scheduling ============ */
+
+static bool claim_chunk(Worker* worker, int* begin, int* end) {
+    WorkRange* range = &worker->range;
+    pthread_mutex_lock(&range->lock);
+    bool claimed = range->next < range->end;
+    if (claimed) {
+        *begin = range->next;
+        *end = range->end - range->next > worker->job->chunk
+            ? range->next + worker->job->chunk
+            : range->end;
+        range->next = *end;
+    }
+    pthread_mutex_unlock(&range->lock);
+    return claimed;
+}
+
+/* Move the back half of another worker's range into this one */
+static bool steal_range(Worker* thief) {
+    ParallelJob* job = thief->job;
+    
+    for (int k = 1; k < job->worker_count; k++) {
+        Worker* victim = &job->workers[(thief->id + k) % job->worker_count];
+        WorkRange* range = &victim->range;
+        
+        pthread_mutex_lock(&range->lock);
+        int remaining = range->end - range->next;
+        if (remaining <= 0) {
+            pthread_mutex_unlock(&range->lock);
+            continue;
+        }
+        int begin = range->end - (remaining + 1) / 2;
+        int end = range->end;
+        range->end = begin;
+        pthread_mutex_unlock(&range->lock);
+        
+        pthread_mutex_lock(&thief->range.lock);
+        thief->range.next = begin;
+        thief->range.end = end;
+        pthread_mutex_unlock(&thief->range.lock);
+        return true;
+    }
+    return false;
+}
+
+static void fail(ParallelJob* job, const char* message) {
+    pthread_mutex_lock(&job->error_lock);
+    if (!job->failed) {
+        snprintf(job->error, sizeof(job->error), "%s", message);
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&job->error_lock);
+}
+
+static bool has_failed(ParallelJob* job) {
+    return __atomic_load_n(&job->failed, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* ============ Workers ============ */
+
+static void* worker_main(void* arg) {
+    Worker* worker = arg;
+    ParallelJob* job = worker->job;
+    
+    Interpreter interp;
+    interp_init(&interp);
+    Value fn = clone_read(job->module, 0, interp.global);
+    
+    int begin, end;
+    while (!has_failed(job)) {
+        if (!claim_chunk(worker, &begin, &end)) {
+            if (!steal_range(worker)) break;
+            continue;
+        }
+        
+        for (int i = begin; i < end && !has_failed(job); i++) {
+            Value element = clone_read(job->elements, job->element_offsets[i],
+                                       interp.global);
+            Value result = brisk_call(&interp, fn, 1, &element);
+            
+            char message[256];
+            if (interp.had_error) {
+                snprintf(message, sizeof(message), "function failed on element %d", i);
+                fail(job, message);
+            } else {
+                job->result_workers[i] = worker->id;
+                job->result_offsets[i] = worker->results.length;
+                if (!clone_write(&worker->results, result, interp.global, false,
+                                 message, sizeof(message))) {
+                    fail(job, message);
+                }
+            }
+            if (IS_OBJ(element)) obj_decref(AS_OBJ(element));
+        }
+    }
+    
+    if (IS_OBJ(fn)) obj_decref(AS_OBJ(fn));
+    interp_destroy(&interp);
+    return NULL;
+}
+
+/* ============ Driver ============ */
+
+bool parallel_map(Interpreter* interp, Value fn, ObjArray* array, int workers,
+                  Value* out, char* error, int error_size) {
+    int count = array->count;
+    if (workers > count) workers = count;
+    if (workers > PARALLEL_MAX_WORKERS) workers = PARALLEL_MAX_WORKERS;
+    
+    ObjArray* result = array_create();
+    if (count == 0) {
+        *out = OBJ_VAL(result);
+        return true;
+    }
+    
+    /* Everything the workers read is serialized before any of them start */
+    CloneBuffer module;
+    CloneBuffer elements;
+    clone_buffer_init(&module);
+    clone_buffer_init(&elements);
+    size_t* element_offsets = mem_alloc(sizeof(size_t) * count);
+    
+    bool ok = clone_write(&module, fn, interp->global, true, error, error_size);
+    for (int i = 0; ok && i < count; i++) {
+        element_offsets[i] = elements.length;
+        ok = clone_write(&elements, array->elements[i], interp->global, false,
+                         error, error_size);
+    }
+    
+    ParallelJob job;
+    job.module = &module;
+    job.elements = &elements;
+    job.element_offsets = element_offsets;
+    job.result_offsets = mem_alloc(sizeof(size_t) * count);
+    job.result_workers = mem_alloc(sizeof(int) * count);
+    job.workers = mem_alloc(sizeof(Worker) * workers);
+    job.worker_count = workers;
+    job.failed = 0;
+    job.error[0] = '\0';
+    pthread_mutex_init(&job.error_lock, NULL);
+    
+    /* Small chunks balance better, large ones touch the locks less */
+    job.chunk = count / (workers * 8);
+    if (job.chunk < 1) job.chunk = 1;
+    if (job.chunk > 1024) job.chunk = 1024;
+    
+    for (int i = 0; i < workers; i++) {
+        Worker* worker = &job.workers[i];
+        worker->job = &job;
+        worker->id = i;
+        pthread_mutex_init(&worker->range.lock, NULL);
+        worker->range.next = (int)((int64_t)count * i / workers);
+        worker->range.end = (int)((int64_t)count * (i + 1) / workers);
+        clone_buffer_init(&worker->results);
+    }
+    
+    int started = 0;
+    for (int i = 0; ok && i < workers; i++) {
+        if (pthread_create(&job.workers[i].thread, NULL, worker_main, &job.workers[i]) != 0) {
+            /* Threads already running pick up the rest by stealing */
+            if (i == 0) {
+                snprintf(error, error_size, "could not start a worker thread");
+                ok = false;
+            }
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(job.workers[i].thread, NULL);
+    }
+    
+    if (ok && job.failed) {
+        snprintf(error, error_size, "%s", job.error);
+        ok = false;
+    }
+    
+    if (ok) {
+        array_reserve(result, count);
+        for (int i = 0; i < count; i++) {
+            Worker* worker = &job.workers[job.result_workers[i]];
+            Value value = clone_read(&worker->results, job.result_offsets[i],
+                                     interp->global);
+            array_push(result, value);
+            if (IS_OBJ(value)) obj_decref(AS_OBJ(value));
+        }
+        *out = OBJ_VAL(result);
+    } else {
+        obj_decref((Object*)result);
+    }
+    
+    for (int i = 0; i < workers; i++) {
+        pthread_mutex_destroy(&job.workers[i].range.lock);
+        clone_buffer_free(&job.workers[i].results);
+    }
+    pthread_mutex_destroy(&job.error_lock);
+    mem_free(job.workers, sizeof(Worker) * workers);
+    mem_free(job.result_workers, sizeof(int) * count);
+    mem_free(job.result_offsets, sizeof(size_t) * count);
+    mem_free(element_offsets, sizeof(size_t) * count);
+    clone_buffer_free(&elements);
+    clone_buffer_free(&module);
+    return ok;
+}
+
+/* ============ Threads ============ */
+
+/* Shared by the handle and the running thread; freed by whichever lets
+   go last */
+struct ThreadState {
+    int ref_count;
+    pthread_t thread;
+    CloneBuffer module;     /* The function and its globals */
+    CloneBuffer args;
+    CloneBuffer result;
+    bool failed;
+    char error[256];
+};
+
+static int threads_running = 0;
+
+static void thread_state_release(ThreadState* state) {
+    if (__atomic_sub_fetch(&state->ref_count, 1, __ATOMIC_ACQ_REL) > 0) return;
+    clone_buffer_free(&state->module);
+    clone_buffer_free(&state->args);
+    clone_buffer_free(&state->result);
+    free(state);
+}
+
+static void* thread_main(void* arg) {
+    ThreadState* state = arg;
+    
+    Interpreter interp;
+    interp_init(&interp);
+    Value fn = clone_read(&state->module, 0, interp.global);
+    Value args = clone_read(&state->args, 0, interp.global);
+    
+    ObjArray* list = AS_ARRAY(args);
+    Value result = brisk_call(&interp, fn, list->count, list->elements);
+    if (interp.had_error) {
+        snprintf(state->error, sizeof(state->error), "thread function failed");
+        state->failed = true;
+    } else if (!clone_write(&state->result, result, interp.global, false,
+                            state->error, sizeof(state->error))) {
+        state->failed = true;
+    }
+    
+    obj_decref(AS_OBJ(args));
+    if (IS_OBJ(fn)) obj_decref(AS_OBJ(fn));
+    interp_destroy(&interp);
+    
+    __atomic_sub_fetch(&threads_running, 1, __ATOMIC_RELEASE);
+    thread_state_release(state);
+    return NULL;
+}
+
+ObjThread* thread_start(Interpreter* interp, Value fn, int arg_count, Value* args,
+                        char* error, int error_size) {
+    ThreadState* state = malloc(sizeof(ThreadState));
+    if (state == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    state->ref_count = 2;
+    state->failed = false;
+    state->error[0] = '\0';
+    clone_buffer_init(&state->module);
+    clone_buffer_init(&state->args);
+    clone_buffer_init(&state->result);
+    
+    ObjArray* list = array_create();
+    for (int i = 0; i < arg_count; i++) {
+        array_push(list, args[i]);
+    }
+    bool ok = clone_write(&state->module, fn, interp->global, true, error, error_size) &&
+              clone_write(&state->args, OBJ_VAL(list), interp->global, false,
+                          error, error_size);
+    obj_decref((Object*)list);
+    
+    if (ok) {
+        __atomic_add_fetch(&threads_running, 1, __ATOMIC_ACQUIRE);
+        if (pthread_create(&state->thread, NULL, thread_main, state) != 0) {
+            __atomic_sub_fetch(&threads_running, 1, __ATOMIC_RELEASE);
+            snprintf(error, error_size, "could not start a thread");
+            ok = false;
+        }
+    }
+    if (!ok) {
+        state->ref_count = 1;
+        thread_state_release(state);
+        return NULL;
+    }
+    
+    ObjThread* thread = (ObjThread*)allocate_object(sizeof(ObjThread), OBJ_THREAD);
+    thread->state = state;
+    thread->joined = false;
+    thread->result = NIL_VAL;
+    return thread;
+}
+
+bool thread_join(Interpreter* interp, ObjThread* thread, Value* out,
+                 char* error, int error_size) {
+    ThreadState* state = thread->state;
+    if (!thread->joined) {
+        pthread_join(state->thread, NULL);
+        thread->joined = true;
+        if (!state->failed) {
+            thread->result = clone_read(&state->result, 0, interp->global);
+        }
+    }
+    
+    if (state->failed) {
+        snprintf(error, error_size, "%s", state->error);
+        return false;
+    }
+    *out = thread->result;
+    return true;
+}
+
+void thread_free(ObjThread* thread) {
+    if (!thread->joined) pthread_detach(thread->state->thread);
+    if (IS_OBJ(thread->result)) obj_decref(AS_OBJ(thread->result));
+    thread_state_release(thread->state);
+}
+
+bool thread_any_running(void) {
+    return __atomic_load_n(&threads_running, __ATOMIC_ACQUIRE) > 0;
+}
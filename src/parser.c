@@ -8,6 +8,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include "parser.h"
+#include "numconv.h"
 
 /* Precedence levels */
 typedef enum {
@@ -39,11 +40,12 @@ static AstNode* parse_expression(Parser* parser);
 static AstNode* parse_precedence(Parser* parser, Precedence precedence);
 static AstNode* parse_statement(Parser* parser);
 static AstNode* parse_block(Parser* parser);
-static ParseRule* get_rule(TokenType type);
+static const ParseRule* get_rule(TokenType type);
 
 /* Forward declarations for parse functions */
 static AstNode* parse_number(Parser* parser);
 static AstNode* parse_string(Parser* parser);
+static AstNode* parse_fstring(Parser* parser);
 static AstNode* parse_literal(Parser* parser);
 static AstNode* parse_identifier(Parser* parser);
 static AstNode* parse_grouping(Parser* parser);
@@ -144,6 +146,7 @@ static void synchronize(Parser* parser) {
             case TOKEN_RETURN:
             case TOKEN_MATCH:
             case TOKEN_DEFER:
+            case TOKEN_YIELD:
                 return;
             default:
                 break;
@@ -153,71 +156,61 @@ static void synchronize(Parser* parser) {
     }
 }
 
-/* Parse rules table */
-static ParseRule rules[TOKEN_COUNT];
-
-static void init_rules(void) {
-    static bool initialized = false;
-    if (initialized) return;
-    initialized = true;
-    
-    /* Initialize all to NULL/NONE */
-    for (int i = 0; i < TOKEN_COUNT; i++) {
-        rules[i] = (ParseRule){NULL, NULL, PREC_NONE};
-    }
-    
+/* Parse rules table. Constant, so parsers on different threads can share
+   it; tokens not listed have no rule. */
+static const ParseRule rules[TOKEN_COUNT] = {
     /* Literals */
-    rules[TOKEN_INT] = (ParseRule){parse_number, NULL, PREC_NONE};
-    rules[TOKEN_FLOAT] = (ParseRule){parse_number, NULL, PREC_NONE};
-    rules[TOKEN_STRING] = (ParseRule){parse_string, NULL, PREC_NONE};
-    rules[TOKEN_TRUE] = (ParseRule){parse_literal, NULL, PREC_NONE};
-    rules[TOKEN_FALSE] = (ParseRule){parse_literal, NULL, PREC_NONE};
-    rules[TOKEN_NIL] = (ParseRule){parse_literal, NULL, PREC_NONE};
+    [TOKEN_INT] = {parse_number, NULL, PREC_NONE},
+    [TOKEN_FLOAT] = {parse_number, NULL, PREC_NONE},
+    [TOKEN_STRING] = {parse_string, NULL, PREC_NONE},
+    [TOKEN_FSTRING] = {parse_fstring, NULL, PREC_NONE},
+    [TOKEN_TRUE] = {parse_literal, NULL, PREC_NONE},
+    [TOKEN_FALSE] = {parse_literal, NULL, PREC_NONE},
+    [TOKEN_NIL] = {parse_literal, NULL, PREC_NONE},
     
     /* Identifier */
-    rules[TOKEN_IDENTIFIER] = (ParseRule){parse_identifier, NULL, PREC_NONE};
+    [TOKEN_IDENTIFIER] = {parse_identifier, NULL, PREC_NONE},
     
     /* Grouping and collections */
-    rules[TOKEN_LPAREN] = (ParseRule){parse_grouping, parse_call, PREC_CALL};
-    rules[TOKEN_LBRACKET] = (ParseRule){parse_array, parse_index, PREC_CALL};
-    rules[TOKEN_LBRACE] = (ParseRule){parse_table, NULL, PREC_NONE};
+    [TOKEN_LPAREN] = {parse_grouping, parse_call, PREC_CALL},
+    [TOKEN_LBRACKET] = {parse_array, parse_index, PREC_CALL},
+    [TOKEN_LBRACE] = {parse_table, NULL, PREC_NONE},
     
     /* Unary */
-    rules[TOKEN_MINUS] = (ParseRule){parse_unary, parse_binary, PREC_TERM};
-    rules[TOKEN_NOT] = (ParseRule){parse_unary, NULL, PREC_NONE};
-    rules[TOKEN_BANG] = (ParseRule){parse_unary, NULL, PREC_NONE};
-    rules[TOKEN_AMPERSAND] = (ParseRule){parse_address_of, NULL, PREC_NONE};
+    [TOKEN_MINUS] = {parse_unary, parse_binary, PREC_TERM},
+    [TOKEN_NOT] = {parse_unary, NULL, PREC_NONE},
+    [TOKEN_BANG] = {parse_unary, NULL, PREC_NONE},
+    [TOKEN_AMPERSAND] = {parse_address_of, NULL, PREC_NONE},
     
     /* Binary operators */
-    rules[TOKEN_PLUS] = (ParseRule){NULL, parse_binary, PREC_TERM};
-    rules[TOKEN_STAR] = (ParseRule){NULL, parse_binary, PREC_FACTOR};
-    rules[TOKEN_SLASH] = (ParseRule){NULL, parse_binary, PREC_FACTOR};
-    rules[TOKEN_PERCENT] = (ParseRule){NULL, parse_binary, PREC_FACTOR};
+    [TOKEN_PLUS] = {NULL, parse_binary, PREC_TERM},
+    [TOKEN_STAR] = {NULL, parse_binary, PREC_FACTOR},
+    [TOKEN_SLASH] = {NULL, parse_binary, PREC_FACTOR},
+    [TOKEN_PERCENT] = {NULL, parse_binary, PREC_FACTOR},
     
     /* Comparison */
-    rules[TOKEN_EQEQ] = (ParseRule){NULL, parse_binary, PREC_EQUALITY};
-    rules[TOKEN_NEQ] = (ParseRule){NULL, parse_binary, PREC_EQUALITY};
-    rules[TOKEN_LT] = (ParseRule){NULL, parse_binary, PREC_COMPARISON};
-    rules[TOKEN_GT] = (ParseRule){NULL, parse_binary, PREC_COMPARISON};
-    rules[TOKEN_LTE] = (ParseRule){NULL, parse_binary, PREC_COMPARISON};
-    rules[TOKEN_GTE] = (ParseRule){NULL, parse_binary, PREC_COMPARISON};
+    [TOKEN_EQEQ] = {NULL, parse_binary, PREC_EQUALITY},
+    [TOKEN_NEQ] = {NULL, parse_binary, PREC_EQUALITY},
+    [TOKEN_LT] = {NULL, parse_binary, PREC_COMPARISON},
+    [TOKEN_GT] = {NULL, parse_binary, PREC_COMPARISON},
+    [TOKEN_LTE] = {NULL, parse_binary, PREC_COMPARISON},
+    [TOKEN_GTE] = {NULL, parse_binary, PREC_COMPARISON},
     
     /* Logical */
-    rules[TOKEN_AND] = (ParseRule){NULL, parse_binary, PREC_AND};
-    rules[TOKEN_OR] = (ParseRule){NULL, parse_binary, PREC_OR};
+    [TOKEN_AND] = {NULL, parse_binary, PREC_AND},
+    [TOKEN_OR] = {NULL, parse_binary, PREC_OR},
     
     /* Range */
-    rules[TOKEN_DOTDOT] = (ParseRule){NULL, parse_range, PREC_RANGE};
+    [TOKEN_DOTDOT] = {NULL, parse_range, PREC_RANGE},
     
     /* Field access */
-    rules[TOKEN_DOT] = (ParseRule){NULL, parse_field, PREC_CALL};
+    [TOKEN_DOT] = {NULL, parse_field, PREC_CALL},
     
     /* Function expression */
-    rules[TOKEN_FN] = (ParseRule){parse_fn_expr, NULL, PREC_NONE};
-}
+    [TOKEN_FN] = {parse_fn_expr, NULL, PREC_NONE},
+};
 
-static ParseRule* get_rule(TokenType type) {
-    init_rules();
+static const ParseRule* get_rule(TokenType type) {
     return &rules[type];
 }
 
@@ -226,8 +219,9 @@ void parser_init(Parser* parser, Lexer* lexer) {
     parser->lexer = lexer;
     parser->had_error = false;
     parser->panic_mode = false;
+    parser->function_depth = 0;
+    parser->saw_yield = false;
     
-    init_rules();
     advance(parser);
 }
 
@@ -236,36 +230,33 @@ static AstNode* parse_number(Parser* parser) {
     Token token = parser->previous;
     
     if (token.type == TOKEN_INT) {
-        /* Parse integer */
-        char* buf = malloc(token.length + 1);
-        int j = 0;
-        for (int i = 0; i < token.length; i++) {
-            if (token.start[i] != '_') {
-                buf[j++] = token.start[i];
-            }
+        /* Hex, leading-zero octal or decimal, parsed straight off the source */
+        int64_t value = 0;
+        if (!num_parse_int(token.start, token.length,
+                           NUM_SEPARATORS | NUM_C_PREFIXES, &value)) {
+            error(parser, "Invalid integer literal");
         }
-        buf[j] = '\0';
-        
-        int64_t value = strtoll(buf, NULL, 0); /* 0 = auto-detect hex/octal/decimal */
-        free(buf);
         return ast_int_literal(value, token.line, token.column);
     } else {
-        /* Parse float */
-        char* buf = malloc(token.length + 1);
-        int j = 0;
-        for (int i = 0; i < token.length; i++) {
-            if (token.start[i] != '_') {
-                buf[j++] = token.start[i];
-            }
+        double value = 0.0;
+        if (!num_parse_double(token.start, token.length, NUM_SEPARATORS, &value)) {
+            error(parser, "Invalid float literal");
         }
-        buf[j] = '\0';
-        
-        double value = strtod(buf, NULL);
-        free(buf);
         return ast_float_literal(value, token.line, token.column);
     }
 }
 
+/* Translate the character after a backslash */
+static char escape_char(char c) {
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case '0': return '\0';
+        default: return c;  /* \\, \" and unknown escapes */
+    }
+}
+
 /* Parse string literal */
 static AstNode* parse_string(Parser* parser) {
     Token token = parser->previous;
@@ -280,15 +271,7 @@ static AstNode* parse_string(Parser* parser) {
     for (int i = 0; i < length; i++) {
         if (start[i] == '\\' && i + 1 < length) {
             i++;
-            switch (start[i]) {
-                case 'n': buf[j++] = '\n'; break;
-                case 't': buf[j++] = '\t'; break;
-                case 'r': buf[j++] = '\r'; break;
-                case '\\': buf[j++] = '\\'; break;
-                case '"': buf[j++] = '"'; break;
-                case '0': buf[j++] = '\0'; break;
-                default: buf[j++] = start[i]; break;
-            }
+            buf[j++] = escape_char(start[i]);
         } else {
             buf[j++] = start[i];
         }
@@ -300,6 +283,202 @@ static AstNode* parse_string(Parser* parser) {
     return node;
 }
 
+/* Parse a format spec: [<|>][0][width][.precision][type] */
+static bool parse_format_spec(const char* spec, int length, FormatSpec* out) {
+    int i = 0;
+    
+    out->align = 0;
+    out->zero_pad = false;
+    out->width = 0;
+    out->precision = -1;
+    out->type = 0;
+    
+    if (i < length && (spec[i] == '<' || spec[i] == '>')) {
+        out->align = spec[i++];
+    }
+    if (i < length && spec[i] == '0') {
+        out->zero_pad = true;
+        i++;
+    }
+    while (i < length && spec[i] >= '0' && spec[i] <= '9') {
+        out->width = out->width * 10 + (spec[i++] - '0');
+        if (out->width > 1024) return false;
+    }
+    if (i < length && spec[i] == '.') {
+        i++;
+        if (i >= length || spec[i] < '0' || spec[i] > '9') return false;
+        out->precision = 0;
+        while (i < length && spec[i] >= '0' && spec[i] <= '9') {
+            out->precision = out->precision * 10 + (spec[i++] - '0');
+            if (out->precision > 100) return false;
+        }
+    }
+    if (i < length && strchr("dxXobfegs", spec[i]) != NULL) {
+        out->type = spec[i++];
+    }
+    
+    return i == length;
+}
+
+/* Parse one {expr} of an interpolated string with a sub-parser */
+static AstNode* parse_interp_expr(Parser* parser, const char* src, int length, int line) {
+    char* buf = malloc(length + 1);
+    memcpy(buf, src, length);
+    buf[length] = '\0';
+    
+    Lexer lexer;
+    Parser sub;
+    lexer_init(&lexer, buf);
+    lexer.line = line;
+    parser_init(&sub, &lexer);
+    
+    AstNode* expr = NULL;
+    if (check(&sub, TOKEN_EOF)) {
+        error(parser, "Empty expression in interpolated string");
+    } else {
+        expr = parse_expression(&sub);
+        if (!sub.had_error && !check(&sub, TOKEN_EOF)) {
+            error_at_current(&sub, "Expected '}' after interpolated expression");
+        }
+        if (sub.had_error) {
+            parser->had_error = true;
+            ast_free_tree(expr);
+            expr = NULL;
+        }
+    }
+    
+    free(buf);
+    return expr;
+}
+
+/* Find the '}' closing the expression that starts at src[i], and the
+   top-level ':' introducing its format spec (or -1) */
+static int find_interp_end(const char* src, int length, int i, int* colon) {
+    int depth = 0;
+    *colon = -1;
+    
+    for (; i < length; i++) {
+        char c = src[i];
+        if (c == '"') {
+            /* Skip a nested string literal */
+            for (i++; i < length && src[i] != '"'; i++) {
+                if (src[i] == '\\') i++;
+            }
+        } else if (c == '(' || c == '[' || c == '{') {
+            depth++;
+        } else if (c == ')' || c == ']') {
+            depth--;
+        } else if (c == '}') {
+            if (depth == 0) return i;
+            depth--;
+        } else if (c == ':' && depth == 0 && *colon < 0) {
+            *colon = i;
+        }
+    }
+    return -1;
+}
+
+/* Append a part to an interpolated string under construction */
+static void add_interp_part(InterpPart** parts, int* count, int* capacity, InterpPart part) {
+    if (*count >= *capacity) {
+        *capacity = *capacity < 8 ? 8 : *capacity * 2;
+        *parts = realloc(*parts, sizeof(InterpPart) * *capacity);
+    }
+    (*parts)[(*count)++] = part;
+}
+
+/* Move pending literal text into its own part */
+static void flush_interp_literal(InterpPart** parts, int* count, int* capacity,
+                                 const char* literal, int* literal_length) {
+    if (*literal_length == 0) return;
+    
+    InterpPart part;
+    memset(&part, 0, sizeof(InterpPart));
+    part.literal = malloc(*literal_length + 1);
+    memcpy(part.literal, literal, *literal_length);
+    part.literal[*literal_length] = '\0';
+    part.literal_length = *literal_length;
+    add_interp_part(parts, count, capacity, part);
+    *literal_length = 0;
+}
+
+/* Parse interpolated string f"..." into literal and expression parts.
+   Splitting and format specs are resolved here so evaluation only has
+   to format values into one result buffer. */
+static AstNode* parse_fstring(Parser* parser) {
+    Token token = parser->previous;
+    
+    /* Skip f" and the closing quote */
+    const char* start = token.start + 2;
+    int length = token.length - 3;
+    
+    InterpPart* parts = NULL;
+    int count = 0;
+    int capacity = 0;
+    bool has_expr = false;
+    char* literal = malloc(length + 1);
+    int literal_length = 0;
+    
+    int i = 0;
+    while (i < length) {
+        char c = start[i];
+        
+        if ((c == '{' || c == '}') && i + 1 < length && start[i + 1] == c) {
+            literal[literal_length++] = c;
+            i += 2;
+            continue;
+        }
+        if (c == '}') {
+            error(parser, "Single '}' in interpolated string");
+            break;
+        }
+        if (c == '\\' && i + 1 < length) {
+            literal[literal_length++] = escape_char(start[i + 1]);
+            i += 2;
+            continue;
+        }
+        if (c != '{') {
+            literal[literal_length++] = c;
+            i++;
+            continue;
+        }
+        
+        /* Expression part */
+        int colon;
+        int end = find_interp_end(start, length, i + 1, &colon);
+        if (end < 0) {
+            error(parser, "Unterminated '{' in interpolated string");
+            break;
+        }
+        
+        int expr_end = colon >= 0 ? colon : end;
+        InterpPart part;
+        memset(&part, 0, sizeof(InterpPart));
+        if (!parse_format_spec(start + expr_end + 1, colon >= 0 ? end - colon - 1 : 0, &part.spec)) {
+            error(parser, "Invalid format spec in interpolated string");
+            break;
+        }
+        part.expr = parse_interp_expr(parser, start + i + 1, expr_end - i - 1, token.line);
+        if (part.expr == NULL) break;
+        
+        flush_interp_literal(&parts, &count, &capacity, literal, &literal_length);
+        add_interp_part(&parts, &count, &capacity, part);
+        has_expr = true;
+        i = end + 1;
+    }
+    
+    /* No expressions: fold to a plain string literal */
+    if (!has_expr) {
+        AstNode* node = ast_string_literal(literal, literal_length, token.line, token.column);
+        free(literal);
+        return node;
+    }
+    
+    flush_interp_literal(&parts, &count, &capacity, literal, &literal_length);
+    free(literal);
+    return ast_interp(parts, count, token.line, token.column);
+}
+
 /* Parse true/false/nil */
 static AstNode* parse_literal(Parser* parser) {
     Token token = parser->previous;
@@ -349,7 +528,7 @@ static AstNode* parse_address_of(Parser* parser) {
 static AstNode* parse_binary(Parser* parser, AstNode* left) {
     Token op = parser->previous;
     
-    ParseRule* rule = get_rule(op.type);
+    const ParseRule* rule = get_rule(op.type);
     AstNode* right = parse_precedence(parser, (Precedence)(rule->precedence + 1));
     
     return ast_binary(op.type, left, right, op.line, op.column);
@@ -525,16 +704,26 @@ static AstNode* parse_fn_expr(Parser* parser) {
         advance(parser);
     }
     
-    /* Parse body */
+    /* Parse body; a yield anywhere in it (but not in nested functions)
+       makes this a generator */
     consume(parser, TOKEN_LBRACE, "Expected '{' before function body");
+    bool outer_saw_yield = parser->saw_yield;
+    parser->saw_yield = false;
+    parser->function_depth++;
     AstNode* body = parse_block(parser);
+    parser->function_depth--;
+    bool is_generator = parser->saw_yield;
+    parser->saw_yield = outer_saw_yield;
     
     if (name) {
         AstNode* node = ast_fn_decl(name, name_len, params, param_lens, param_count, body, token.line, token.column);
+        if (node) node->as.fn_decl.is_generator = is_generator;
         free(name);
         return node;
     } else {
-        return ast_lambda(params, param_lens, param_count, body, token.line, token.column);
+        AstNode* node = ast_lambda(params, param_lens, param_count, body, token.line, token.column);
+        if (node) node->as.lambda.is_generator = is_generator;
+        return node;
     }
 }
 
@@ -651,6 +840,23 @@ static AstNode* parse_return(Parser* parser) {
     return ast_return(value, token.line, token.column);
 }
 
+/* Parse yield statement */
+static AstNode* parse_yield(Parser* parser) {
+    Token token = parser->previous;
+    
+    if (parser->function_depth == 0) {
+        error(parser, "Can't yield outside a function");
+    }
+    parser->saw_yield = true;
+    
+    AstNode* value = NULL;
+    if (!check(parser, TOKEN_RBRACE) && !check(parser, TOKEN_NEWLINE) && !check(parser, TOKEN_EOF)) {
+        value = parse_expression(parser);
+    }
+    
+    return ast_yield(value, token.line, token.column);
+}
+
 /* Parse match statement */
 static AstNode* parse_match(Parser* parser) {
     Token token = parser->previous;
@@ -794,6 +1000,10 @@ static AstNode* parse_statement(Parser* parser) {
         return parse_return(parser);
     }
     
+    if (match(parser, TOKEN_YIELD)) {
+        return parse_yield(parser);
+    }
+    
     if (match(parser, TOKEN_BREAK)) {
         return ast_break(parser->previous.line, parser->previous.column);
     }
@@ -0,0 +1,218 @@
+/*
+ * Brisk Language - Work-Stealing Pool Implementation
+ * Every pool thread owns a deque of ranges. A thread splits its range in
+ * half, pushes the upper half on its own deque and keeps going with the
+ * lower, so it works depth-first from the bottom while idle threads steal
+ * the big early pieces from the top. Threads from outside the pool share
+ * one extra deque.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pool.h"
+
+typedef struct {
+    PoolFn fn;
+    void* context;
+    int64_t grain;
+    int64_t remaining;      /* Elements not yet done, updated atomically */
+} PoolJob;
+
+typedef struct {
+    PoolJob* job;
+    int64_t begin;
+    int64_t end;
+} PoolTask;
+
+/* Owner pushes and pops at the tail, thieves take from the head */
+typedef struct {
+    pthread_mutex_t lock;
+    PoolTask* tasks;
+    int head;
+    int tail;
+    int capacity;
+} Deque;
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static int pool_threads = 0;    /* Helper threads besides callers */
+static Deque* deques;           /* [0] is shared by outside threads */
+
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleep_cond = PTHREAD_COND_INITIALIZER;
+static int sleepers = 0;
+static int64_t queued = 0;      /* Tasks sitting in any deque */
+
+/* Deque of the current thread; 0 for threads outside the pool */
+static __thread int pool_index = 0;
+
+/* ============ Deques ============ */
+
+static void deque_push(Deque* deque, PoolTask task) {
+    pthread_mutex_lock(&deque->lock);
+    if (deque->tail == deque->capacity) {
+        int live = deque->tail - deque->head;
+        if (deque->head > 0) {
+            /* Slide down instead of growing when thieves emptied the front */
+            memmove(deque->tasks, deque->tasks + deque->head, sizeof(PoolTask) * live);
+        }
+        if (live == deque->capacity) {
+            deque->capacity = deque->capacity < 8 ? 8 : deque->capacity * 2;
+            deque->tasks = realloc(deque->tasks, sizeof(PoolTask) * deque->capacity);
+            if (deque->tasks == NULL) {
+                fprintf(stderr, "Fatal: Out of memory\n");
+                exit(1);
+            }
+        }
+        deque->head = 0;
+        deque->tail = live;
+    }
+    deque->tasks[deque->tail++] = task;
+    pthread_mutex_unlock(&deque->lock);
+}
+
+static bool deque_take(Deque* deque, PoolTask* task, bool steal) {
+    pthread_mutex_lock(&deque->lock);
+    bool taken = deque->head < deque->tail;
+    if (taken) {
+        *task = steal ? deque->tasks[deque->head++] : deque->tasks[--deque->tail];
+        if (deque->head == deque->tail) {
+            deque->head = 0;
+            deque->tail = 0;
+        }
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return taken;
+}
+
+/* ============ Scheduling ============ */
+
+static void publish(PoolTask task) {
+    deque_push(&deques[pool_index], task);
+    __atomic_add_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+    
+    /* A sleeper registers before its last look at queued, so one of the
+       two always sees the other */
+    if (__atomic_load_n(&sleepers, __ATOMIC_SEQ_CST) > 0) {
+        pthread_mutex_lock(&sleep_lock);
+        pthread_cond_signal(&sleep_cond);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+}
+
+/* Own deque first (newest piece), then the oldest piece of any other */
+static bool find_task(PoolTask* task) {
+    int self = pool_index;
+    int count = __atomic_load_n(&pool_threads, __ATOMIC_ACQUIRE) + 1;
+    bool found = deque_take(&deques[self], task, false);
+    for (int k = 1; !found && k < count; k++) {
+        found = deque_take(&deques[(self + k) % count], task, true);
+    }
+    if (found) __atomic_sub_fetch(&queued, 1, __ATOMIC_SEQ_CST);
+    return found;
+}
+
+static void run_task(PoolTask task) {
+    PoolJob* job = task.job;
+    while (task.end - task.begin > job->grain) {
+        int64_t mid = task.begin + (task.end - task.begin) / 2;
+        PoolTask upper = {job, mid, task.end};
+        publish(upper);
+        task.end = mid;
+    }
+    
+    job->fn(job->context, task.begin, task.end);
+    __atomic_sub_fetch(&job->remaining, task.end - task.begin, __ATOMIC_RELEASE);
+}
+
+static void* pool_main(void* arg) {
+    pool_index = (int)(intptr_t)arg;
+    
+    for (;;) {
+        PoolTask task;
+        if (find_task(&task)) {
+            run_task(task);
+            continue;
+        }
+        
+        pthread_mutex_lock(&sleep_lock);
+        __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&queued, __ATOMIC_SEQ_CST) <= 0) {
+            pthread_cond_wait(&sleep_cond, &sleep_lock);
+        }
+        __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+    return NULL;
+}
+
+/* ============ Pool ============ */
+
+static void pool_start(void) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* setting = getenv("BRISK_THREADS");
+    if (setting != NULL && *setting != '\0') {
+        char* end;
+        long requested = strtol(setting, &end, 10);
+        if (*end == '\0' && requested >= 1) {
+            threads = requested;
+        } else {
+            fprintf(stderr, "Warning: ignoring BRISK_THREADS=%s (expected a positive integer)\n",
+                    setting);
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+    
+    /* One deque per helper thread plus the shared one; they live as long
+       as the process */
+    deques = calloc(threads, sizeof(Deque));
+    if (deques == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    for (long i = 0; i < threads; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+    }
+    
+    /* The caller is the first of the threads */
+    for (long i = 1; i < threads; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, pool_main, (void*)(intptr_t)i) != 0) break;
+        pthread_detach(thread);
+        __atomic_add_fetch(&pool_threads, 1, __ATOMIC_RELEASE);
+    }
+}
+
+int pool_size(void) {
+    pthread_once(&pool_once, pool_start);
+    return __atomic_load_n(&pool_threads, __ATOMIC_ACQUIRE) + 1;
+}
+
+void pool_for(int64_t count, int64_t grain, PoolFn fn, void* context) {
+    if (grain < 1) grain = 1;
+    if (count <= grain || pool_size() == 1) {
+        if (count > 0) fn(context, 0, count);
+        return;
+    }
+    
+    PoolJob job = {fn, context, grain, count};
+    PoolTask root = {&job, 0, count};
+    run_task(root);
+    
+    /* Help with whatever is queued, ours or not, until our pieces are in */
+    while (__atomic_load_n(&job.remaining, __ATOMIC_ACQUIRE) > 0) {
+        PoolTask task;
+        if (find_task(&task)) {
+            run_task(task);
+        } else {
+            sched_yield();
+        }
+    }
+}
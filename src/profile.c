@@ -0,0 +1,438 @@
+/*
+ * Brisk Language - Sampling Profiler Implementation
+ * A timer on the script thread's CPU clock raises SIGPROF, and the handler
+ * walks the interpreter's CallFrame chain. It cannot allocate or lock, so
+ * functions, (function, line) sites and whole stacks are counted in fixed
+ * open-addressed tables made up front. Nothing is formatted until the
+ * script is done.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "profile.h"
+
+/* Older glibc only has the kernel's name for the target thread */
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#define PROFILE_MAX_DEPTH 256       /* Innermost frames kept per sample */
+#define PROFILE_FUNCTIONS 4096
+#define PROFILE_SITES 16384
+#define PROFILE_STACKS 16384
+#define PROFILE_SLOTS (1 << 20)     /* Site ids of every distinct stack */
+#define PROFILE_NAMES (1 << 16)     /* Bytes of function names */
+#define PROFILE_TOP 10              /* Rows in each summary table */
+
+#define NO_ENTRY UINT32_MAX
+
+typedef struct {
+    uint32_t name;          /* Offset in names; NO_ENTRY if anonymous */
+    int def_line;
+    uint32_t hash;
+    bool used;
+} ProfileFunction;
+
+typedef struct {
+    uint32_t function;
+    int line;
+    uint32_t hash;
+    bool used;
+} ProfileSite;
+
+typedef struct {
+    uint32_t first;         /* Offset in slots, innermost frame first */
+    int depth;
+    uint64_t count;
+    uint32_t hash;
+    bool used;
+} ProfileStack;
+
+typedef struct {
+    const char* path;
+    int rate;
+    FILE* file;
+    Interpreter* interp;
+    timer_t timer;
+    bool timing;            /* The timer exists */
+    volatile sig_atomic_t active;
+    
+    ProfileFunction* functions;
+    ProfileSite* sites;
+    ProfileStack* stacks;
+    uint32_t* slots;
+    char* names;
+    uint32_t function_count;
+    uint32_t site_count;
+    uint32_t stack_count;
+    uint32_t slot_count;
+    uint32_t name_length;
+    
+    uint64_t samples;
+    uint64_t dropped;       /* Did not fit in the tables */
+    uint64_t truncated;     /* Deeper than PROFILE_MAX_DEPTH */
+} Profile;
+
+static Profile profile;
+
+void profile_configure(const char* path, int rate) {
+    profile.path = path;
+    profile.rate = rate > 0 ? rate : PROFILE_DEFAULT_RATE;
+}
+
+/* ============ Sampling ============ */
+
+static uint32_t hash_mix(uint32_t hash, uint32_t value) {
+    return (hash ^ value) * 16777619u;
+}
+
+/* Tables stay at most three quarters full so probes stay short */
+static bool table_full(uint32_t count, uint32_t capacity) {
+    return count >= capacity / 4 * 3;
+}
+
+static bool same_name(uint32_t stored, const char* name) {
+    if (stored == NO_ENTRY || name == NULL) return stored == NO_ENTRY && name == NULL;
+    return strcmp(profile.names + stored, name) == 0;
+}
+
+static uint32_t intern_function(const char* name, int def_line) {
+    uint32_t hash = hash_mix(2166136261u, (uint32_t)def_line);
+    size_t length = 0;
+    if (name != NULL) {
+        for (; name[length] != '\0'; length++) {
+            hash = hash_mix(hash, (unsigned char)name[length]);
+        }
+    }
+    
+    uint32_t mask = PROFILE_FUNCTIONS - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        ProfileFunction* function = &profile.functions[i];
+        if (function->used) {
+            if (function->hash == hash && function->def_line == def_line &&
+                same_name(function->name, name)) {
+                return i;
+            }
+            continue;
+        }
+        
+        if (table_full(profile.function_count, PROFILE_FUNCTIONS)) return NO_ENTRY;
+        function->name = NO_ENTRY;
+        if (name != NULL) {
+            if (profile.name_length + length + 1 > PROFILE_NAMES) return NO_ENTRY;
+            function->name = profile.name_length;
+            memcpy(profile.names + profile.name_length, name, length + 1);
+            profile.name_length += (uint32_t)length + 1;
+        }
+        function->def_line = def_line;
+        function->hash = hash;
+        function->used = true;
+        profile.function_count++;
+        return i;
+    }
+}
+
+static uint32_t intern_site(uint32_t function, int line) {
+    uint32_t hash = hash_mix(hash_mix(2166136261u, function), (uint32_t)line);
+    uint32_t mask = PROFILE_SITES - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        ProfileSite* site = &profile.sites[i];
+        if (site->used) {
+            if (site->function == function && site->line == line) return i;
+            continue;
+        }
+        
+        if (table_full(profile.site_count, PROFILE_SITES)) return NO_ENTRY;
+        site->function = function;
+        site->line = line;
+        site->hash = hash;
+        site->used = true;
+        profile.site_count++;
+        return i;
+    }
+}
+
+static bool count_stack(const uint32_t* ids, int depth, uint64_t weight) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < depth; i++) hash = hash_mix(hash, ids[i]);
+    
+    uint32_t mask = PROFILE_STACKS - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        ProfileStack* stack = &profile.stacks[i];
+        if (stack->used) {
+            if (stack->hash == hash && stack->depth == depth &&
+                memcmp(profile.slots + stack->first, ids, sizeof(uint32_t) * depth) == 0) {
+                stack->count += weight;
+                return true;
+            }
+            continue;
+        }
+        
+        if (table_full(profile.stack_count, PROFILE_STACKS) ||
+            profile.slot_count + depth > PROFILE_SLOTS) {
+            return false;
+        }
+        memcpy(profile.slots + profile.slot_count, ids, sizeof(uint32_t) * depth);
+        stack->first = profile.slot_count;
+        stack->depth = depth;
+        stack->count = weight;
+        stack->hash = hash;
+        stack->used = true;
+        profile.slot_count += depth;
+        profile.stack_count++;
+        return true;
+    }
+}
+
+/* Runs on the script thread between any two of its instructions, so it
+   only reads the frame chain and writes tables nothing else touches */
+static void profile_signal(int signal_number) {
+    (void)signal_number;
+    if (!profile.active) return;
+    
+    /* CPU timers fire on scheduler ticks, so one signal may stand for
+       several intervals; weighting by the overrun keeps the counts true */
+    int overrun = timer_getoverrun(profile.timer);
+    uint64_t weight = 1 + (overrun > 0 ? (uint64_t)overrun : 0);
+    
+    uint32_t ids[PROFILE_MAX_DEPTH];
+    int depth = 0;
+    const CallFrame* frame = profile.interp->frame;
+    for (; frame != NULL && depth < PROFILE_MAX_DEPTH; frame = frame->caller) {
+        uint32_t function = intern_function(frame->name, frame->def_line);
+        uint32_t site = function == NO_ENTRY ? NO_ENTRY : intern_site(function, frame->line);
+        if (site == NO_ENTRY) {
+            profile.samples += weight;
+            profile.dropped += weight;
+            return;
+        }
+        ids[depth++] = site;
+    }
+    
+    profile.samples += weight;
+    if (frame != NULL) profile.truncated += weight;
+    if (!count_stack(ids, depth, weight)) profile.dropped += weight;
+}
+
+static void* table_alloc(size_t count, size_t size) {
+    void* table = calloc(count, size);
+    if (table == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    return table;
+}
+
+bool profile_start(Interpreter* interp) {
+    if (profile.path == NULL) return true;
+    
+    profile.file = fopen(profile.path, "w");
+    if (profile.file == NULL) {
+        fprintf(stderr, "Error: Could not open profile output '%s'\n", profile.path);
+        return false;
+    }
+    
+    profile.functions = table_alloc(PROFILE_FUNCTIONS, sizeof(ProfileFunction));
+    profile.sites = table_alloc(PROFILE_SITES, sizeof(ProfileSite));
+    profile.stacks = table_alloc(PROFILE_STACKS, sizeof(ProfileStack));
+    profile.slots = table_alloc(PROFILE_SLOTS, sizeof(uint32_t));
+    profile.names = table_alloc(PROFILE_NAMES, 1);
+    profile.interp = interp;
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+    
+    /* Only this thread's CPU time counts, and only this thread is
+       interrupted: workers and blocking waits are not sampled */
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &profile.timer) != 0) {
+        fprintf(stderr, "Warning: could not start the profiling timer\n");
+        return true;
+    }
+    
+    long interval_ns = 1000000000L / profile.rate;
+    struct itimerspec interval;
+    interval.it_interval.tv_sec = interval_ns / 1000000000L;
+    interval.it_interval.tv_nsec = interval_ns % 1000000000L;
+    interval.it_value = interval.it_interval;
+    profile.timing = true;
+    profile.active = 1;
+    timer_settime(profile.timer, 0, &interval, NULL);
+    return true;
+}
+
+/* ============ Reporting ============ */
+
+static void write_function(FILE* out, uint32_t index) {
+    const ProfileFunction* function = &profile.functions[index];
+    if (function->name != NO_ENTRY) {
+        fputs(profile.names + function->name, out);
+    } else {
+        fprintf(out, "<fn@%d>", function->def_line);
+    }
+}
+
+/* Natives have no line of their own */
+static void write_site(FILE* out, uint32_t index) {
+    const ProfileSite* site = &profile.sites[index];
+    write_function(out, site->function);
+    if (site->line > 0) fprintf(out, ":%d", site->line);
+}
+
+/* Orders indices by descending count for qsort */
+static const uint64_t* sort_counts;
+
+static int compare_counts(const void* a, const void* b) {
+    uint64_t x = sort_counts[*(const uint32_t*)a];
+    uint64_t y = sort_counts[*(const uint32_t*)b];
+    if (x != y) return x < y ? 1 : -1;
+    return *(const uint32_t*)a < *(const uint32_t*)b ? -1 : 1;
+}
+
+/* Indices with a nonzero count, most first; returns how many */
+static uint32_t rank(const uint64_t* counts, uint32_t capacity, uint32_t* order) {
+    uint32_t length = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (counts[i] > 0) order[length++] = i;
+    }
+    sort_counts = counts;
+    qsort(order, length, sizeof(uint32_t), compare_counts);
+    return length;
+}
+
+/* One line per stack, outermost frame first: the collapsed format that
+   flamegraph.pl, speedscope and inferno read */
+static void write_folded(FILE* out) {
+    uint64_t* counts = table_alloc(PROFILE_STACKS, sizeof(uint64_t));
+    uint32_t* order = table_alloc(PROFILE_STACKS, sizeof(uint32_t));
+    for (uint32_t i = 0; i < PROFILE_STACKS; i++) {
+        if (profile.stacks[i].used) counts[i] = profile.stacks[i].count;
+    }
+    
+    uint32_t length = rank(counts, PROFILE_STACKS, order);
+    for (uint32_t i = 0; i < length; i++) {
+        const ProfileStack* stack = &profile.stacks[order[i]];
+        for (int d = stack->depth - 1; d >= 0; d--) {
+            write_site(out, profile.slots[stack->first + d]);
+            if (d > 0) fputc(';', out);
+        }
+        fprintf(out, " %llu\n", (unsigned long long)stack->count);
+    }
+    
+    free(counts);
+    free(order);
+}
+
+static void print_table(const char* title, const uint64_t* self, const uint64_t* total,
+                        uint32_t capacity, uint64_t recorded, bool sites) {
+    uint32_t* order = table_alloc(capacity, sizeof(uint32_t));
+    uint32_t length = rank(self, capacity, order);
+    if (length > PROFILE_TOP) length = PROFILE_TOP;
+    
+    fprintf(stderr, "\n%s\n", title);
+    for (uint32_t i = 0; i < length; i++) {
+        uint32_t index = order[i];
+        fprintf(stderr, "  %6.1f%%", 100.0 * (double)self[index] / (double)recorded);
+        if (total != NULL) {
+            fprintf(stderr, "  %6.1f%%", 100.0 * (double)total[index] / (double)recorded);
+        }
+        fputs("  ", stderr);
+        if (sites) {
+            write_site(stderr, index);
+        } else {
+            write_function(stderr, index);
+        }
+        fputc('\n', stderr);
+    }
+    free(order);
+}
+
+static void print_summary(void) {
+    uint64_t recorded = profile.samples - profile.dropped;
+    fprintf(stderr, "\nProfile: %llu samples, one per %.2f ms of CPU time, written to %s\n",
+            (unsigned long long)profile.samples, 1000.0 / profile.rate, profile.path);
+    if (profile.dropped > 0) {
+        fprintf(stderr, "  %llu samples had too many distinct stacks to record\n",
+                (unsigned long long)profile.dropped);
+    }
+    if (profile.truncated > 0) {
+        fprintf(stderr, "  %llu samples were cut to their innermost %d calls\n",
+                (unsigned long long)profile.truncated, PROFILE_MAX_DEPTH);
+    }
+    if (recorded == 0) return;
+    
+    uint64_t* function_self = table_alloc(PROFILE_FUNCTIONS, sizeof(uint64_t));
+    uint64_t* function_total = table_alloc(PROFILE_FUNCTIONS, sizeof(uint64_t));
+    uint64_t* site_self = table_alloc(PROFILE_SITES, sizeof(uint64_t));
+    uint32_t* last_stack = table_alloc(PROFILE_FUNCTIONS, sizeof(uint32_t));
+    
+    for (uint32_t s = 0; s < PROFILE_STACKS; s++) {
+        const ProfileStack* stack = &profile.stacks[s];
+        if (!stack->used || stack->depth == 0) continue;
+        
+        uint32_t leaf = profile.slots[stack->first];
+        site_self[leaf] += stack->count;
+        function_self[profile.sites[leaf].function] += stack->count;
+        
+        /* Recursion counts a function once per stack in its total */
+        for (int d = 0; d < stack->depth; d++) {
+            uint32_t function = profile.sites[profile.slots[stack->first + d]].function;
+            if (last_stack[function] != s + 1) {
+                last_stack[function] = s + 1;
+                function_total[function] += stack->count;
+            }
+        }
+    }
+    
+    print_table("    Self    Total  Function", function_self, function_total,
+                PROFILE_FUNCTIONS, recorded, false);
+    print_table("    Self  Line", site_self, NULL, PROFILE_SITES, recorded, true);
+    
+    free(function_self);
+    free(function_total);
+    free(site_self);
+    free(last_stack);
+}
+
+void profile_stop(Interpreter* interp) {
+    if (profile.file == NULL) return;
+    
+    /* A signal already on its way sees active cleared and does nothing */
+    profile.active = 0;
+    if (profile.timing) timer_delete(profile.timer);
+    profile.timing = false;
+    signal(SIGPROF, SIG_IGN);
+    
+    /* The summary goes after everything the script printed */
+    output_flush(&interp->out);
+    
+    write_folded(profile.file);
+    if (fclose(profile.file) != 0) {
+        fprintf(stderr, "Error: Could not write profile output '%s'\n", profile.path);
+    }
+    profile.file = NULL;
+    print_summary();
+    
+    free(profile.functions);
+    free(profile.sites);
+    free(profile.stacks);
+    free(profile.slots);
+    free(profile.names);
+    profile.path = NULL;
+}
@@ -0,0 +1,611 @@
+/*
+ * Brisk Language - Sorting Implementation
+ * Introsort and merge sort over Values, LSD radix sort for numeric keys.
+ * Large inputs use the thread pool: radix passes count and scatter per
+ * block, and string sorts sort blocks independently before merging them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sort.h"
+#include "pool.h"
+#include "memory.h"
+
+/* Below this size comparison sorts beat radix sort */
+#define RADIX_THRESHOLD 256
+
+/* Subarrays at or below this size use insertion sort */
+#define INSERTION_THRESHOLD 16
+
+#define SIGN_BIT 0x8000000000000000ULL
+
+/* Inputs shorter than this are sorted on the calling thread */
+#define PARALLEL_THRESHOLD (1 << 17)
+
+/* Entries per block when a sort is split across the pool */
+#define PARALLEL_BLOCK (1 << 15)
+
+/* Key/value pair being sorted (key == value for plain sorts) */
+typedef struct {
+    Value key;
+    Value value;
+    uint64_t prefix;  /* First 8 bytes of a string key, big-endian */
+} SortEntry;
+
+/* Radix entry: order-preserving key bits plus original position */
+typedef struct {
+    uint64_t bits;
+    int index;
+} RadixEntry;
+
+typedef struct SortContext SortContext;
+typedef int (*CompareFn)(SortContext* ctx, SortEntry* a, SortEntry* b);
+
+struct SortContext {
+    Interpreter* interp;
+    Value cmp;          /* User comparator (NIL for default ordering) */
+    CompareFn compare;
+};
+
+/* Homogeneity of a key set, decides which algorithm to use */
+typedef enum {
+    KEYS_INT,
+    KEYS_NUMBER,    /* Floats, possibly mixed with ints */
+    KEYS_STRING,
+    KEYS_MIXED
+} KeyKind;
+
+static KeyKind classify_keys(Value* keys, int count) {
+    bool all_int = true;
+    bool all_number = true;
+    bool all_string = true;
+    
+    for (int i = 0; i < count; i++) {
+        Value key = keys[i];
+        if (!IS_INT(key)) all_int = false;
+        if (!IS_NUMBER(key)) all_number = false;
+        if (!IS_STRING(key)) all_string = false;
+        if (!all_number && !all_string) return KEYS_MIXED;
+    }
+    
+    if (all_int) return KEYS_INT;
+    if (all_number) return KEYS_NUMBER;
+    return KEYS_STRING;
+}
+
+/* ============ Comparators ============ */
+
+/* Zero-padded big-endian prefix: comparing prefixes as integers agrees
+   with memcmp order, so most string comparisons never touch the chars */
+static uint64_t string_prefix(ObjString* str) {
+    uint64_t prefix = 0;
+    int n = str->length < 8 ? str->length : 8;
+    for (int i = 0; i < 8; i++) {
+        prefix <<= 8;
+        if (i < n) prefix |= (uint8_t)str->chars[i];
+    }
+    return prefix;
+}
+
+static int compare_string_values(Value a, Value b) {
+    ObjString* x = AS_STRING(a);
+    ObjString* y = AS_STRING(b);
+    if (x == y) return 0;  /* Interned: same object means same contents */
+    
+    int n = x->length < y->length ? x->length : y->length;
+    int result = memcmp(x->chars, y->chars, n);
+    if (result != 0) return result;
+    return (x->length > y->length) - (x->length < y->length);
+}
+
+static int compare_strings(SortContext* ctx, SortEntry* ea, SortEntry* eb) {
+    (void)ctx;
+    if (ea->prefix != eb->prefix) return ea->prefix < eb->prefix ? -1 : 1;
+    return compare_string_values(ea->key, eb->key);
+}
+
+static int compare_default(SortContext* ctx, SortEntry* ea, SortEntry* eb) {
+    Value a = ea->key;
+    Value b = eb->key;
+    if (IS_INT(a) && IS_INT(b)) {
+        return (AS_INT(a) > AS_INT(b)) - (AS_INT(a) < AS_INT(b));
+    }
+    if (IS_NUMBER(a) && IS_NUMBER(b)) {
+        double x = AS_NUMBER(a);
+        double y = AS_NUMBER(b);
+        return (x > y) - (x < y);
+    }
+    if (IS_STRING(a) && IS_STRING(b)) {
+        return compare_string_values(a, b);
+    }
+    if (IS_BOOL(a) && IS_BOOL(b)) {
+        return (int)AS_BOOL(a) - (int)AS_BOOL(b);
+    }
+    
+    Interpreter* interp = ctx->interp;
+    if (!interp->had_error) {
+        runtime_error(interp, interp->call_line, "Cannot compare %s with %s",
+                      value_type_name(a), value_type_name(b));
+    }
+    return 0;
+}
+
+static int compare_user(SortContext* ctx, SortEntry* a, SortEntry* b) {
+    Interpreter* interp = ctx->interp;
+    if (interp->had_error) return 0;
+    
+    Value args[2] = {a->key, b->key};
+    Value result = brisk_call(interp, ctx->cmp, 2, args);
+    
+    if (IS_INT(result)) return (AS_INT(result) > 0) - (AS_INT(result) < 0);
+    if (IS_FLOAT(result)) return (AS_FLOAT(result) > 0) - (AS_FLOAT(result) < 0);
+    if (IS_BOOL(result)) return AS_BOOL(result) ? -1 : 0;  /* true means a < b */
+    
+    if (!interp->had_error) {
+        runtime_error(interp, interp->call_line,
+                      "Sort comparator must return a number or bool, got %s",
+                      value_type_name(result));
+    }
+    return 0;
+}
+
+static inline bool entry_less(SortContext* ctx, SortEntry* a, SortEntry* b) {
+    return ctx->compare(ctx, a, b) < 0;
+}
+
+static inline void entry_swap(SortEntry* a, SortEntry* b) {
+    SortEntry tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/* ============ Comparison Sorts ============ */
+
+/* Stable insertion sort of e[lo, hi) */
+static void insertion_sort(SortContext* ctx, SortEntry* e, int lo, int hi) {
+    for (int i = lo + 1; i < hi; i++) {
+        SortEntry tmp = e[i];
+        int j = i;
+        while (j > lo && entry_less(ctx, &tmp, &e[j - 1])) {
+            e[j] = e[j - 1];
+            j--;
+        }
+        e[j] = tmp;
+    }
+}
+
+static void sift_down(SortContext* ctx, SortEntry* base, int root, int n) {
+    for (;;) {
+        int child = 2 * root + 1;
+        if (child >= n) break;
+        if (child + 1 < n && entry_less(ctx, &base[child], &base[child + 1])) {
+            child++;
+        }
+        if (!entry_less(ctx, &base[root], &base[child])) break;
+        entry_swap(&base[root], &base[child]);
+        root = child;
+    }
+}
+
+/* Heapsort fallback of e[lo, hi) once introsort recursion gets too deep */
+static void heap_sort(SortContext* ctx, SortEntry* e, int lo, int hi) {
+    SortEntry* base = e + lo;
+    int n = hi - lo;
+    
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        sift_down(ctx, base, i, n);
+    }
+    for (int end = n - 1; end > 0; end--) {
+        entry_swap(&base[0], &base[end]);
+        sift_down(ctx, base, 0, end);
+    }
+}
+
+/* Order e[a] <= e[b] <= e[c] */
+static void sort3(SortContext* ctx, SortEntry* e, int a, int b, int c) {
+    if (entry_less(ctx, &e[b], &e[a])) entry_swap(&e[a], &e[b]);
+    if (entry_less(ctx, &e[c], &e[b])) {
+        entry_swap(&e[b], &e[c]);
+        if (entry_less(ctx, &e[b], &e[a])) entry_swap(&e[a], &e[b]);
+    }
+}
+
+/* Introsort of e[lo, hi): median-of-three quicksort, heapsort when the
+   depth budget runs out, insertion sort for short ranges. Partition scans
+   are bounds-checked so inconsistent user comparators cannot overrun. */
+static void intro_sort(SortContext* ctx, SortEntry* e, int lo, int hi, int depth) {
+    while (hi - lo > INSERTION_THRESHOLD) {
+        if (ctx->interp->had_error) return;
+        if (depth == 0) {
+            heap_sort(ctx, e, lo, hi);
+            return;
+        }
+        depth--;
+        
+        int mid = lo + (hi - lo) / 2;
+        sort3(ctx, e, lo, mid, hi - 1);
+        SortEntry pivot = e[mid];
+        
+        /* Hoare partition */
+        int i = lo - 1;
+        int j = hi;
+        for (;;) {
+            do { i++; } while (i < hi - 1 && entry_less(ctx, &e[i], &pivot));
+            do { j--; } while (j > lo && entry_less(ctx, &pivot, &e[j]));
+            if (i >= j) break;
+            entry_swap(&e[i], &e[j]);
+        }
+        
+        /* Recurse into the smaller half, loop on the larger */
+        int split = j + 1;
+        if (split - lo < hi - split) {
+            intro_sort(ctx, e, lo, split, depth);
+            lo = split;
+        } else {
+            intro_sort(ctx, e, split, hi, depth);
+            hi = split;
+        }
+    }
+    
+    insertion_sort(ctx, e, lo, hi);
+}
+
+/* Stable top-down merge sort of e[lo, hi) using tmp as scratch */
+static void merge_sort(SortContext* ctx, SortEntry* e, SortEntry* tmp, int lo, int hi) {
+    if (hi - lo <= INSERTION_THRESHOLD) {
+        insertion_sort(ctx, e, lo, hi);
+        return;
+    }
+    if (ctx->interp->had_error) return;
+    
+    int mid = lo + (hi - lo) / 2;
+    merge_sort(ctx, e, tmp, lo, mid);
+    merge_sort(ctx, e, tmp, mid, hi);
+    
+    /* Halves already in order */
+    if (!entry_less(ctx, &e[mid], &e[mid - 1])) return;
+    
+    memcpy(tmp + lo, e + lo, sizeof(SortEntry) * (mid - lo));
+    int i = lo, j = mid, k = lo;
+    while (i < mid && j < hi) {
+        if (entry_less(ctx, &e[j], &tmp[i])) {
+            e[k++] = e[j++];
+        } else {
+            e[k++] = tmp[i++];
+        }
+    }
+    while (i < mid) {
+        e[k++] = tmp[i++];
+    }
+}
+
+static int depth_limit(int count) {
+    int depth = 0;
+    while (count > 1) {
+        depth++;
+        count >>= 1;
+    }
+    return depth * 2;
+}
+
+/* ============ Parallel Merge Sort ============ */
+
+typedef struct {
+    SortContext* ctx;
+    SortEntry* src;
+    SortEntry* dst;
+    int count;
+    int width;          /* Run length in entries for the current round */
+    bool stable;
+} BlockSort;
+
+static void sort_blocks(void* context, int64_t begin, int64_t end) {
+    BlockSort* job = context;
+    for (int64_t b = begin; b < end; b++) {
+        int lo = (int)(b * PARALLEL_BLOCK);
+        int hi = job->count - lo < PARALLEL_BLOCK ? job->count : lo + PARALLEL_BLOCK;
+        if (job->stable) {
+            merge_sort(job->ctx, job->src, job->dst, lo, hi);
+        } else {
+            intro_sort(job->ctx, job->src, lo, hi, depth_limit(hi - lo));
+        }
+    }
+}
+
+/* Merge each pair of neighbouring runs from src into dst; ties take the
+   left run so the merge is stable */
+static void merge_runs(void* context, int64_t begin, int64_t end) {
+    BlockSort* job = context;
+    SortEntry* src = job->src;
+    SortEntry* dst = job->dst;
+    
+    for (int64_t pair = begin; pair < end; pair++) {
+        int64_t lo = pair * 2 * job->width;
+        int mid = (int)(lo + job->width < job->count ? lo + job->width : job->count);
+        int hi = (int)(mid + job->width < job->count ? mid + job->width : job->count);
+        int i = (int)lo, j = mid, k = (int)lo;
+        
+        while (i < mid && j < hi) {
+            if (entry_less(job->ctx, &src[j], &src[i])) {
+                dst[k++] = src[j++];
+            } else {
+                dst[k++] = src[i++];
+            }
+        }
+        memcpy(dst + k, src + i, sizeof(SortEntry) * (mid - i));
+        k += mid - i;
+        memcpy(dst + k, src + j, sizeof(SortEntry) * (hi - j));
+    }
+}
+
+/* Only for comparators that never call back into the interpreter */
+static void parallel_sort_entries(SortContext* ctx, SortEntry* entries, int count, bool stable) {
+    SortEntry* tmp = mem_alloc(sizeof(SortEntry) * count);
+    BlockSort job = {ctx, entries, tmp, count, PARALLEL_BLOCK, stable};
+    
+    int64_t blocks = (count + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    pool_for(blocks, 1, sort_blocks, &job);
+    
+    for (; job.width < count; job.width *= 2) {
+        int64_t pairs = (count + 2 * (int64_t)job.width - 1) / (2 * (int64_t)job.width);
+        pool_for(pairs, 1, merge_runs, &job);
+        SortEntry* swap = job.src;
+        job.src = job.dst;
+        job.dst = swap;
+    }
+    
+    if (job.src != entries) {
+        memcpy(entries, job.src, sizeof(SortEntry) * count);
+    }
+    mem_free(tmp, sizeof(SortEntry) * count);
+}
+
+static void sort_entries(SortContext* ctx, SortEntry* entries, int count, bool stable) {
+    if (ctx->compare == compare_strings && count >= PARALLEL_THRESHOLD && pool_size() > 1) {
+        parallel_sort_entries(ctx, entries, count, stable);
+    } else if (stable) {
+        SortEntry* tmp = mem_alloc(sizeof(SortEntry) * count);
+        merge_sort(ctx, entries, tmp, 0, count);
+        mem_free(tmp, sizeof(SortEntry) * count);
+    } else {
+        intro_sort(ctx, entries, 0, count, depth_limit(count));
+    }
+}
+
+/* ============ Radix Sort ============ */
+
+/* Map a key to bits whose unsigned order matches numeric order */
+static uint64_t radix_bits(Value key, KeyKind kind) {
+    if (kind == KEYS_INT) {
+        return (uint64_t)AS_INT(key) ^ SIGN_BIT;
+    }
+    
+    double d = AS_NUMBER(key);
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return (bits & SIGN_BIT) ? ~bits : (bits | SIGN_BIT);
+}
+
+/* Stable LSD radix sort, one byte per pass; passes where every key
+   shares the same byte are skipped */
+static void radix_sort(RadixEntry* entries, RadixEntry* tmp, int count) {
+    static const int passes = (int)sizeof(uint64_t);
+    size_t (*histogram)[256] = calloc(passes, sizeof(*histogram));
+    if (histogram == NULL) {
+        fprintf(stderr, "Fatal: Out of memory\n");
+        exit(1);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        uint64_t bits = entries[i].bits;
+        for (int p = 0; p < passes; p++) {
+            histogram[p][(bits >> (8 * p)) & 0xFF]++;
+        }
+    }
+    
+    RadixEntry* src = entries;
+    RadixEntry* dst = tmp;
+    
+    for (int p = 0; p < passes; p++) {
+        int shift = 8 * p;
+        size_t* counts = histogram[p];
+        if (counts[(src[0].bits >> shift) & 0xFF] == (size_t)count) continue;
+        
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t n = counts[b];
+            counts[b] = offset;
+            offset += n;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            dst[counts[(src[i].bits >> shift) & 0xFF]++] = src[i];
+        }
+        
+        RadixEntry* swap = src;
+        src = dst;
+        dst = swap;
+    }
+    
+    if (src != entries) {
+        memcpy(entries, src, sizeof(RadixEntry) * count);
+    }
+    free(histogram);
+}
+
+typedef struct {
+    RadixEntry* src;
+    RadixEntry* dst;
+    int count;
+    int shift;
+    size_t (*counts)[256];  /* Per block: byte counts, then where each goes */
+} RadixPass;
+
+static int radix_block_span(const RadixPass* pass, int64_t b, int* hi) {
+    int lo = (int)(b * PARALLEL_BLOCK);
+    *hi = pass->count - lo < PARALLEL_BLOCK ? pass->count : lo + PARALLEL_BLOCK;
+    return lo;
+}
+
+static void radix_count_blocks(void* context, int64_t begin, int64_t end) {
+    RadixPass* pass = context;
+    for (int64_t b = begin; b < end; b++) {
+        size_t* counts = pass->counts[b];
+        memset(counts, 0, sizeof(size_t) * 256);
+        int hi;
+        for (int i = radix_block_span(pass, b, &hi); i < hi; i++) {
+            counts[(pass->src[i].bits >> pass->shift) & 0xFF]++;
+        }
+    }
+}
+
+static void radix_scatter_blocks(void* context, int64_t begin, int64_t end) {
+    RadixPass* pass = context;
+    for (int64_t b = begin; b < end; b++) {
+        size_t* offsets = pass->counts[b];
+        int hi;
+        for (int i = radix_block_span(pass, b, &hi); i < hi; i++) {
+            pass->dst[offsets[(pass->src[i].bits >> pass->shift) & 0xFF]++] = pass->src[i];
+        }
+    }
+}
+
+/* radix_sort with every pass split into blocks: each block counts its
+   bytes, and a block's share of a bucket lands after the earlier blocks'
+   share, which keeps the sort stable */
+static void parallel_radix_sort(RadixEntry* entries, RadixEntry* tmp, int count) {
+    int blocks = (count + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK;
+    RadixPass pass = {entries, tmp, count, 0, mem_alloc(sizeof(size_t) * 256 * blocks)};
+    
+    for (int p = 0; p < (int)sizeof(uint64_t); p++) {
+        pass.shift = 8 * p;
+        pool_for(blocks, 1, radix_count_blocks, &pass);
+        
+        size_t offset = 0;
+        bool trivial = false;
+        for (int bucket = 0; bucket < 256 && !trivial; bucket++) {
+            size_t total = 0;
+            for (int b = 0; b < blocks; b++) {
+                size_t n = pass.counts[b][bucket];
+                pass.counts[b][bucket] = offset + total;
+                total += n;
+            }
+            trivial = total == (size_t)count;
+            offset += total;
+        }
+        if (trivial) continue;
+        
+        pool_for(blocks, 1, radix_scatter_blocks, &pass);
+        RadixEntry* swap = pass.src;
+        pass.src = pass.dst;
+        pass.dst = swap;
+    }
+    
+    if (pass.src != entries) {
+        memcpy(entries, pass.src, sizeof(RadixEntry) * count);
+    }
+    mem_free(pass.counts, sizeof(size_t) * 256 * blocks);
+}
+
+/* Radix sort values by numeric keys (keys may alias values) */
+static void radix_sort_values(Value* values, Value* keys, int count, KeyKind kind) {
+    RadixEntry* entries = mem_alloc(sizeof(RadixEntry) * count);
+    RadixEntry* tmp = mem_alloc(sizeof(RadixEntry) * count);
+    
+    for (int i = 0; i < count; i++) {
+        entries[i].bits = radix_bits(keys[i], kind);
+        entries[i].index = i;
+    }
+    
+    if (count >= PARALLEL_THRESHOLD && pool_size() > 1) {
+        parallel_radix_sort(entries, tmp, count);
+    } else {
+        radix_sort(entries, tmp, count);
+    }
+    
+    /* Apply the permutation through a scratch copy */
+    Value* scratch = mem_alloc(sizeof(Value) * count);
+    memcpy(scratch, values, sizeof(Value) * count);
+    for (int i = 0; i < count; i++) {
+        values[i] = scratch[entries[i].index];
+    }
+    if (keys != values) {
+        memcpy(scratch, keys, sizeof(Value) * count);
+        for (int i = 0; i < count; i++) {
+            keys[i] = scratch[entries[i].index];
+        }
+    }
+    
+    mem_free(scratch, sizeof(Value) * count);
+    mem_free(tmp, sizeof(RadixEntry) * count);
+    mem_free(entries, sizeof(RadixEntry) * count);
+}
+
+/* ============ Public API ============ */
+
+bool sort_values(Interpreter* interp, Value* values, int count, Value cmp, bool stable) {
+    if (count < 2) return true;
+    
+    SortContext ctx = {interp, cmp, compare_user};
+    
+    if (IS_NIL(cmp)) {
+        KeyKind kind = classify_keys(values, count);
+        
+        /* Typed fast path: radix sort is stable, so it serves both modes */
+        if ((kind == KEYS_INT || kind == KEYS_NUMBER) && count >= RADIX_THRESHOLD) {
+            radix_sort_values(values, values, count, kind);
+            return true;
+        }
+        
+        ctx.compare = kind == KEYS_STRING ? compare_strings : compare_default;
+    }
+    
+    SortEntry* entries = mem_alloc(sizeof(SortEntry) * count);
+    for (int i = 0; i < count; i++) {
+        entries[i].key = values[i];
+        entries[i].value = values[i];
+        entries[i].prefix = ctx.compare == compare_strings
+                            ? string_prefix(AS_STRING(values[i])) : 0;
+    }
+    
+    sort_entries(&ctx, entries, count, stable);
+    
+    /* Always a permutation of the input, even if a comparison failed */
+    for (int i = 0; i < count; i++) {
+        values[i] = entries[i].value;
+    }
+    mem_free(entries, sizeof(SortEntry) * count);
+    
+    return !interp->had_error;
+}
+
+bool sort_values_by_keys(Interpreter* interp, Value* values, Value* keys, int count) {
+    if (count < 2) return true;
+    
+    KeyKind kind = classify_keys(keys, count);
+    if ((kind == KEYS_INT || kind == KEYS_NUMBER) && count >= RADIX_THRESHOLD) {
+        radix_sort_values(values, keys, count, kind);
+        return true;
+    }
+    
+    SortContext ctx = {interp, NIL_VAL,
+                       kind == KEYS_STRING ? compare_strings : compare_default};
+    
+    SortEntry* entries = mem_alloc(sizeof(SortEntry) * count);
+    for (int i = 0; i < count; i++) {
+        entries[i].key = keys[i];
+        entries[i].value = values[i];
+        entries[i].prefix = kind == KEYS_STRING ? string_prefix(AS_STRING(keys[i])) : 0;
+    }
+    
+    sort_entries(&ctx, entries, count, true);
+    
+    for (int i = 0; i < count; i++) {
+        keys[i] = entries[i].key;
+        values[i] = entries[i].value;
+    }
+    mem_free(entries, sizeof(SortEntry) * count);
+    
+    return !interp->had_error;
+}
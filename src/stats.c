@@ -0,0 +1,172 @@
+/*
+ * Brisk Language - Execution Statistics Implementation
+ * Every thread counts into its own copy, so the hot paths pay one
+ * increment and no synchronization; interpreters fold their thread's
+ * counts into the totals when they are destroyed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "stats.h"
+
+#ifdef BRISK_STATS
+
+__thread Stats stats_thread;
+
+static Stats totals;
+static pthread_mutex_t totals_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool enabled = false;
+static const char* json_path = NULL;
+
+void stats_merge(void) {
+    /* Add field by field: Stats is nothing but uint64_t counters */
+    const uint64_t* from = (const uint64_t*)&stats_thread;
+    uint64_t* to = (uint64_t*)&totals;
+    size_t count = sizeof(Stats) / sizeof(uint64_t);
+    
+    pthread_mutex_lock(&totals_lock);
+    for (size_t i = 0; i < count; i++) to[i] += from[i];
+    pthread_mutex_unlock(&totals_lock);
+    memset(&stats_thread, 0, sizeof(Stats));
+}
+
+void stats_enable(const char* path) {
+    enabled = true;
+    json_path = path;
+}
+
+/* ============ Text ============ */
+
+static uint64_t sum(const uint64_t* counts, int length) {
+    uint64_t total = 0;
+    for (int i = 0; i < length; i++) total += counts[i];
+    return total;
+}
+
+static double percent(uint64_t part, uint64_t whole) {
+    return whole > 0 ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+static void print_count(const char* label, uint64_t count) {
+    fprintf(stderr, "  %-19s %14llu\n", label, (unsigned long long)count);
+}
+
+static void print_share(const char* label, uint64_t count, uint64_t whole) {
+    fprintf(stderr, "    %-17s %14llu  %5.1f%%\n", label, (unsigned long long)count,
+            percent(count, whole));
+}
+
+/* Nonzero counts, largest first, each with its share of the total */
+static void print_ranked(const uint64_t* counts, int length, const char* (*name)(int)) {
+    uint64_t total = sum(counts, length);
+    bool* printed = calloc(length, sizeof(bool));
+    if (printed == NULL) return;
+    
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i < length; i++) {
+            if (!printed[i] && counts[i] > 0 && (best < 0 || counts[i] > counts[best])) {
+                best = i;
+            }
+        }
+        if (best < 0) break;
+        printed[best] = true;
+        print_share(name(best), counts[best], total);
+    }
+    free(printed);
+}
+
+static const char* node_name(int type) {
+    return node_type_name((NodeType)type);
+}
+
+static const char* object_name(int type) {
+    return object_type_name((ObjectType)type);
+}
+
+static void print_text(const Stats* stats) {
+    fprintf(stderr, "\nExecution statistics\n");
+    
+    print_count("Nodes evaluated", sum(stats->nodes, NODE_TYPE_COUNT));
+    print_ranked(stats->nodes, NODE_TYPE_COUNT, node_name);
+    
+    uint64_t lookups = sum(stats->env_depth, STATS_DEPTHS) + stats->env_misses;
+    print_count("Variable lookups", lookups);
+    for (int d = 0; d < STATS_DEPTHS; d++) {
+        if (stats->env_depth[d] == 0) continue;
+        char label[32];
+        snprintf(label, sizeof(label), "%d scope%s up%s", d, d == 1 ? "" : "s",
+                 d == STATS_DEPTHS - 1 ? " or more" : "");
+        print_share(label, stats->env_depth[d], lookups);
+    }
+    if (stats->env_misses > 0) print_share("not found", stats->env_misses, lookups);
+    print_count("Environments created", stats->environments);
+    
+    print_count("Table lookups", stats->table_lookups);
+    if (stats->table_lookups > 0) {
+        fprintf(stderr, "    %-17s %14.2f\n", "probes per lookup",
+                (double)stats->table_probes / (double)stats->table_lookups);
+    }
+    print_count("Strings requested", stats->strings);
+    print_share("already interned", stats->intern_hits, stats->strings);
+    print_count("FFI calls", stats->ffi_calls);
+    
+    print_count("Objects allocated", sum(stats->objects, OBJ_TYPE_COUNT));
+    print_ranked(stats->objects, OBJ_TYPE_COUNT, object_name);
+}
+
+/* ============ JSON ============ */
+
+static void write_counts(FILE* out, const uint64_t* counts, int length, const char* (*name)(int)) {
+    fputc('{', out);
+    for (int i = 0; i < length; i++) {
+        fprintf(out, "%s\"%s\":%llu", i > 0 ? "," : "", name(i), (unsigned long long)counts[i]);
+    }
+    fputc('}', out);
+}
+
+static void write_json(FILE* out, const Stats* stats) {
+    fputs("{\"nodes\":", out);
+    write_counts(out, stats->nodes, NODE_TYPE_COUNT, node_name);
+    
+    fputs(",\"env_get\":{\"depth\":[", out);
+    for (int d = 0; d < STATS_DEPTHS; d++) {
+        fprintf(out, "%s%llu", d > 0 ? "," : "", (unsigned long long)stats->env_depth[d]);
+    }
+    fprintf(out, "],\"misses\":%llu}", (unsigned long long)stats->env_misses);
+    fprintf(out, ",\"environments\":%llu", (unsigned long long)stats->environments);
+    fprintf(out, ",\"table\":{\"lookups\":%llu,\"probes\":%llu}",
+            (unsigned long long)stats->table_lookups, (unsigned long long)stats->table_probes);
+    fprintf(out, ",\"strings\":{\"requested\":%llu,\"intern_hits\":%llu}",
+            (unsigned long long)stats->strings, (unsigned long long)stats->intern_hits);
+    fprintf(out, ",\"ffi_calls\":%llu", (unsigned long long)stats->ffi_calls);
+    
+    fputs(",\"objects\":", out);
+    write_counts(out, stats->objects, OBJ_TYPE_COUNT, object_name);
+    fputs("}\n", out);
+}
+
+void stats_report(void) {
+    if (!enabled) return;
+    
+    pthread_mutex_lock(&totals_lock);
+    Stats stats = totals;
+    pthread_mutex_unlock(&totals_lock);
+    
+    print_text(&stats);
+    
+    if (json_path != NULL) {
+        FILE* out = fopen(json_path, "w");
+        if (out == NULL) {
+            fprintf(stderr, "Error: Could not open statistics output '%s'\n", json_path);
+            return;
+        }
+        write_json(out, &stats);
+        fclose(out);
+    }
+}
+
+#endif /* BRISK_STATS */
@@ -0,0 +1,261 @@
+/*
+ * Brisk Language - Substring Search Implementation
+ * memchr for single bytes; first/last-byte SIMD filtering for longer needles
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "strsearch.h"
+#include "pool.h"
+#include "memory.h"
+
+/* Haystacks shorter than this are searched on the calling thread */
+#define FIND_PARALLEL_MIN (1 << 20)
+
+/* Bytes of haystack per pool task */
+#define FIND_CHUNK (1 << 18)
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Scalar search: memchr to the first byte, then verify the last byte
+   before paying for memcmp. needle_len must be >= 2. */
+static const char* find_scalar(const char* h, size_t h_len,
+                               const char* n, size_t n_len) {
+    if (h_len < n_len) return NULL;
+    
+    const char* end = h + h_len - n_len + 1;  /* One past the last start */
+    const char* p = h;
+    
+    while (p < end) {
+        p = memchr(p, n[0], end - p);
+        if (p == NULL) return NULL;
+        if (p[n_len - 1] == n[n_len - 1] &&
+            memcmp(p + 1, n + 1, n_len - 2) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+#if defined(__AVX2__)
+
+/* Compare 32 candidate positions at once: a position survives only if
+   both the first and the last needle bytes match */
+static const char* find_simd(const char* h, size_t h_len,
+                             const char* n, size_t n_len) {
+    const __m256i first = _mm256_set1_epi8(n[0]);
+    const __m256i last = _mm256_set1_epi8(n[n_len - 1]);
+    size_t i = 0;
+    
+    for (; i + n_len - 1 + 32 <= h_len; i += 32) {
+        __m256i block_first = _mm256_loadu_si256((const __m256i*)(h + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i*)(h + i + n_len - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                             _mm256_cmpeq_epi8(last, block_last)));
+        
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (memcmp(h + i + bit + 1, n + 1, n_len - 2) == 0) {
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    return find_scalar(h + i, h_len - i, n, n_len);
+}
+
+#elif defined(__SSE2__)
+
+/* Same filter as the AVX2 version, 16 positions at a time */
+static const char* find_simd(const char* h, size_t h_len,
+                             const char* n, size_t n_len) {
+    const __m128i first = _mm_set1_epi8(n[0]);
+    const __m128i last = _mm_set1_epi8(n[n_len - 1]);
+    size_t i = 0;
+    
+    for (; i + n_len - 1 + 16 <= h_len; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i*)(h + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i*)(h + i + n_len - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                          _mm_cmpeq_epi8(last, block_last)));
+        
+        while (mask != 0) {
+            int bit = __builtin_ctz(mask);
+            if (memcmp(h + i + bit + 1, n + 1, n_len - 2) == 0) {
+                return h + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    
+    return find_scalar(h + i, h_len - i, n, n_len);
+}
+
+#else
+
+#define find_simd find_scalar
+
+#endif
+
+int str_find(const char* haystack, int haystack_len,
+             const char* needle, int needle_len, int start) {
+    if (start < 0) start = 0;
+    if (start > haystack_len) return -1;
+    if (needle_len == 0) return start;
+    if (needle_len > haystack_len - start) return -1;
+    
+    const char* h = haystack + start;
+    size_t h_len = (size_t)(haystack_len - start);
+    const char* found;
+    
+    if (needle_len == 1) {
+        found = memchr(h, needle[0], h_len);
+    } else {
+        found = find_simd(h, h_len, needle, (size_t)needle_len);
+    }
+    
+    return found != NULL ? (int)(found - haystack) : -1;
+}
+
+int str_rfind(const char* haystack, int haystack_len,
+              const char* needle, int needle_len) {
+    if (needle_len == 0) return haystack_len;
+    if (needle_len > haystack_len) return -1;
+    
+    char first = needle[0];
+    char last = needle[needle_len - 1];
+    
+    for (int i = haystack_len - needle_len; i >= 0; i--) {
+        if (haystack[i] == first &&
+            haystack[i + needle_len - 1] == last &&
+            memcmp(haystack + i, needle, needle_len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int str_count(const char* haystack, int haystack_len,
+              const char* needle, int needle_len) {
+    if (needle_len == 0) return 0;
+    
+    int count = 0;
+    int pos = 0;
+    while ((pos = str_find(haystack, haystack_len, needle, needle_len, pos)) >= 0) {
+        count++;
+        pos += needle_len;
+    }
+    return count;
+}
+
+/* ============ All Occurrences ============ */
+
+/* Positions found in one chunk; pool threads cannot use mem_alloc */
+typedef struct {
+    int* positions;
+    int count;
+    int capacity;
+} Matches;
+
+typedef struct {
+    const char* haystack;
+    int haystack_len;
+    const char* needle;
+    int needle_len;
+    Matches* chunks;
+} FindJob;
+
+static void matches_push(Matches* matches, int position) {
+    if (matches->count == matches->capacity) {
+        matches->capacity = matches->capacity < 8 ? 8 : matches->capacity * 2;
+        matches->positions = realloc(matches->positions, sizeof(int) * matches->capacity);
+        if (matches->positions == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+    }
+    matches->positions[matches->count++] = position;
+}
+
+/* Every match starting inside the chunk, overlapping ones included: a
+   match that straddles the previous chunk may rule out the first ones
+   here, and only the merge knows */
+static void find_chunks(void* context, int64_t begin, int64_t end) {
+    FindJob* job = context;
+    for (int64_t c = begin; c < end; c++) {
+        int lo = (int)(c * FIND_CHUNK);
+        int hi = job->haystack_len - lo < FIND_CHUNK ? job->haystack_len : lo + FIND_CHUNK;
+        int limit = job->haystack_len - hi < job->needle_len - 1
+                    ? job->haystack_len : hi + job->needle_len - 1;
+        
+        int pos = lo;
+        while ((pos = str_find(job->haystack, limit, job->needle, job->needle_len, pos)) >= 0) {
+            matches_push(&job->chunks[c], pos);
+            pos++;
+        }
+    }
+}
+
+int str_find_all(const char* haystack, int haystack_len,
+                 const char* needle, int needle_len, int** out) {
+    int count = 0;
+    int capacity = 0;
+    int* positions = NULL;
+    
+    if (needle_len > 0 && haystack_len >= FIND_PARALLEL_MIN && pool_size() > 1) {
+        int chunks = (haystack_len + FIND_CHUNK - 1) / FIND_CHUNK;
+        FindJob job = {haystack, haystack_len, needle, needle_len,
+                       calloc(chunks, sizeof(Matches))};
+        if (job.chunks == NULL) {
+            fprintf(stderr, "Fatal: Out of memory\n");
+            exit(1);
+        }
+        pool_for(chunks, 1, find_chunks, &job);
+        
+        for (int c = 0; c < chunks; c++) {
+            capacity += job.chunks[c].count;
+        }
+        positions = capacity > 0 ? mem_alloc(sizeof(int) * capacity) : NULL;
+        
+        /* Keep the matches a left-to-right scan would have taken */
+        int next = 0;
+        for (int c = 0; c < chunks; c++) {
+            for (int i = 0; i < job.chunks[c].count; i++) {
+                int pos = job.chunks[c].positions[i];
+                if (pos < next) continue;
+                positions[count++] = pos;
+                next = pos + needle_len;
+            }
+            free(job.chunks[c].positions);
+        }
+        free(job.chunks);
+    } else if (needle_len > 0) {
+        int pos = 0;
+        while ((pos = str_find(haystack, haystack_len, needle, needle_len, pos)) >= 0) {
+            if (count == capacity) {
+                int old_capacity = capacity;
+                capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+                positions = mem_realloc(positions, sizeof(int) * old_capacity,
+                                        sizeof(int) * capacity);
+            }
+            positions[count++] = pos;
+            pos += needle_len;
+        }
+    }
+    
+    if (count < capacity) {
+        positions = mem_realloc(positions, sizeof(int) * capacity, sizeof(int) * count);
+    }
+    *out = positions;
+    return count;
+}
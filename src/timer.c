@@ -0,0 +1,22 @@
+/*
+ * Brisk Language - Timers Implementation
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include "timer.h"
+
+static uint64_t read_clock(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint64_t timer_now_ns(void) {
+    return read_clock(CLOCK_MONOTONIC);
+}
+
+uint64_t timer_cpu_ns(void) {
+    return read_clock(CLOCK_PROCESS_CPUTIME_ID);
+}
@@ -0,0 +1,172 @@
+/*
+ * Brisk Language - Trace Events Implementation
+ * Spans are kept in memory as complete ("X") events and written as one
+ * JSON array when the process exits, so tracing costs two clock reads and
+ * a locked append per span while the script runs. Times are microseconds
+ * since --trace was parsed.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include "trace.h"
+#include "timer.h"
+
+/* Beyond this many spans, later ones are only counted */
+#define TRACE_MAX_EVENTS 4000000
+
+typedef struct {
+    const char* category;    /* Static string */
+    char* name;
+    uint64_t start;          /* ns since trace_origin */
+    uint64_t duration;       /* ns */
+    int tid;
+} TraceEvent;
+
+bool trace_enabled = false;
+bool trace_calls = false;
+
+static const char* trace_path = NULL;
+static uint64_t trace_origin = 0;
+static uint64_t call_threshold_ns = 0;
+static int main_tid = 0;
+
+/* Worker threads trace their calls too */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceEvent* events = NULL;
+static size_t event_count = 0;
+static size_t event_capacity = 0;
+static size_t dropped = 0;
+
+static int current_tid(void) {
+    return (int)syscall(SYS_gettid);
+}
+
+static void trace_write(void);
+
+void trace_configure(const char* path, double call_threshold_us) {
+    trace_path = path;
+    trace_origin = timer_now_ns();
+    main_tid = current_tid();
+    trace_calls = call_threshold_us >= 0;
+    call_threshold_ns = trace_calls ? (uint64_t)(call_threshold_us * 1000.0) : 0;
+    if (!trace_enabled) {
+        trace_enabled = true;
+        /* exit() from a script still gets its trace written */
+        atexit(trace_write);
+    }
+}
+
+uint64_t trace_clock(void) {
+    return trace_enabled ? timer_now_ns() : 0;
+}
+
+static void record(const char* category, char* name, uint64_t started, uint64_t ended) {
+    pthread_mutex_lock(&trace_lock);
+    if (event_count == TRACE_MAX_EVENTS) {
+        dropped++;
+        pthread_mutex_unlock(&trace_lock);
+        free(name);
+        return;
+    }
+    if (event_count == event_capacity) {
+        size_t capacity = event_capacity < 1024 ? 1024 : event_capacity * 2;
+        TraceEvent* grown = realloc(events, sizeof(TraceEvent) * capacity);
+        if (grown == NULL) {
+            dropped++;
+            pthread_mutex_unlock(&trace_lock);
+            free(name);
+            return;
+        }
+        events = grown;
+        event_capacity = capacity;
+    }
+    TraceEvent* event = &events[event_count++];
+    event->category = category;
+    event->name = name;
+    event->start = started - trace_origin;
+    event->duration = ended - started;
+    event->tid = current_tid();
+    pthread_mutex_unlock(&trace_lock);
+}
+
+void trace_span(const char* category, const char* name, uint64_t started) {
+    if (!trace_enabled) return;
+    uint64_t ended = timer_now_ns();
+    char* copy = strdup(name);
+    if (copy != NULL) record(category, copy, started, ended);
+}
+
+void trace_call(const char* name, int def_line, uint64_t started) {
+    uint64_t ended = timer_now_ns();
+    if (ended - started < call_threshold_ns) return;
+    
+    char* label;
+    if (name != NULL) {
+        label = strdup(name);
+    } else {
+        label = malloc(32);
+        if (label != NULL) snprintf(label, 32, "<fn@%d>", def_line);
+    }
+    if (label != NULL) record("call", label, started, ended);
+}
+
+/* ============ Output ============ */
+
+static void write_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const unsigned char* c = (const unsigned char*)text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (*c < 0x20) {
+            fprintf(out, "\\u%04x", *c);
+        } else {
+            fputc(*c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void trace_write(void) {
+    pthread_mutex_lock(&trace_lock);
+    FILE* out = fopen(trace_path, "w");
+    if (out == NULL) {
+        fprintf(stderr, "Error: Could not write trace to '%s'\n", trace_path);
+        pthread_mutex_unlock(&trace_lock);
+        return;
+    }
+    
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                 "\"args\": {\"name\": \"brisk\"}},\n", main_tid);
+    fprintf(out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                 "\"args\": {\"name\": \"script\"}}", main_tid);
+    for (size_t i = 0; i < event_count; i++) {
+        const TraceEvent* event = &events[i];
+        fprintf(out, ",\n{\"name\": ");
+        write_string(out, event->name);
+        fprintf(out, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                     "\"pid\": 1, \"tid\": %d}",
+                event->category, (double)event->start / 1000.0,
+                (double)event->duration / 1000.0, event->tid);
+        free(event->name);
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    
+    if (dropped > 0) {
+        fprintf(stderr, "Trace: %zu spans past the first %d were dropped\n",
+                dropped, TRACE_MAX_EVENTS);
+    }
+    free(events);
+    events = NULL;
+    event_count = 0;
+    event_capacity = 0;
+    trace_enabled = false;
+    pthread_mutex_unlock(&trace_lock);
+}
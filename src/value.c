@@ -8,21 +8,36 @@
 #include "value.h"
 #include "memory.h"
 #include "cffi.h"
-
-/* Global object list for GC */
-Object* all_objects = NULL;
-
-/* String interning table */
-static ObjTable* string_table = NULL;
+#include "fileio.h"
+#include "numconv.h"
+#include "isolate.h"
+#include "env.h"
+#include "channel.h"
+#include "parallel.h"
+#include "iter.h"
+#include "event.h"
+#include "stats.h"
+#include "heap.h"
 
 /* Reference counting */
 void obj_incref(Object* obj) {
     if (obj == NULL) return;
+    if (obj->frozen) {
+        /* Other isolates may hold it too */
+        __atomic_add_fetch(&obj->ref_count, 1, __ATOMIC_RELAXED);
+        return;
+    }
     obj->ref_count++;
 }
 
 void obj_decref(Object* obj) {
     if (obj == NULL) return;
+    if (obj->frozen) {
+        if (__atomic_sub_fetch(&obj->ref_count, 1, __ATOMIC_ACQ_REL) <= 0) {
+            free_object(obj);
+        }
+        return;
+    }
     obj->ref_count--;
     if (obj->ref_count <= 0) {
         free_object(obj);
@@ -32,40 +47,103 @@ void obj_decref(Object* obj) {
 /* Object allocation */
 Object* allocate_object(size_t size, ObjectType type) {
     Object* obj = (Object*)mem_alloc(size);
+    STAT_INC(objects[type]);
     obj->type = type;
     obj->ref_count = 1;
     obj->marked = false;
-    obj->next = all_objects;
-    all_objects = obj;
+    obj->frozen = false;
+    obj->heap_slot = 0;
+    
+    Isolate* isolate = isolate_current();
+    obj->next = isolate->all_objects;
+    isolate->all_objects = obj;
+    if (isolate == heap_isolate) heap_track(obj, size);
     return obj;
 }
 
-/* String hash function (FNV-1a) */
+void object_adopt(Object* obj, size_t size) {
+    mem_adopt(size);
+    STAT_INC(objects[obj->type]);
+    
+    Isolate* isolate = isolate_current();
+    obj->next = isolate->all_objects;
+    isolate->all_objects = obj;
+    if (isolate == heap_isolate) heap_track(obj, size);
+}
+
+/* String hash function: FNV-1a style xor-multiply over eight bytes at a
+   time, then a final avalanche (murmur3 fmix64) so the low bits used for
+   bucket indexing depend on every input byte */
 uint32_t string_hash(const char* chars, int length) {
-    uint32_t hash = 2166136261u;
-    for (int i = 0; i < length; i++) {
-        hash ^= (uint8_t)chars[i];
-        hash *= 16777619;
+    uint64_t hash = 14695981039346656037ULL ^ (uint64_t)length;
+    int i = 0;
+    
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, chars + i, 8);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    if (i < length) {
+        uint64_t word = 0;
+        memcpy(&word, chars + i, length - i);
+        hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+    }
+    
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return (uint32_t)hash;
+}
+
+/* Look up an interned string by contents (probes like find_entry) */
+static ObjString* find_interned(ObjTable* string_table, const char* chars,
+                                int length, uint32_t hash) {
+    if (string_table->count == 0) return NULL;
+    
+    uint32_t index = hash % string_table->capacity;
+    for (;;) {
+        TableEntry* entry = &string_table->entries[index];
+        
+        if (entry->key == NULL) {
+            /* Empty slot ends the probe; skip tombstones */
+            if (IS_NIL(entry->value)) return NULL;
+        } else if (entry->key->length == length &&
+                   entry->key->hash == hash &&
+                   memcmp(entry->key->chars, chars, length) == 0) {
+            return entry->key;
+        }
+        
+        index = (index + 1) % string_table->capacity;
+    }
+}
+
+/* Add a freshly built string to the intern table */
+static void intern_new(Isolate* isolate, ObjString* string) {
+    if (isolate->string_table == NULL) {
+        isolate->string_table = table_create();
     }
-    return hash;
+    table_set(isolate->string_table, string, NIL_VAL, false);  /* Holds a reference */
 }
 
 /* Create a string */
 ObjString* string_create(const char* chars, int length) {
-    uint32_t hash = string_hash(chars, length);
+    return string_create_hashed(chars, length, string_hash(chars, length));
+}
+
+/* Create a string whose string_hash is already known */
+ObjString* string_create_hashed(const char* chars, int length, uint32_t hash) {
+    Isolate* isolate = isolate_current();
+    STAT_INC(strings);
     
     /* Check if string already interned */
-    if (string_table != NULL) {
-        /* Simple linear search for now */
-        for (int i = 0; i < string_table->capacity; i++) {
-            TableEntry* entry = &string_table->entries[i];
-            if (entry->key != NULL &&
-                entry->key->length == length &&
-                entry->key->hash == hash &&
-                memcmp(entry->key->chars, chars, length) == 0) {
-                obj_incref((Object*)entry->key);
-                return entry->key;
-            }
+    if (isolate->string_table != NULL) {
+        ObjString* interned = find_interned(isolate->string_table, chars, length, hash);
+        if (interned != NULL) {
+            STAT_INC(intern_hits);
+            obj_incref((Object*)interned);
+            return interned;
         }
     }
     
@@ -77,27 +155,70 @@ ObjString* string_create(const char* chars, int length) {
     memcpy(string->chars, chars, length);
     string->chars[length] = '\0';
     
-    /* Intern the string */
-    if (string_table == NULL) {
-        string_table = table_create();
+    intern_new(isolate, string);
+    return string;
+}
+
+/* Create a string that is not added to the intern table, so it is freed
+   when its last reference goes away. Used for large or streamed data. */
+ObjString* string_create_uninterned(const char* chars, int length) {
+    STAT_INC(strings);
+    ObjString* string = (ObjString*)allocate_object(
+        sizeof(ObjString) + length + 1, OBJ_STRING);
+    string->length = length;
+    string->hash = string_hash(chars, length);
+    memcpy(string->chars, chars, length);
+    string->chars[length] = '\0';
+    return string;
+}
+
+/* Allocate an untracked string of the given length to be filled in place */
+ObjString* string_allocate(int length) {
+    ObjString* string = (ObjString*)mem_alloc(sizeof(ObjString) + length + 1);
+    string->obj.type = OBJ_STRING;
+    string->obj.ref_count = 1;
+    string->obj.marked = false;
+    string->obj.frozen = false;
+    string->obj.heap_slot = 0;
+    string->obj.next = NULL;
+    string->length = length;
+    string->hash = 0;
+    string->chars[length] = '\0';
+    return string;
+}
+
+/* Intern a string filled in after string_allocate. If an equal string
+   already exists the new one is released and the existing one returned. */
+ObjString* string_finish(ObjString* string) {
+    string->hash = string_hash(string->chars, string->length);
+    Isolate* isolate = isolate_current();
+    STAT_INC(strings);
+    
+    if (isolate->string_table != NULL) {
+        ObjString* interned = find_interned(isolate->string_table, string->chars,
+                                            string->length, string->hash);
+        if (interned != NULL) {
+            STAT_INC(intern_hits);
+            mem_free(string, sizeof(ObjString) + string->length + 1);
+            obj_incref((Object*)interned);
+            return interned;
+        }
     }
-    obj_incref((Object*)string);  /* Table holds a reference */
-    table_set(string_table, string, NIL_VAL, false);
     
+    STAT_INC(objects[OBJ_STRING]);
+    string->obj.next = isolate->all_objects;
+    isolate->all_objects = (Object*)string;
+    if (isolate == heap_isolate) heap_track((Object*)string, sizeof(ObjString) + string->length + 1);
+    intern_new(isolate, string);
     return string;
 }
 
 /* Concatenate two strings */
 ObjString* string_concat(ObjString* a, ObjString* b) {
-    int length = a->length + b->length;
-    char* chars = mem_alloc(length + 1);
-    memcpy(chars, a->chars, a->length);
-    memcpy(chars + a->length, b->chars, b->length);
-    chars[length] = '\0';
-    
-    ObjString* result = string_create(chars, length);
-    mem_free(chars, length + 1);
-    return result;
+    ObjString* result = string_allocate(a->length + b->length);
+    memcpy(result->chars, a->chars, a->length);
+    memcpy(result->chars + a->length, b->chars, b->length);
+    return string_finish(result);
 }
 
 /* Intern a string */
@@ -115,6 +236,15 @@ ObjArray* array_create(void) {
     return array;
 }
 
+/* Grow capacity to at least the given size */
+void array_reserve(ObjArray* array, int capacity) {
+    if (capacity <= array->capacity) return;
+    array->elements = mem_realloc(array->elements,
+                                   sizeof(Value) * array->capacity,
+                                   sizeof(Value) * capacity);
+    array->capacity = capacity;
+}
+
 /* Push to array */
 void array_push(ObjArray* array, Value value) {
     if (array->count >= array->capacity) {
@@ -190,9 +320,11 @@ static TableEntry* find_entry(TableEntry* entries, int capacity, ObjString* key)
     
     uint32_t index = key->hash % capacity;
     TableEntry* tombstone = NULL;
+    STAT_INC(table_lookups);
     
     for (;;) {
         TableEntry* entry = &entries[index];
+        STAT_INC(table_probes);
         
         if (entry->key == NULL) {
             if (IS_NIL(entry->value)) {
@@ -202,7 +334,11 @@ static TableEntry* find_entry(TableEntry* entries, int capacity, ObjString* key)
                 /* Tombstone */
                 if (tombstone == NULL) tombstone = entry;
             }
-        } else if (entry->key == key) {
+        } else if (entry->key == key ||
+                   (entry->key->hash == key->hash &&
+                    entry->key->length == key->length &&
+                    memcmp(entry->key->chars, key->chars, key->length) == 0)) {
+            /* Interned keys match by pointer; uninterned ones by contents */
             return entry;
         }
         
@@ -241,6 +377,13 @@ static void grow_table(ObjTable* table, int capacity) {
     table->capacity = capacity;
 }
 
+/* Size a table for count entries up front so filling it never rehashes */
+void table_reserve(ObjTable* table, int count) {
+    int capacity = 8;
+    while (count > capacity * 0.75) capacity *= 2;
+    if (capacity > table->capacity) grow_table(table, capacity);
+}
+
 /* Get from table */
 bool table_get(ObjTable* table, ObjString* key, Value* value) {
     if (table->count == 0) return false;
@@ -262,8 +405,9 @@ bool table_set(ObjTable* table, ObjString* key, Value value, bool is_const) {
     TableEntry* entry = find_entry(table->entries, table->capacity, key);
     bool is_new = entry->key == NULL;
     
-    if (is_new && IS_NIL(entry->value)) {
-        table->count++;
+    /* Reused tombstones are already counted, but still need the key */
+    if (is_new) {
+        if (IS_NIL(entry->value)) table->count++;
         obj_incref((Object*)key);
     }
     
@@ -359,6 +503,8 @@ ObjFunction* function_create(const char* name, int name_len,
     fn->params = params;
     fn->param_lengths = param_lens;
     fn->closure = closure;
+    fn->is_generator = false;
+    fn->compiled = NULL;
     
     return fn;
 }
@@ -367,6 +513,20 @@ ObjFunction* function_create(const char* name, int name_len,
 ObjNative* native_create(NativeFn function, int arity, const char* name) {
     ObjNative* native = (ObjNative*)allocate_object(sizeof(ObjNative), OBJ_NATIVE);
     native->function = function;
+    native->interp_function = NULL;
+    native->user_data = NULL;
+    native->arity = arity;
+    native->name = name;
+    return native;
+}
+
+/* Create an interpreter-aware native function */
+ObjNative* native_create_interp(NativeInterpFn function, void* user_data,
+                                int arity, const char* name) {
+    ObjNative* native = (ObjNative*)allocate_object(sizeof(ObjNative), OBJ_NATIVE);
+    native->function = NULL;
+    native->interp_function = function;
+    native->user_data = user_data;
     native->arity = arity;
     native->name = name;
     return native;
@@ -430,11 +590,13 @@ void value_print(Value value) {
             printf(AS_BOOL(value) ? "true" : "false");
             break;
         case VAL_INT:
-            printf("%ld", (long)AS_INT(value));
-            break;
-        case VAL_FLOAT:
-            printf("%g", AS_FLOAT(value));
+        case VAL_FLOAT: {
+            char buffer[VALUE_TEXT_BUFFER];
+            const char* text;
+            int length = value_text(value, buffer, &text);
+            fwrite(text, 1, length, stdout);
             break;
+        }
         case VAL_OBJ:
             switch (AS_OBJ(value)->type) {
                 case OBJ_STRING:
@@ -474,43 +636,63 @@ void value_print(Value value) {
                 case OBJ_CFUNCTION:
                     printf("<cfn>");
                     break;
+                case OBJ_FILE:
+                    printf("<file>");
+                    break;
+                case OBJ_CHANNEL:
+                    printf("<channel>");
+                    break;
+                case OBJ_THREAD:
+                    printf("<thread>");
+                    break;
+                case OBJ_ITERATOR:
+                    printf("<iterator>");
+                    break;
+                case OBJ_TASK:
+                    printf("<task>");
+                    break;
             }
             break;
     }
 }
 
-/* Convert value to string */
-char* value_to_string(Value value) {
-    char* buffer = mem_alloc(256);
+/* Get the text of a value; only non-string objects touch snprintf */
+int value_text(Value value, char* buffer, const char** text) {
+    *text = buffer;
     
     switch (value.type) {
         case VAL_NIL:
-            strcpy(buffer, "nil");
-            break;
+            *text = "nil";
+            return 3;
         case VAL_BOOL:
-            strcpy(buffer, AS_BOOL(value) ? "true" : "false");
-            break;
+            *text = AS_BOOL(value) ? "true" : "false";
+            return AS_BOOL(value) ? 4 : 5;
         case VAL_INT:
-            snprintf(buffer, 256, "%ld", (long)AS_INT(value));
-            break;
+            return num_format_int(buffer, AS_INT(value));
         case VAL_FLOAT:
-            snprintf(buffer, 256, "%g", AS_FLOAT(value));
-            break;
+            return num_format_double(buffer, AS_FLOAT(value));
         case VAL_OBJ:
             if (AS_OBJ(value)->type == OBJ_STRING) {
-                ObjString* str = AS_STRING(value);
-                mem_free(buffer, 256);
-                buffer = mem_alloc(str->length + 1);
-                memcpy(buffer, str->chars, str->length);
-                buffer[str->length] = '\0';
-            } else {
-                snprintf(buffer, 256, "<%s>", 
-                         value_type_name(value));
+                *text = AS_STRING(value)->chars;
+                return AS_STRING(value)->length;
             }
-            break;
+            return snprintf(buffer, VALUE_TEXT_BUFFER, "<%s>", value_type_name(value));
     }
     
-    return buffer;
+    *text = "";
+    return 0;
+}
+
+/* Convert value to a NUL-terminated copy; free with strlen + 1 bytes */
+char* value_to_string(Value value) {
+    char buffer[VALUE_TEXT_BUFFER];
+    const char* text;
+    int length = value_text(value, buffer, &text);
+    
+    char* result = mem_alloc(length + 1);
+    memcpy(result, text, length);
+    result[length] = '\0';
+    return result;
 }
 
 /* Check truthiness */
@@ -532,24 +714,37 @@ const char* value_type_name(Value value) {
         case VAL_BOOL: return "bool";
         case VAL_INT: return "int";
         case VAL_FLOAT: return "float";
-        case VAL_OBJ:
-            switch (AS_OBJ(value)->type) {
-                case OBJ_STRING: return "string";
-                case OBJ_ARRAY: return "array";
-                case OBJ_TABLE: return "table";
-                case OBJ_FUNCTION: return "function";
-                case OBJ_NATIVE: return "native";
-                case OBJ_POINTER: return "pointer";
-                case OBJ_CSTRUCT: return "cstruct";
-                case OBJ_CFUNCTION: return "cfunction";
-                default: return "unknown";
-            }
+        case VAL_OBJ: return object_type_name(AS_OBJ(value)->type);
+        default: return "unknown";
+    }
+}
+
+/* Get object type name */
+const char* object_type_name(ObjectType type) {
+    switch (type) {
+        case OBJ_STRING: return "string";
+        case OBJ_ARRAY: return "array";
+        case OBJ_TABLE: return "table";
+        case OBJ_FUNCTION: return "function";
+        case OBJ_NATIVE: return "native";
+        case OBJ_POINTER: return "pointer";
+        case OBJ_CSTRUCT: return "cstruct";
+        case OBJ_CFUNCTION: return "cfunction";
+        case OBJ_FILE: return "file";
+        case OBJ_CHANNEL: return "channel";
+        case OBJ_THREAD: return "thread";
+        case OBJ_ITERATOR: return "iterator";
+        case OBJ_TASK: return "task";
         default: return "unknown";
     }
 }
 
 /* Free an object */
 void free_object(Object* obj) {
+    /* Atomic because the profiler may renumber a frozen object that
+       another thread is freeing */
+    if (__atomic_load_n(&obj->heap_slot, __ATOMIC_RELAXED) != 0) heap_untrack(obj);
+    
     switch (obj->type) {
         case OBJ_STRING: {
             ObjString* str = (ObjString*)obj;
@@ -594,6 +789,7 @@ void free_object(Object* obj) {
                 mem_free(fn->name, strlen(fn->name) + 1);
             }
             /* Note: params are owned by AST, don't free */
+            env_decref(fn->closure);  /* Taken when the function was made */
             mem_free(obj, sizeof(ObjFunction));
             break;
         }
@@ -622,5 +818,50 @@ void free_object(Object* obj) {
             mem_free(obj, sizeof(ObjCFunction));
             break;
         }
+        case OBJ_FILE: {
+            file_close((ObjFile*)obj);
+            mem_free(obj, sizeof(ObjFile));
+            break;
+        }
+        case OBJ_CHANNEL: {
+            channel_release(((ObjChannel*)obj)->channel);
+            mem_free(obj, sizeof(ObjChannel));
+            break;
+        }
+        case OBJ_THREAD: {
+            thread_free((ObjThread*)obj);
+            mem_free(obj, sizeof(ObjThread));
+            break;
+        }
+        case OBJ_ITERATOR: {
+            iterator_free((ObjIterator*)obj);
+            mem_free(obj, sizeof(ObjIterator));
+            break;
+        }
+        case OBJ_TASK: {
+            task_free((ObjTask*)obj);
+            mem_free(obj, sizeof(ObjTask));
+            break;
+        }
+    }
+}
+
+/* Bytes an object owns */
+size_t object_size(Object* obj) {
+    switch (obj->type) {
+        case OBJ_STRING: return sizeof(ObjString) + ((ObjString*)obj)->length + 1;
+        case OBJ_ARRAY: return sizeof(ObjArray) + sizeof(Value) * ((ObjArray*)obj)->capacity;
+        case OBJ_TABLE: return sizeof(ObjTable) + sizeof(TableEntry) * ((ObjTable*)obj)->capacity;
+        case OBJ_FUNCTION: return sizeof(ObjFunction);
+        case OBJ_NATIVE: return sizeof(ObjNative);
+        case OBJ_POINTER: return sizeof(ObjPointer);
+        case OBJ_CSTRUCT: return sizeof(ObjCStruct);
+        case OBJ_CFUNCTION: return sizeof(ObjCFunction);
+        case OBJ_FILE: return sizeof(ObjFile);
+        case OBJ_CHANNEL: return sizeof(ObjChannel);
+        case OBJ_THREAD: return sizeof(ObjThread);
+        case OBJ_ITERATOR: return sizeof(ObjIterator);
+        case OBJ_TASK: return sizeof(ObjTask);
     }
+    return 0;
 }
@@ -0,0 +1,326 @@
+/*
+ * Brisk Language - Numeric Array Kernels Implementation
+ * The element kind is checked once up front so each loop reads raw ints
+ * or doubles; independent accumulators let the compiler vectorize them.
+ * Big arrays are cut into fixed blocks spread over the thread pool;
+ * reductions combine the per-block results in block order, so the answer
+ * does not depend on how many threads there are.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "vecmath.h"
+#include "pool.h"
+#include "memory.h"
+
+/* Arrays shorter than this stay in one piece on the calling thread */
+#define VEC_PARALLEL_MIN (1 << 17)
+
+/* Elements per block handed to the pool */
+#define VEC_BLOCK (1 << 15)
+
+/* Decided by size alone: a float sum is grouped the same way however
+   many threads the pool has, even just one */
+static bool vec_parallel(int count) {
+    return count >= VEC_PARALLEL_MIN;
+}
+
+/* ============ Blocks ============ */
+
+typedef struct {
+    Value* out;
+    const Value* values;
+    const Value* other;     /* Second operand, or the clamp bounds */
+    int stride;
+    int count;
+    VecKind kind;
+    char op;
+    void* partials;         /* One result per block for reductions */
+} VecJob;
+
+static int block_count(int count) {
+    return (count + VEC_BLOCK - 1) / VEC_BLOCK;
+}
+
+/* First element and length of block b */
+static int block_span(const VecJob* job, int64_t b, int* length) {
+    int first = (int)(b * VEC_BLOCK);
+    *length = job->count - first < VEC_BLOCK ? job->count - first : VEC_BLOCK;
+    return first;
+}
+
+static unsigned kind_bits(const Value* values, int count) {
+    /* OR together one bit per type instead of branching per element */
+    unsigned seen = 0;
+    for (int i = 0; i < count; i++) {
+        seen |= 1u << values[i].type;
+    }
+    return seen;
+}
+
+static void kind_blocks(void* context, int64_t begin, int64_t end) {
+    VecJob* job = context;
+    unsigned* partials = job->partials;
+    for (int64_t b = begin; b < end; b++) {
+        int length;
+        int first = block_span(job, b, &length);
+        partials[b] = kind_bits(job->values + first, length);
+    }
+}
+
+VecKind vec_kind(const Value* values, int count) {
+    unsigned seen = 0;
+    if (vec_parallel(count)) {
+        int blocks = block_count(count);
+        unsigned* partials = mem_alloc(sizeof(unsigned) * blocks);
+        VecJob job = {NULL, values, NULL, 0, count, VEC_INT, 0, partials};
+        pool_for(blocks, 1, kind_blocks, &job);
+        for (int b = 0; b < blocks; b++) {
+            seen |= partials[b];
+        }
+        mem_free(partials, sizeof(unsigned) * blocks);
+    } else {
+        seen = kind_bits(values, count);
+    }
+    
+    unsigned ints = 1u << VAL_INT;
+    unsigned floats = 1u << VAL_FLOAT;
+    if (seen & ~(ints | floats)) return VEC_INVALID;
+    if (seen == floats) return VEC_FLOAT;
+    if (seen == (ints | floats)) return VEC_MIXED;
+    return VEC_INT;
+}
+
+VecKind vec_kind_join(VecKind a, VecKind b) {
+    if (a == VEC_INVALID || b == VEC_INVALID) return VEC_INVALID;
+    if (a == b) return a;
+    return VEC_MIXED;
+}
+
+/* ============ Reductions ============ */
+
+static double number_at(const Value* values, int i, VecKind kind) {
+    return kind == VEC_FLOAT ? values[i].as.floating : AS_NUMBER(values[i]);
+}
+
+static Value sum_serial(const Value* values, int count, VecKind kind) {
+    int i = 0;
+    
+    if (kind == VEC_INT) {
+        /* Unsigned so overflow wraps instead of being undefined */
+        uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (; i + 4 <= count; i += 4) {
+            s0 += (uint64_t)values[i].as.integer;
+            s1 += (uint64_t)values[i + 1].as.integer;
+            s2 += (uint64_t)values[i + 2].as.integer;
+            s3 += (uint64_t)values[i + 3].as.integer;
+        }
+        for (; i < count; i++) s0 += (uint64_t)values[i].as.integer;
+        return INT_VAL((int64_t)((s0 + s1) + (s2 + s3)));
+    }
+    
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    if (kind == VEC_FLOAT) {
+        for (; i + 4 <= count; i += 4) {
+            s0 += values[i].as.floating;
+            s1 += values[i + 1].as.floating;
+            s2 += values[i + 2].as.floating;
+            s3 += values[i + 3].as.floating;
+        }
+    }
+    for (; i < count; i++) s0 += number_at(values, i, kind);
+    return FLOAT_VAL((s0 + s1) + (s2 + s3));
+}
+
+static Value prod_serial(const Value* values, int count, VecKind kind) {
+    int i = 0;
+    
+    if (kind == VEC_INT) {
+        uint64_t p0 = 1, p1 = 1;
+        for (; i + 2 <= count; i += 2) {
+            p0 *= (uint64_t)values[i].as.integer;
+            p1 *= (uint64_t)values[i + 1].as.integer;
+        }
+        for (; i < count; i++) p0 *= (uint64_t)values[i].as.integer;
+        return INT_VAL((int64_t)(p0 * p1));
+    }
+    
+    double p0 = 1.0, p1 = 1.0;
+    if (kind == VEC_FLOAT) {
+        for (; i + 2 <= count; i += 2) {
+            p0 *= values[i].as.floating;
+            p1 *= values[i + 1].as.floating;
+        }
+    }
+    for (; i < count; i++) p0 *= number_at(values, i, kind);
+    return FLOAT_VAL(p0 * p1);
+}
+
+static void sum_blocks(void* context, int64_t begin, int64_t end) {
+    VecJob* job = context;
+    Value* partials = job->partials;
+    for (int64_t b = begin; b < end; b++) {
+        int length;
+        int first = block_span(job, b, &length);
+        partials[b] = sum_serial(job->values + first, length, job->kind);
+    }
+}
+
+static void prod_blocks(void* context, int64_t begin, int64_t end) {
+    VecJob* job = context;
+    Value* partials = job->partials;
+    for (int64_t b = begin; b < end; b++) {
+        int length;
+        int first = block_span(job, b, &length);
+        partials[b] = prod_serial(job->values + first, length, job->kind);
+    }
+}
+
+/* Reduce each block on the pool, then the block results in order */
+static Value reduce_parallel(const Value* values, int count, VecKind kind, PoolFn blocks_fn,
+                             Value (*combine)(const Value*, int, VecKind)) {
+    int blocks = block_count(count);
+    Value* partials = mem_alloc(sizeof(Value) * blocks);
+    VecJob job = {NULL, values, NULL, 0, count, kind, 0, partials};
+    pool_for(blocks, 1, blocks_fn, &job);
+    
+    /* Block results are ints only when every element was */
+    Value result = combine(partials, blocks, kind == VEC_INT ? VEC_INT : VEC_FLOAT);
+    mem_free(partials, sizeof(Value) * blocks);
+    return result;
+}
+
+Value vec_sum(const Value* values, int count, VecKind kind) {
+    if (vec_parallel(count)) {
+        return reduce_parallel(values, count, kind, sum_blocks, sum_serial);
+    }
+    return sum_serial(values, count, kind);
+}
+
+Value vec_prod(const Value* values, int count, VecKind kind) {
+    if (vec_parallel(count)) {
+        return reduce_parallel(values, count, kind, prod_blocks, prod_serial);
+    }
+    return prod_serial(values, count, kind);
+}
+
+static int arg_extreme(const Value* values, int count, VecKind kind, bool want_max) {
+    if (count == 0) return -1;
+    int best = 0;
+    
+    if (kind == VEC_INT) {
+        /* Compare as int64 so large ints are not rounded through double */
+        int64_t best_value = values[0].as.integer;
+        for (int i = 1; i < count; i++) {
+            int64_t x = values[i].as.integer;
+            if (want_max ? x > best_value : x < best_value) {
+                best_value = x;
+                best = i;
+            }
+        }
+        return best;
+    }
+    
+    double best_value = number_at(values, 0, kind);
+    for (int i = 1; i < count; i++) {
+        double x = number_at(values, i, kind);
+        if ((want_max ? x > best_value : x < best_value) ||
+            (best_value != best_value && x == x)) {
+            best_value = x;
+            best = i;
+        }
+    }
+    return best;
+}
+
+int vec_argmin(const Value* values, int count, VecKind kind) {
+    return arg_extreme(values, count, kind, false);
+}
+
+int vec_argmax(const Value* values, int count, VecKind kind) {
+    return arg_extreme(values, count, kind, true);
+}
+
+/* ============ Elementwise ============ */
+
+static void clamp_serial(Value* out, const Value* values, int count, VecKind kind,
+                         Value lo, Value hi) {
+    if (kind == VEC_INT && IS_INT(lo) && IS_INT(hi)) {
+        int64_t low = AS_INT(lo);
+        int64_t high = AS_INT(hi);
+        for (int i = 0; i < count; i++) {
+            int64_t x = values[i].as.integer;
+            out[i] = INT_VAL(x < low ? low : (x > high ? high : x));
+        }
+        return;
+    }
+    
+    double low = AS_NUMBER(lo);
+    double high = AS_NUMBER(hi);
+    for (int i = 0; i < count; i++) {
+        double x = number_at(values, i, kind);
+        out[i] = x < low ? lo : (x > high ? hi : values[i]);
+    }
+}
+
+static void binary_serial(Value* out, const Value* a, const Value* b, int b_stride,
+                          int count, VecKind kind, char op) {
+    if (kind == VEC_INT) {
+        /* Wrapping arithmetic, as in vec_sum */
+        for (int i = 0; i < count; i++) {
+            uint64_t x = (uint64_t)a[i].as.integer;
+            uint64_t y = (uint64_t)b[i * b_stride].as.integer;
+            out[i] = INT_VAL((int64_t)(op == '+' ? x + y : x * y));
+        }
+        return;
+    }
+    
+    if (kind == VEC_FLOAT) {
+        for (int i = 0; i < count; i++) {
+            double x = a[i].as.floating;
+            double y = b[i * b_stride].as.floating;
+            out[i] = FLOAT_VAL(op == '+' ? x + y : x * y);
+        }
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        double x = AS_NUMBER(a[i]);
+        double y = AS_NUMBER(b[i * b_stride]);
+        out[i] = FLOAT_VAL(op == '+' ? x + y : x * y);
+    }
+}
+
+static void clamp_range(void* context, int64_t begin, int64_t end) {
+    VecJob* job = context;
+    clamp_serial(job->out + begin, job->values + begin, (int)(end - begin), job->kind,
+                 job->other[0], job->other[1]);
+}
+
+static void binary_range(void* context, int64_t begin, int64_t end) {
+    VecJob* job = context;
+    binary_serial(job->out + begin, job->values + begin, job->other + begin * job->stride,
+                  job->stride, (int)(end - begin), job->kind, job->op);
+}
+
+void vec_clamp(Value* out, const Value* values, int count, VecKind kind,
+               Value lo, Value hi) {
+    if (vec_parallel(count)) {
+        Value bounds[2] = {lo, hi};
+        VecJob job = {out, values, bounds, 0, count, kind, 0, NULL};
+        pool_for(count, VEC_BLOCK, clamp_range, &job);
+        return;
+    }
+    clamp_serial(out, values, count, kind, lo, hi);
+}
+
+void vec_binary(Value* out, const Value* a, const Value* b, int b_stride,
+                int count, VecKind kind, char op) {
+    if (vec_parallel(count)) {
+        VecJob job = {out, a, b, b_stride, count, kind, op, NULL};
+        pool_for(count, VEC_BLOCK, binary_range, &job);
+        return;
+    }
+    binary_serial(out, a, b, b_stride, count, kind, op);
+}
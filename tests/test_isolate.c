@@ -0,0 +1,134 @@
+/*
+ * Brisk Language - Isolate Tests
+ * Several interpreters running at once on separate threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "../include/parser.h"
+#include "../include/interp.h"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST(name) static void test_##name(void)
+#define RUN_TEST(name) do { \
+    printf("  Running test_%s... ", #name); \
+    test_##name(); \
+    printf("PASSED\n"); \
+    tests_passed++; \
+} while(0)
+
+#define ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("FAILED: %s\n", msg); \
+        tests_failed++; \
+        return; \
+    } \
+} while(0)
+
+#define THREAD_COUNT 8
+
+/* Interns, concatenates and counts strings so every thread hammers its
+   allocator and intern table at the same time */
+static const char* WORKLOAD =
+    "counts := {}\n"
+    "for i in 0..20000 {\n"
+    "    word := \"w\" + str((i * seed) % 97)\n"
+    "    if has(counts, word) {\n"
+    "        counts[word] = counts[word] + 1\n"
+    "    } else {\n"
+    "        counts[word] = 1\n"
+    "    }\n"
+    "}\n"
+    "total := 0\n"
+    "for k in keys(counts) {\n"
+    "    total = total + counts[k]\n"
+    "}\n"
+    "result := json_stringify([seed, total, len(keys(counts))])\n";
+
+typedef struct {
+    int seed;
+    bool ok;
+    char result[64];
+    size_t bytes_allocated;
+} Worker;
+
+static void* run_worker(void* arg) {
+    Worker* worker = arg;
+    AstNode* ast = parse(WORKLOAD);
+    if (ast == NULL) return NULL;
+    
+    Interpreter interp;
+    interp_init(&interp);
+    env_define(interp.global, "seed", 4, INT_VAL(worker->seed), false);
+    exec_program(&interp, ast);
+    
+    Value result;
+    if (!interp.had_error && env_get(interp.global, "result", 6, &result) &&
+        IS_STRING(result)) {
+        snprintf(worker->result, sizeof(worker->result), "%s", AS_CSTRING(result));
+        worker->ok = true;
+    }
+    worker->bytes_allocated = isolate_current()->bytes_allocated;
+    
+    interp_destroy(&interp);
+    ast_free_tree(ast);
+    return NULL;
+}
+
+TEST(threads_run_independently) {
+    pthread_t threads[THREAD_COUNT];
+    Worker workers[THREAD_COUNT];
+    
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        memset(&workers[i], 0, sizeof(Worker));
+        workers[i].seed = i + 1;
+        ASSERT(pthread_create(&threads[i], NULL, run_worker, &workers[i]) == 0,
+               "Thread should start");
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        char expected[64];
+        /* 97 is prime, so every seed below it reaches all residues */
+        snprintf(expected, sizeof(expected), "[%d,20000,97]", i + 1);
+        ASSERT(workers[i].ok, "Interpreter should finish without errors");
+        ASSERT(strcmp(workers[i].result, expected) == 0, "Result should match");
+        ASSERT(workers[i].bytes_allocated > 0, "Isolate should count its own memory");
+    }
+}
+
+TEST(isolate_restored_after_destroy) {
+    Isolate* outer = isolate_current();
+    size_t before = outer->bytes_allocated;
+    
+    Interpreter interp;
+    interp_init(&interp);
+    ASSERT(isolate_current() == &interp.isolate, "Interpreter isolate should be current");
+    
+    ObjString* string = string_create("isolated", 8);
+    obj_decref((Object*)string);
+    ASSERT(outer->bytes_allocated == before, "Outer isolate should not see allocations");
+    
+    interp_destroy(&interp);
+    ASSERT(isolate_current() == outer, "Previous isolate should be restored");
+}
+
+int main(void) {
+    printf("\n=== Brisk Isolate Tests ===\n\n");
+    
+    RUN_TEST(threads_run_independently);
+    RUN_TEST(isolate_restored_after_destroy);
+    
+    printf("\n=== Results ===\n");
+    printf("Passed: %d\n", tests_passed);
+    printf("Failed: %d\n", tests_failed);
+    
+    return tests_failed > 0 ? 1 : 0;
+}
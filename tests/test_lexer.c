@@ -238,6 +238,12 @@ TEST(strings) {
     lexer_init(&lexer, "\"test\\\"quote\"");
     t = lexer_next_token(&lexer);
     ASSERT(t.type == TOKEN_STRING, "String with escaped quote should be STRING");
+    
+    lexer_init(&lexer, "f\"a{b[\"k\"]}c\" x");
+    t = lexer_next_token(&lexer);
+    ASSERT(t.type == TOKEN_FSTRING, "f\"...\" should be FSTRING");
+    ASSERT(t.length == 13, "Quotes inside {} should not end the FSTRING");
+    ASSERT_TOKEN(lexer, TOKEN_IDENTIFIER);
 }
 
 /* Test comments */
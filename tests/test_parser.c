@@ -56,6 +56,21 @@ TEST(literal_float) {
     ast_free_tree(ast);
 }
 
+TEST(literal_number_forms) {
+    AstNode* ast = parse("1_000_000\n0x1F\n0755\n0.0025\n1_0.2_5");
+    ASSERT(ast != NULL, "AST should not be NULL");
+    ASSERT(ast->as.program.statement_count == 5, "Should have 5 statements");
+    
+    AstNode** stmts = ast->as.program.statements;
+    ASSERT(stmts[0]->as.unary.operand->as.int_literal.value == 1000000, "Separators skipped");
+    ASSERT(stmts[1]->as.unary.operand->as.int_literal.value == 31, "Hex literal");
+    ASSERT(stmts[2]->as.unary.operand->as.int_literal.value == 493, "Octal literal");
+    ASSERT(stmts[3]->as.unary.operand->as.float_literal.value == 0.0025, "Leading zeros in fraction");
+    ASSERT(stmts[4]->as.unary.operand->as.float_literal.value == 10.25, "Float separators");
+    
+    ast_free_tree(ast);
+}
+
 TEST(literal_string) {
     AstNode* ast = parse("\"hello\"");
     ASSERT(ast != NULL, "AST should not be NULL");
@@ -68,6 +83,33 @@ TEST(literal_string) {
     ast_free_tree(ast);
 }
 
+TEST(interp_string) {
+    AstNode* ast = parse("f\"x={x:05} y={y}\"");
+    ASSERT(ast != NULL, "AST should not be NULL");
+    
+    AstNode* stmt = ast->as.program.statements[0];
+    AstNode* expr = stmt->as.unary.operand;
+    ASSERT(expr->type == NODE_INTERP, "Should be interpolated string");
+    ASSERT(expr->as.interp_string.part_count == 4, "Should have 4 parts");
+    
+    InterpPart* parts = expr->as.interp_string.parts;
+    ASSERT(strcmp(parts[0].literal, "x=") == 0, "First part should be 'x='");
+    ASSERT(parts[1].expr->type == NODE_IDENTIFIER, "Second part should be identifier");
+    ASSERT(parts[1].spec.zero_pad && parts[1].spec.width == 5, "Spec should be 05");
+    ASSERT(strcmp(parts[2].literal, " y=") == 0, "Third part should be ' y='");
+    ASSERT(parts[3].spec.width == 0 && parts[3].spec.precision == -1, "No spec on y");
+    
+    ast_free_tree(ast);
+    
+    /* No expressions folds to a plain string */
+    ast = parse("f\"{{a}}\"");
+    expr = ast->as.program.statements[0]->as.unary.operand;
+    ASSERT(expr->type == NODE_LITERAL_STRING, "Should fold to string literal");
+    ASSERT(strcmp(expr->as.string_literal.value, "{a}") == 0, "Braces should be unescaped");
+    
+    ast_free_tree(ast);
+}
+
 TEST(literal_bool) {
     AstNode* ast = parse("true");
     ASSERT(ast != NULL, "AST should not be NULL");
@@ -264,6 +306,19 @@ TEST(function_decl) {
     ast_free_tree(ast);
 }
 
+/* Test generator functions */
+TEST(generator_decl) {
+    AstNode* ast = parse("fn gen() { yield 1\n f := fn() { 2 } }\nfn plain() { fn() { yield 3 } }");
+    ASSERT(ast != NULL, "AST should not be NULL");
+    
+    AstNode* gen = ast->as.program.statements[0];
+    AstNode* plain = ast->as.program.statements[1];
+    ASSERT(gen->as.fn_decl.is_generator, "yield should make a generator");
+    ASSERT(!plain->as.fn_decl.is_generator, "yield in a nested fn should not count");
+    
+    ast_free_tree(ast);
+}
+
 /* Test array literals */
 TEST(array_literal) {
     AstNode* ast = parse("[1, 2, 3]");
@@ -321,7 +376,9 @@ int main(void) {
     
     RUN_TEST(literal_int);
     RUN_TEST(literal_float);
+    RUN_TEST(literal_number_forms);
     RUN_TEST(literal_string);
+    RUN_TEST(interp_string);
     RUN_TEST(literal_bool);
     RUN_TEST(literal_nil);
     RUN_TEST(binary_add);
@@ -337,6 +394,7 @@ int main(void) {
     RUN_TEST(while_loop);
     RUN_TEST(for_loop);
     RUN_TEST(function_decl);
+    RUN_TEST(generator_decl);
     RUN_TEST(array_literal);
     RUN_TEST(table_literal);
     RUN_TEST(complex_nested);